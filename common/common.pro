@@ -14,6 +14,7 @@ win32-msvc:CONFIG += staticlib
 win32-g++:DLLDESTDIR = $$MESHLAB_DISTRIB_DIRECTORY/lib
 
 linux:CONFIG += dll
+linux:QMAKE_LFLAGS += -fopenmp -lgomp
 
 INCLUDEPATH *= \
 	../.. \
@@ -51,6 +52,7 @@ HEADERS += 	\
 	plugins/interfaces/render_plugin.h \
 	plugins/meshlab_plugin_type.h \
 	plugins/plugin_manager.h \
+	plugins/plugin_manifest.h \
 	ml_document/helpers/mesh_document_state_data.h \
 	ml_document/helpers/mesh_model_state_data.h \
 	ml_document/base_types.h \
@@ -78,6 +80,7 @@ HEADERS += 	\
 	GLLogStream.h \
 	mlexception.h \
 	mlapplication.h \
+	ml_memory_accounting.h \
 	ml_selection_buffers.h
 
 
@@ -94,6 +97,7 @@ SOURCES += \
 	plugins/interfaces/io_plugin.cpp \
 	plugins/meshlab_plugin_type.cpp \
 	plugins/plugin_manager.cpp \
+	plugins/plugin_manifest.cpp \
 	ml_document/helpers/mesh_document_state_data.cpp \
 	ml_document/cmesh.cpp \
 	ml_document/mesh_model.cpp \
@@ -118,6 +122,7 @@ SOURCES += \
 	GLLogStream.cpp \
 	mlapplication.cpp \
 	searcher.cpp \
+	ml_memory_accounting.cpp \
 	ml_selection_buffers.cpp \
 	$$MESHLAB_EXTERNAL_DIRECTORY/easyexif/exif.cpp
 
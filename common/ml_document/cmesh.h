@@ -115,9 +115,18 @@ class CEdgeO : public vcg::Edge<CUsedTypesO,
 };
 
 // Each face needs 32 byte, on 32bit arch. and 48 byte on 64bit arch.
+// Building with MESHLAB_COMPACT_FACES the vertex references are stored as 32 bit
+// indices: a face needs 40 byte on 64bit arch. and adding vertices does not
+// require to update the faces.
+#ifdef MESHLAB_COMPACT_FACES
+#define MESHLAB_FACE_VERTEX_REF vcg::face::VertexRefIdxOcf
+#else
+#define MESHLAB_FACE_VERTEX_REF vcg::face::VertexRef
+#endif
+
 class CFaceO    : public vcg::Face<  CUsedTypesO,
 		vcg::face::InfoOcf,              /* 4b */
-		vcg::face::VertexRef,            /*12b */
+		MESHLAB_FACE_VERTEX_REF,         /*12b (24b with pointers on 64bit arch.) */
 		vcg::face::BitFlags,             /* 4b */
 		vcg::face::Normal3m,             /*12b */
 		vcg::face::QualitymOcf,          /* 0b */
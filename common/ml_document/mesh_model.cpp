@@ -26,16 +26,53 @@
 #include <QFileInfo>
 
 #include "mesh_model.h"
+#include "../globals.h"
+#include "../plugins/plugin_manager.h"
 #include "../utilities/load_save.h"
 
 #include <wrap/gl/math.h>
+#include <vcg/complex/algorithms/memory_usage.h>
 
 #include <QDir>
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <set>
 #include <utility>
 
 using namespace vcg;
 
+namespace {
+
+// memory used by the decoded textures that can be evicted, for all the meshes
+std::atomic<qint64> decodedTextureBytes(0);
+// 0 means no limit
+std::atomic<qint64> textureMemoryLimitBytes(0);
+// shared by all the meshes, so that the last uses of their textures can be compared
+std::atomic<quint64> textureUseCounter(0);
+
+// all the existing meshes, among which the textures to evict are chosen.
+// Lock order: meshRegistryMutex first, then the textureMutex of a mesh.
+QMutex meshRegistryMutex;
+std::set<MeshModel*> meshRegistry;
+
+qint64 imageBytes(const QImage& img)
+{
+	return qint64(img.bytesPerLine()) * img.height();
+}
+
+// true if the file exists and there is an image plugin able to read it
+bool isReadableImage(const QString& fileName)
+{
+	QFileInfo fi(fileName);
+	return fi.isFile() &&
+		meshlab::pluginManagerInstance().inputImagePlugin(fi.suffix()) != nullptr;
+}
+
+}
+
 MeshModel::MeshModel(unsigned int id, const QString& fullFileName, const QString& labelName) :
+	savedSelections(cm),
 	idInsideFile(-1),
 	visible(true)
 {
@@ -44,6 +81,17 @@ MeshModel::MeshModel(unsigned int id, const QString& fullFileName, const QString
 	_id=id;
 	if(!fullFileName.isEmpty())   this->fullPathFileName=fullFileName;
 	if(!labelName.isEmpty())	 this->_label=labelName;
+	QMutexLocker locker(&meshRegistryMutex);
+	meshRegistry.insert(this);
+}
+
+MeshModel::~MeshModel()
+{
+	{
+		QMutexLocker locker(&meshRegistryMutex);
+		meshRegistry.erase(this);
+	}
+	clearTextures();
 }
 
 void MeshModel::clear()
@@ -82,7 +130,9 @@ QString MeshModel::relativePathName(const QString& path) const
 
 /**
  * @brief Starting from the (still unloaded) textures contained in the contained
- * CMeshO, loads the textures in the map of QImages contained in the MeshModel.
+ * CMeshO, finds the texture files and registers them in the map of textures
+ * contained in the MeshModel. The images are not decoded here: this happens
+ * on their first access (see getTexture and decodeTextures).
  *
  * The contained CMeshO will have a list of texture names like ":filename.png",
  * and these names will be mapped with the actual loaded image in the map
@@ -95,81 +145,105 @@ QString MeshModel::relativePathName(const QString& path) const
  */
 std::list<std::string> MeshModel::loadTextures(
 		GLLogStream* log,
-		vcg::CallBackPos* cb)
+		vcg::CallBackPos*)
 {
 	std::list<std::string> unloadedTextures;
+	QMutexLocker locker(&textureMutex);
 	for (std::string& textName : cm.textures){
 		if (textures.find(textName) == textures.end()){
-			QImage img(":/img/dummy.png");
+			Texture t;
 			QFileInfo finfo(QString::fromStdString(textName));
-			try {
-				img = meshlab::loadImage(finfo.absoluteFilePath(), log, cb);
+			//could be relative to the meshmodel
+			QString fn2 = QFileInfo(fullName()).absolutePath() + "/" + finfo.fileName();
+			if (isReadableImage(finfo.absoluteFilePath()))
+				t.fileName = finfo.absoluteFilePath();
+			else if (isReadableImage(fn2))
+				t.fileName = fn2;
+
+			if (!t.fileName.isEmpty()) {
 				textName = finfo.fileName().toStdString();
-			} catch (const MLException& e) {
-				try { //could be relative to the meshmodel
-					QFileInfo mfi(fullName());
-					QString fn2 = mfi.absolutePath() + "/" + finfo.fileName();
-					img = meshlab::loadImage(fn2, log, cb);
-					textName = finfo.fileName().toStdString();
-				} catch (const MLException& e) {
-					if (log){
-						log->log(
-							GLLogStream::WARNING, "Failed loading " + textName +
-							"; using a dummy texture");
-					}
-					else {
-						std::cerr <<
-							"Failed loading " + textName + "; using a dummy texture\n";
-					}
-					unloadedTextures.push_back(textName);
-					textName = "dummy.png";
+			}
+			else {
+				// without a log, the caller reports the returned list
+				if (log){
+					log->log(
+						GLLogStream::WARNING, "Failed loading " + textName +
+						"; using a dummy texture");
 				}
+				unloadedTextures.push_back(textName);
+				textName = "dummy.png";
+				t.image = QImage(":/img/dummy.png");
 			}
-			textures[textName] = img;
+			auto it = textures.find(textName);
+			if (it != textures.end())
+				releaseTexture(it->second);
+			textures[textName] = t;
 		}
 	}
 	return unloadedTextures;
 }
 
+/**
+ * @brief Decodes, in parallel, all the textures that have not been decoded
+ * yet. It is not needed to call this function before accessing the textures,
+ * but it is faster when all of them are going to be used.
+ * Textures that cannot be decoded are replaced by a dummy texture and
+ * reported in the log, if given.
+ */
+void MeshModel::decodeTextures(GLLogStream* log, vcg::CallBackPos* cb) const
+{
+	decodedTextures(std::vector<std::string>(cm.textures.begin(), cm.textures.end()), log, cb);
+}
+
 void MeshModel::saveTextures(
 		const QString& basePath,
 		int quality,
 		GLLogStream* log,
 		CallBackPos* cb)
 {
-	for (const std::string& tname : cm.textures){
-		meshlab::saveImage(
-				basePath + "/" + QString::fromStdString(tname),
-				textures.at(tname), quality, log, cb);
-	}
+	QStringList fileNames;
+	for (const std::string& tname : cm.textures)
+		fileNames.push_back(basePath + "/" + QString::fromStdString(tname));
+	std::vector<std::string> names(cm.textures.begin(), cm.textures.end());
+	meshlab::saveImages(fileNames, decodedTextures(names, log, cb), quality, log, cb);
 }
 
 QImage MeshModel::getTexture(const std::string& tn) const
 {
-	auto it = textures.find(tn);
-	if (it != textures.end())
-		return it->second;
-	else
-		return QImage();
+	return decodedTextures(std::vector<std::string>(1, tn), nullptr, nullptr).front();
 }
 
 void MeshModel::clearTextures()
 {
+	QMutexLocker locker(&textureMutex);
+	for (auto& t : textures)
+		releaseTexture(t.second);
 	textures.clear();
 	cm.textures.clear();
 }
 
 void MeshModel::addTexture(std::string name, const QImage& txt)
 {
+	QMutexLocker locker(&textureMutex);
 	cm.textures.push_back(name);
-	textures[name]=txt;
+	auto it = textures.find(name);
+	if (it != textures.end())
+		releaseTexture(it->second);
+	Texture t;
+	t.image = txt;
+	textures[name] = t;
 }
 
 void MeshModel::setTexture(std::string name, const QImage& txt)
 {
+	QMutexLocker locker(&textureMutex);
 	auto it = textures.find(name);
-	if (it != textures.end())
-		it->second = txt;
+	if (it != textures.end()) {
+		// from now on the image exists only in memory
+		releaseTexture(it->second);
+		it->second.fileName.clear();
+		it->second.image = txt;
+	}
 }
 
 void MeshModel::changeTextureName(
@@ -177,17 +251,189 @@ void MeshModel::changeTextureName(
 		std::string newName)
 {
 	if (oldName != newName) {
+		QMutexLocker locker(&textureMutex);
 		auto mit = textures.find(oldName);
 		auto tit = std::find(cm.textures.begin(), cm.textures.end(), oldName);
 		if (mit != textures.end() && tit != cm.textures.end()){
 			*tit = newName;
 
+			auto nit = textures.find(newName);
+			if (nit != textures.end())
+				releaseTexture(nit->second);
 			textures[newName] = mit->second;
 			textures.erase(mit);
 		}
 	}
 }
 
+/**
+ * @brief Sets the maximum amount of memory (in bytes) used by the decoded
+ * textures read from a file, summed over all the meshes. When a mesh accesses
+ * its textures and the limit is exceeded, the least recently used textures
+ * among all the meshes are released and will be decoded again from their
+ * file when needed.
+ * Textures modified or created in memory are never released.
+ * 0 (the default) means no limit. A lower limit is applied immediately.
+ */
+void MeshModel::setTextureMemoryLimit(qint64 bytes)
+{
+	textureMemoryLimitBytes = bytes;
+	evictTextures();
+}
+
+qint64 MeshModel::textureMemoryLimit()
+{
+	return textureMemoryLimitBytes;
+}
+
+/**
+ * @brief Returns the bytes of main memory used by the mesh: element containers
+ * (with the enabled optional components), user attributes and decoded textures.
+ */
+qint64 MeshModel::memoryUsage() const
+{
+	qint64 bytes = qint64(tri::MemoryUsage<CMeshO>::Total(cm));
+	QMutexLocker locker(&textureMutex);
+	for (const auto& t : textures)
+		if (!t.second.image.isNull())
+			bytes += imageBytes(t.second.image);
+	return bytes;
+}
+
+/**
+ * @brief Releases the decoded textures of the mesh that have been read from a
+ * file; they will be decoded again when needed. Returns the released bytes.
+ */
+qint64 MeshModel::releaseDecodedTextures()
+{
+	qint64 bytes = 0;
+	QMutexLocker locker(&textureMutex);
+	for (auto& t : textures) {
+		if (!t.second.fileName.isEmpty() && !t.second.image.isNull()) {
+			bytes += imageBytes(t.second.image);
+			releaseTexture(t.second);
+		}
+	}
+	return bytes;
+}
+
+/*
+ * Returns the images of the given textures (a null image for unknown names),
+ * decoding in parallel the ones that are not decoded yet. The decoding is done
+ * without holding the texture mutex. Textures that cannot be decoded are
+ * replaced by a dummy image (and not decoded again), and are reported in the
+ * log, if given.
+ */
+std::vector<QImage> MeshModel::decodedTextures(
+		const std::vector<std::string>& names,
+		GLLogStream* log,
+		vcg::CallBackPos* cb) const
+{
+	std::vector<QImage> images(names.size());
+	std::vector<size_t> toDecode;
+	QStringList fileNames;
+
+	QMutexLocker locker(&textureMutex);
+	for (size_t i = 0; i < names.size(); ++i) {
+		auto it = textures.find(names[i]);
+		if (it == textures.end())
+			continue;
+		it->second.lastUse = ++textureUseCounter;
+		if (it->second.image.isNull() && !it->second.fileName.isEmpty()) {
+			toDecode.push_back(i);
+			fileNames.push_back(it->second.fileName);
+		}
+		else {
+			images[i] = it->second.image;
+		}
+	}
+
+	if (!toDecode.empty()) {
+		locker.unlock();
+		std::vector<std::string> unloaded;
+		std::vector<QImage> decoded = meshlab::loadImages(fileNames, unloaded, cb);
+		if (log) {
+			for (const std::string& fn : unloaded)
+				log->log(GLLogStream::WARNING, "Failed decoding " + fn + "; using a dummy texture");
+		}
+		locker.relock();
+
+		for (size_t k = 0; k < toDecode.size(); ++k) {
+			const size_t i = toDecode[k];
+			images[i] = decoded[k];
+			// the texture could have been changed while decoding
+			auto it = textures.find(names[i]);
+			if (it != textures.end() && it->second.image.isNull() &&
+					it->second.fileName == fileNames[int(k)]) {
+				if (std::find(unloaded.begin(), unloaded.end(), fileNames[int(k)].toStdString()) != unloaded.end()) {
+					// keep the dummy image in memory instead of failing again
+					it->second.fileName.clear();
+					it->second.image = decoded[k];
+				}
+				else {
+					setDecodedTexture(it->second, decoded[k]);
+				}
+			}
+		}
+	}
+	locker.unlock();
+	// the returned images are not freed by the eviction, as QImage is shared
+	evictTextures();
+	return images;
+}
+
+void MeshModel::setDecodedTexture(Texture& t, const QImage& img) const
+{
+	t.image = img;
+	decodedTextureBytes += imageBytes(img);
+}
+
+void MeshModel::releaseTexture(Texture& t) const
+{
+	if (!t.fileName.isEmpty() && !t.image.isNull())
+		decodedTextureBytes -= imageBytes(t.image);
+	t.image = QImage();
+}
+
+/*
+ * Releases the least recently used decoded textures, among all the meshes,
+ * until the texture memory limit is satisfied (or no texture can be released).
+ * Must be called without holding any texture mutex.
+ */
+void MeshModel::evictTextures()
+{
+	const qint64 limit = textureMemoryLimitBytes;
+	if (limit <= 0 || decodedTextureBytes <= limit)
+		return;
+
+	QMutexLocker registryLocker(&meshRegistryMutex);
+	while (decodedTextureBytes > limit) {
+		MeshModel* lruMesh = nullptr;
+		std::string lruName;
+		quint64 lruUse = std::numeric_limits<quint64>::max();
+		for (MeshModel* m : meshRegistry) {
+			QMutexLocker locker(&m->textureMutex);
+			for (const auto& t : m->textures) {
+				if (!t.second.fileName.isEmpty() && !t.second.image.isNull() &&
+						t.second.lastUse < lruUse) {
+					lruMesh = m;
+					lruName = t.first;
+					lruUse = t.second.lastUse;
+				}
+			}
+		}
+		if (lruMesh == nullptr)
+			break;
+
+		// the texture could have been used or released in the meantime:
+		// in that case the search is repeated
+		QMutexLocker locker(&lruMesh->textureMutex);
+		auto it = lruMesh->textures.find(lruName);
+		if (it != lruMesh->textures.end() && it->second.lastUse == lruUse)
+			lruMesh->releaseTexture(it->second);
+	}
+}
+
 int MeshModel::io2mm(int single_iobit)
 {
 	switch(single_iobit)
@@ -52,6 +52,7 @@
 #include <QStringList>
 #include <QFileInfo>
 #include <QReadWriteLock>
+#include <QMutex>
 #include <QImage>
 #include <QAction>
 /*
@@ -122,9 +123,7 @@ public:
 	};
 
 	MeshModel(unsigned int id, const QString& fullFileName, const QString& labelName);
-	~MeshModel()
-	{
-	}
+	~MeshModel();
 
 	void clear();
 	void updateBoxAndNormals(); // This is the STANDARD method that you should call after changing coords.
@@ -168,6 +167,7 @@ public:
 	void setVisible(bool vis = true) { visible = vis;}
 
 	std::list<std::string> loadTextures(GLLogStream* log = nullptr, vcg::CallBackPos* cb = nullptr);
+	void decodeTextures(GLLogStream* log = nullptr, vcg::CallBackPos* cb = nullptr) const;
 	void saveTextures(const QString& basePath, int quality = -1, GLLogStream* log = nullptr, vcg::CallBackPos* cb = nullptr);
 
 	QImage getTexture(const std::string& tn) const;
@@ -192,7 +192,15 @@ public:
 	void setMeshModified(bool b = true);
 	static int io2mm(int single_iobit);
 
+	static void setTextureMemoryLimit(qint64 bytes);
+	static qint64 textureMemoryLimit();
+
+	qint64 memoryUsage() const;
+	qint64 releaseDecodedTextures();
+
 	CMeshO cm;
+	// selections saved by name, see the Save/Restore Selection filters
+	vcg::tri::SelectionStore<CMeshO> savedSelections;
 
 private:
 	int currentDataMask;
@@ -207,8 +215,24 @@ private:
 	//files containing just this mesh, this id will be -1.
 	int idInsideFile;
 
-	//textures associated to mesh
-	std::map<std::string, QImage> textures;
+	//textures associated to mesh; images read from a file are decoded on first
+	//access and can be evicted (and decoded again later) to stay within the
+	//texture memory limit
+	struct Texture
+	{
+		Texture() : lastUse(0) {}
+		QString fileName; // empty if the image exists only in memory
+		QImage image;     // null if not decoded yet
+		quint64 lastUse;
+	};
+
+	std::vector<QImage> decodedTextures(const std::vector<std::string>& names, GLLogStream* log, vcg::CallBackPos* cb) const;
+	void setDecodedTexture(Texture& t, const QImage& img) const;
+	void releaseTexture(Texture& t) const;
+	static void evictTextures();
+
+	mutable QMutex textureMutex;
+	mutable std::map<std::string, Texture> textures;
 };// end class MeshModel
 
 #endif
@@ -62,22 +62,10 @@ void MeshModelState::create(int _mask, MeshModel* _m)
 	}
 	
 	if(changeMask & MeshModel::MM_FACEFLAGSELECT)
-	{
-		faceSelection.resize(m->cm.face.size());
-		std::vector<bool>::iterator ci;
-		CMeshO::FaceIterator fi;
-		for(fi = m->cm.face.begin(), ci = faceSelection.begin(); fi != m->cm.face.end(); ++fi, ++ci)
-			if(!(*fi).IsD()) (*ci) = (*fi).IsS();
-	}
+		vcg::tri::UpdateSelection<CMeshO>::FaceToBitSet(m->cm, faceSelection);
 	
 	if(changeMask & MeshModel::MM_VERTFLAGSELECT)
-	{
-		vertSelection.resize(m->cm.vert.size());
-		std::vector<bool>::iterator ci;
-		CMeshO::VertexIterator vi;
-		for(vi = m->cm.vert.begin(), ci = vertSelection.begin(); vi != m->cm.vert.end(); ++vi, ++ci)
-			if(!(*vi).IsD()) (*ci) = (*vi).IsS();
-	}
+		vcg::tri::UpdateSelection<CMeshO>::VertexToBitSet(m->cm, vertSelection);
 	
 	if(changeMask & MeshModel::MM_TRANSFMATRIX)
 		Tr = m->cm.Tr;
@@ -145,30 +133,14 @@ bool MeshModelState::apply(MeshModel *_m)
 	
 	if(changeMask & MeshModel::MM_FACEFLAGSELECT)
 	{
-		if(faceSelection.size() != m->cm.face.size()) return false;
-		std::vector<bool>::iterator ci;
-		CMeshO::FaceIterator fi;
-		for(fi = m->cm.face.begin(), ci = faceSelection.begin(); fi != m->cm.face.end(); ++fi, ++ci)
-		{
-			if((*ci))
-				(*fi).SetS();
-			else
-				(*fi).ClearS();
-		}
+		if(faceSelection.Size() != m->cm.face.size()) return false;
+		vcg::tri::UpdateSelection<CMeshO>::FaceFromBitSet(m->cm, faceSelection);
 	}
 	
 	if(changeMask & MeshModel::MM_VERTFLAGSELECT)
 	{
-		if(vertSelection.size() != m->cm.vert.size()) return false;
-		std::vector<bool>::iterator ci;
-		CMeshO::VertexIterator vi;
-		for(vi = m->cm.vert.begin(), ci = vertSelection.begin(); vi != m->cm.vert.end(); ++vi, ++ci)
-		{
-			if((*ci))
-				(*vi).SetS();
-			else
-				(*vi).ClearS();
-		}
+		if(vertSelection.Size() != m->cm.vert.size()) return false;
+		vcg::tri::UpdateSelection<CMeshO>::VertexFromBitSet(m->cm, vertSelection);
 	}
 	
 	
@@ -26,6 +26,7 @@
 
 #include <vector>
 #include "cmesh.h"
+#include <vcg/complex/algorithms/update/selection.h>
 
 class MeshModel;
 
@@ -54,8 +55,8 @@ private:
 	std::vector<Point3m> vertCoord;
 	std::vector<Point3m> vertNormal;
 	std::vector<Point3m> faceNormal;
-	std::vector<bool> faceSelection;
-	std::vector<bool> vertSelection;
+	vcg::tri::SelectionBitSet faceSelection;
+	vcg::tri::SelectionBitSet vertSelection;
 	Matrix44m Tr;
 	Shotm shot;
 };
@@ -0,0 +1,183 @@
+/****************************************************************************
+* MeshLab                                                           o o     *
+* A versatile mesh processing toolbox                             o     o   *
+*                                                                _   O  _   *
+* Copyright(C) 2005-2021                                           \/)\/    *
+* Visual Computing Lab                                            /\/|      *
+* ISTI - Italian National Research Council                           |      *
+*                                                                    \      *
+* All rights reserved.                                                      *
+*                                                                           *
+* This program is free software; you can redistribute it and/or modify      *
+* it under the terms of the GNU General Public License as published by      *
+* the Free Software Foundation; either version 2 of the License, or         *
+* (at your option) any later version.                                       *
+*                                                                           *
+* This program is distributed in the hope that it will be useful,           *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)          *
+* for more details.                                                         *
+*                                                                           *
+****************************************************************************/
+
+#include "ml_memory_accounting.h"
+
+#include "mlexception.h"
+#include "ml_document/mesh_document.h"
+
+#if defined(Q_OS_LINUX)
+#include <unistd.h>
+#include <stdio.h>
+#elif defined(Q_OS_MAC)
+#include <mach/mach.h>
+#endif
+
+MLMemoryAccounting::MLMemoryAccounting() :
+	budgetBytes(0),
+	documentBytes(0),
+	trackedBytes(0),
+	peakBytes(0),
+	peakResidentBytes(0)
+{
+}
+
+MLMemoryAccounting& MLMemoryAccounting::instance()
+{
+	static MLMemoryAccounting accounting;
+	return accounting;
+}
+
+void MLMemoryAccounting::setBudget(qint64 bytes)
+{
+	budgetBytes = bytes;
+}
+
+qint64 MLMemoryAccounting::budget() const
+{
+	return budgetBytes;
+}
+
+/**
+ * @brief Measures the memory used by the layers of the document: element
+ * containers, optional components, user attributes and decoded textures.
+ */
+void MLMemoryAccounting::updateDocumentMemory(const MeshDocument& md)
+{
+	qint64 bytes = 0;
+	for (const MeshModel* m : md.meshIterator())
+		bytes += m->memoryUsage();
+	documentBytes = bytes;
+	updatePeak(peakBytes, usedMemory());
+}
+
+qint64 MLMemoryAccounting::documentMemory() const
+{
+	return documentBytes;
+}
+
+void MLMemoryAccounting::acquiredMemory(qint64 bytes)
+{
+	trackedBytes += bytes;
+	updatePeak(peakBytes, usedMemory());
+}
+
+void MLMemoryAccounting::releasedMemory(qint64 bytes)
+{
+	trackedBytes -= bytes;
+}
+
+qint64 MLMemoryAccounting::trackedMemory() const
+{
+	return trackedBytes;
+}
+
+qint64 MLMemoryAccounting::usedMemory() const
+{
+	return documentBytes + trackedBytes;
+}
+
+bool MLMemoryAccounting::isAdditionalMemoryAvailable(qint64 bytes) const
+{
+	const qint64 b = budgetBytes;
+	return b <= 0 || usedMemory() + bytes <= b;
+}
+
+void MLMemoryAccounting::resetPeak()
+{
+	peakBytes = usedMemory();
+	peakResidentBytes = processResidentMemory();
+}
+
+qint64 MLMemoryAccounting::peakMemory() const
+{
+	return peakBytes;
+}
+
+/**
+ * @brief Updates the peak of the resident memory of the process. It is meant
+ * to be called often during long operations (e.g. from the progress callback).
+ */
+void MLMemoryAccounting::sampleResidentMemory()
+{
+	updatePeak(peakResidentBytes, processResidentMemory());
+}
+
+qint64 MLMemoryAccounting::peakResidentMemory() const
+{
+	return peakResidentBytes;
+}
+
+/**
+ * @brief Returns the resident memory of the process in bytes, or -1 where it
+ * cannot be read (currently everywhere but Linux and macOS).
+ */
+qint64 MLMemoryAccounting::processResidentMemory()
+{
+#if defined(Q_OS_LINUX)
+	FILE* fp = fopen("/proc/self/statm", "r");
+	if (fp == nullptr)
+		return -1;
+	long long size = 0, resident = 0;
+	const int n = fscanf(fp, "%lld %lld", &size, &resident);
+	fclose(fp);
+	if (n != 2)
+		return -1;
+	return qint64(resident) * sysconf(_SC_PAGESIZE);
+#elif defined(Q_OS_MAC)
+	mach_task_basic_info info;
+	mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+	if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t) &info, &count) != KERN_SUCCESS)
+		return -1;
+	return qint64(info.resident_size);
+#else
+	return -1;
+#endif
+}
+
+void MLMemoryAccounting::updatePeak(std::atomic<qint64>& peak, qint64 value)
+{
+	qint64 cur = peak;
+	while (value > cur && !peak.compare_exchange_weak(cur, value))
+		;
+}
+
+MLMemoryReservation::MLMemoryReservation(qint64 bytes, const QString& what) :
+	bytes(bytes)
+{
+	MLMemoryAccounting& acc = MLMemoryAccounting::instance();
+	if (!acc.isAdditionalMemoryAvailable(bytes)) {
+		throw MLException(
+			QString("Not enough memory for %1: %2 MB are needed, %3 MB of the %4 MB budget are already in use.")
+				.arg(what)
+				.arg(bytes / (1024 * 1024))
+				.arg(acc.usedMemory() / (1024 * 1024))
+				.arg(acc.budget() / (1024 * 1024)));
+	}
+	acc.acquiredMemory(bytes);
+}
+
+MLMemoryReservation::~MLMemoryReservation()
+{
+	MLMemoryAccounting::instance().releasedMemory(bytes);
+}
@@ -0,0 +1,100 @@
+/****************************************************************************
+* MeshLab                                                           o o     *
+* A versatile mesh processing toolbox                             o     o   *
+*                                                                _   O  _   *
+* Copyright(C) 2005-2021                                           \/)\/    *
+* Visual Computing Lab                                            /\/|      *
+* ISTI - Italian National Research Council                           |      *
+*                                                                    \      *
+* All rights reserved.                                                      *
+*                                                                           *
+* This program is free software; you can redistribute it and/or modify      *
+* it under the terms of the GNU General Public License as published by      *
+* the Free Software Foundation; either version 2 of the License, or         *
+* (at your option) any later version.                                       *
+*                                                                           *
+* This program is distributed in the hope that it will be useful,           *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)          *
+* for more details.                                                         *
+*                                                                           *
+****************************************************************************/
+
+#ifndef MESHLAB_MEMORY_ACCOUNTING_H
+#define MESHLAB_MEMORY_ACCOUNTING_H
+
+#include <QString>
+#include <atomic>
+
+class MeshDocument;
+
+/**
+ * @brief The MLMemoryAccounting class keeps track of the main memory used by
+ * the mesh data of the document and by the temporary buffers that filters
+ * declare, and checks it against an optional budget.
+ *
+ * The memory of the document is measured (see updateDocumentMemory) before
+ * and after each filter; temporaries are declared with acquiredMemory and
+ * releasedMemory, or with a MLMemoryReservation. The peak of the accounted
+ * memory is kept since the last resetPeak, together with the peak of the
+ * resident memory of the process sampled by sampleResidentMemory.
+ *
+ * All the member functions can be called from any thread.
+ */
+class MLMemoryAccounting
+{
+public:
+	static MLMemoryAccounting& instance();
+
+	/// budget in bytes for the accounted memory; 0 (the default) means no limit
+	void setBudget(qint64 bytes);
+	qint64 budget() const;
+
+	void updateDocumentMemory(const MeshDocument& md);
+	qint64 documentMemory() const;
+
+	void acquiredMemory(qint64 bytes);
+	void releasedMemory(qint64 bytes);
+	qint64 trackedMemory() const;
+
+	qint64 usedMemory() const;
+	bool isAdditionalMemoryAvailable(qint64 bytes) const;
+
+	void resetPeak();
+	qint64 peakMemory() const;
+	void sampleResidentMemory();
+	qint64 peakResidentMemory() const;
+
+	static qint64 processResidentMemory();
+
+private:
+	MLMemoryAccounting();
+	void updatePeak(std::atomic<qint64>& peak, qint64 value);
+
+	std::atomic<qint64> budgetBytes;
+	std::atomic<qint64> documentBytes;
+	std::atomic<qint64> trackedBytes;
+	std::atomic<qint64> peakBytes;
+	std::atomic<qint64> peakResidentBytes;
+};
+
+/**
+ * @brief Declares a temporary allocation of a given size for the lifetime of
+ * the object. The constructor throws a MLException if the memory budget
+ * does not allow it.
+ */
+class MLMemoryReservation
+{
+public:
+	MLMemoryReservation(qint64 bytes, const QString& what);
+	~MLMemoryReservation();
+
+	MLMemoryReservation(const MLMemoryReservation&) = delete;
+	MLMemoryReservation& operator=(const MLMemoryReservation&) = delete;
+
+private:
+	qint64 bytes;
+};
+
+#endif // MESHLAB_MEMORY_ACCOUNTING_H
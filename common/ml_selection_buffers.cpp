@@ -1,5 +1,8 @@
 #include "ml_selection_buffers.h"
 
+#include <vcg/complex/algorithms/update/selection.h>
+#include <wrap/system/parallel.h>
+
 MLSelectionBuffers::MLSelectionBuffers(MeshModel& m,unsigned int primitivebatch)
 	:_lock(),_m(m),_primitivebatch(primitivebatch),_selmap(2)
 {
@@ -50,36 +53,35 @@ void MLSelectionBuffers::updateBuffer(ML_SELECTION_TYPE selbuf)
 	
 
 
+	// the selected elements are collected from a packed copy of the selection flags,
+	// then each chunk of positions is filled in parallel and uploaded in order
+	vcg::tri::SelectionBitSet selbits;
+	std::vector<unsigned int> selidx;
+
 	if (selbuf == ML_PERFACE_SEL)
 	{
-		size_t selectedperchunk = 0;
+		vcg::tri::UpdateSelection<CMeshO>::FaceToBitSet(_m.cm, selbits);
+		selbits.Indices(selidx);
+		_m.cm.sfn = int(selidx.size());
+
 		std::vector<vcg::Point3f> rpv;
 		rpv.resize(privchunksize * 3);
-
-		for (CFaceO& ff: _m.cm.face)
-		{			
-			size_t chunkindex = _m.cm.sfn % privchunksize;
-			if (!ff.IsD() && ff.IsS())
-			{	
-				rpv[chunkindex * 3 + 0].Import(ff.V(0)->P());
-				rpv[chunkindex * 3 + 1].Import(ff.V(1)->P());
-				rpv[chunkindex * 3 + 2].Import(ff.V(2)->P());
-				
-				++_m.cm.sfn;
-				++selectedperchunk;
-			}
-
-			if (((&ff == &_m.cm.face.back()) && (selectedperchunk > 0)) || 
-                ((chunkindex == privchunksize - 1) && (selectedperchunk == privchunksize)) )
-			{
-				_selmap[ML_PERFACE_SEL].push_back(0);
-				glGenBuffers(1, &(_selmap[ML_PERFACE_SEL][_selmap[ML_PERFACE_SEL].size() - 1]));
-
-				glBindBuffer(GL_ARRAY_BUFFER, _selmap[ML_PERFACE_SEL][_selmap[ML_PERFACE_SEL].size() - 1]);
-				glBufferData(GL_ARRAY_BUFFER,3 * 3 * 4 * selectedperchunk, &rpv[0],GL_DYNAMIC_DRAW);
-				glBindBuffer(GL_ARRAY_BUFFER, 0);
-				selectedperchunk = 0;
-			}
+		for (size_t chunkbegin = 0; chunkbegin < selidx.size(); chunkbegin += privchunksize)
+		{
+			const int selectedperchunk = int(std::min(privchunksize, selidx.size() - chunkbegin));
+			vcg::parallel::For(selectedperchunk, [&](int ii) {
+				const CFaceO& ff = _m.cm.face[selidx[chunkbegin + ii]];
+				rpv[ii * 3 + 0].Import(ff.cV(0)->cP());
+				rpv[ii * 3 + 1].Import(ff.cV(1)->cP());
+				rpv[ii * 3 + 2].Import(ff.cV(2)->cP());
+			});
+
+			_selmap[ML_PERFACE_SEL].push_back(0);
+			glGenBuffers(1, &(_selmap[ML_PERFACE_SEL][_selmap[ML_PERFACE_SEL].size() - 1]));
+
+			glBindBuffer(GL_ARRAY_BUFFER, _selmap[ML_PERFACE_SEL][_selmap[ML_PERFACE_SEL].size() - 1]);
+			glBufferData(GL_ARRAY_BUFFER,3 * 3 * 4 * selectedperchunk, &rpv[0],GL_DYNAMIC_DRAW);
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
 		}
 
 		rpv.clear();
@@ -87,32 +89,26 @@ void MLSelectionBuffers::updateBuffer(ML_SELECTION_TYPE selbuf)
 
 	if (selbuf == ML_PERVERT_SEL)
 	{
-		size_t selectedperchunk = 0;
+		vcg::tri::UpdateSelection<CMeshO>::VertexToBitSet(_m.cm, selbits);
+		selbits.Indices(selidx);
+		_m.cm.svn = int(selidx.size());
+
 		std::vector<vcg::Point3f> rpv;
 		rpv.resize(privchunksize);
-		_m.cm.svn = 0;
-
-		for (CVertexO& vv : _m.cm.vert)
+		for (size_t chunkbegin = 0; chunkbegin < selidx.size(); chunkbegin += privchunksize)
 		{
-			size_t chunkindex = _m.cm.svn % privchunksize;
-			if (!vv.IsD() && vv.IsS())
-			{
-				rpv[chunkindex].Import(vv.cP());
-				++_m.cm.svn;
-				++selectedperchunk;
-			}
-			if (((&vv ==  &_m.cm.vert.back()) && (selectedperchunk > 0)) ||
-                ((chunkindex == privchunksize - 1) && (selectedperchunk == privchunksize)))
-			{
-				_selmap[ML_PERVERT_SEL].push_back(0);
-
-				glGenBuffers(1, &(_selmap[ML_PERVERT_SEL][_selmap[ML_PERVERT_SEL].size() - 1]));
-
-				glBindBuffer(GL_ARRAY_BUFFER, _selmap[ML_PERVERT_SEL][_selmap[selbuf].size() - 1]);
-				glBufferData(GL_ARRAY_BUFFER, sizeof(vcg::Point3f) * selectedperchunk, &(rpv[0]), GL_DYNAMIC_DRAW);
-				glBindBuffer(GL_ARRAY_BUFFER, 0);
-				selectedperchunk = 0;
-			}
+			const int selectedperchunk = int(std::min(privchunksize, selidx.size() - chunkbegin));
+			vcg::parallel::For(selectedperchunk, [&](int ii) {
+				rpv[ii].Import(_m.cm.vert[selidx[chunkbegin + ii]].cP());
+			});
+
+			_selmap[ML_PERVERT_SEL].push_back(0);
+
+			glGenBuffers(1, &(_selmap[ML_PERVERT_SEL][_selmap[ML_PERVERT_SEL].size() - 1]));
+
+			glBindBuffer(GL_ARRAY_BUFFER, _selmap[ML_PERVERT_SEL][_selmap[selbuf].size() - 1]);
+			glBufferData(GL_ARRAY_BUFFER, sizeof(vcg::Point3f) * selectedperchunk, &(rpv[0]), GL_DYNAMIC_DRAW);
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
 		}
 
 		rpv.clear();
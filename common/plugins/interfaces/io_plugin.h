@@ -164,6 +164,24 @@ public:
 			const RichParameterList & par,
 			vcg::CallBackPos *cb = nullptr) = 0;
 
+	/**
+	 * @brief The supportsConcurrentOpen function returns true if the open
+	 * function of the given format can be called at the same time from more
+	 * threads, each one loading a different file into different MeshModels.
+	 * This is used by the framework to load the meshes of a project in
+	 * parallel.
+	 * To return true, the open function of the format must not rely on the
+	 * current working directory, must not use any static or shared state and
+	 * must not log or report warnings (the framework will call it with a null
+	 * callback).
+	 * The default implementation returns false: files of the format will be
+	 * loaded one at a time.
+	 */
+	virtual bool supportsConcurrentOpen(const QString& /*format*/) const
+	{
+		return false;
+	}
+
 	/***********************
 	 * Save Mesh Functions *
 	 ***********************/
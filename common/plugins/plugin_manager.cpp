@@ -26,6 +26,8 @@
 #include <QObject>
 #include <QDir>
 #include <QApplication>
+#include <QMutexLocker>
+#include <QThread>
 
 #include <vcg/complex/algorithms/create/platonic.h>
 
@@ -133,13 +135,15 @@ MeshLabPluginType PluginManager::checkPlugin(const QString& filename)
  * 
  * If at least one plugin fails to be loaded, a MLException is thrown.
  * In any case, all the other valid plugins contained in the directory are loaded.
+ *
+ * If lazy is true, see loadPlugins(QDir, bool).
  */
-void PluginManager::loadPlugins()
+void PluginManager::loadPlugins(bool lazy)
 {
 	// without adding the correct library path in the mac the loading of jpg (done via qt plugins) fails
 	// ToDo: get rid of any qApp here
 	qApp->addLibraryPath(meshlab::defaultPluginPath());
-	loadPlugins(QDir(meshlab::defaultPluginPath()));
+	loadPlugins(QDir(meshlab::defaultPluginPath()), lazy);
 }
 
 /**
@@ -147,9 +151,23 @@ void PluginManager::loadPlugins()
  * 
  * If at least one plugin fails to be loaded, a MLException is thrown.
  * In any case, all the other valid plugins contained in the directory are loaded.
+ *
+ * If lazy is true, the libraries that are described by an up to date entry
+ * of the plugin manifest are not loaded: they are loaded the first time one
+ * of their filters, decorations or file formats is requested, or when the
+ * plugins are iterated. The other libraries are loaded and added to the
+ * manifest, that is saved for the next run. The manifest is not read nor
+ * written as long as the plugins are loaded only eagerly.
+ *
+ * Pending plugins can be loaded by lookups made from any thread.
  */
-void PluginManager::loadPlugins(QDir pluginsDirectory)
+void PluginManager::loadPlugins(QDir pluginsDirectory, bool lazy)
 {
+	QMutexLocker locker(&pluginsMutex);
+	if (lazy && manifestFile.isEmpty()) {
+		manifestFile = PluginManifest::defaultManifestFile();
+		manifest.load(manifestFile);
+	}
 	if (pluginsDirectory.exists()){
 		QStringList nameFiltersPlugins = fileNamePluginDLLs();
 		
@@ -159,13 +177,25 @@ void PluginManager::loadPlugins(QDir pluginsDirectory)
 		//qDebug("Current Plugins Dir is: %s ", qUtf8Printable(pluginsDirectory.absolutePath()));
 		std::list<std::pair<QString, QString>> errors;
 		for(QString fileName : pluginsDirectory.entryList(QDir::Files)) {
+			QFileInfo fin(pluginsDirectory.absoluteFilePath(fileName));
+			const PluginManifest::Entry* entry = lazy ? manifest.find(fin) : nullptr;
+			if (entry && pluginFiles.find(fin.absoluteFilePath()) == pluginFiles.end()) {
+				bool alreadyPending = false;
+				for (const PluginManifest::Entry& e : pendingPlugins)
+					alreadyPending = alreadyPending || e.fileName == entry->fileName;
+				if (!alreadyPending)
+					pendingPlugins.push_back(*entry);
+				continue;
+			}
 			try {
-				loadPlugin(pluginsDirectory.absoluteFilePath(fileName));
+				loadPluginFile(fin.absoluteFilePath());
 			}
 			catch(const MLException& e){
 				errors.push_back(std::make_pair(fileName, e.what()));
 			}
 		}
+		if (manifest.isModified())
+			manifest.save(manifestFile);
 		if (errors.size() > 0){
 			QString singleError = "Unable to load the following plugins:\n\n";
 			for (const auto& p : errors){
@@ -176,6 +206,36 @@ void PluginManager::loadPlugins(QDir pluginsDirectory)
 	}
 }
 
+/**
+ * @brief Loads all the plugins that have been left pending by a lazy loadPlugins.
+ *
+ * If at least one plugin fails to be loaded, a MLException is thrown.
+ * In any case, all the other valid plugins are loaded.
+ */
+void PluginManager::loadPendingPlugins()
+{
+	QMutexLocker locker(&pluginsMutex);
+	std::list<std::pair<QString, QString>> errors;
+	while (!pendingPlugins.empty()) {
+		QString fileName = pendingPlugins.front().fileName;
+		try {
+			loadPluginFile(fileName);
+		}
+		catch(const MLException& e){
+			errors.push_back(std::make_pair(QFileInfo(fileName).fileName(), e.what()));
+		}
+	}
+	if (manifest.isModified())
+		manifest.save(manifestFile);
+	if (errors.size() > 0){
+		QString singleError = "Unable to load the following plugins:\n\n";
+		for (const auto& p : errors){
+			singleError += "\t" + p.first + ": " + p.second + "\n";
+		}
+		throw MLException(singleError);
+	}
+}
+
 /**
  * @brief Loads the plugin specified in the given file and adds the plugin into the
  * PluginManager.
@@ -185,18 +245,53 @@ void PluginManager::loadPlugins(QDir pluginsDirectory)
  * Throws a MLException if the load of the plugin fails.
  */
 MeshLabPlugin* PluginManager::loadPlugin(const QString& fileName)
+{
+	QMutexLocker locker(&pluginsMutex);
+	return loadPluginFile(fileName);
+}
+
+/**
+ * @brief Implementation of loadPlugin, called with pluginsMutex locked.
+ */
+MeshLabPlugin* PluginManager::loadPluginFile(const QString& fileName)
 {
 	QFileInfo fin(fileName);
+
+	//the plugin is not pending anymore, even if its load fails
+	bool wasPending = false;
+	for (auto it = pendingPlugins.begin(); it != pendingPlugins.end(); ++it) {
+		if (it->fileName == fin.absoluteFilePath()) {
+			pendingPlugins.erase(it);
+			wasPending = true;
+			break;
+		}
+	}
+
 	if (pluginFiles.find(fin.absoluteFilePath()) != pluginFiles.end())
 		throw MLException(fin.fileName() + " has been already loaded.");
 
-	checkPlugin(fileName);
+	try {
+		checkPlugin(fileName);
+	}
+	catch(const MLException&){
+		manifest.remove(fin.absoluteFilePath());
+		throw;
+	}
 
 	//load the plugin depending on the type (can be more than one type!)
 	QPluginLoader* loader = new QPluginLoader(fin.absoluteFilePath());
 	QObject *plugin = loader->instance();
 	MeshLabPlugin* ifp = dynamic_cast<MeshLabPlugin *>(plugin);
 	MeshLabPluginType type(ifp);
+
+	//a pending plugin can be loaded by a lookup made from a worker thread:
+	//its objects (and their children, e.g. the filter actions) must live in
+	//the main thread, as the ones of the plugins loaded at startup
+	QThread* mainThread = qApp != nullptr ? qApp->thread() : nullptr;
+	if (mainThread != nullptr && plugin->thread() != mainThread) {
+		plugin->moveToThread(mainThread);
+		loader->moveToThread(mainThread);
+	}
 	
 	if (type.isDecoratePlugin()){
 		decoratePlugins.pushDecoratePlugin(qobject_cast<DecoratePlugin *>(plugin));
@@ -220,11 +315,20 @@ MeshLabPlugin* PluginManager::loadPlugin(const QString& fileName)
 	allPlugins.push_back(ifp);
 	allPluginLoaders.push_back(loader);
 	pluginFiles.insert(fin.absoluteFilePath());
+
+	//an entry with the same mtime could still describe a different build:
+	//when the library has been loaded because of its entry, check its hash
+	if (!manifestFile.isEmpty()) {
+		const PluginManifest::Entry* entry = manifest.find(fin);
+		if (!entry || (wasPending && entry->hash != PluginManifest::fileHash(fin.absoluteFilePath())))
+			manifest.insert(PluginManifest::entryFromPlugin(ifp, fin));
+	}
 	return ifp;
 }
 
 void PluginManager::unloadPlugin(MeshLabPlugin* ifp)
 {
+	QMutexLocker locker(&pluginsMutex);
 	auto it = std::find(allPlugins.begin(), allPlugins.end(), ifp);
 	if (it != allPlugins.end()){
 		unsigned int index = it - allPlugins.begin();
@@ -272,113 +376,167 @@ void PluginManager::disablePlugin(MeshLabPlugin* ifp)
 
 unsigned int PluginManager::size() const
 {
+	QMutexLocker locker(&pluginsMutex);
+	loadAllPendingPlugins();
 	return allPlugins.size();
 }
 
 int PluginManager::numberIOPlugins() const
 {
+	QMutexLocker locker(&pluginsMutex);
+	loadAllPendingPlugins();
 	return ioPlugins.size();
 }
 
 // Search among all the decorator plugins the one that contains a decoration with the given name
 DecoratePlugin *PluginManager::getDecoratePlugin(const QString& name)
 {
-	return decoratePlugins.decoratePlugin(name);
+	QMutexLocker locker(&pluginsMutex);
+	DecoratePlugin* dp = decoratePlugins.decoratePlugin(name);
+	if (!dp && loadPendingPlugin([&](const PluginManifest::Entry& e){ return e.decorations.contains(name); }))
+		dp = decoratePlugins.decoratePlugin(name);
+	return dp;
 }
 
 QAction* PluginManager::filterAction(const QString& name)
 {
-	return filterPlugins.filterAction(name);
+	QMutexLocker locker(&pluginsMutex);
+	QAction* act = filterPlugins.filterAction(name);
+	if (!act && loadPendingPlugin([&](const PluginManifest::Entry& e){ return e.hasFilter(name); }))
+		act = filterPlugins.filterAction(name);
+	return act;
 }
 
 IOPlugin* PluginManager::inputMeshPlugin(const QString& inputFormat) const
 {
-	return ioPlugins.inputMeshPlugin(inputFormat);
+	QMutexLocker locker(&pluginsMutex);
+	IOPlugin* iop = ioPlugins.inputMeshPlugin(inputFormat);
+	if (!iop && loadPendingPlugin([&](const PluginManifest::Entry& e){ return e.inputMeshFormats.contains(inputFormat.toLower()); }))
+		iop = ioPlugins.inputMeshPlugin(inputFormat);
+	return iop;
 }
 
 IOPlugin* PluginManager::outputMeshPlugin(const QString& outputFormat) const
 {
-	return ioPlugins.outputMeshPlugin(outputFormat);
+	QMutexLocker locker(&pluginsMutex);
+	IOPlugin* iop = ioPlugins.outputMeshPlugin(outputFormat);
+	if (!iop && loadPendingPlugin([&](const PluginManifest::Entry& e){ return e.outputMeshFormats.contains(outputFormat.toLower()); }))
+		iop = ioPlugins.outputMeshPlugin(outputFormat);
+	return iop;
 }
 
 IOPlugin* PluginManager::inputImagePlugin(const QString inputFormat) const
 {
-	return ioPlugins.inputImagePlugin(inputFormat);
+	QMutexLocker locker(&pluginsMutex);
+	IOPlugin* iop = ioPlugins.inputImagePlugin(inputFormat);
+	if (!iop && loadPendingPlugin([&](const PluginManifest::Entry& e){ return e.inputImageFormats.contains(inputFormat.toLower()); }))
+		iop = ioPlugins.inputImagePlugin(inputFormat);
+	return iop;
 }
 
 IOPlugin* PluginManager::outputImagePlugin(const QString& outputFormat) const
 {
-	return ioPlugins.outputImagePlugin(outputFormat);
+	QMutexLocker locker(&pluginsMutex);
+	IOPlugin* iop = ioPlugins.outputImagePlugin(outputFormat);
+	if (!iop && loadPendingPlugin([&](const PluginManifest::Entry& e){ return e.outputImageFormats.contains(outputFormat.toLower()); }))
+		iop = ioPlugins.outputImagePlugin(outputFormat);
+	return iop;
 }
 
 IOPlugin* PluginManager::inputProjectPlugin(const QString& inputFormat) const
 {
-	return ioPlugins.inputProjectPlugin(inputFormat);
+	QMutexLocker locker(&pluginsMutex);
+	IOPlugin* iop = ioPlugins.inputProjectPlugin(inputFormat);
+	if (!iop && loadPendingPlugin([&](const PluginManifest::Entry& e){ return e.inputProjectFormats.contains(inputFormat.toLower()); }))
+		iop = ioPlugins.inputProjectPlugin(inputFormat);
+	return iop;
 }
 
 IOPlugin* PluginManager::outputProjectPlugin(const QString& outputFormat) const
 {
-	return ioPlugins.outputProjectPlugin(outputFormat);
+	QMutexLocker locker(&pluginsMutex);
+	IOPlugin* iop = ioPlugins.outputProjectPlugin(outputFormat);
+	if (!iop && loadPendingPlugin([&](const PluginManifest::Entry& e){ return e.outputProjectFormats.contains(outputFormat.toLower()); }))
+		iop = ioPlugins.outputProjectPlugin(outputFormat);
+	return iop;
 }
 
 bool PluginManager::isInputMeshFormatSupported(const QString inputFormat) const
 {
-	return ioPlugins.isInputMeshFormatSupported(inputFormat);
+	QMutexLocker locker(&pluginsMutex);
+	return ioPlugins.isInputMeshFormatSupported(inputFormat) ||
+			pendingFormatList(QStringList(), &PluginManifest::Entry::inputMeshFormats).contains(inputFormat.toLower());
 }
 
 bool PluginManager::isOutputMeshFormatSupported(const QString outputFormat) const
 {
-	return ioPlugins.isOutputMeshFormatSupported(outputFormat);
+	QMutexLocker locker(&pluginsMutex);
+	return ioPlugins.isOutputMeshFormatSupported(outputFormat) ||
+			pendingFormatList(QStringList(), &PluginManifest::Entry::outputMeshFormats).contains(outputFormat.toLower());
 }
 
 bool PluginManager::isInputImageFormatSupported(const QString inputFormat) const
 {
-	return ioPlugins.isInputImageFormatSupported(inputFormat);
+	QMutexLocker locker(&pluginsMutex);
+	return ioPlugins.isInputImageFormatSupported(inputFormat) ||
+			pendingFormatList(QStringList(), &PluginManifest::Entry::inputImageFormats).contains(inputFormat.toLower());
 }
 
 bool PluginManager::isOutputImageFormatSupported(const QString outputFormat) const
 {
-	return ioPlugins.isOutputImageFormatSupported(outputFormat);
+	QMutexLocker locker(&pluginsMutex);
+	return ioPlugins.isOutputImageFormatSupported(outputFormat) ||
+			pendingFormatList(QStringList(), &PluginManifest::Entry::outputImageFormats).contains(outputFormat.toLower());
 }
 
 bool PluginManager::isInputProjectFormatSupported(const QString inputFormat) const
 {
-	return ioPlugins.isInputProjectFormatSupported(inputFormat);
+	QMutexLocker locker(&pluginsMutex);
+	return ioPlugins.isInputProjectFormatSupported(inputFormat) ||
+			pendingFormatList(QStringList(), &PluginManifest::Entry::inputProjectFormats).contains(inputFormat.toLower());
 }
 
 bool PluginManager::isOutputProjectFormatSupported(const QString outputFormat) const
 {
-	return ioPlugins.isOutputProjectFormatSupported(outputFormat);
+	QMutexLocker locker(&pluginsMutex);
+	return ioPlugins.isOutputProjectFormatSupported(outputFormat) ||
+			pendingFormatList(QStringList(), &PluginManifest::Entry::outputProjectFormats).contains(outputFormat.toLower());
 }
 
 QStringList PluginManager::inputMeshFormatList() const
 {
-	return ioPlugins.inputMeshFormatList();
+	QMutexLocker locker(&pluginsMutex);
+	return pendingFormatList(ioPlugins.inputMeshFormatList(), &PluginManifest::Entry::inputMeshFormats);
 }
 
 QStringList PluginManager::outputMeshFormatList() const
 {
-	return ioPlugins.outputMeshFormatList();
+	QMutexLocker locker(&pluginsMutex);
+	return pendingFormatList(ioPlugins.outputMeshFormatList(), &PluginManifest::Entry::outputMeshFormats);
 }
 
 QStringList PluginManager::inputImageFormatList() const
 {
-	return ioPlugins.inputImageFormatList();
+	QMutexLocker locker(&pluginsMutex);
+	return pendingFormatList(ioPlugins.inputImageFormatList(), &PluginManifest::Entry::inputImageFormats);
 }
 
 QStringList PluginManager::outputImageFormatList() const
 {
-	return ioPlugins.outputImageFormatList();
+	QMutexLocker locker(&pluginsMutex);
+	return pendingFormatList(ioPlugins.outputImageFormatList(), &PluginManifest::Entry::outputImageFormats);
 }
 
 QStringList PluginManager::inputProjectFormatList() const
 {
-	return ioPlugins.inputProjectFormatList();
+	QMutexLocker locker(&pluginsMutex);
+	return pendingFormatList(ioPlugins.inputProjectFormatList(), &PluginManifest::Entry::inputProjectFormats);
 }
 
 QStringList PluginManager::outputProjectFormatList() const
 {
-	return ioPlugins.outputProjectFormatList();
+	QMutexLocker locker(&pluginsMutex);
+	return pendingFormatList(ioPlugins.outputProjectFormatList(), &PluginManifest::Entry::outputProjectFormats);
 }
 
 QStringList PluginManager::inputMeshFormatListDialog() const
@@ -408,36 +566,50 @@ QStringList PluginManager::outputProjectFormatListDialog() const
 
 MeshLabPlugin* PluginManager::operator[](unsigned int i) const
 {
+	QMutexLocker locker(&pluginsMutex);
+	loadAllPendingPlugins();
 	return allPlugins[i];
 }
 
 PluginManager::PluginRangeIterator PluginManager::pluginIterator(bool iterateAlsoDisabledPlugins) const
 {
+	QMutexLocker locker(&pluginsMutex);
+	loadAllPendingPlugins();
 	return PluginRangeIterator(this, iterateAlsoDisabledPlugins);
 }
 
 FilterPluginContainer::FilterPluginRangeIterator PluginManager::filterPluginIterator(bool iterateAlsoDisabledPlugins) const
 {
+	QMutexLocker locker(&pluginsMutex);
+	loadAllPendingPlugins();
 	return filterPlugins.filterPluginIterator(iterateAlsoDisabledPlugins);
 }
 
 IOPluginContainer::IOPluginRangeIterator PluginManager::ioPluginIterator(bool iterateAlsoDisabledPlugins) const
 {
+	QMutexLocker locker(&pluginsMutex);
+	loadAllPendingPlugins();
 	return ioPlugins.ioPluginIterator(iterateAlsoDisabledPlugins);
 }
 
 RenderPluginContainer::RenderPluginRangeIterator PluginManager::renderPluginIterator(bool iterateAlsoDisabledPlugins) const
 {
+	QMutexLocker locker(&pluginsMutex);
+	loadAllPendingPlugins();
 	return renderPlugins.renderPluginIterator(iterateAlsoDisabledPlugins);
 }
 
 DecoratePluginContainer::DecoratePluginRangeIterator PluginManager::decoratePluginIterator(bool iterateAlsoDisabledPlugins) const
 {
+	QMutexLocker locker(&pluginsMutex);
+	loadAllPendingPlugins();
 	return decoratePlugins.decoratePluginIterator(iterateAlsoDisabledPlugins);
 }
 
 EditPluginContainer::EditPluginFactoryRangeIterator PluginManager::editPluginFactoryIterator(bool iterateAlsoDisabledPlugins) const
 {
+	QMutexLocker locker(&pluginsMutex);
+	loadAllPendingPlugins();
 	return editPlugins.editPluginIterator(iterateAlsoDisabledPlugins);
 }
 
@@ -462,6 +634,58 @@ void PluginManager::checkFilterPlugin(FilterPlugin* iFilter)
 	}
 }
 
+/**
+ * @brief Loads the first pending plugin whose manifest entry satisfies isWanted.
+ * Returns nullptr if there is no such plugin or its load fails.
+ *
+ * Lookups are const member functions: loading a pending plugin does not
+ * change what they return with respect to a PluginManager that loaded all
+ * the plugins at startup.
+ * Must be called with pluginsMutex locked.
+ */
+template <typename Predicate>
+MeshLabPlugin* PluginManager::loadPendingPlugin(Predicate isWanted) const
+{
+	PluginManager* pm = const_cast<PluginManager*>(this);
+	auto it = std::find_if(pm->pendingPlugins.begin(), pm->pendingPlugins.end(), isWanted);
+	if (it == pm->pendingPlugins.end())
+		return nullptr;
+	QString fileName = it->fileName;
+	MeshLabPlugin* ifp = nullptr;
+	try {
+		ifp = pm->loadPluginFile(fileName);
+	}
+	catch(const MLException& e){
+		qDebug("Unable to load %s: %s", qUtf8Printable(fileName), e.what());
+	}
+	if (pm->manifest.isModified())
+		pm->manifest.save(manifestFile);
+	return ifp;
+}
+
+void PluginManager::loadAllPendingPlugins() const
+{
+	while (!pendingPlugins.empty())
+		loadPendingPlugin([](const PluginManifest::Entry&){ return true; });
+}
+
+/**
+ * @brief Returns the given list of formats of the loaded plugins, extended with
+ * the formats of the pending plugins.
+ */
+template <typename Member>
+QStringList PluginManager::pendingFormatList(QStringList loadedFormats, Member formats) const
+{
+	if (pendingPlugins.empty())
+		return loadedFormats;
+	for (const PluginManifest::Entry& e : pendingPlugins)
+		for (const QString& f : e.*formats)
+			if (!loadedFormats.contains(f))
+				loadedFormats.push_back(f);
+	loadedFormats.sort();
+	return loadedFormats;
+}
+
 template<typename RangeIterator>
 QStringList PluginManager::inputFormatListDialog(RangeIterator iterator)
 {
@@ -30,12 +30,18 @@
 #include "containers/io_plugin_container.h"
 #include "containers/render_plugin_container.h"
 #include "meshlab_plugin_type.h"
+#include "plugin_manifest.h"
 
 #include <QPluginLoader>
 #include <QObject>
+#include <QMutex>
 
 /**
  * @brief The PluginManager class provides the basic tools for managing all the plugins.
+ *
+ * Lookups and iterators can be used from any thread, also when they load
+ * pending plugins (see loadPlugins(QDir, bool)). Loading or unloading plugins
+ * explicitly must not overlap with iterations made by other threads.
  */
 class PluginManager
 {
@@ -48,8 +54,9 @@ public:
 	/** Member functions **/
 	static MeshLabPluginType checkPlugin(const QString& filename);
 
-	void loadPlugins();
-	void loadPlugins(QDir pluginsDirectory);
+	void loadPlugins(bool lazy = false);
+	void loadPlugins(QDir pluginsDirectory, bool lazy = false);
+	void loadPendingPlugins();
 	MeshLabPlugin* loadPlugin(const QString& filename);
 	void unloadPlugin(MeshLabPlugin* ifp);
 
@@ -103,6 +110,16 @@ private:
 	std::vector<QPluginLoader*> allPluginLoaders;
 	std::set<QString> pluginFiles; //used to check if a plugin file has been already loaded
 
+	//plugins described by the manifest and not loaded yet (lazy loading),
+	//in the order in which they have been found
+	PluginManifest manifest;
+	QString manifestFile;
+	std::vector<PluginManifest::Entry> pendingPlugins;
+
+	//guards the pending plugins, the manifest and the plugin containers
+	//while they are changed by loading a plugin
+	mutable QMutex pluginsMutex;
+
 	//Plugin containers: used for better organization of each type of plugin
 	// note: these containers do not own any plugin. Plugins are owned by the PluginManager
 	IOPluginContainer ioPlugins;
@@ -113,6 +130,14 @@ private:
 
 	static void checkFilterPlugin(FilterPlugin* iFilter);
 
+	MeshLabPlugin* loadPluginFile(const QString& filename);
+
+	template <typename Predicate>
+	MeshLabPlugin* loadPendingPlugin(Predicate isWanted) const;
+	void loadAllPendingPlugins() const;
+	template <typename Member>
+	QStringList pendingFormatList(QStringList loadedFormats, Member formats) const;
+
 	template <typename RangeIterator>
 	static QStringList inputFormatListDialog(RangeIterator iterator);
 
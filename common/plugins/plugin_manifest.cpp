@@ -0,0 +1,272 @@
+/****************************************************************************
+* MeshLab                                                           o o     *
+* A versatile mesh processing toolbox                             o     o   *
+*                                                                _   O  _   *
+* Copyright(C) 2005-2021                                           \/)\/    *
+* Visual Computing Lab                                            /\/|      *
+* ISTI - Italian National Research Council                           |      *
+*                                                                    \      *
+* All rights reserved.                                                      *
+*                                                                           *
+* This program is free software; you can redistribute it and/or modify      *
+* it under the terms of the GNU General Public License as published by      *
+* the Free Software Foundation; either version 2 of the License, or         *
+* (at your option) any later version.                                       *
+*                                                                           *
+* This program is distributed in the hope that it will be useful,           *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)          *
+* for more details.                                                         *
+*                                                                           *
+****************************************************************************/
+
+
+#include "plugin_manifest.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include "interfaces/decorate_plugin.h"
+#include "interfaces/filter_plugin.h"
+#include "interfaces/io_plugin.h"
+#include "../globals.h"
+
+static QStringList extensionList(const std::list<FileFormat>& formats)
+{
+	QStringList l;
+	for (const FileFormat& ff : formats)
+		for (const QString& ext : ff.extensions)
+			l.push_back(ext.toLower());
+	return l;
+}
+
+static QJsonArray toJson(const QStringList& l)
+{
+	return QJsonArray::fromStringList(l);
+}
+
+static QStringList fromJson(const QJsonValue& v)
+{
+	QStringList l;
+	for (const QJsonValue& s : v.toArray())
+		l.push_back(s.toString());
+	return l;
+}
+
+static QString manifestVersion()
+{
+	return QString::fromStdString(meshlab::meshlabVersion()) +
+			(meshlab::builtWithDoublePrecision() ? "d" : "");
+}
+
+bool PluginManifest::Entry::matches(const QFileInfo& library) const
+{
+	return library.absoluteFilePath() == fileName &&
+			library.size() == size &&
+			library.lastModified().toMSecsSinceEpoch() == lastModified;
+}
+
+bool PluginManifest::Entry::hasFilter(const QString& name) const
+{
+	for (const FilterInfo& f : filters)
+		if (f.name == name)
+			return true;
+	return false;
+}
+
+PluginManifest::PluginManifest() : modified(false)
+{
+}
+
+QString PluginManifest::defaultManifestFile()
+{
+	QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+	if (cacheDir.isEmpty())
+		return QString();
+	return cacheDir + "/plugin_manifest.json";
+}
+
+QByteArray PluginManifest::fileHash(const QString& fileName)
+{
+	QFile f(fileName);
+	QCryptographicHash h(QCryptographicHash::Sha1);
+	if (f.open(QIODevice::ReadOnly))
+		h.addData(&f);
+	return h.result().toHex();
+}
+
+PluginManifest::Entry PluginManifest::entryFromPlugin(MeshLabPlugin* plugin, const QFileInfo& library)
+{
+	Entry e;
+	e.fileName = library.absoluteFilePath();
+	e.size = library.size();
+	e.lastModified = library.lastModified().toMSecsSinceEpoch();
+	e.hash = fileHash(e.fileName);
+	e.pluginName = plugin->pluginName();
+
+	FilterPlugin* fp = dynamic_cast<FilterPlugin*>(plugin);
+	if (fp) {
+		for (QAction* act : fp->actions()) {
+			FilterInfo fi;
+			fi.name = act->text();
+			fi.pythonName = fp->pythonFilterName(act);
+			fi.filterClass = fp->getClass(act);
+			fi.requirements = fp->getRequirements(act);
+			fi.preConditions = fp->getPreConditions(act);
+			e.filters.push_back(fi);
+		}
+	}
+	DecoratePlugin* dp = dynamic_cast<DecoratePlugin*>(plugin);
+	if (dp) {
+		for (QAction* act : dp->actions())
+			e.decorations.push_back(dp->decorationName(act));
+	}
+	IOPlugin* iop = dynamic_cast<IOPlugin*>(plugin);
+	if (iop) {
+		e.inputMeshFormats = extensionList(iop->importFormats());
+		e.outputMeshFormats = extensionList(iop->exportFormats());
+		e.inputImageFormats = extensionList(iop->importImageFormats());
+		e.outputImageFormats = extensionList(iop->exportImageFormats());
+		e.inputProjectFormats = extensionList(iop->importProjectFormats());
+		e.outputProjectFormats = extensionList(iop->exportProjectFormats());
+	}
+	return e;
+}
+
+/**
+ * @brief Loads the manifest from the given file, replacing the current entries.
+ * Returns false if the file cannot be read or has been written by a different
+ * MeshLab version; in that case the manifest is left empty.
+ */
+bool PluginManifest::load(const QString& manifestFile)
+{
+	entries.clear();
+	modified = false;
+	QFile f(manifestFile);
+	if (manifestFile.isEmpty() || !f.open(QIODevice::ReadOnly))
+		return false;
+	QJsonObject root = QJsonDocument::fromJson(f.readAll()).object();
+	if (root.value("version").toString() != manifestVersion())
+		return false;
+
+	for (const QJsonValue& v : root.value("plugins").toArray()) {
+		QJsonObject o = v.toObject();
+		Entry e;
+		e.fileName = o.value("file").toString();
+		e.size = (qint64) o.value("size").toDouble();
+		e.lastModified = (qint64) o.value("mtime").toDouble();
+		e.hash = o.value("hash").toString().toLatin1();
+		e.pluginName = o.value("name").toString();
+		for (const QJsonValue& fv : o.value("filters").toArray()) {
+			QJsonObject fo = fv.toObject();
+			FilterInfo fi;
+			fi.name = fo.value("name").toString();
+			fi.pythonName = fo.value("python").toString();
+			fi.filterClass = fo.value("class").toInt();
+			fi.requirements = fo.value("requirements").toInt();
+			fi.preConditions = fo.value("preconditions").toInt();
+			e.filters.push_back(fi);
+		}
+		e.decorations = fromJson(o.value("decorations"));
+		e.inputMeshFormats = fromJson(o.value("inputMesh"));
+		e.outputMeshFormats = fromJson(o.value("outputMesh"));
+		e.inputImageFormats = fromJson(o.value("inputImage"));
+		e.outputImageFormats = fromJson(o.value("outputImage"));
+		e.inputProjectFormats = fromJson(o.value("inputProject"));
+		e.outputProjectFormats = fromJson(o.value("outputProject"));
+		if (!e.fileName.isEmpty())
+			entries[e.fileName] = e;
+	}
+	return true;
+}
+
+/**
+ * @brief Writes the manifest to the given file, dropping the entries of the
+ * libraries that do not exist anymore.
+ */
+bool PluginManifest::save(const QString& manifestFile)
+{
+	if (manifestFile.isEmpty())
+		return false;
+	QJsonArray plugins;
+	for (const auto& p : entries) {
+		const Entry& e = p.second;
+		if (!QFileInfo::exists(e.fileName))
+			continue;
+		QJsonObject o;
+		o.insert("file", e.fileName);
+		o.insert("size", double(e.size));
+		o.insert("mtime", double(e.lastModified));
+		o.insert("hash", QString::fromLatin1(e.hash));
+		o.insert("name", e.pluginName);
+		QJsonArray filters;
+		for (const FilterInfo& fi : e.filters) {
+			QJsonObject fo;
+			fo.insert("name", fi.name);
+			fo.insert("python", fi.pythonName);
+			fo.insert("class", fi.filterClass);
+			fo.insert("requirements", fi.requirements);
+			fo.insert("preconditions", fi.preConditions);
+			filters.push_back(fo);
+		}
+		o.insert("filters", filters);
+		o.insert("decorations", toJson(e.decorations));
+		o.insert("inputMesh", toJson(e.inputMeshFormats));
+		o.insert("outputMesh", toJson(e.outputMeshFormats));
+		o.insert("inputImage", toJson(e.inputImageFormats));
+		o.insert("outputImage", toJson(e.outputImageFormats));
+		o.insert("inputProject", toJson(e.inputProjectFormats));
+		o.insert("outputProject", toJson(e.outputProjectFormats));
+		plugins.push_back(o);
+	}
+	QJsonObject root;
+	root.insert("version", manifestVersion());
+	root.insert("plugins", plugins);
+
+	QDir().mkpath(QFileInfo(manifestFile).absolutePath());
+	QSaveFile f(manifestFile);
+	if (!f.open(QIODevice::WriteOnly))
+		return false;
+	f.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+	if (!f.commit())
+		return false;
+	modified = false;
+	return true;
+}
+
+bool PluginManifest::isModified() const
+{
+	return modified;
+}
+
+/**
+ * @brief Returns the entry of the given library, or nullptr if there is no
+ * entry or the library has changed since the entry was written.
+ */
+const PluginManifest::Entry* PluginManifest::find(const QFileInfo& library) const
+{
+	auto it = entries.find(library.absoluteFilePath());
+	if (it == entries.end() || !it->second.matches(library))
+		return nullptr;
+	return &it->second;
+}
+
+void PluginManifest::insert(const Entry& entry)
+{
+	entries[entry.fileName] = entry;
+	modified = true;
+}
+
+void PluginManifest::remove(const QString& fileName)
+{
+	if (entries.erase(fileName) > 0)
+		modified = true;
+}
@@ -0,0 +1,101 @@
+/****************************************************************************
+* MeshLab                                                           o o     *
+* A versatile mesh processing toolbox                             o     o   *
+*                                                                _   O  _   *
+* Copyright(C) 2005-2021                                           \/)\/    *
+* Visual Computing Lab                                            /\/|      *
+* ISTI - Italian National Research Council                           |      *
+*                                                                    \      *
+* All rights reserved.                                                      *
+*                                                                           *
+* This program is free software; you can redistribute it and/or modify      *
+* it under the terms of the GNU General Public License as published by      *
+* the Free Software Foundation; either version 2 of the License, or         *
+* (at your option) any later version.                                       *
+*                                                                           *
+* This program is distributed in the hope that it will be useful,           *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)          *
+* for more details.                                                         *
+*                                                                           *
+****************************************************************************/
+
+
+#ifndef MESHLAB_PLUGIN_MANIFEST_H
+#define MESHLAB_PLUGIN_MANIFEST_H
+
+#include <map>
+#include <vector>
+
+#include <QByteArray>
+#include <QFileInfo>
+#include <QStringList>
+
+class MeshLabPlugin;
+
+/**
+ * @brief The PluginManifest class is a cache of what each plugin library
+ * provides (filters, decorations and file formats), saved on disk so that
+ * the PluginManager can load a library only when one of its filters or
+ * formats is actually used.
+ *
+ * Entries are keyed by the absolute path of the library and are valid as
+ * long as its size and modification time do not change. The hash of the
+ * library is checked when the library gets loaded, and the entry is
+ * replaced if the library has been rebuilt without changing its mtime.
+ * The whole manifest is discarded when written by a different MeshLab
+ * version or floating point precision.
+ */
+class PluginManifest
+{
+public:
+	struct FilterInfo
+	{
+		QString name;
+		QString pythonName;
+		int filterClass = 0;
+		int requirements = 0;
+		int preConditions = 0;
+	};
+
+	struct Entry
+	{
+		QString fileName;
+		qint64 size = 0;
+		qint64 lastModified = 0;
+		QByteArray hash;
+		QString pluginName;
+		std::vector<FilterInfo> filters;
+		QStringList decorations;
+		QStringList inputMeshFormats;
+		QStringList outputMeshFormats;
+		QStringList inputImageFormats;
+		QStringList outputImageFormats;
+		QStringList inputProjectFormats;
+		QStringList outputProjectFormats;
+
+		bool matches(const QFileInfo& library) const;
+		bool hasFilter(const QString& name) const;
+	};
+
+	PluginManifest();
+
+	static QString defaultManifestFile();
+	static QByteArray fileHash(const QString& fileName);
+	static Entry entryFromPlugin(MeshLabPlugin* plugin, const QFileInfo& library);
+
+	bool load(const QString& manifestFile);
+	bool save(const QString& manifestFile);
+	bool isModified() const;
+
+	const Entry* find(const QFileInfo& library) const;
+	void insert(const Entry& entry);
+	void remove(const QString& fileName);
+
+private:
+	std::map<QString, Entry> entries;
+	bool modified;
+};
+
+#endif // MESHLAB_PLUGIN_MANIFEST_H
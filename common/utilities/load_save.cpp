@@ -25,50 +25,146 @@
 
 #include <QElapsedTimer>
 #include <QDir>
+#include <QMutex>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+#include <algorithm>
+#include <functional>
 
 #include "../globals.h"
 #include "../plugins/plugin_manager.h"
 
 #include <exif.h>
+#include <wrap/system/parallel.h>
 
 namespace meshlab {
 
-/**
- * @brief This function assumes that you already have the followind data:
- * - the plugin that is needed to load the mesh
- * - the number of meshes that will be loaded from the file
- * - the list of MeshModel(s) that will contain the loaded mesh(es)
- * - the open parameters that will be used to load the mesh(es)
- *
- * The function will take care to loat the mesh, load textures if needed
- * and make all the clean operations after loading the meshes.
- * If load fails, throws a MLException.
- *
- * @param[i] fileName: the filename
- * @param[i] ioPlugin: the plugin that supports the file format to load
- * @param[i] prePar: the pre open parameters
- * @param[i/o] meshList: the list of meshes that will be loaded from the file
- * @param[o] maskList: masks of loaded components for each loaded mesh
- * @param cb: callback
- * @return the list of texture names that could not be loaded
+namespace {
+
+/*
+ * Upper bound of the size of the files being decoded at the same time by
+ * loadMeshesWithStandardParameters and loadImages. A single file larger than
+ * the bound is still loaded, alone.
  */
-std::list<std::string> loadMesh(
-		const QString& fileName,
-		IOPlugin* ioPlugin,
-		const RichParameterList& prePar,
+const qint64 maxInFlightBytes = qint64(1) << 30;
+
+class FunctionRunnable : public QRunnable
+{
+public:
+	FunctionRunnable(const std::function<void()>& f) : f(f) {}
+	void run() { f(); }
+
+private:
+	std::function<void()> f;
+};
+
+/*
+ * Runs task(i) for every i in [0, weights.size()) on a thread pool, starting
+ * them in index order and without having more than maxInFlightBytes (sum of
+ * the weights) running at the same time. A single task is run directly on the
+ * calling thread. The pool and the tasks share the thread limit of the vcglib
+ * parallel code (see vcg::parallel::MaxThreads): at most that many tasks run
+ * at once, and the parallel loops of each task are capped to its share of it.
+ * The callback is called only from the calling thread, with the percentage of
+ * completed tasks.
+ * Returns, for each task, the message of the exception it has thrown, or an
+ * empty string if it succeeded.
+ */
+std::vector<QString> runConcurrently(
+		const std::vector<qint64>& weights,
+		const std::function<void(size_t)>& task,
+		vcg::CallBackPos* cb,
+		const char* msg)
+{
+	const size_t n = weights.size();
+	std::vector<QString> errors(n);
+	if (n == 1) {
+		try {
+			task(0);
+		}
+		catch (const std::exception& e) {
+			errors[0] = e.what();
+			if (errors[0].isEmpty())
+				errors[0] = "Unknown error";
+		}
+		if (cb != nullptr)
+			cb(100, msg);
+		return errors;
+	}
+
+	QMutex mutex;
+	QWaitCondition taskDone;
+	size_t next = 0, finished = 0;
+	int running = 0;
+	qint64 inFlight = 0;
+
+	// declared after the synchronization objects: its destructor waits for
+	// the worker threads before they are destroyed
+	QThreadPool pool;
+#ifdef _OPENMP
+	const int threads = vcg::parallel::MaxThreads();
+#else
+	// without OpenMP the vcglib loops are serial: only the pool is parallel
+	const int threads = std::max(1, QThread::idealThreadCount());
+#endif
+	const int workers = std::max(1, int(std::min<size_t>(threads, n)));
+	const int innerThreads = std::max(1, threads / workers);
+	pool.setMaxThreadCount(workers);
+
+	QMutexLocker locker(&mutex);
+	while (finished < n) {
+		while (next < n && running < pool.maxThreadCount() &&
+			   (running == 0 || inFlight + weights[next] <= maxInFlightBytes)) {
+			const size_t i = next++;
+			++running;
+			inFlight += weights[i];
+			pool.start(new FunctionRunnable([&, i]() {
+				QString error;
+				vcg::parallel::ApplyMaxThreads(innerThreads);
+				try {
+					task(i);
+				}
+				catch (const std::exception& e) {
+					error = e.what();
+					if (error.isEmpty())
+						error = "Unknown error";
+				}
+				QMutexLocker l(&mutex);
+				errors[i] = error;
+				--running;
+				inFlight -= weights[i];
+				++finished;
+				taskDone.wakeAll();
+			}));
+		}
+		taskDone.wait(&mutex);
+		if (cb != nullptr) {
+			const int perc = int(100 * finished / n);
+			locker.unlock();
+			cb(perc, msg);
+			locker.relock();
+		}
+	}
+	return errors;
+}
+
+/*
+ * Makes the clean operations needed after loading the meshes (normals,
+ * bounding box, degenerate elements) and loads their textures.
+ * Messages are not logged, but appended to logs and warnings, so that this
+ * can be run concurrently on different meshes.
+ */
+std::list<std::string> cleanLoadedMeshes(
 		const std::list<MeshModel*>& meshList,
-		std::list<int>& maskList,
+		const std::list<int>& maskList,
+		std::list<std::string>& logs,
+		QStringList& warnings,
 		vcg::CallBackPos *cb)
 {
 	std::list<std::string> unloadedTextures;
-	QFileInfo fi(fileName);
-	QString extension = fi.suffix();
-
-	QDir oldDir = QDir::current();
-	QDir::setCurrent(fi.absolutePath());
-	ioPlugin->open(extension, fileName, meshList, maskList, prePar, cb);
-	QDir::setCurrent(oldDir.absolutePath());
-
 	auto itmesh = meshList.begin();
 	auto itmask = maskList.begin();
 	for (unsigned int i = 0; i < meshList.size(); ++i){
@@ -83,7 +179,7 @@ std::list<std::string> loadMesh(
 			mm->updateDataMask(MeshModel::MM_POLYGONAL); // just to be sure. Hopefully it should be done in the plugin...
 			int degNum = vcg::tri::Clean<CMeshO>::RemoveDegenerateFace(mm->cm);
 			if(degNum)
-				ioPlugin->log("Warning model contains " + std::to_string(degNum) +" degenerate faces. Removed them.");
+				logs.push_back("Warning model contains " + std::to_string(degNum) +" degenerate faces. Removed them.");
 			mm->updateDataMask(MeshModel::MM_FACEFACETOPO);
 			vcg::tri::UpdateNormal<CMeshO>::PerBitQuadFaceNormalized(mm->cm);
 			vcg::tri::UpdateNormal<CMeshO>::PerVertexFromCurrentFaceNormal(mm->cm);
@@ -105,7 +201,7 @@ std::list<std::string> loadMesh(
 		int delFaceNum = vcg::tri::Clean<CMeshO>::RemoveDegenerateFace(mm->cm);
 		vcg::tri::Allocator<CMeshO>::CompactEveryVector(mm->cm);
 		if(delVertNum>0 || delFaceNum>0 )
-			ioPlugin->reportWarning(QString("Warning mesh contains %1 vertices with NAN coords and %2 degenerated faces.\nCorrected.").arg(delVertNum).arg(delFaceNum));
+			warnings.push_back(QString("Warning mesh contains %1 vertices with NAN coords and %2 degenerated faces.\nCorrected.").arg(delVertNum).arg(delFaceNum));
 
 		//computeRenderingDataOnLoading(mm,isareload, rendOpt);
 		++itmesh;
@@ -114,6 +210,62 @@ std::list<std::string> loadMesh(
 	return unloadedTextures;
 }
 
+void logLoadMessages(
+		IOPlugin* ioPlugin,
+		const std::list<std::string>& logs,
+		const QStringList& warnings)
+{
+	for (const std::string& l : logs)
+		ioPlugin->log(l);
+	for (const QString& w : warnings)
+		ioPlugin->reportWarning(w);
+}
+
+} // namespace
+
+/**
+ * @brief This function assumes that you already have the followind data:
+ * - the plugin that is needed to load the mesh
+ * - the number of meshes that will be loaded from the file
+ * - the list of MeshModel(s) that will contain the loaded mesh(es)
+ * - the open parameters that will be used to load the mesh(es)
+ *
+ * The function will take care to loat the mesh, load textures if needed
+ * and make all the clean operations after loading the meshes.
+ * If load fails, throws a MLException.
+ *
+ * @param[i] fileName: the filename
+ * @param[i] ioPlugin: the plugin that supports the file format to load
+ * @param[i] prePar: the pre open parameters
+ * @param[i/o] meshList: the list of meshes that will be loaded from the file
+ * @param[o] maskList: masks of loaded components for each loaded mesh
+ * @param cb: callback
+ * @return the list of texture names that could not be loaded
+ */
+std::list<std::string> loadMesh(
+		const QString& fileName,
+		IOPlugin* ioPlugin,
+		const RichParameterList& prePar,
+		const std::list<MeshModel*>& meshList,
+		std::list<int>& maskList,
+		vcg::CallBackPos *cb)
+{
+	QFileInfo fi(fileName);
+	QString extension = fi.suffix();
+
+	QDir oldDir = QDir::current();
+	QDir::setCurrent(fi.absolutePath());
+	ioPlugin->open(extension, fileName, meshList, maskList, prePar, cb);
+	QDir::setCurrent(oldDir.absolutePath());
+
+	std::list<std::string> logs;
+	QStringList warnings;
+	std::list<std::string> unloadedTextures =
+			cleanLoadedMeshes(meshList, maskList, logs, warnings, cb);
+	logLoadMessages(ioPlugin, logs, warnings);
+	return unloadedTextures;
+}
+
 /**
  * @brief loads the given filename and puts the loaded mesh(es) into the
  * given MeshDocument. Returns the list of loaded meshes.
@@ -187,6 +339,104 @@ std::list<MeshModel*> loadMeshWithStandardParameters(
 }
 
 
+/**
+ * @brief loads the given list of files and puts the loaded meshes into the
+ * given MeshDocument, using the standard open parameters of each format.
+ * Returns, for each file, the list of meshes loaded from it.
+ *
+ * The layers are added to the MeshDocument in the order of the filenames,
+ * before any file is read. Then files whose format supports it (see
+ * IOPlugin::supportsConcurrentOpen) are loaded concurrently, while the others
+ * are loaded one at a time. The callback reports the overall progress and is
+ * called only from the calling thread.
+ *
+ * if an error occurs, an exception will be thrown, and MeshDocument won't
+ * contain any of the new meshes.
+ */
+std::vector<std::list<MeshModel*>> loadMeshesWithStandardParameters(
+		const QStringList& filenames,
+		MeshDocument& md,
+		vcg::CallBackPos* cb)
+{
+	PluginManager& pm = meshlab::pluginManagerInstance();
+	const size_t n = filenames.size();
+	std::vector<std::list<MeshModel*>> meshLists(n);
+	std::vector<std::list<int>> maskLists(n);
+	std::vector<IOPlugin*> plugins(n);
+	std::vector<RichParameterList> prePars(n);
+
+	auto deleteLoadedMeshes = [&]() {
+		for (const std::list<MeshModel*>& ml : meshLists)
+			for (MeshModel* mm : ml)
+				md.delMesh(mm);
+	};
+
+	for (size_t i = 0; i < n; ++i) {
+		QFileInfo fi(filenames[int(i)]);
+		QString extension = fi.suffix();
+		plugins[i] = pm.inputMeshPlugin(extension);
+		if (plugins[i] == nullptr) {
+			deleteLoadedMeshes();
+			throw MLException(
+					"Mesh " + filenames[int(i)] + " cannot be opened. Your MeshLab version "
+					"has not plugin to read " + extension + " file format");
+		}
+		plugins[i]->setLog(&md.Log);
+		prePars[i] = plugins[i]->initPreOpenParameter(extension);
+		prePars[i].join(meshlab::defaultGlobalParameterList());
+
+		unsigned int nMeshes = plugins[i]->numberMeshesContainedInFile(extension, filenames[int(i)], prePars[i]);
+		for (unsigned int j = 0; j < nMeshes; j++) {
+			MeshModel *mm = md.addNewMesh(filenames[int(i)], fi.fileName());
+			if (nMeshes != 1)
+				mm->setIdInFile(j);
+			meshLists[i].push_back(mm);
+		}
+	}
+
+	std::vector<size_t> concurrentFiles;
+	std::vector<qint64> weights;
+	std::vector<QString> errors(n);
+	for (size_t i = 0; i < n; ++i) {
+		QFileInfo fi(filenames[int(i)]);
+		if (plugins[i]->supportsConcurrentOpen(fi.suffix())) {
+			concurrentFiles.push_back(i);
+			weights.push_back(fi.size());
+		}
+		else {
+			try {
+				loadMesh(filenames[int(i)], plugins[i], prePars[i], meshLists[i], maskLists[i], nullptr);
+			}
+			catch (const std::exception& e) {
+				errors[i] = e.what();
+			}
+		}
+	}
+
+	std::vector<std::list<std::string>> logs(n);
+	std::vector<QStringList> warnings(n);
+	std::vector<QString> concurrentErrors = runConcurrently(weights, [&](size_t k) {
+		const size_t i = concurrentFiles[k];
+		QFileInfo fi(filenames[int(i)]);
+		plugins[i]->open(fi.suffix(), fi.absoluteFilePath(), meshLists[i], maskLists[i], prePars[i], nullptr);
+		cleanLoadedMeshes(meshLists[i], maskLists[i], logs[i], warnings[i], nullptr);
+	}, cb, "Loading meshes...");
+
+	for (size_t k = 0; k < concurrentFiles.size(); ++k) {
+		const size_t i = concurrentFiles[k];
+		errors[i] = concurrentErrors[k];
+		logLoadMessages(plugins[i], logs[i], warnings[i]);
+	}
+
+	for (size_t i = 0; i < n; ++i) {
+		if (!errors[i].isEmpty()) {
+			deleteLoadedMeshes();
+			throw MLException(errors[i]);
+		}
+	}
+	return meshLists;
+}
+
 void reloadMesh(
 		const QString& filename,
 		const std::list<MeshModel*>& meshList,
@@ -310,10 +560,42 @@ QImage loadImage(
 				"Image " + filename + " cannot be opened. Your MeshLab version "
 				"has not plugin to read " + extension + " file format.");
 
-	ioPlugin->setLog(log);
+	// the log of the plugin is not touched when no log is given, so that
+	// images can be loaded concurrently (see loadImages)
+	if (log != nullptr)
+		ioPlugin->setLog(log);
 	return ioPlugin->openImage(extension, filename, cb);
 }
 
+/**
+ * @brief loads the given list of images concurrently. Images that cannot be
+ * loaded are replaced by a dummy image and their filename is appended to the
+ * unloadedImgList. The callback is called only from the calling thread.
+ */
+std::vector<QImage> loadImages(
+		const QStringList& filenames,
+		std::vector<std::string>& unloadedImgList,
+		vcg::CallBackPos* cb)
+{
+	const size_t n = filenames.size();
+	std::vector<QImage> images(n);
+	std::vector<qint64> weights(n);
+	for (size_t i = 0; i < n; ++i)
+		weights[i] = QFileInfo(filenames[int(i)]).size();
+
+	std::vector<QString> errors = runConcurrently(weights, [&](size_t i) {
+		images[i] = loadImage(filenames[int(i)]);
+	}, cb, "Loading images...");
+
+	for (size_t i = 0; i < n; ++i) {
+		if (!errors[i].isEmpty()) {
+			images[i] = QImage(":/img/dummy.png");
+			unloadedImgList.push_back(filenames[int(i)].toStdString());
+		}
+	}
+	return images;
+}
+
 void saveImage(
 		const QString& filename,
 		const QImage& image,
@@ -335,6 +617,43 @@ void saveImage(
 	ioPlugin->saveImage(extension, filename, image, quality, cb);
 }
 
+/**
+ * @brief saves the given images concurrently. Plugins are looked up (and
+ * their log set) on the calling thread; if any image cannot be saved, an
+ * exception is thrown after all the others have been written.
+ */
+void saveImages(
+		const QStringList& filenames,
+		const std::vector<QImage>& images,
+		int quality,
+		GLLogStream* log,
+		vcg::CallBackPos* cb)
+{
+	PluginManager& pm = meshlab::pluginManagerInstance();
+	const size_t n = filenames.size();
+	std::vector<IOPlugin*> plugins(n);
+	std::vector<qint64> weights(n);
+	for (size_t i = 0; i < n; ++i) {
+		QString extension = QFileInfo(filenames[int(i)]).suffix();
+		plugins[i] = pm.outputImagePlugin(extension);
+		if (plugins[i] == nullptr)
+			throw MLException(
+					"Image " + filenames[int(i)] + " cannot be saved. Your MeshLab version "
+					"has not plugin to save " + extension + " file format.");
+		plugins[i]->setLog(log);
+		weights[i] = qint64(images[i].bytesPerLine()) * images[i].height();
+	}
+
+	std::vector<QString> errors = runConcurrently(weights, [&](size_t i) {
+		QString extension = QFileInfo(filenames[int(i)]).suffix();
+		plugins[i]->saveImage(extension, filenames[int(i)], images[i], quality, nullptr);
+	}, cb, "Saving images...");
+
+	for (const QString& error : errors)
+		if (!error.isEmpty())
+			throw MLException(error);
+}
+
 void loadRaster(const QString& filename, RasterModel& rm, GLLogStream* log, vcg::CallBackPos* cb)
 {
 	QImage loadedImage = loadImage(filename, log, cb);
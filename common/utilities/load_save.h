@@ -48,6 +48,11 @@ std::list<MeshModel*> loadMeshWithStandardParameters(
 		vcg::CallBackPos *cb = nullptr,
 		RichParameterList prePar = RichParameterList());
 
+std::vector<std::list<MeshModel*>> loadMeshesWithStandardParameters(
+		const QStringList& filenames,
+		MeshDocument& md,
+		vcg::CallBackPos *cb = nullptr);
+
 void reloadMesh(
 		const QString& filename,
 		const std::list<MeshModel*>& meshList,
@@ -72,6 +77,11 @@ QImage loadImage(
 		GLLogStream* log = nullptr,
 		vcg::CallBackPos *cb = nullptr);
 
+std::vector<QImage> loadImages(
+		const QStringList& filenames,
+		std::vector<std::string>& unloadedImgList,
+		vcg::CallBackPos *cb = nullptr);
+
 void saveImage(
 		const QString& filename,
 		const QImage& image,
@@ -79,6 +89,13 @@ void saveImage(
 		GLLogStream* log = nullptr,
 		vcg::CallBackPos* cb = nullptr);
 
+void saveImages(
+		const QStringList& filenames,
+		const std::vector<QImage>& images,
+		int quality = -1,
+		GLLogStream* log = nullptr,
+		vcg::CallBackPos* cb = nullptr);
+
 void loadRaster(
 		const QString& filename,
 		RasterModel& rm,
@@ -87,6 +87,15 @@ public:
 	std::ptrdiff_t maxTextureMemory;
 	inline static QString maxTextureMemoryParam()  {return "MeshLab::System::maxTextureMemory";}
 
+	std::ptrdiff_t maxDecodedTextureMemory;
+	inline static QString maxDecodedTextureMemoryParam()  {return "MeshLab::System::maxDecodedTextureMemory";}
+
+	std::ptrdiff_t maxMemoryBudget;
+	inline static QString maxMemoryBudgetParam()  {return "MeshLab::System::maxMemoryBudget";}
+
+	int maxThreads;
+	inline static QString maxThreadsParam()  {return "MeshLab::System::maxThreads";}
+
 	bool showPreOpenParameterDialog;
 	inline static QString showPreOpenParameterDialogParam()  {return "MeshLab::System::showPreOpenParameterDialog";}
 };
@@ -40,6 +40,8 @@
 #include <common/mlapplication.h>
 #include <common/mlexception.h>
 #include <common/globals.h>
+#include <common/ml_memory_accounting.h>
+#include <wrap/system/parallel.h>
 #include "dialogs/options_dialog.h"
 #include "dialogs/save_snapshot_dialog.h"
 #include "dialogs/congrats_dialog.h"
@@ -1340,6 +1342,9 @@ void MainWindowSetting::initGlobalParameterList(RichParameterList& gbllist)
 	if (MeshLabScalarTest<Scalarm>::doublePrecision())
 		gbllist.addParam(RichBool(highPrecisionRendering(), false, "High Precision Rendering", "If true all the models in the scene will be rendered at the center of the world"));
 	gbllist.addParam(RichInt(maxTextureMemoryParam(), 256, "Max Texture Memory (in MB)", "The maximum quantity of texture memory allowed to load mesh textures"));
+	gbllist.addParam(RichInt(maxDecodedTextureMemoryParam(), 0, "Max Decoded Texture Memory (in MB)", "The maximum quantity of main memory used by the textures read from files, summed over all the layers. When it is exceeded, the least recently used textures are released and read again from their file when needed. 0 means no limit."));
+	gbllist.addParam(RichInt(maxMemoryBudgetParam(), 0, "Memory Budget for Mesh Data (in MB)", "The maximum quantity of main memory that the layers and the filters temporaries are expected to use. Filters that declare their memory needs fail instead of exceeding it, and the decoded textures of hidden layers are released when it is exceeded. 0 means no limit."));
+	gbllist.addParam(RichInt(maxThreadsParam(), 0, "Max Threads", "The maximum number of threads used by the filters that run in parallel. 0 means the default: the value of OMP_NUM_THREADS when set, otherwise one thread per processor."));
 	gbllist.addParam(RichBool(showPreOpenParameterDialogParam(), false, "Show Open Parameter Dialog", "If true, each time that a mesh is imported, a dialog asking for extra parameters (if applicable), is shown."));
 }
 
@@ -1352,7 +1357,13 @@ void MainWindowSetting::updateGlobalParameterList(const RichParameterList& rpl)
 	if (MeshLabScalarTest<Scalarm>::doublePrecision())
 		highprecision = rpl.getBool(highPrecisionRendering());
 	maxTextureMemory = (std::ptrdiff_t) rpl.getInt(this->maxTextureMemoryParam()) * (float)(1024 * 1024);
+	maxDecodedTextureMemory = (std::ptrdiff_t) rpl.getInt(maxDecodedTextureMemoryParam()) * (float)(1024 * 1024);
+	MeshModel::setTextureMemoryLimit(maxDecodedTextureMemory);
 	showPreOpenParameterDialog = rpl.getBool(showPreOpenParameterDialogParam());
+	maxMemoryBudget = (std::ptrdiff_t) rpl.getInt(maxMemoryBudgetParam()) * (float)(1024 * 1024);
+	MLMemoryAccounting::instance().setBudget(maxMemoryBudget);
+	maxThreads = rpl.getInt(maxThreadsParam());
+	vcg::parallel::SetMaxThreads(maxThreads);
 }
 
 void MainWindow::defaultPerViewRenderingData(MLRenderingData& dt) const
@@ -43,6 +43,7 @@
 #include <common/filterscript.h>
 #include <common/mlexception.h>
 #include <common/globals.h>
+#include <common/ml_memory_accounting.h>
 #include <common/utilities/load_save.h>
 
 #include "rich_parameter_gui/richparameterlistdialog.h"
@@ -1154,6 +1155,22 @@ void MainWindow::executeFilter(const QAction* action, RichParameterList &params,
 	// (4) Apply the Filter
 	qApp->setOverrideCursor(QCursor(Qt::WaitCursor));
 	QElapsedTimer tt; tt.start();
+
+	// when the layers exceed the memory budget, release first the decoded
+	// textures of the hidden layers, that can be read again when needed
+	MLMemoryAccounting& memacc = MLMemoryAccounting::instance();
+	memacc.updateDocumentMemory(*meshDoc());
+	if (!memacc.isAdditionalMemoryAvailable(0)) {
+		for (MeshModel* mm : meshDoc()->meshIterator())
+			if (!mm->isVisible())
+				mm->releaseDecodedTextures();
+		memacc.updateDocumentMemory(*meshDoc());
+		if (!memacc.isAdditionalMemoryAvailable(0))
+			meshDoc()->Log.logf(GLLogStream::WARNING, "The layers use %lld MB, more than the memory budget of %lld MB",
+				memacc.documentMemory() / (1024 * 1024), memacc.budget() / (1024 * 1024));
+	}
+	memacc.resetPeak();
+
 	meshDoc()->setBusy(true);
 	RichParameterList mergedenvironment(params);
 	mergedenvironment.join(currentGlobalParams);
@@ -1221,6 +1238,14 @@ void MainWindow::executeFilter(const QAction* action, RichParameterList &params,
 		// (5) Apply post filter actions (e.g. recompute non updated stuff if needed)
 		
 		meshDoc()->Log.logf(GLLogStream::SYSTEM,"Applied filter %s in %i msec",qUtf8Printable(action->text()),tt.elapsed());
+		memacc.updateDocumentMemory(*meshDoc());
+		memacc.sampleResidentMemory();
+		if (memacc.peakResidentMemory() > 0)
+			meshDoc()->Log.logf(GLLogStream::SYSTEM,"Memory: layers %lld MB, accounted peak %lld MB, resident peak %lld MB",
+				memacc.documentMemory() / (1024 * 1024), memacc.peakMemory() / (1024 * 1024), memacc.peakResidentMemory() / (1024 * 1024));
+		else
+			meshDoc()->Log.logf(GLLogStream::SYSTEM,"Memory: layers %lld MB, accounted peak %lld MB",
+				memacc.documentMemory() / (1024 * 1024), memacc.peakMemory() / (1024 * 1024));
 		if (meshDoc()->mm() != NULL)
 			meshDoc()->mm()->setMeshModified();
 		MainWindow::globalStatusBar()->showMessage("Filter successfully completed...",2000);
@@ -2632,6 +2657,7 @@ bool MainWindow::QCallBack(const int pos, const char * str)
 	if (currTime.isValid() && currTime.elapsed() < 100)
 		return true;
 	currTime.start();
+	MLMemoryAccounting::instance().sampleResidentMemory();
 	MainWindow::globalStatusBar()->showMessage(str, 5000);
 	qb->show();
 	qb->setEnabled(true);
@@ -2668,6 +2694,8 @@ void MainWindow::updateTexture(int meshid)
 	
 	int singleMaxTextureSizeMpx = int(textmemMB/((totalTextureNum != 0)? totalTextureNum : 1));
 
+	// decode all the textures of the mesh in parallel before uploading them
+	mymesh->decodeTextures(&meshDoc()->Log);
 	bool sometextnotfound = false;
 	for(const std::string& textname : mymesh->cm.textures)
 	{
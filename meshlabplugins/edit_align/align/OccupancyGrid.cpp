@@ -24,30 +24,89 @@
 #include <time.h>
 #include <list>
 #include <utility>
-#include <bitset>
+#include <unordered_map>
 
 #include "OccupancyGrid.h"
 
 #include <vcg/complex/algorithms/clean.h>
 #include <wrap/io_trimesh/import.h>
 #include <wrap/ply/plystuff.h>
+#include <wrap/system/parallel.h>
 
 using namespace std;
 using namespace vcg;
 
 
-// Nota che il bbox viene automaticamento inflatato dalla G.SetBBox();
+// Nota che il bbox viene automaticamento inflatato
 bool OccupancyGrid::Init(int _mn, Box3d bb, int size)
 {
   mn=_mn; // the number of meshes (including all the unused ones; eg it is the range of the possible id)
-  if(mn>MeshCounter::MaxVal()) return false;
-  MeshCounter MC;
-  MC.Clear();
-  G.Create(bb,size,MC);
-  VM.clear();
+  G.bbox.Import(bb);
+  G.bbox.Offset(0.01*G.bbox.Diag());
+  G.dim = G.bbox.max - G.bbox.min;
+  BestDim( size, G.dim, G.siz );
+  G.ComputeDimAndVoxel();
+  Clear();
   return true;
 }
 
+void OccupancyGrid::Clear()
+{
+  VM.clear();
+  SVA.clear();
+  MeshCells.clear();
+  CellKeys.clear();
+  CellStart.clear();
+  CellMesh.clear();
+  TotalArea=0;
+  MaxCount=0;
+}
+
+OccupancyGrid::CellKey OccupancyGrid::GridKey(const Point3f &p) const
+{
+  Point3i pi = G.GridP(p);
+  for(int i=0;i<3;++i)
+    pi[i] = std::max(0, std::min(pi[i], G.siz[i]-1));
+  return CellKey(pi[0]) + CellKey(G.siz[0])*(CellKey(pi[1]) + CellKey(G.siz[1])*CellKey(pi[2]));
+}
+
+void OccupancyGrid::AddMeshCells(int ind, std::vector<CellKey> &cells)
+{
+  MeshCells[ind].swap(cells);
+  VM[ind].Init(ind);
+  VM[ind].used=true;
+}
+
+// Merge the per mesh cell lists into the compressed cell -> meshes table.
+// Inside each cell the mesh ids are sorted in increasing order.
+void OccupancyGrid::BuildCellTable()
+{
+  size_t entryNum=0;
+  for(auto mi=MeshCells.begin();mi!=MeshCells.end();++mi)
+    entryNum+=mi->second.size();
+
+  std::vector<std::pair<CellKey,int> > entries;
+  entries.reserve(entryNum);
+  for(auto mi=MeshCells.begin();mi!=MeshCells.end();++mi)
+    for(CellKey k : mi->second)
+      entries.push_back(std::make_pair(k,mi->first));
+  std::sort(entries.begin(),entries.end());
+
+  CellKeys.clear();
+  CellStart.clear();
+  CellMesh.resize(entries.size());
+  for(size_t i=0;i<entries.size();++i)
+  {
+    if(i==0 || entries[i].first!=entries[i-1].first)
+    {
+      CellKeys.push_back(entries[i].first);
+      CellStart.push_back(int(i));
+    }
+    CellMesh[i]=entries[i].second;
+  }
+  CellStart.push_back(int(entries.size()));
+}
+
 void OccupancyGrid::Add(const char *MeshName, Matrix44d &Tr, int id)
 {
     A2Mesh M;
@@ -89,33 +148,44 @@ void OccupancyGrid::Compute()
   // Si deve trovare l'insieme degli archi piu'plausibili
   // un arco ha "senso" in una cella se entrambe le mesh compaiono in quell'arco
   // Si considera tutti gli archi possibili e si conta in quante celle ha senso un arco
-  std::vector<int> VA; // virtual arcs
-  VA.resize(mn*mn,0);
-  std::map< std::pair<int,int>, int > VAMap;
+  BuildCellTable();
+  const int cellNum = int(CellKeys.size());
 
   // First Loop:
-  // Scan the grid and update possible arc count
-  for(int i=0;i<G.siz[0];++i)
-    for(int j=0;j<G.siz[1];++j)
-      for(int k=0;k<G.siz[2];++k)
-      {
-        vector<int > vv;
-        G.Grid(i,j,k).Pack(vv);
-        size_t meshInCell = vv.size();
-        for( size_t ii=0; ii< vv.size(); ++ii)
-        { 
-          OGMeshInfo & omi_ii = VM[vv[ii]];
-          ++omi_ii.area; // compute mesh area
-          if(meshInCell>omi_ii.densityDistribution.size())
-            omi_ii.densityDistribution.resize(meshInCell);
-          ++(omi_ii.densityDistribution[meshInCell-1]);
-        }
+  // Scan the occupied cells and update the per mesh area and density distribution
+  for(int c=0;c<cellNum;++c)
+  {
+    size_t meshInCell = size_t(CellStart[c+1]-CellStart[c]);
+    for(int ii=CellStart[c]; ii<CellStart[c+1]; ++ii)
+    {
+      OGMeshInfo & omi_ii = VM[CellMesh[ii]];
+      ++omi_ii.area; // compute mesh area
+      if(meshInCell>omi_ii.densityDistribution.size())
+        omi_ii.densityDistribution.resize(meshInCell);
+      ++(omi_ii.densityDistribution[meshInCell-1]);
+    }
+  }
 
-        for(size_t ii=0;ii<vv.size();++ii)
-          for(size_t jj=ii+1;jj<vv.size();++jj)
-//              ++VA[vv[ii]+vv[jj]*mn]; // count intersections of all mesh pairs
-            ++VAMap[std::make_pair(vv[ii],vv[jj])]; // count intersections of all mesh pairs
-      }
+  // Second Loop:
+  // count intersections of all the mesh pairs that actually share a cell.
+  // Every range of cells counts into its own table, tables are merged at the end.
+  typedef std::unordered_map<unsigned long long,int> PairCountMap;
+  const int grain = std::max(1024, (cellNum + 63) / 64);
+  std::vector<PairCountMap> chunkVA(std::max(1, parallel::ChunkNum(cellNum, grain)));
+  parallel::ForRange(cellNum, grain, [&](int chunk, int b, int e) {
+    PairCountMap &va=chunkVA[chunk];
+    for(int c=b;c<e;++c)
+      for(int ii=CellStart[c];ii<CellStart[c+1];++ii)
+        for(int jj=ii+1;jj<CellStart[c+1];++jj)
+          ++va[(static_cast<unsigned long long>(CellMesh[ii])<<32) | static_cast<unsigned int>(CellMesh[jj])];
+  });
+  PairCountMap &VAMap=chunkVA[0];
+  for(size_t t=1;t<chunkVA.size();++t)
+  {
+    for(auto vi=chunkVA[t].begin();vi!=chunkVA[t].end();++vi)
+      VAMap[vi->first]+=vi->second;
+    PairCountMap().swap(chunkVA[t]);
+  }
 
   // Find all the arcs, e.g. all the pair of meshes 
   SVA.clear();
@@ -123,21 +193,13 @@ void OccupancyGrid::Compute()
   {
     if(vi->second > 0) 
     {
-      int m_s = vi->first.first;
-      int m_t = vi->first.second;
+      int m_s = int(vi->first>>32);
+      int m_t = int(vi->first & 0xffffffffull);
       int area = vi->second;
         SVA.push_back( OGArcInfo (m_s,m_t,area,float(area)/float(min(VM[m_s].area,VM[m_t].area)) ));
     }     
   }
   
-//  SVA.clear();
-//  for(int i=0;i<mn-1;++i)
-//    if(VM[i].used)
-//      for(int j=i+1;j<mn;++j)
-//        if(VM[j].used && VA[i+j*mn]>0)
-//          SVA.push_back( OGArcInfo(i,j, VA[i+j*mn], VA[i+j*mn]/float( min(VM[i].area,VM[j].area)) ));
-
-    
   // Compute Mesh Coverage
   for(size_t i=0;i<SVA.size();++i)
   {
@@ -145,23 +207,22 @@ void OccupancyGrid::Compute()
     VM[SVA[i].t].coverage += SVA[i].area;
   }
 
-  sort(SVA.begin(),SVA.end());
-  reverse(SVA.begin(),SVA.end());
+  // the pair table is unordered: break ties on source and target to keep the arc order deterministic
+  sort(SVA.begin(),SVA.end(),[](const OGArcInfo &a, const OGArcInfo &b){
+    if(a.norm_area!=b.norm_area) return a.norm_area > b.norm_area;
+    if(a.s!=b.s) return a.s < b.s;
+    return a.t < b.t;
+  });
 }
 
 
 void OccupancyGrid::ComputeTotalArea()
 {
-    int ccnt=0;
     MaxCount=0;
-    int sz=G.size();
-    for(int i=0;i<sz;++i)
-        if(!G.grid[i].Empty()) {
-            ccnt++;
-            if(G.grid[i].Count()>(unsigned int)MaxCount) MaxCount=G.grid[i].Count();
-        }
+    for(size_t c=0;c+1<CellStart.size();++c)
+        MaxCount=std::max(MaxCount,CellStart[c+1]-CellStart[c]);
 
-    TotalArea=ccnt;
+    TotalArea=int(CellKeys.size());
 }
 /*
     Ordinare le RangeMap in base a quanto sono utili.
@@ -191,7 +252,8 @@ void OccupancyGrid::ComputeUsefulMesh(FILE *elfp)
             }
         }
 
-    int sz=G.size();
+    int sz=GridSize();
+    std::vector<bool> cleared(CellKeys.size(),false);
     if(elfp) {
         fprintf(elfp,"\n\nComputing Usefulness of Meshes of %i(on %i) meshes\n Og with %i / %i fill ratio %i max mesh per cell\n\n",mcnt,mn,TotalArea,sz,MaxCount);
         fprintf(elfp,"\n");
@@ -211,18 +273,21 @@ void OccupancyGrid::ComputeUsefulMesh(FILE *elfp)
             UpdArea[best]=-1;
             UpdCovg[best]=-1;
 
-            for(i=0;i<sz;++i)
+            // every cell touched by <best> is cleared: the other meshes lose it.
+            for(CellKey k : MeshCells[best])
             {
-                MeshCounter &mc=G.grid[i];
-                if(mc.IsSet(best))	{
-                  mc.UnSet(best);
-                    for(j=0;j<mn;++j)
-                      if(mc.IsSet(j)) {
-                            --UpdArea[j];
-                            UpdCovg[j]-=mc.Count();
-                      }
-                    mc.Clear();
-              }
+                i = int(std::lower_bound(CellKeys.begin(),CellKeys.end(),k)-CellKeys.begin());
+                if(cleared[i]) continue;
+                int remainingCnt = CellStart[i+1]-CellStart[i]-1;
+                for(int ii=CellStart[i];ii<CellStart[i+1];++ii)
+                {
+                    j=CellMesh[ii];
+                    if(j!=best && j<mn) {
+                        --UpdArea[j];
+                        UpdCovg[j]-=remainingCnt;
+                    }
+                }
+                cleared[i]=true;
             }
         }
 }
@@ -230,7 +295,7 @@ void OccupancyGrid::ComputeUsefulMesh(FILE *elfp)
 void OccupancyGrid::Dump(FILE *fp)
 {
     fprintf(fp,"Occupancy Grid\n");
-    fprintf(fp,"grid of ~%i kcells: %d x %d x %d\n",G.size(),G.siz[0],G.siz[1],G.siz[2]);
+    fprintf(fp,"grid of ~%i kcells: %d x %d x %d (%zu occupied)\n",GridSize(),G.siz[0],G.siz[1],G.siz[2],CellKeys.size());
     fprintf(fp,"grid voxel size of %f %f %f\n",G.voxel[0],G.voxel[1],G.voxel[2]);
 
     fprintf(fp,"Computed %lu arcs for %i meshes\n",SVA.size(),mn);
@@ -292,8 +357,7 @@ void OccupancyGrid::Dump(FILE *fp)
 
 void OccupancyGrid::RemoveMesh(int id)
 {
-    MeshCounter *GridEnd=G.grid+G.size();
-    MeshCounter *ig;
-    for(ig=G.grid;ig!=GridEnd;++ig)
-        ig->UnSet(id);
+    MeshCells.erase(id);
+    if(!CellKeys.empty())
+        BuildCellTable();
 }
@@ -24,8 +24,10 @@
 #define ALIGN_OCCUPANCY_GRID_H
 
 #include <vcg/complex/algorithms/align_pair.h>
-#include <bitset>
-#include <vcg/space/index/grid_static_obj.h>
+#include <vcg/space/index/grid_util.h>
+#include <algorithm>
+#include <map>
+#include <vector>
 
 namespace vcg
 {
@@ -33,46 +35,18 @@ namespace vcg
  * Used to find the mesh pairs (arcs) to be used for ICP
  * It counts over the cell of a grid how many meshes passes through that cell.
  * It compute the relative overlaps and returns a set of arcs with overlap greater than a given threshold.
+ *
+ * The grid is sparse: each mesh is rasterized independently into the sorted list of
+ * the cells it touches (so AddMesh can be run concurrently on different meshes),
+ * and Compute() merges these lists into a compressed (CSR) cell -> mesh set table.
+ * Memory is proportional to the number of occupied (cell, mesh) pairs and the arc
+ * computation to the number of actual overlaps, not to the number of meshes.
  */
 class OccupancyGrid{
 public:
   typedef AlignPair::A2Mesh A2Mesh;
+  typedef long long CellKey;
 
-  // Class to keep for each voxel the id of the mesh passing throuhg it.
-  // based on bitset
-  class MeshCounter
-  {
-  private:
-#define OG_MAX_MCB_SIZE 2048
-    std::bitset<OG_MAX_MCB_SIZE> cnt;
-  public:
-    static int MaxVal() {return OG_MAX_MCB_SIZE;}
-    bool Empty() const {return cnt.none();}
-    void Clear() {cnt.reset();}
-    bool IsSet(size_t i) const {return cnt.test(i);}
-    void Set(size_t i) {cnt.set(i);}
-    void UnSet(size_t i) {cnt.reset(i);}
-    size_t Count() const { return cnt.count();}
-
-    // Return a vector with all the id of the meshes
-    void Pack(std::vector<int> &v) const
-    {
-      v.clear();
-      for(size_t i=0;i<OG_MAX_MCB_SIZE;++i)
-        if(cnt.test(int(i))) v.push_back(int(i));
-    }
-
-    bool operator < (const MeshCounter &c) const {
-      size_t ii=0;
-      if(cnt==c.cnt) return false;
-      while(ii<OG_MAX_MCB_SIZE){
-        if(cnt[ii]!=c.cnt[ii]) return cnt[ii]<c.cnt[ii];
-        ++ii;
-      }
-      return false;
-    }
-  };
-  
   // Class for collecting cumulative information about each mesh in the OG.
   // This info are collected in the Compute() by scanning the OG after we filled it with all the meshes.
   class OGMeshInfo
@@ -112,7 +86,7 @@ public:
 
 
 
-  void Clear() {};
+  void Clear();
   bool Init(int _mn, Box3d bb, int size);
 
   void Add(const char *MeshName, Matrix44d &Tr, int id);
@@ -120,6 +94,12 @@ public:
   template <class MESH>
   void AddMesh(MESH &M, const Matrix44d &Tr, int ind);
 
+  // Thread safe: compute the sorted list of the cells touched by a mesh without touching the grid.
+  template <class MESH>
+  void ComputeMeshCells(MESH &M, const Matrix44d &Tr, std::vector<CellKey> &cells) const;
+  // Store the (sorted) cell list of a mesh; the vector is swapped in, not copied.
+  void AddMeshCells(int ind, std::vector<CellKey> &cells);
+
   void RemoveMesh(int id);
 
 
@@ -129,29 +109,52 @@ public:
   void ComputeUsefulMesh(FILE *elfp=0);
   void Dump(FILE *fp);
   void ComputeTotalArea();
-  GridStaticObj<MeshCounter, float> G;
+  int GridSize() const { return G.siz[0]*G.siz[1]*G.siz[2]; }
+  CellKey GridKey(const Point3f &p) const;
+
+  BasicGrid<float> G;  // only the geometry of the grid, cells are stored sparsely below
   int mn;
   int TotalArea;
   int MaxCount;   // massimo numero di mesh che passano per una cella;
 
   std::vector<OGArcInfo>  SVA;  // SortedVirtual Arcs;
   std::map<int,OGMeshInfo> VM;  // High level information for each mesh. Mapped by mesh id
+
+  std::map<int, std::vector<CellKey> > MeshCells; // For each mesh id the sorted list of touched cells
+
+  // Compressed cell -> mesh table built by Compute(), only occupied cells are stored.
+  // The meshes of the i-th cell are CellMesh[CellStart[i]] .. CellMesh[CellStart[i+1]-1]
+  std::vector<CellKey> CellKeys;
+  std::vector<int> CellStart;
+  std::vector<int> CellMesh;
+  void BuildCellTable();
 };
 
 // Implementation of the templated AddMesh
 template <class MESH>
-void OccupancyGrid::AddMesh(MESH &M, const Matrix44d &Tr, int ind)
+void OccupancyGrid::ComputeMeshCells(MESH &M, const Matrix44d &Tr, std::vector<CellKey> &cells) const
 {
 	Matrix44f Trf;
 	Trf.Import(Tr);
+	cells.clear();
+	cells.reserve(M.vert.size());
 	typename MESH::VertexIterator vi;
 	for(vi=M.vert.begin();vi!=M.vert.end();++vi)
 	{
 	  if(!(*vi).IsD())
-		G.Grid( Trf * Point3f::Construct((*vi).P()) ).Set(ind);
+		cells.push_back(GridKey( Trf * Point3f::Construct((*vi).P()) ));
 	}
-	VM[ind].Init(ind);
-	VM[ind].used=true;
+	std::sort(cells.begin(),cells.end());
+	cells.erase(std::unique(cells.begin(),cells.end()),cells.end());
+	cells.shrink_to_fit();
+}
+
+template <class MESH>
+void OccupancyGrid::AddMesh(MESH &M, const Matrix44d &Tr, int ind)
+{
+	std::vector<CellKey> cells;
+	ComputeMeshCells(M,Tr,cells);
+	AddMeshCells(ind,cells);
 }
 
 
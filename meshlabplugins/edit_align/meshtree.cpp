@@ -24,9 +24,7 @@
 #include <QObject>
 #include <QStringList>
 #include <QList>
-#ifdef _OPENMP
-#include <omp.h>
-#endif
+#include <wrap/system/parallel.h>
 #include "meshtree.h"
 using namespace vcg;
 
@@ -116,12 +114,19 @@ void MeshTree::Process(vcg::AlignPair::Param &ap, MeshTree::Param &mtp)
   /******* Occupancy Grid Computation *************/
   cb(0,qUtf8Printable(buf.sprintf("Computing Overlaps %i glued meshes...\n",gluedNum() )));
   OG.Init(int(nodeMap.size()), vcg::Box3d::Construct(gluedBBox()), mtp.OGSize);
-  for(auto ni=nodeMap.begin();ni!=nodeMap.end();++ni) { 
-    MeshNode *mn=ni->second;
-//	foreach(MeshNode *mn, nodeList)
-    if(mn->glued)
-      OG.AddMesh<CMeshO>(mn->m->cm, vcg::Matrix44d::Construct(mn->tr()), mn->Id());
-  }
+  std::vector<MeshNode *> gluedNodes;
+  for(auto ni=nodeMap.begin();ni!=nodeMap.end();++ni)
+    if(ni->second->glued)
+      gluedNodes.push_back(ni->second);
+
+  // Meshes are rasterized concurrently, each one into its own cell list;
+  // the lists are then handed over to the grid without copying.
+  std::vector<std::vector<vcg::OccupancyGrid::CellKey> > gluedCells(gluedNodes.size());
+  vcg::parallel::For(int(gluedNodes.size()), [&](int i) {
+    OG.ComputeMeshCells<CMeshO>(gluedNodes[i]->m->cm, vcg::Matrix44d::Construct(gluedNodes[i]->tr()), gluedCells[i]);
+  }, 0, "", 1);
+  for(size_t i=0;i<gluedNodes.size(); ++i)
+    OG.AddMeshCells(gluedNodes[i]->Id(), gluedCells[i]);
   OG.Compute();
   OG.Dump(stdout);
   // Note: the s and t of the OG translate into fix and mov, respectively.
@@ -167,10 +172,8 @@ void MeshTree::Process(vcg::AlignPair::Param &ap, MeshTree::Param &mtp)
   }
 
   int num_max_thread = 1;
-#ifdef _OPENMP
   if (totalArcNum > 32)
-    num_max_thread = omp_get_max_threads(); 
-#endif
+    num_max_thread = vcg::parallel::MaxThreads();
   cb(0,qUtf8Printable(buf.sprintf("Arc with good overlap %6zu (on  %6zu)\n",totalArcNum,OG.SVA.size())));
   cb(0,qUtf8Printable(buf.sprintf(" %6i preserved %i Recalc \n",preservedArcNum,recalcArcNum)));
 
@@ -177,7 +177,7 @@ int CleanFilter::getRequirements(const QAction *action)
 	case FP_REMOVE_WRT_Q:
 	case FP_BALL_PIVOTING:                return MeshModel::MM_VERTMARK;
 	case FP_REMOVE_ISOLATED_COMPLEXITY:
-	case FP_REMOVE_ISOLATED_DIAMETER:     return MeshModel::MM_FACEFACETOPO | MeshModel::MM_FACEMARK;
+	case FP_REMOVE_ISOLATED_DIAMETER:     return MeshModel::MM_NONE;
 	case FP_REMOVE_TVERTEX_COLLAPSE:      return MeshModel::MM_VERTMARK;
 	case FP_REMOVE_TVERTEX_FLIP:          return MeshModel::MM_FACEFACETOPO | MeshModel::MM_VERTMARK;
 	case FP_REMOVE_NON_MANIF_EDGE:        return MeshModel::MM_FACEFACETOPO | MeshModel::MM_VERTMARK;
@@ -234,6 +234,7 @@ RichParameterList CleanFilter::initParameterList(const QAction *action, const Me
 		parlst.addParam(RichFloat("Clustering",20.0f,"Clustering radius (% of ball radius)","To avoid the creation of too small triangles, if a vertex is found too close to a previous one, it is clustered/merged with it."));
 		parlst.addParam(RichFloat("CreaseThr", 90.0f,"Angle Threshold (degrees)","If we encounter a crease angle that is too large we should stop the ball rolling"));
 		parlst.addParam(RichBool("DeleteFaces",false,"Delete initial set of faces","if true all the initial faces of the mesh are deleted and the whole surface is rebuilt from scratch. Otherwise the current faces are used as a starting point. Useful if you run the algorithm multiple times with an increasing ball radius."));
+		parlst.addParam(RichBool("Partitioned",false,"Partitioned reconstruction","if true the point cloud is split in cells that are reconstructed independently (on several threads, when MeshLab is built with OpenMP) and then stitched together. Much faster on large point clouds on multi-core machines, the result can slightly differ from the standard one along the cell borders."));
 		break;
 	case FP_REMOVE_ISOLATED_DIAMETER:
 		parlst.addParam(RichAbsPerc("MinComponentDiag",md.mm()->cm.bbox.Diag()/10.0f,0.0f,md.mm()->cm.bbox.Diag(),"Enter max diameter of isolated pieces","Delete all the connected components (floating pieces) with a diameter smaller than the specified one"));
@@ -293,7 +294,10 @@ std::map<std::string, QVariant> CleanFilter::applyFilter(const QAction *filter,
 		int startingFn=m.cm.fn;
 		tri::BallPivoting<CMeshO> pivot(m.cm, Radius, Clustering, CreaseThr);
 		// the main processing
-		pivot.BuildMesh(cb);
+		if(par.getBool("Partitioned"))
+			pivot.BuildMeshPartitioned(cb);
+		else
+			pivot.BuildMesh(cb);
 		m.clearDataMask(MeshModel::MM_FACEFACETOPO);
 		log("Reconstructed surface. Added %i faces",m.cm.fn-startingFn);
 	} break;
@@ -8,3 +8,4 @@ SOURCES += \
 
 TARGET = filter_clean
 
+linux:QMAKE_LFLAGS += -fopenmp -lgomp
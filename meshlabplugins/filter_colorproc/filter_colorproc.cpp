@@ -706,7 +706,7 @@ std::map<std::string, QVariant> FilterColorProc::applyFilter(const QAction *filt
 		{
 			m->updateDataMask(MeshModel::MM_FACECOLOR | MeshModel::MM_FACEQUALITY);
 			CMeshO::FaceIterator fi;
-			Distribution<Scalarm> distrib;
+			StreamingDistribution<Scalarm> distrib;
 			Scalarm minV = 0;
 			Scalarm maxV = 1.0;
 			int metric = par.getEnum("Metric");
@@ -828,8 +828,7 @@ std::map<std::string, QVariant> FilterColorProc::applyFilter(const QAction *filt
 
 		case CP_RANDOM_CONNECTED_COMPONENT:
 		{
-			m->updateDataMask(MeshModel::MM_FACEFACETOPO);
-			m->updateDataMask(MeshModel::MM_FACEMARK | MeshModel::MM_FACECOLOR);
+			m->updateDataMask(MeshModel::MM_FACECOLOR);
 			vcg::tri::UpdateColor<CMeshO>::PerFaceRandomConnectedComponent(m->cm);
 			break;
 		}
@@ -7,3 +7,5 @@ SOURCES += \
     filter_colorproc.cpp
 				
 TARGET = filter_colorproc
+
+linux:QMAKE_LFLAGS += -fopenmp -lgomp
@@ -115,8 +115,7 @@ std::map<std::string, QVariant> FilterCreateIso::applyFilter(const QAction *filt
 					volume.Val(i,j,k)=(j-gridSize/2)*(j-gridSize/2)+(k-gridSize/2)*(k-gridSize/2) + i*gridSize/5*(float)math::Perlin::Noise(i*.2,j*.2,k*.2);
 
 		printf("[MARCHING CUBES] Building mesh...");
-		MyMarchingCubes mc(m.cm, walker);
-		walker.BuildMesh<MyMarchingCubes>(m.cm, volume, mc, (gridSize*gridSize)/10,cb);
+		walker.BuildMeshParallel<MyMarchingCubes>(m.cm, volume, (gridSize*gridSize)/10, 0, cb);
 		m.updateBoxAndNormals();
 	}
 	else {
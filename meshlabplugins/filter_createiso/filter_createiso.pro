@@ -8,3 +8,5 @@ SOURCES += \
 		
 TARGET = filter_createiso
 
+linux:QMAKE_LFLAGS += -fopenmp -lgomp
+
@@ -1028,8 +1028,7 @@ std::map<std::string, QVariant> FilterFunctionPlugin::applyFilter(
 		
 		// MARCHING CUBES
 		log("[MARCHING CUBES] Building mesh...");
-		MyMarchingCubes					mc(m.cm, walker);
-		walker.BuildMesh<MyMarchingCubes>(m.cm, volume, mc, 0);
+		walker.BuildMeshParallel<MyMarchingCubes>(m.cm, volume, 0);
 		//    Matrix44m tr; tr.SetIdentity(); tr.SetTranslate(rbb.min[0],rbb.min[1],rbb.min[2]);
 		//    Matrix44m sc; sc.SetIdentity(); sc.SetScale(step,step,step);
 		//    tr=tr*sc;
@@ -8,6 +8,8 @@ SOURCES += \
 
 TARGET = filter_func
 
+linux:QMAKE_LFLAGS += -fopenmp -lgomp
+
 DEFINES += _UNICODE
 
 !CONFIG(system_muparser) INCLUDEPATH += $$MESHLAB_EXTERNAL_DIRECTORY/muparser_v225/include
@@ -157,7 +157,9 @@ public:
         /*Log("Num Diamonds: %d \n",SampledPos.size());*/
 
 
-        for (unsigned int diam=0;diam<SampledPos.size();diam++)
+        ///diamonds are sampled in parallel, each one counting its own samples
+        std::vector<vcg::Point3i> domainCount(SampledPos.size(),vcg::Point3i(0,0,0));
+        vcg::parallel::For(int(SampledPos.size()),[&](int diam){
             for (unsigned int j=0;j<sampleSize;j++)
                 for (unsigned int k=0;k<sampleSize;k++)
                 {
@@ -174,16 +176,9 @@ public:
                     std::vector<CoordType> barys;
                     int domain=isoParam->Theta(I,UV,faces,barys);
 
-                    if (domain==0)
-                        inFace++;
-                    else
-                        if (domain==1)
-                            inEdge++;
-                        else
-                            if (domain==2)
-                                inStar++;
+                    if ((domain>=0)&&(domain<=2))
+                        domainCount[diam][domain]++;
 
-                    global++;
                     //printf("Find in domain: %d \n",domain);
                     ///store value
                     CoordType val=AveragePos(faces,barys);
@@ -191,6 +186,15 @@ public:
                     val=CoordType(0,0,0);*/
                     SampledPos[diam][j][k]=val;
                 }
+        },0,"",1);
+
+        for (unsigned int diam=0;diam<domainCount.size();diam++)
+        {
+            inFace+=domainCount[diam][0];
+            inEdge+=domainCount[diam][1];
+            inStar+=domainCount[diam][2];
+            global+=sampleSize*sampleSize;
+        }
                 return true;
                 /*#ifndef _MESHLAB
                 printf("In Face: %f \n",(PScalarType)inFace/(PScalarType)global);
@@ -1,6 +1,7 @@
 #ifndef DUAL_OPTIMIZER
 #define DUAL_OPTIMIZER
 #include <wrap/callback.h>
+#include <wrap/system/parallel.h>
 #ifndef IMPLICIT
 #include "texcoord_optimization.h"
 #else
@@ -216,82 +217,96 @@ public:
     }
 
 
-    ///initialize Star Submeshes
-    void InitStarSubdivision()
+    ///return the face of the parametrized domain corresponding to the original face f
+    FaceType *GetParamFace(param_domain &dom,FaceType *f)
     {
+        for (unsigned int k=0;k<dom.ordered_faces.size();k++)
+            if (dom.ordered_faces[k]==f)
+                return &dom.domain->face[k];
+        assert(0);
+        return NULL;
+    }
 
-        int index=0;
+    ///copy the parametrization of a domain on the vertices of the original faces
+    void CopyDomainUV(param_domain &dom)
+    {
+        for (unsigned int k=0;k<dom.ordered_faces.size();k++)
+        {
+            FaceType *param=&dom.domain->face[k];
+            FaceType *original=dom.ordered_faces[k];
+            for (int v=0;v<3;v++)
+                original->V(v)->T().P()=param->V(v)->T().P();
+        }
+    }
+
+    ///allocate one Hres mesh for each domain
+    void AllocateSubdivision(const size_t &domainNum)
+    {
         HRES_meshes.clear();
         Ord_HVert.clear();
         ///initialilze vector of meshes
-        HRES_meshes.resize(star_meshes.size());
-        Ord_HVert.resize(star_meshes.size());
-        /*HVert.resize(star_meshes.size());*/
+        HRES_meshes.resize(domainNum);
+        Ord_HVert.resize(domainNum);
         for (unsigned int i=0;i<HRES_meshes.size();i++)
             HRES_meshes[i]=new MeshType();
+    }
+
+    ///initialize Star Submeshes
+    void InitStarSubdivision()
+    {
+        AllocateSubdivision(star_meshes.size());
 
         ///for each vertex of base domain
+        std::vector<VertexType*> centers;
         for (unsigned int i=0;i<domain->vert.size();i++)
-        {
-            VertexType *center=&domain->vert[i];
-            if (!center->IsD())
+            if (!domain->vert[i].IsD())
             {
                 ///copy current parametrization of star
-                for (unsigned int k=0;k<star_meshes[index].ordered_faces.size();k++)
-                {
-                    FaceType *param=&star_meshes[index].domain->face[k];
-                    FaceType *original=star_meshes[index].ordered_faces[k];
-                    for (int v=0;v<3;v++)
-                        original->V(v)->T().P()=param->V(v)->T().P();
-                }
+                CopyDomainUV(star_meshes[centers.size()]);
+                centers.push_back(&domain->vert[i]);
+            }
+
+        ///each Hres vertex falls in exactly one half-star,
+        ///so the stars are parametrized in parallel
+        vcg::parallel::For(int(centers.size()),[&](int index){
+            VertexType *center=centers[index];
 
-                ///get h res vertex on faces composing the star
-                std::vector<VertexType*> Hres,inDomain;
-                getHresVertex<FaceType>(star_meshes[index].ordered_faces,Hres);
+            ///get h res vertex on faces composing the star
+            std::vector<VertexType*> Hres,inDomain;
+            getHresVertex<FaceType>(star_meshes[index].ordered_faces,Hres);
 
-                ///find out the vertices falling in the substar
-                /*HVert[index].reserve(Hres.size()/2);*/
-                for (unsigned int k=0;k<Hres.size();k++)
+            ///find out the vertices falling in the substar
+            for (unsigned int k=0;k<Hres.size();k++)
+            {
+                VertexType* chosen;
+                VertexType* test=Hres[k];
+                CoordType proj=Warp(test);
+                FaceType * father=test->father;
+                CoordType bary=test->Bary;
+                ///get index of half-star
+                int vertIndex=getVertexStar(proj,father);
+                chosen=father->V(vertIndex);
+                ///if is part of current half star
+                if (chosen==center)
                 {
-                    VertexType* chosen;
-                    VertexType* test=Hres[k];
-                    CoordType proj=Warp(test);
-                    FaceType * father=test->father;
-                    CoordType bary=test->Bary;
-                    ///get index of half-star
-                    int index=getVertexStar(proj,father);
-                    chosen=father->V(index);
-                    ///if is part of current half star
-                    if (chosen==center)
-                    {
-                        inDomain.push_back(test);
-                        ///parametrize it
-                        InterpolateUV<MeshType>(father,bary,test->T().U(),test->T().V());
-                    }
+                    inDomain.push_back(test);
+                    ///parametrize it
+                    InterpolateUV<MeshType>(GetParamFace(star_meshes[index],father),bary,test->T().U(),test->T().V());
                 }
-                ///create Hres mesh already parametrized
-                std::vector<FaceType*> OrderedFaces;
-                CopyMeshFromVertices<MeshType>(inDomain,Ord_HVert[index],OrderedFaces,*HRES_meshes[index]);
-                index++;
             }
-        }
+            ///create Hres mesh already parametrized
+            std::vector<FaceType*> OrderedFaces;
+            CopyMeshFromVertices<MeshType>(inDomain,Ord_HVert[index],OrderedFaces,*HRES_meshes[index]);
+        },0,"",1);
     }
 
-    ///initialize Star Submeshes
+    ///initialize Diamond Submeshes
     void InitDiamondSubdivision()
     {
-
-        int index=0;
-        HRES_meshes.clear();
-        Ord_HVert.clear();
-        ///initialilze vector of meshes
-        HRES_meshes.resize(diamond_meshes.size());
-        Ord_HVert.resize(diamond_meshes.size());
-        /*HVert.resize(star_meshes.size());*/
-        for (unsigned int i=0;i<HRES_meshes.size();i++)
-            HRES_meshes[i]=new MeshType();
+        AllocateSubdivision(diamond_meshes.size());
 
         ///for each edge of base domain
+        std::vector<std::pair<FaceType*,int> > edges;
         for (unsigned int i=0;i<domain->face.size();i++)
         {
             FaceType *f0=&domain->face[i];
@@ -304,77 +319,71 @@ public:
                 if (f1<f0)
                 {
                     ///copy current parametrization of diamond
-                    for (unsigned int k=0;k<diamond_meshes[index].ordered_faces.size();k++)
-                    {
-                        FaceType *param=&diamond_meshes[index].domain->face[k];
-                        FaceType *original=diamond_meshes[index].ordered_faces[k];
-                        for (int v=0;v<3;v++)
-                            original->V(v)->T().P()=param->V(v)->T().P();
-                    }
+                    CopyDomainUV(diamond_meshes[edges.size()]);
+                    edges.push_back(std::pair<FaceType*,int>(f0,eNum));
+                }
+            }
+        }
 
-                    ///get h res vertex on faces composing the diamond
-                    std::vector<VertexType*> Hres,inDomain;
-                    getHresVertex<FaceType>(diamond_meshes[index].ordered_faces,Hres);
+        ///each Hres vertex falls in exactly one half-diamond,
+        ///so the diamonds are parametrized in parallel
+        vcg::parallel::For(int(edges.size()),[&](int index){
+            FaceType *f0=edges[index].first;
+            int eNum=edges[index].second;
 
-                    ///find out the vertices falling in the half-diamond
-                    /*HVert[index].reserve(Hres.size()/2);*/
-                    for (unsigned int k=0;k<Hres.size();k++)
-                    {
-                        //VertexType* chosen;
-                        VertexType* test=Hres[k];
-                        CoordType proj=Warp(test);
-                        FaceType * father=test->father;
-                        CoordType bary=test->Bary;
-                        ///get index of half-star
-                        int index=getEdgeDiamond(proj,father);
-                        ///if is part of current half star
-                        if (index==eNum)
-                        {
-                            inDomain.push_back(test);
-                            ///parametrize it
-                            InterpolateUV<MeshType>(father,bary,test->T().U(),test->T().V());
-                        }
-                    }
-                    ///create Hres mesh already parametrized
-                    std::vector<FaceType*> OrderedFaces;
-                    CopyMeshFromVertices<MeshType>(inDomain,Ord_HVert[index],OrderedFaces,*HRES_meshes[index]);
-                    index++;
+            ///get h res vertex on faces composing the diamond
+            std::vector<VertexType*> Hres,inDomain;
+            getHresVertex<FaceType>(diamond_meshes[index].ordered_faces,Hres);
+
+            ///find out the vertices falling in the half-diamond
+            for (unsigned int k=0;k<Hres.size();k++)
+            {
+                VertexType* test=Hres[k];
+                CoordType proj=Warp(test);
+                FaceType * father=test->father;
+                CoordType bary=test->Bary;
+                ///get index of half-diamond and the index of the shared edge
+                ///as seen from the father
+                int edgeIndex=getEdgeDiamond(proj,father);
+                int sharedEdge=(father==f0)?eNum:f0->FFi(eNum);
+                ///if is part of current half diamond
+                if (edgeIndex==sharedEdge)
+                {
+                    inDomain.push_back(test);
+                    ///parametrize it
+                    InterpolateUV<MeshType>(GetParamFace(diamond_meshes[index],father),bary,test->T().U(),test->T().V());
                 }
             }
-        }
+            ///create Hres mesh already parametrized
+            std::vector<FaceType*> OrderedFaces;
+            CopyMeshFromVertices<MeshType>(inDomain,Ord_HVert[index],OrderedFaces,*HRES_meshes[index]);
+        },0,"",1);
     }
 
-    ///initialize Star Submeshes
+    ///initialize Face Submeshes
     void InitFaceSubdivision()
     {
-
-        int index=0;
-        HRES_meshes.clear();
-        Ord_HVert.clear();
-        ///initialilze vector of meshes
-        HRES_meshes.resize(face_meshes.size());
-        Ord_HVert.resize(face_meshes.size());
-
-        for (unsigned int i=0;i<HRES_meshes.size();i++)
-            HRES_meshes[i]=new MeshType();
+        AllocateSubdivision(face_meshes.size());
 
         ///for each face of base domain
+        int faceNum=0;
         for (unsigned int i=0;i<domain->face.size();i++)
         {
             FaceType *f0=&domain->face[i];
             if (f0->IsD())
                 break;
-            ///copy current parametrization of face
-            FaceType *param=&face_meshes[index].domain->face[0];
-            FaceType *original=face_meshes[index].ordered_faces[0];
+            assert(face_meshes[faceNum].domain->vn==3);
+            assert(face_meshes[faceNum].domain->fn==1);
+            assert(face_meshes[faceNum].ordered_faces.size()==1);
+            assert(face_meshes[faceNum].ordered_faces[0]==f0);
 
-            assert(face_meshes[index].domain->vn==3);
-            assert(face_meshes[index].domain->fn==1);
-            assert(face_meshes[index].ordered_faces.size()==1);
-            assert(original==f0);
+            ///copy current parametrization of face
+            CopyDomainUV(face_meshes[faceNum]);
+            faceNum++;
+        }
 
-            for (int v=0;v<3;v++)
-                original->V(v)->T().P()=param->V(v)->T().P();
+        vcg::parallel::For(faceNum,[&](int index){
+            FaceType *param=&face_meshes[index].domain->face[0];
 
             ///get h res vertex on faces composing the diamond
             std::vector<VertexType*> inDomain;
@@ -385,25 +394,22 @@ public:
             {
                 VertexType* test=inDomain[k];
                 FaceType * father=test->father;
-                assert(father==f0);
+                assert(father==face_meshes[index].ordered_faces[0]);
                 CoordType bary=test->Bary;
-                InterpolateUV<MeshType>(father,bary,test->T().U(),test->T().V());
+                InterpolateUV<MeshType>(param,bary,test->T().U(),test->T().V());
             }
             ///create Hres mesh already parametrized
             std::vector<FaceType*> OrderedFaces;
             CopyMeshFromVertices<MeshType>(inDomain,Ord_HVert[index],OrderedFaces,*HRES_meshes[index]);
-            index++;
-        }
+        },0,"",1);
     }
 
-
     void MinimizeStep(const int &phaseNum)
     {
 
 
-        //Ord_HVert[index]
-        for (unsigned int i=0;i<HRES_meshes.size();i++)
-        {
+        ///the Hres meshes of different domains are disjoint copies: optimize them in parallel
+        vcg::parallel::For(int(HRES_meshes.size()),[&](int i){
 
             MeshType *currMesh=HRES_meshes[i];
             if (currMesh->fn>0)
@@ -524,7 +530,7 @@ public:
             }
             ///delete current mesh
             delete(HRES_meshes[i]);
-        }
+        },0,"",1);
 
         ///clear father and bary
         for (unsigned int i=0;i<domain->face.size();i++)
@@ -9,6 +9,7 @@
 #include "uv_grid.h"
 #include <vcg/complex/algorithms/clean.h>
 #include <vcg/complex/algorithms/stat.h>
+#include <wrap/system/parallel.h>
 #include "param_mesh.h"
 
 ///ABSTRACT MESH THAT MAINTAINS THE WHOLE PARAMETERIZATION
@@ -192,12 +193,6 @@ void CopyMeshFromVerticesAbs(std::vector<typename MeshType::VertexType*> &vertic
         typedef typename MeshType::VertexType VertexType;
         typedef typename MeshType::FaceType FaceType;
 
-        typename std::vector<VertexType*>::const_iterator iteV;
-    for (iteV=vertices.begin();iteV!=vertices.end();iteV++)
-        (*iteV)->ClearV();
-
-
-
     OrderedVertices.clear();
 
     ///vertex-vertex reference
@@ -213,10 +208,10 @@ void CopyMeshFromVerticesAbs(std::vector<typename MeshType::VertexType*> &vertic
     new_mesh.vn=0;
     new_mesh.fn=0;
 
-    ///set vertices as selected
-
-    for (iteV=vertices.begin();iteV!=vertices.end();iteV++)
-        (*iteV)->SetV();
+    ///sorted copy of the group used to test membership: no flags are touched
+    ///so that the submeshes of different domains can be built in parallel
+    std::vector<VertexType*> inGroup(vertices.begin(),vertices.end());
+    std::sort(inGroup.begin(),inGroup.end());
 
     ///getting inside faces
         typename std::vector<FaceType*>::const_iterator iteF;
@@ -227,7 +222,9 @@ void CopyMeshFromVerticesAbs(std::vector<typename MeshType::VertexType*> &vertic
         VertexType* v0=(*iteF)->V(0);
         VertexType* v1=(*iteF)->V(1);
         VertexType* v2=(*iteF)->V(2);
-        bool inside=((*v0).IsV()&&(*v1).IsV()&&(*v2).IsV());
+        bool inside=(std::binary_search(inGroup.begin(),inGroup.end(),v0)&&
+                     std::binary_search(inGroup.begin(),inGroup.end(),v1)&&
+                     std::binary_search(inGroup.begin(),inGroup.end(),v2));
         if (inside)
             OrderedFaces.push_back((*iteF));
     }
@@ -281,11 +278,6 @@ void CopyMeshFromVerticesAbs(std::vector<typename MeshType::VertexType*> &vertic
             (*iteF1).V(j)=(*iteMap).second;
         }
     }
-
-    ///clear flags
-    for (iteV=vertices.begin();iteV!=vertices.end();iteV++)
-        (*iteV)->ClearV();
-
 }
 
 
@@ -408,7 +400,7 @@ private:
     }
 
 
-    void GetHresVert(int &I,std::vector<ParamVertex*> &HresVert)
+    void GetHresVert(const int &I,std::vector<ParamVertex*> &HresVert)
     {
         for (unsigned int k=0;k<face_to_vert[I].size();k++)
         {
@@ -417,82 +409,141 @@ private:
         }
     }
 
-    ///initialize star parametrization
-    void InitStar()
+    ///initialize the star domain of index "index" centered in abstract vertex "center"
+    void InitStarDomain(const int &index,AbstractVertex *center)
     {
-        ///for each vertex
-        int index=0;
-        for (unsigned int i=0;i<abstract_mesh->vert.size();i++)
-        {
-            if (!(abstract_mesh->vert[i].IsD()))
-            {
-                std::vector<AbstractVertex*> starCenter;
-                starCenter.push_back(&abstract_mesh->vert[i]);
+        std::vector<AbstractVertex*> starCenter;
+        starCenter.push_back(center);
 
-                star_meshes[index].domain=new AbstractMesh();
-                star_meshes[index].HresDomain=new ParamMesh();
+        star_meshes[index].domain=new AbstractMesh();
+        star_meshes[index].HresDomain=new ParamMesh();
 
-                ///create star
-                std::vector<AbstractFace*> ordered_faces;
-                std::vector<AbstractVertex*> ordered_vert;
-                //CreateMeshVertexStar(starCenter,ordered_faces,*star_meshes[index].domain);
-                ///get faces referenced by vertices
-                getSharedFace<AbstractMesh>(starCenter,ordered_faces);
+        ///create star
+        std::vector<AbstractFace*> ordered_faces;
+        std::vector<AbstractVertex*> ordered_vert;
+        //CreateMeshVertexStar(starCenter,ordered_faces,*star_meshes[index].domain);
+        ///get faces referenced by vertices
+        getSharedFace<AbstractMesh>(starCenter,ordered_faces);
 
-                CopyMeshFromFacesAbs<AbstractMesh>(ordered_faces,ordered_vert,*star_meshes[index].domain);
+        CopyMeshFromFacesAbs<AbstractMesh>(ordered_faces,ordered_vert,*star_meshes[index].domain);
 
-                UpdateTopologies(star_meshes[index].domain);
+        UpdateTopologies(star_meshes[index].domain);
 
-                ///and parametrize it
-                ParametrizeStarEquilateral<AbstractMesh>(*star_meshes[index].domain,1.0);
+        ///and parametrize it
+        ParametrizeStarEquilateral<AbstractMesh>(*star_meshes[index].domain,1.0);
 
-                ///set other components as reefrence to original faces
-                star_meshes[index].local_to_global.resize(star_meshes[index].domain->face.size());
-                std::vector<ParamVertex*> HresVert;
-                for (unsigned int k=0;k<star_meshes[index].domain->face.size();k++)
-                {
-                    int IndexF;
-                    getFaceIndexFromPointer(ordered_faces[k],IndexF);
-                    star_meshes[index].local_to_global[k]=IndexF;
-                    ///get H res vertex
-                    GetHresVert(IndexF,HresVert);
-                }
-
-                ///copy Hres mesh
-                std::vector<ParamVertex*> OrderedVertices;
-                CopyMeshFromVerticesAbs(HresVert,OrderedVertices,star_meshes[index].ordered_faces,*star_meshes[index].HresDomain);
-                ///set new parametrization values
-                for (unsigned int k=0;k<star_meshes[index].HresDomain->vert.size();k++)
-                {
-                    ParamVertex * v=&star_meshes[index].HresDomain->vert[k];
-                    CoordType bary=CoordType(v->T().U(),v->T().V(),1-v->T().U()-v->T().V());
-                    AbstractMesh *paramDomain=star_meshes[index].domain;
-                    ///get the right face on the parametrized domain
-                    int Father=v->T().N();
-                    int faceNum=-1;
-                    for (unsigned int i=0;i<star_meshes[index].local_to_global.size();i++)
-                    {
-                        if (star_meshes[index].local_to_global[i]==Father)
-                            faceNum=i;
-                    }
-                    AbstractFace *faceDom=&paramDomain->face[faceNum];
-                    v->T().P()=(faceDom->V(0)->T().P())*bary.X()+(faceDom->V(1)->T().P())*bary.Y()+(faceDom->V(2)->T().P())*bary.Z();
-                    assert(faceNum!=-1);
-                }
-                star_meshes[index].InitGrid();
-                index++;
+        ///set other components as reefrence to original faces
+        star_meshes[index].local_to_global.resize(star_meshes[index].domain->face.size());
+        std::vector<ParamVertex*> HresVert;
+        for (unsigned int k=0;k<star_meshes[index].domain->face.size();k++)
+        {
+            int IndexF;
+            getFaceIndexFromPointer(ordered_faces[k],IndexF);
+            star_meshes[index].local_to_global[k]=IndexF;
+            ///get H res vertex
+            GetHresVert(IndexF,HresVert);
+        }
 
+        ///copy Hres mesh
+        std::vector<ParamVertex*> OrderedVertices;
+        CopyMeshFromVerticesAbs(HresVert,OrderedVertices,star_meshes[index].ordered_faces,*star_meshes[index].HresDomain);
+        ///set new parametrization values
+        for (unsigned int k=0;k<star_meshes[index].HresDomain->vert.size();k++)
+        {
+            ParamVertex * v=&star_meshes[index].HresDomain->vert[k];
+            CoordType bary=CoordType(v->T().U(),v->T().V(),1-v->T().U()-v->T().V());
+            AbstractMesh *paramDomain=star_meshes[index].domain;
+            ///get the right face on the parametrized domain
+            int Father=v->T().N();
+            int faceNum=-1;
+            for (unsigned int i=0;i<star_meshes[index].local_to_global.size();i++)
+            {
+                if (star_meshes[index].local_to_global[i]==Father)
+                    faceNum=i;
             }
+            AbstractFace *faceDom=&paramDomain->face[faceNum];
+            v->T().P()=(faceDom->V(0)->T().P())*bary.X()+(faceDom->V(1)->T().P())*bary.Y()+(faceDom->V(2)->T().P())*bary.Z();
+            assert(faceNum!=-1);
         }
+        star_meshes[index].InitGrid();
     }
 
+    ///initialize star parametrization
+    void InitStar()
+    {
+        ///one star for each vertex
+        std::vector<AbstractVertex*> centers;
+        for (unsigned int i=0;i<abstract_mesh->vert.size();i++)
+            if (!(abstract_mesh->vert[i].IsD()))
+                centers.push_back(&abstract_mesh->vert[i]);
 
+        ///stars only read the abstract and the parametrized mesh
+        vcg::parallel::For(int(centers.size()),[&](int index){
+            InitStarDomain(index,centers[index]);
+        },0,"",1);
+    }
 
-    void InitDiamond(const PScalarType &edge_len=1.0)
+    ///initialize the diamond domain of index "index" on the edge "num0" of face "f0"
+    void InitDiamondDomain(const int &index,AbstractFace *f0,const int &num0,
+                           const PScalarType &edge_len)
     {
+        AbstractFace * f1=f0->FFp(num0);
+        int num1=f0->FFi(num0);
+
+        ///copy the mesh
+        std::vector<AbstractFace*> faces;
+        faces.push_back(f0);
+        faces.push_back(f1);
+
+        diamond_meshes[index].domain=new AbstractMesh();
+        diamond_meshes[index].HresDomain=new ParamMesh();
+
+        ///create a copy of the mesh
+        std::vector<AbstractVertex*> orderedVertex;
+        CopyMeshFromFacesAbs<AbstractMesh>(faces,orderedVertex,*diamond_meshes[index].domain);
+        UpdateTopologies<AbstractMesh>(diamond_meshes[index].domain);
+
+        ///set other components
+        int index0,index1;
+        getFaceIndexFromPointer(f0,index0);
+        getFaceIndexFromPointer(f1,index1);
+        diamond_meshes[index].local_to_global.resize(2);
+        diamond_meshes[index].local_to_global[0]=index0;
+        diamond_meshes[index].local_to_global[1]=index1;
+
+        ///parametrize locally
+        ParametrizeDiamondEquilateral<AbstractMesh>(*diamond_meshes[index].domain,num0,num1,edge_len);
+        ///add h resolution vertices
+        std::vector<ParamVertex*> HresVert;
+        GetHresVert(index0,HresVert);
+        GetHresVert(index1,HresVert);
+        std::vector<ParamVertex*> OrderedVertices;
+        CopyMeshFromVerticesAbs(HresVert,OrderedVertices,diamond_meshes[index].ordered_faces,*diamond_meshes[index].HresDomain);
+        ///set new parametrization values
+        for (unsigned int k=0;k<diamond_meshes[index].HresDomain->vert.size();k++)
+        {
+            ParamVertex * v=&diamond_meshes[index].HresDomain->vert[k];
+            CoordType bary=CoordType(v->T().U(),v->T().V(),1-v->T().U()-v->T().V());
+            AbstractMesh *paramDomain=diamond_meshes[index].domain;
+            ///get the right face on the parametrized domain
+            int Father=v->T().N();
+            int faceNum=-1;
+            for (unsigned int i=0;i<diamond_meshes[index].local_to_global.size();i++)
+            {
+                if (diamond_meshes[index].local_to_global[i]==Father)
+                    faceNum=i;
+            }
+            assert(faceNum!=-1);
+            AbstractFace *faceDom=&paramDomain->face[faceNum];
+            v->T().P()=(faceDom->V(0)->T().P())*bary.X()+(faceDom->V(1)->T().P())*bary.Y()+(faceDom->V(2)->T().P())*bary.Z();
+        }
+        diamond_meshes[index].InitGrid();
+    }
 
+    void InitDiamond(const PScalarType &edge_len=1.0)
+    {
         ///for each face
-        int index=0;
+        std::vector<std::pair<AbstractFace*,int> > edges;
         EdgeTab.clear();
         for (unsigned int i=0;i<abstract_mesh->face.size();i++)
         {
@@ -505,10 +556,6 @@ private:
                     AbstractFace * f1=f0->FFp(j);
                     if (f1>f0)
                     {
-
-                        int num0=j;
-                        int num1=f0->FFi(j);
-
                         ///add to domain map
                         AbstractVertex *v0,*v1;
                         v0=f0->V(j);
@@ -519,118 +566,75 @@ private:
                         else
                             k=keyEdgeType(v1,v0);
 
-                        std::pair<keyEdgeType,int> entry=std::pair<keyEdgeType,int>(k,index);
+                        std::pair<keyEdgeType,int> entry=std::pair<keyEdgeType,int>(k,int(edges.size()));
                         EdgeTab.insert(entry);
-
-
-
-                        ///copy the mesh
-                        std::vector<AbstractFace*> faces;
-                        faces.push_back(f0);
-                        faces.push_back(f1);
-
-                        diamond_meshes[index].domain=new AbstractMesh();
-                        diamond_meshes[index].HresDomain=new ParamMesh();
-
-                        ///create a copy of the mesh
-                        std::vector<AbstractVertex*> orderedVertex;
-                        CopyMeshFromFacesAbs<AbstractMesh>(faces,orderedVertex,*diamond_meshes[index].domain);
-                        UpdateTopologies<AbstractMesh>(diamond_meshes[index].domain);
-
-                        ///set other components
-                        int index0,index1;
-                        getFaceIndexFromPointer(f0,index0);
-                        getFaceIndexFromPointer(f1,index1);
-                        diamond_meshes[index].local_to_global.resize(2);
-                        diamond_meshes[index].local_to_global[0]=index0;
-                        diamond_meshes[index].local_to_global[1]=index1;
-
-                        ///parametrize locally
-                        ParametrizeDiamondEquilateral<AbstractMesh>(*diamond_meshes[index].domain,num0,num1,edge_len);
-                        ///add h resolution vertices
-                        std::vector<ParamVertex*> HresVert;
-                        GetHresVert(index0,HresVert);
-                        GetHresVert(index1,HresVert);
-                        std::vector<ParamVertex*> OrderedVertices;
-                        CopyMeshFromVerticesAbs(HresVert,OrderedVertices,diamond_meshes[index].ordered_faces,*diamond_meshes[index].HresDomain);
-                        ///set new parametrization values
-                        for (unsigned int k=0;k<diamond_meshes[index].HresDomain->vert.size();k++)
-                        {
-                            ParamVertex * v=&diamond_meshes[index].HresDomain->vert[k];
-                            CoordType bary=CoordType(v->T().U(),v->T().V(),1-v->T().U()-v->T().V());
-                            AbstractMesh *paramDomain=diamond_meshes[index].domain;
-                            ///get the right face on the parametrized domain
-                            int Father=v->T().N();
-                            int faceNum=-1;
-                            for (unsigned int i=0;i<diamond_meshes[index].local_to_global.size();i++)
-                            {
-                                if (diamond_meshes[index].local_to_global[i]==Father)
-                                    faceNum=i;
-                            }
-                            assert(faceNum!=-1);
-                            AbstractFace *faceDom=&paramDomain->face[faceNum];
-                            v->T().P()=(faceDom->V(0)->T().P())*bary.X()+(faceDom->V(1)->T().P())*bary.Y()+(faceDom->V(2)->T().P())*bary.Z();
-
-
-                        }
-                        diamond_meshes[index].InitGrid();
-                        index++;
+                        edges.push_back(std::pair<AbstractFace*,int>(f0,j));
                     }
                 }
             }
         }
-    }
 
+        ///diamonds only read the abstract and the parametrized mesh
+        vcg::parallel::For(int(edges.size()),[&](int index){
+            InitDiamondDomain(index,edges[index].first,edges[index].second,edge_len);
+        },0,"",1);
+    }
 
-    void InitFace(const PScalarType &edge_len=1)
+    ///initialize the face domain of index "index" on the abstract face of index "I"
+    void InitFaceDomain(const int &index,const int &I,const PScalarType &edge_len)
     {
-        ///for each face
-        int index=0;
-        for (unsigned int i=0;i<abstract_mesh->face.size();i++)
-        {
-            if (!(abstract_mesh->face[i].IsD()))
-            {
-                AbstractFace *f0=&abstract_mesh->face[i];
+        AbstractFace *f0=&abstract_mesh->face[I];
 
-                std::vector<AbstractFace*> faces;
-                faces.push_back(f0);
+        std::vector<AbstractFace*> faces;
+        faces.push_back(f0);
 
-                ///create the mesh
-                face_meshes[index].domain=new AbstractMesh();
-                face_meshes[index].HresDomain=new ParamMesh();
+        ///create the mesh
+        face_meshes[index].domain=new AbstractMesh();
+        face_meshes[index].HresDomain=new ParamMesh();
 
-                std::vector<AbstractVertex*> orderedVertex;
-                CopyMeshFromFacesAbs<AbstractMesh>(faces,orderedVertex,*face_meshes[index].domain);
+        std::vector<AbstractVertex*> orderedVertex;
+        CopyMeshFromFacesAbs<AbstractMesh>(faces,orderedVertex,*face_meshes[index].domain);
 
-                assert(face_meshes[index].domain->vn==3);
-                assert(face_meshes[index].domain->fn==1);
+        assert(face_meshes[index].domain->vn==3);
+        assert(face_meshes[index].domain->fn==1);
 
-                ///initialize auxiliary structures
-                face_meshes[index].local_to_global.resize(1);
-                face_meshes[index].local_to_global[0]=i;
+        ///initialize auxiliary structures
+        face_meshes[index].local_to_global.resize(1);
+        face_meshes[index].local_to_global[0]=I;
 
-                ///parametrize it
-                ParametrizeFaceEquilateral<AbstractMesh>(*face_meshes[index].domain,edge_len);
+        ///parametrize it
+        ParametrizeFaceEquilateral<AbstractMesh>(*face_meshes[index].domain,edge_len);
 
-                ///add h resolution vertices
-                std::vector<ParamVertex*> HresVert;
-                GetHresVert(index,HresVert);
-                std::vector<ParamVertex*> OrderedVertices;
-                CopyMeshFromVerticesAbs(HresVert,OrderedVertices,face_meshes[index].ordered_faces,*face_meshes[index].HresDomain);
-                ///set new parametrization values
-                for (unsigned int k=0;k<face_meshes[index].HresDomain->vert.size();k++)
-                {
-                    ParamVertex * v=&face_meshes[index].HresDomain->vert[k];
-                    CoordType bary=CoordType(v->T().U(),v->T().V(),1-v->T().U()-v->T().V());
-                    AbstractMesh *paramDomain=face_meshes[index].domain;
-                    AbstractFace *faceDom=&paramDomain->face[0];
-                    v->T().P()=(faceDom->V(0)->T().P())*bary.X()+(faceDom->V(1)->T().P())*bary.Y()+(faceDom->V(2)->T().P())*bary.Z();
-                }
-
-                face_meshes[index].InitGrid();
-                index++;
-            }
+        ///add h resolution vertices
+        std::vector<ParamVertex*> HresVert;
+        GetHresVert(index,HresVert);
+        std::vector<ParamVertex*> OrderedVertices;
+        CopyMeshFromVerticesAbs(HresVert,OrderedVertices,face_meshes[index].ordered_faces,*face_meshes[index].HresDomain);
+        ///set new parametrization values
+        for (unsigned int k=0;k<face_meshes[index].HresDomain->vert.size();k++)
+        {
+            ParamVertex * v=&face_meshes[index].HresDomain->vert[k];
+            CoordType bary=CoordType(v->T().U(),v->T().V(),1-v->T().U()-v->T().V());
+            AbstractMesh *paramDomain=face_meshes[index].domain;
+            AbstractFace *faceDom=&paramDomain->face[0];
+            v->T().P()=(faceDom->V(0)->T().P())*bary.X()+(faceDom->V(1)->T().P())*bary.Y()+(faceDom->V(2)->T().P())*bary.Z();
         }
+
+        face_meshes[index].InitGrid();
+    }
+
+    void InitFace(const PScalarType &edge_len=1)
+    {
+        ///for each face
+        std::vector<int> faces;
+        for (unsigned int i=0;i<abstract_mesh->face.size();i++)
+            if (!(abstract_mesh->face[i].IsD()))
+                faces.push_back(i);
+
+        ///faces only read the abstract and the parametrized mesh
+        vcg::parallel::For(int(faces.size()),[&](int index){
+            InitFaceDomain(index,faces[index],edge_len);
+        },0,"",1);
     }
 
     void getFaceIndexFromPointer(AbstractFace * f,int &index)
@@ -851,9 +851,8 @@ public:
             for (int i=0;i<(int)final_mesh.vert.size();i++)
                 final_mesh.vert[i].RPos=para_mesh0.vert[i].P();
 
-            ///finally merge in between
-            for (int i=0;i<(int)para_mesh0.vert.size();i++)
-            {
+            ///finally merge in between: each vertex is mapped independently
+            vcg::parallel::For(int(para_mesh0.vert.size()),[&](int i){
                 ///get the index of the first parametrization process
                 int Index0=para_mesh0.vert[i].T().N();
                 ///find the parametrization coordinates
@@ -877,7 +876,7 @@ public:
                 //assert(!base_mesh.face[I_final].IsD());
                 //final_mesh.vert[i].Bary=bary2;
                 AssingFather(final_mesh.vert[i],&base_mesh.face[I_final],bary2,base_mesh);
-            }
+            });
 
             ///set father to son link
             for (int i=0;i<(int)final_mesh.vert.size();i++)
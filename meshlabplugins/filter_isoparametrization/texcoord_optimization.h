@@ -5,9 +5,6 @@
 
 
 #include <vcg/container/simple_temporary_data.h>
-#ifdef _USE_OMP
-#include <omp.h>
-#endif
 /*
 
 SINGLE PATCH TEXTURE OPTIMIZATIONS
@@ -270,16 +267,10 @@ public:
 	 int k;
          auto n=Super::m.vert.size();
          auto n1=Super::m.face.size();
-#ifdef _USE_OMP
-	 #pragma omp parallel for default (none) shared(n) private(k)
-#endif
 	 for (k=0;k<n;k++) 
 	 {
 	   sum[k]=Point2<ScalarType>(0,0); 
 	 }
-#ifdef _USE_OMP
-	 #pragma omp parallel for default (none) shared(n1) private(k)
-#endif
 	 for (k=0;k<n1;k++)
 	 {
 	   sumX[k].X()=0;
@@ -289,9 +280,6 @@ public:
 	   sumY[k].Y()=0;
 	   sumY[k].Z()=0;
 	 }
-#ifdef _USE_OMP
-	 #pragma omp barrier
-#endif
  }
 
 ScalarType getProjArea()
@@ -300,15 +288,9 @@ ScalarType getProjArea()
           int n=Super::m.face.size();
 	  ScalarType tot_proj_area=0;
 	 //# pragma omp parallel for 
-#ifdef _USE_OMP
-	  #pragma omp parallel for default (none) shared(n) private(k) reduction(+: tot_proj_area)
-#endif
 	  for (k=0;k<n; k++) {
 	      tot_proj_area+=Area(k);
 	  }
-#ifdef _USE_OMP
-	  #pragma omp barrier
-#endif
 	  return (tot_proj_area);
 }
 
@@ -362,9 +344,6 @@ void UpdateSum(const double &scale)
 	 FaceType *f;
 	 ScalarType myscale=scale;
 	 vcg::Point2<ScalarType> val0,val1,val2;
-#ifdef _USE_OMP
-	  #pragma omp parallel for default (none) shared(n,myscale) private(k,f,val0,val1,val2) 
-#endif
 	  for (k=0;k<n; k++) {
                           f=&Super::m.face[k];
 			  val0=VertValue(k,0,myscale);
@@ -377,9 +356,6 @@ void UpdateSum(const double &scale)
 			  sumY[k].V(1)=val1.Y();
 			  sumY[k].V(2)=val2.Y();
 	  }
-#ifdef _USE_OMP
-	  #pragma omp barrier
-#endif
 }
 
 
@@ -26,8 +26,10 @@
 #include <time.h>
 
 #include "filter_layer.h"
+#include <common/ml_memory_accounting.h>
 
 #include<vcg/complex/append.h>
+#include <wrap/system/parallel.h>
 #include <QImageReader>
 #include <QDir>
 #include <QXmlStreamWriter>
@@ -346,6 +348,7 @@ std::map<std::string, QVariant> FilterLayerPlugin::applyFilter(
 	case FP_DUPLICATE :
 	{
 		MeshModel *currentModel = md.mm();				// source = current
+		MLMemoryReservation reservation(currentModel->memoryUsage(), "the duplicated layer");
 		QString newName = currentModel->label() + "_copy";
 		MeshModel *destModel = md.addNewMesh("", newName, true); // After Adding a mesh to a MeshDocument the new mesh is the current one
 		destModel->updateDataMask(currentModel);
@@ -369,32 +372,34 @@ std::map<std::string, QVariant> FilterLayerPlugin::applyFilter(
 		bool mergeVertices = par.getBool("MergeVertices");
 		bool alsoUnreferenced = par.getBool("AlsoUnreferenced");
 
-		MeshModel *destModel = md.addNewMesh("", "Merged Mesh", true);
-
 		QList<MeshModel *> toBeDeletedList;
-
-		int cnt=0;
+		std::vector<const CMeshO *> sources;
+		qint64 mergedBytes = 0;
 		for(MeshModel *mmp: md.meshIterator())
 		{
-			++cnt;
 			if(mmp->isVisible() || !mergeVisible)
 			{
-				if (mmp != destModel)
-				{
-					cb(cnt*100/md.meshNumber(), "Merging layers...");
-					tri::UpdatePosition<CMeshO>::Matrix(mmp->cm,mmp->cm.Tr,true);
-					toBeDeletedList.push_back(mmp);
-					if(!alsoUnreferenced)
-					{
-						vcg::tri::Clean<CMeshO>::RemoveUnreferencedVertex(mmp->cm);
-					}
-					destModel->updateDataMask(mmp);
-					tri::Append<CMeshO, CMeshO>::Mesh(destModel->cm, mmp->cm);
-					tri::UpdatePosition<CMeshO>::Matrix(mmp->cm,Inverse(mmp->cm.Tr),true);
-
-				}
+				toBeDeletedList.push_back(mmp);
+				sources.push_back(&mmp->cm);
+				mergedBytes += mmp->memoryUsage();
 			}
 		}
+		MLMemoryReservation reservation(mergedBytes, "the merged layer");
+
+		MeshModel *destModel = md.addNewMesh("", "Merged Mesh", true);
+		for(MeshModel *mmp: toBeDeletedList)
+			destModel->updateDataMask(mmp);
+
+		// each layer is copied into its own slice of the merged mesh, then the slice is transformed
+		cb(10, "Merging layers...");
+		CMeshO &dm = destModel->cm;
+		std::vector<size_t> vertOffset, faceOffset;
+		tri::Append<CMeshO, CMeshO>::Meshes(dm, sources, !alsoUnreferenced, &vertOffset, &faceOffset);
+
+		cb(60, "Applying layer transformations...");
+		parallel::For(int(sources.size()), [&](int k) {
+			tri::UpdatePosition<CMeshO>::Matrix(dm, sources[k]->Tr, vertOffset[k], vertOffset[k+1], faceOffset[k], faceOffset[k+1], true);
+		}, 0, "", 1);
 
 		if( deleteLayer )
 		{
@@ -418,27 +423,56 @@ std::map<std::string, QVariant> FilterLayerPlugin::applyFilter(
 	{
 		MeshModel *currentModel = md.mm();
 		CMeshO &cm = md.mm()->cm;
-		md.mm()->updateDataMask(MeshModel::MM_FACEFACETOPO);
-		std::vector< std::pair<int,CMeshO::FacePointer> > connectedCompVec;
-		int numCC = tri::Clean<CMeshO>::ConnectedComponents(cm,  connectedCompVec);
+		MLMemoryReservation reservation(currentModel->memoryUsage(), "the component layers");
+		std::vector<int> faceCC;
+		int numCC = tri::Clean<CMeshO>::FaceVertexConnectedComponents(cm, faceCC);
 		log("Found %i Connected Components",numCC);
-		
-		for(size_t i=0; i<connectedCompVec.size();++i)
-		{
-			tri::UpdateSelection<CMeshO>::FaceClear(cm);
-			connectedCompVec[i].second->SetS();
-			tri::UpdateSelection<CMeshO>::FaceConnectedFF(cm/*,true*/);
-			tri::UpdateSelection<CMeshO>::VertexClear(cm);
-			tri::UpdateSelection<CMeshO>::VertexFromFaceLoose(cm);
 
-			MeshModel *destModel= md.addNewMesh("",QString("CC %1").arg(i), true);
+		// component of each vertex and position of vertices and faces inside their component
+		std::vector<int> vertCC(cm.vert.size(), -1);
+		for(size_t i=0; i<cm.face.size(); ++i)
+			if(faceCC[i] >= 0)
+				for(int j=0; j<cm.face[i].VN(); ++j)
+					vertCC[tri::Index(cm, cm.face[i].cV(j))] = faceCC[i];
+		std::vector<int> vertNum(numCC, 0), faceNum(numCC, 0);
+		std::vector<int> vertLocal(cm.vert.size(), -1), faceLocal(cm.face.size(), -1);
+		for(size_t i=0; i<cm.vert.size(); ++i)
+			if(vertCC[i] >= 0)
+				vertLocal[i] = vertNum[vertCC[i]]++;
+		for(size_t i=0; i<cm.face.size(); ++i)
+			if(faceCC[i] >= 0)
+				faceLocal[i] = faceNum[faceCC[i]]++;
+
+		std::vector<MeshModel *> parts(numCC);
+		for(int c=0; c<numCC; ++c)
+		{
+			MeshModel *destModel= md.addNewMesh("",QString("CC %1").arg(c), true);
 			destModel->updateDataMask(currentModel);
-			tri::Append<CMeshO, CMeshO>::Mesh(destModel->cm, cm, true);
-
-			// init new layer
-			destModel->updateBoxAndNormals();
 			destModel->cm.Tr = currentModel->cm.Tr;
+			destModel->cm.textures = cm.textures;
+			tri::Allocator<CMeshO>::AddVertices(destModel->cm, vertNum[c]);
+			tri::Allocator<CMeshO>::AddFaces(destModel->cm, faceNum[c]);
+			parts[c] = destModel;
 		}
+
+		// scatter vertices and faces into all the new layers at once
+		parallel::For(int(cm.vert.size()), [&](int i) {
+			if(vertCC[i] >= 0)
+				parts[vertCC[i]]->cm.vert[vertLocal[i]].ImportData(cm.vert[i]);
+		});
+		parallel::For(int(cm.face.size()), [&](int i) {
+			if(faceCC[i] < 0) return;
+			CMeshO &pm = parts[faceCC[i]]->cm;
+			CFaceO &f = pm.face[faceLocal[i]];
+			for(int j=0; j<3; ++j)
+				f.V(j) = &pm.vert[vertLocal[tri::Index(cm, cm.face[i].cV(j))]];
+			f.ImportData(cm.face[i]);
+		});
+
+		// init new layers
+		parallel::For(numCC, [&](int c) {
+			parts[c]->updateBoxAndNormals();
+		}, 0, "", 1);
 	} break;
 
 	case FP_EXPORT_CAMERAS:
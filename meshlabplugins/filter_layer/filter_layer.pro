@@ -8,3 +8,5 @@ SOURCES += \
 
 TARGET = \
     filter_layer
+
+linux:QMAKE_LFLAGS += -fopenmp -lgomp
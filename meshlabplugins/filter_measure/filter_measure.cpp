@@ -561,7 +561,7 @@ std::map<std::string, QVariant> FilterMeasurePlugin::perVertexQualityStat(MeshDo
 {
 	std::map<std::string, QVariant> outputValues;
 	CMeshO &m = md.mm()->cm;
-	Distribution<Scalarm> DD;
+	StreamingDistribution<Scalarm> DD;
 	tri::Stat<CMeshO>::ComputePerVertexQualityDistribution(m, DD, false);
 
 	log("   Min %f Max %f", DD.Min(), DD.Max());
@@ -581,7 +581,7 @@ std::map<std::string, QVariant> FilterMeasurePlugin::perFaceQualityStat(MeshDocu
 {
 	std::map<std::string, QVariant> outputValues;
 	CMeshO &m = md.mm()->cm;
-	Distribution<Scalarm> DD;
+	StreamingDistribution<Scalarm> DD;
 	tri::Stat<CMeshO>::ComputePerFaceQualityDistribution(m, DD, false);
 
 	log("   Min %f Max %f", DD.Min(), DD.Max());
@@ -7,3 +7,5 @@ SOURCES += \
     filter_measure.cpp
 		
 TARGET = filter_measure
+
+linux:QMAKE_LFLAGS += -fopenmp -lgomp
@@ -11,3 +11,5 @@ SOURCES += \
 TARGET = filter_meshing
 
 win32-msvc:QMAKE_CXXFLAGS = /bigobj
+
+linux:QMAKE_LFLAGS += -fopenmp -lgomp
@@ -22,3 +22,4 @@ SOURCES += \
 
 TARGET = filter_mls
 
+linux:QMAKE_LFLAGS += -fopenmp -lgomp
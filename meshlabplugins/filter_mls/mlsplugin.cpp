@@ -383,8 +383,9 @@ std::map<std::string, QVariant> MlsPlugin::applyFilter(
 	if (id == FP_SELECT_SMALL_COMPONENTS)
 	{
 		MeshModel* mesh = md.mm();
-		mesh->updateDataMask(MeshModel::MM_FACEFACETOPO);
 		bool nonClosedOnly = par.getBool("NonClosedOnly");
+		if (nonClosedOnly)
+			mesh->updateDataMask(MeshModel::MM_FACEFACETOPO);
 		Scalarm ratio = par.getFloat("NbFaceRatio");
 		vcg::tri::SmallComponent<CMeshO>::Select(mesh->cm, ratio, nonClosedOnly);
 		return outValues;
@@ -604,12 +605,10 @@ std::map<std::string, QVariant> MlsPlugin::applyFilter(
 
 			// extra zero detection and removal
 			{
-				mesh->updateDataMask(MeshModel::MM_FACEFACETOPO );
 				// selection...
 				vcg::tri::SmallComponent<CMeshO>::Select(mesh->cm, 0.1f);
 				// deletion...
 				vcg::tri::SmallComponent<CMeshO>::DeleteFaceVert(mesh->cm);
-				mesh->clearDataMask(MeshModel::MM_FACEFACETOPO);
 			}
 
 			log( "Marching cubes MLS meshing done.");
@@ -42,85 +42,51 @@ public:
 
 	static int Select(MeshType &m, float nbFaceRatio = 0.1, bool nonClosedOnly = false)
 	{
-		assert(tri::HasFFAdjacency(m) && "The small component selection procedure requires face to face adjacency.");
+		assert((!nonClosedOnly || tri::HasFFAdjacency(m)) && "Selecting only non closed components requires face to face adjacency.");
 
-		// the different components as a list of face pointer
-		std::vector< std::vector<FacePointer> > components;
+		// the different components, as per face component index
+		std::vector<int> faceCC;
+		std::vector<typename Clean<MeshType>::ConnectedComponentInfo> CCV;
+		Clean<MeshType>::FaceVertexConnectedComponents(m, faceCC, CCV);
 
-		for(uint faceSeed = 0; faceSeed<m.face.size(); )
+		// with nonClosedOnly only the components with a border face are candidates
+		std::vector<bool> candidate(CCV.size(), !nonClosedOnly);
+		if (nonClosedOnly)
 		{
-			// find the first not selected face
-			bool foundSeed = false;
-			while (faceSeed<m.face.size())
+			for (uint i=0; i<m.face.size(); ++i)
 			{
-				CFaceO& f = m.face[faceSeed];
-				if (!f.IsD() && !f.IsS())
-				{
-					if (nonClosedOnly)
-					{
-						for (int k=0; k<3; ++k)
-							if (face::IsBorder(f,k))
-							{
-								foundSeed = true;
-								break;
-							}
-					}
-					else
-						foundSeed = true;
-					if (foundSeed)
-						break;
-				}
-				++faceSeed;
-			}
-			if (!foundSeed) // no more seed, stop
-				break;
-
-			// expand the region from this face...
-			components.resize(components.size()+1);
-			std::vector<FacePointer> activefaces;
-			activefaces.push_back(&m.face[faceSeed]);
-			while (!activefaces.empty())
-			{
-				FacePointer f = activefaces.back();
-				activefaces.pop_back();
-				if (f->IsS())
+				if (faceCC[i]<0 || candidate[faceCC[i]])
 					continue;
-
-				f->SetS();
-				components.back().push_back(f);
 				for (int k=0; k<3; ++k)
-				{
-					if (face::IsBorder(*f,k))
-						continue;
-					FacePointer of = f->FFp(k);
-					if (!of->IsS())
-						activefaces.push_back(of);
-				}
+					if (face::IsBorder(m.face[i],k))
+					{
+						candidate[faceCC[i]] = true;
+						break;
+					}
 			}
-			++faceSeed;
 		}
-		UpdateSelection<MeshType>::FaceClear(m);
 
 		// now the segmentation is done, let's compute the absolute face count threshold
 		int total_selected = 0;
 		int maxComponent = 0;
-		for (uint i=0; i<components.size(); ++i)
+		for (uint i=0; i<CCV.size(); ++i)
 		{
-			//std::cout << "Component " << i << " -> " << components[i].size() << "\n";
-			total_selected += components[i].size();
-			maxComponent = std::max<int>(maxComponent,components[i].size());
+			if (!candidate[i])
+				continue;
+			total_selected += CCV[i].faceNum;
+			maxComponent = std::max<int>(maxComponent,CCV[i].faceNum);
 		}
 		int remaining = m.face.size() - total_selected;
 		uint th = std::max(maxComponent,remaining) * nbFaceRatio;
 
 		int selCount = 0;
-		for (uint i=0; i<components.size(); ++i)
+		for (uint i=0; i<m.face.size(); ++i)
 		{
-			if (components[i].size()<th)
+			m.face[i].ClearS();
+			if (faceCC[i]>=0 && candidate[faceCC[i]] && uint(CCV[faceCC[i]].faceNum)<th)
 			{
-				selCount += components[i].size();
-				for (uint j=0; j<components[i].size(); ++j)
-					components[i][j]->SetS();
+				m.face[i].SetS();
+				++selCount;
 			}
 		}
 		return selCount;
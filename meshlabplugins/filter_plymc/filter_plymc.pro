@@ -8,3 +8,5 @@ SOURCES += \
     $$VCGDIR/wrap/ply/plylib.cpp
 
 TARGET = filter_plymc
+
+linux:QMAKE_LFLAGS += -fopenmp -lgomp
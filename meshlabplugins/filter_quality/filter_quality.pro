@@ -16,4 +16,4 @@ SOURCES += \
 
 TARGET = filter_quality
 
-
+linux:QMAKE_LFLAGS += -fopenmp -lgomp
@@ -9,4 +9,4 @@ SOURCES += \
 
 TARGET = filter_sampling
 
-
+linux:QMAKE_LFLAGS += -fopenmp -lgomp
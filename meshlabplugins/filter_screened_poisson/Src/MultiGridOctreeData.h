@@ -876,6 +876,9 @@ protected:
 	bool _getIsoVertex( const BSplineData< ColorDegree , BType >* colorBSData , const DensityEstimator< WeightDegree >* densityWeights , const SparseNodeData< ProjectiveData< Point3D< Real > , Real > , ColorDegree >* colorData , Real isoValue , ConstPointSupportKey< WeightDegree >& weightKey , ConstPointSupportKey< ColorDegree >& colorKey , const TreeOctNode* node , int cornerIndex , const _SliceValues< Vertex >& bValues , const _SliceValues< Vertex >& fValues , Vertex& vertex );
 
 	void _init( TreeOctNode* node , LocalDepth maxDepth , bool (*Refine)( LocalDepth d , LocalOffset off ) );
+	// Splats one oriented point into the tree, returns 0 or the reason why the point was discarded (1: out of bounds, 2: zero-length normal, 3: undefined normal)
+	template< class Data >
+	int _addPointSample( Point3D< Real > p , Point3D< Real > n , const Data* d , LocalDepth maxDepth , bool useConfidence , std::vector< int >& nodeToIndexMap , std::vector< PointSample >& samples , std::vector< ProjectiveData< Data , Real > >* sampleData );
 
 	double _maxMemoryUsage , _localMemoryUsage;
 public:
@@ -890,6 +893,8 @@ public:
 	void init( LocalDepth maxDepth , bool (*Refine)( LocalDepth d , LocalOffset off ) );
 	template< class Data >
 	int init( OrientedPointStream< Real >& pointStream , LocalDepth maxDepth , bool useConfidence , std::vector< PointSample >& samples , std::vector< ProjectiveData< Data , Real > >* sampleData );
+	template< class Data >
+	int init( OrientedPointBlockStream< Real , Data >& pointStream , LocalDepth maxDepth , bool useConfidence , std::vector< PointSample >& samples , std::vector< ProjectiveData< Data , Real > >* sampleData );
 	template< int DensityDegree >
 	typename Octree::template DensityEstimator< DensityDegree >* setDensityEstimator( const std::vector< PointSample >& samples , LocalDepth splatDepth , Real samplesPerNode );
 	template< int NormalDegree , int DensityDegree >
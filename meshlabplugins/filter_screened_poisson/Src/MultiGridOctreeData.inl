@@ -231,63 +231,99 @@ void Octree< Real >::_init( TreeOctNode* node , LocalDepth maxDepth , bool (*Ref
 template< class Real > void Octree< Real >::init( LocalDepth maxDepth , bool (*Refine)( LocalDepth , LocalOffset ) ){ _init( _spaceRoot , maxDepth , Refine ); }
 template< class Real >
 template< class Data >
+int Octree< Real >::_addPointSample( Point3D< Real > p , Point3D< Real > n , const Data* d , LocalDepth maxDepth , bool useConfidence , std::vector< int >& nodeToIndexMap , std::vector< PointSample >& samples , std::vector< ProjectiveData< Data , Real > >* sampleData )
+{
+	Real len = (Real)Length( n );
+	if( !_InBounds(p) ) return 1;
+	if( !len ) return 2;
+	if( len!=len ) return 3;
+	n /= len;
+	Point3D< Real > center = Point3D< Real >( Real(0.5) , Real(0.5) , Real(0.5) );
+	Real width = Real(1.0);
+	TreeOctNode* temp = _spaceRoot;
+	LocalDepth depth = _localDepth( temp );
+	while( depth<maxDepth )
+	{
+		if( !temp->children ) temp->initChildren( _NodeInitializer );
+		int cIndex = TreeOctNode::CornerIndex( center , p );
+		temp = temp->children + cIndex;
+		width /= 2;
+		if( cIndex&1 ) center[0] += width/2;
+		else           center[0] -= width/2;
+		if( cIndex&2 ) center[1] += width/2;
+		else           center[1] -= width/2;
+		if( cIndex&4 ) center[2] += width/2;
+		else           center[2] -= width/2;
+		depth++;
+	}
+	Real weight = (Real)( useConfidence ? len : 1. );
+	int nodeIndex = temp->nodeData.nodeIndex;
+	if( (unsigned int)nodeIndex>=nodeToIndexMap.size() ) nodeToIndexMap.resize( nodeIndex+1 , -1 );
+	int idx = nodeToIndexMap[ nodeIndex ];
+	if( idx==-1 )
+	{
+		idx = (int)samples.size();
+		nodeToIndexMap[ nodeIndex ] = idx;
+		samples.resize( idx+1 ) , samples[idx].node = temp;
+		if( sampleData ) sampleData->resize( idx+1 );
+	}
+	samples[idx].sample += ProjectiveData< OrientedPoint3D< Real > , Real >( OrientedPoint3D< Real >( p * weight , n * weight ) , weight );
+	if( sampleData ) (*sampleData)[ idx ] += ProjectiveData< Data , Real >( (*d) * weight , weight );
+	return 0;
+}
+template< class Real >
+template< class Data >
 int Octree< Real >::init( OrientedPointStream< Real >& pointStream , LocalDepth maxDepth , bool useConfidence , std::vector< PointSample >& samples , std::vector< ProjectiveData< Data , Real > >* sampleData )
 {
 	OrientedPointStreamWithData< Real , Data >& pointStreamWithData = ( OrientedPointStreamWithData< Real , Data >& )pointStream;
 
 	// Add the point data
-	int outOfBoundPoints = 0 , zeroLengthNormals = 0 , undefinedNormals = 0 , pointCount = 0;
+	int discarded[4] = { 0 , 0 , 0 , 0 } , pointCount = 0;
 	{
 		std::vector< int > nodeToIndexMap;
-		Point3D< Real > p , n;
 		OrientedPoint3D< Real > _p;
 		Data _d;
 		while( ( sampleData ? pointStreamWithData.nextPoint( _p , _d ) : pointStream.nextPoint( _p ) ) )
 		{
-			p = Point3D< Real >(_p.p) , n = Point3D< Real >(_p.n);
-			Real len = (Real)Length( n );
-			if( !_InBounds(p) ){ outOfBoundPoints++ ; continue; }
-			if( !len ){ zeroLengthNormals++ ; continue; }
-			if( len!=len ){ undefinedNormals++ ; continue; }
-			n /= len;
-			Point3D< Real > center = Point3D< Real >( Real(0.5) , Real(0.5) , Real(0.5) );
-			Real width = Real(1.0);
-			TreeOctNode* temp = _spaceRoot;
-			LocalDepth depth = _localDepth( temp );
-			while( depth<maxDepth )
-			{
-				if( !temp->children ) temp->initChildren( _NodeInitializer );
-				int cIndex = TreeOctNode::CornerIndex( center , p );
-				temp = temp->children + cIndex;
-				width /= 2;
-				if( cIndex&1 ) center[0] += width/2;
-				else           center[0] -= width/2;
-				if( cIndex&2 ) center[1] += width/2;
-				else           center[1] -= width/2;
-				if( cIndex&4 ) center[2] += width/2;
-				else           center[2] -= width/2;
-				depth++;
-			}
-			Real weight = (Real)( useConfidence ? len : 1. );
-			int nodeIndex = temp->nodeData.nodeIndex;
-			if( (unsigned int)nodeIndex>=nodeToIndexMap.size() ) nodeToIndexMap.resize( nodeIndex+1 , -1 );
-			int idx = nodeToIndexMap[ nodeIndex ];
-			if( idx==-1 )
+			int res = _addPointSample( Point3D< Real >(_p.p) , Point3D< Real >(_p.n) , &_d , maxDepth , useConfidence , nodeToIndexMap , samples , sampleData );
+			if( res ) discarded[res]++;
+			else      pointCount++;
+		}
+		pointStream.reset();
+	}
+	if( discarded[1] ) fprintf( stderr , "[WARNING] Found out-of-bound points: %d\n" , discarded[1] );
+	if( discarded[2] ) fprintf( stderr , "[WARNING] Found zero-length normals: %d\n" , discarded[2] );
+	if( discarded[3] ) fprintf( stderr , "[WARNING] Found undefined normals: %d\n" , discarded[3] );
+
+	memoryUsage();
+	return pointCount;
+}
+template< class Real >
+template< class Data >
+int Octree< Real >::init( OrientedPointBlockStream< Real , Data >& pointStream , LocalDepth maxDepth , bool useConfidence , std::vector< PointSample >& samples , std::vector< ProjectiveData< Data , Real > >* sampleData )
+{
+	// Add the point data, one block at a time (blocks must carry data if sampleData is requested)
+	int discarded[4] = { 0 , 0 , 0 , 0 } , pointCount = 0;
+	{
+		std::vector< int > nodeToIndexMap;
+		OrientedPointBlock< Real , Data > block;
+		while( pointStream.nextBlock( block ) )
+		{
+			for( int i=0 ; i<block.size ; i++ )
 			{
-				idx = (int)samples.size();
-				nodeToIndexMap[ nodeIndex ] = idx;
-				samples.resize( idx+1 ) , samples[idx].node = temp;
-				if( sampleData ) sampleData->resize( idx+1 );
+				Point3D< Real > p , n;
+				p[0] = block.px[i] , p[1] = block.py[i] , p[2] = block.pz[i];
+				n[0] = block.nx[i] , n[1] = block.ny[i] , n[2] = block.nz[i];
+				int res = _addPointSample( p , n , block.data ? block.data+i : (const Data*)NULL , maxDepth , useConfidence , nodeToIndexMap , samples , sampleData );
+				if( res ) discarded[res]++;
+				else      pointCount++;
 			}
-			samples[idx].sample += ProjectiveData< OrientedPoint3D< Real > , Real >( OrientedPoint3D< Real >( p * weight , n * weight ) , weight );
-			if( sampleData ) (*sampleData)[ idx ] += ProjectiveData< Data , Real >( _d * weight , weight );
-			pointCount++;
 		}
 		pointStream.reset();
 	}
-	if( outOfBoundPoints  ) fprintf( stderr , "[WARNING] Found out-of-bound points: %d\n" , outOfBoundPoints );
-	if( zeroLengthNormals ) fprintf( stderr , "[WARNING] Found zero-length normals: %d\n" , zeroLengthNormals );
-	if( undefinedNormals  ) fprintf( stderr , "[WARNING] Found undefined normals: %d\n" , undefinedNormals );
+	if( discarded[1] ) fprintf( stderr , "[WARNING] Found out-of-bound points: %d\n" , discarded[1] );
+	if( discarded[2] ) fprintf( stderr , "[WARNING] Found zero-length normals: %d\n" , discarded[2] );
+	if( discarded[3] ) fprintf( stderr , "[WARNING] Found undefined normals: %d\n" , discarded[3] );
 
 	memoryUsage();
 	return pointCount;
@@ -85,6 +85,28 @@ public:
 	virtual int nextPoints( OrientedPoint3D< Real >* p , int count ){ return OrientedPointStream< Real >::nextPoints( p , count ); }
 };
 
+// A block of oriented points, stored as separate coordinate arrays.
+// data is NULL if the points carry no data.
+template< class Real , class Data >
+struct OrientedPointBlock
+{
+	int size;
+	const Real *px , *py , *pz;
+	const Real *nx , *ny , *nz;
+	const Data* data;
+};
+
+// Batched point source: the points are handed over a block at a time, already in the
+// reconstruction space, so the tree construction does one virtual call per block.
+template< class Real , class Data >
+class OrientedPointBlockStream
+{
+public:
+	virtual ~OrientedPointBlockStream( void ){}
+	virtual void reset( void ) = 0;
+	virtual bool nextBlock( OrientedPointBlock< Real , Data >& block ) = 0;
+};
+
 template< class Real >
 class TransformedOrientedPointStream : public OrientedPointStream< Real >
 {
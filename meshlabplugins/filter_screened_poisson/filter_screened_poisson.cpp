@@ -26,10 +26,6 @@
 #include <Psapi.h>
 #endif
 
-#include <QDir>
-#include <QTemporaryDir>
-#include <QTemporaryFile>
-
 #include "filter_screened_poisson.h"
 #include "poisson_utils.h"
 
@@ -103,27 +99,7 @@ std::map<std::string, QVariant> FilterScreenedPoissonPlugin::applyFilter(
 		unsigned int& /*postConditionMask*/,
 		vcg::CallBackPos* cb)
 {
-	bool currDirChanged=false;
-	QDir currDir = QDir::current();
-
 	if (ID(filter) == FP_SCREENED_POISSON) {
-		//Using tmp dir
-		QTemporaryDir tmpdir;
-		QTemporaryFile file(tmpdir.path());
-		if (!file.open()) { //if a file cannot be created in the tmp folder
-			log("Warning - tmp folder is not writable.");
-
-			QTemporaryFile file2("./_tmp_XXXXXX.tmp"); //try to create a file in the meshlab folder
-			if (!file2.open()){ //if a file cannot be created in the tmp and in the meshlab folder, we cannot run the filter
-				log("Warning - current folder is not writable. Screened Poisson Merging needs to save intermediate files in the tmp working folder. Project and meshes must be in a write-enabled folder. Please save your data in a suitable folder before applying.");
-				throw MLException("current and tmp folder are not writable.<br> Screened Poisson Merging needs to save intermediate files in the current working folder.<br> Project and meshes must be in a write-enabled folder.<br> Please save your data in a suitable folder before applying.");
-			}
-		}
-		else { //if the tmp folder is writable, we will use it
-			currDirChanged=true;
-			QDir::setCurrent(tmpdir.path());
-		}
-
 		PoissonParam<Scalarm> pp;
 		pp.MaxDepthVal = params.getInt("depth");
 		pp.FullDepthVal = params.getInt("fullDepth");
@@ -176,18 +152,16 @@ std::map<std::string, QVariant> FilterScreenedPoissonPlugin::applyFilter(
 				_mm=md.nextVisibleMesh(_mm);
 			}
 
-			MeshDocumentPointStream<Scalarm> documentStream(md);
+			MeshPointBlockStream<Scalarm> documentStream(md);
 			_Execute<Scalarm,2,BOUNDARY_NEUMANN,PlyColorAndValueVertex<Scalarm> >(&documentStream,bb,pm->cm,pp,cb);
 		}
 		else {
-			MeshModelPointStream<Scalarm> meshStream(md.mm()->cm);
+			MeshPointBlockStream<Scalarm> meshStream(md.mm()->cm);
 			_Execute<Scalarm,2,BOUNDARY_NEUMANN,PlyColorAndValueVertex<Scalarm> >(&meshStream,md.mm()->cm.bbox,pm->cm,pp,cb);
 		}
 		pm->updateBoxAndNormals();
 		md.setVisible(pm->id(),true);
 		md.setCurrentMesh(pm->id());
-		if(currDirChanged)
-			QDir::setCurrent(currDir.path());
 	}
 	else {
 		wrongActionCalled(filter);
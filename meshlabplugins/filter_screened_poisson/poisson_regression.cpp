@@ -0,0 +1,175 @@
+/****************************************************************************
+* MeshLab                                                           o o     *
+* A versatile mesh processing toolbox                             o     o   *
+*                                                                _   O  _   *
+* Copyright(C) 2005                                                \/)\/    *
+* Visual Computing Lab                                            /\/|      *
+* ISTI - Italian National Research Council                           |      *
+*                                                                    \      *
+* All rights reserved.                                                      *
+*                                                                           *
+* This program is free software; you can redistribute it and/or modify      *
+* it under the terms of the GNU General Public License as published by      *
+* the Free Software Foundation; either version 2 of the License, or         *
+* (at your option) any later version.                                       *
+*                                                                           *
+* This program is distributed in the hope that it will be useful,           *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)          *
+* for more details.                                                         *
+*                                                                           *
+****************************************************************************/
+
+/* Checks that CMeshOMeshData::moveTo builds the same mesh that _Execute built from
+ * a CoredVectorMeshData, and that the triangles added concurrently by the iso-surface
+ * extraction are all kept. The exit code is the number of failed checks.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <thread>
+
+#include "poisson_utils.h"
+
+typedef PlyColorAndValueVertex< Scalarm > PoissonVertex;
+
+// Vertices and triangles as the iso-surface extraction hands them to the mesh data
+// (in-core points first, out-of-core indices flagged by CoredVertexIndex::inCore).
+struct ExtractedSurface
+{
+	std::vector< PoissonVertex > inCore , outOfCore;
+	std::vector< std::vector< CoredVertexIndex > > triangles;
+
+	ExtractedSurface( int inCoreNum , int outOfCoreNum , int triangleNum )
+	{
+		unsigned int s = 12345;
+		auto rnd = [&s]( int n ) { s = s*1664525u + 1013904223u; return int( ( s>>8 ) % unsigned( n ) ); };
+		auto vertex = [&rnd]() {
+			PoissonVertex v;
+			for( int k=0 ; k<3 ; k++ ) v.point[k] = Scalarm( rnd( 1<<16 ) )/( 1<<16 ) , v.color[k] = (unsigned char)rnd( 256 );
+			v.value = Scalarm( rnd( 1<<12 ) )/( 1<<8 );
+			return v;
+		};
+		for( int i=0 ; i<inCoreNum ; i++ ) inCore.push_back( vertex() );
+		for( int i=0 ; i<outOfCoreNum ; i++ ) outOfCore.push_back( vertex() );
+		triangles.resize( triangleNum , std::vector< CoredVertexIndex >( 3 ) );
+		for( auto &t : triangles ) {
+			int g[3];
+			g[0] = rnd( inCoreNum+outOfCoreNum );
+			do g[1] = rnd( inCoreNum+outOfCoreNum ); while( g[1]==g[0] );
+			do g[2] = rnd( inCoreNum+outOfCoreNum ); while( g[2]==g[0] || g[2]==g[1] );
+			for( int k=0 ; k<3 ; k++ ) {
+				t[k].inCore = g[k]<inCoreNum;
+				t[k].idx = t[k].inCore ? g[k] : g[k]-inCoreNum;
+			}
+		}
+	}
+
+	void addTo( CoredMeshData< PoissonVertex > &mesh , int threadNum ) const
+	{
+		mesh.inCorePoints = inCore;
+		for( const auto &v : outOfCore ) mesh.addOutOfCorePoint( v );
+		std::vector< std::thread > threads;
+		for( int t=0 ; t<threadNum ; t++ )
+			threads.emplace_back( [&mesh , this , t , threadNum]() {
+				for( size_t i=t ; i<triangles.size() ; i+=threadNum ) mesh.addPolygon_s( triangles[i] );
+			} );
+		for( auto &th : threads ) th.join();
+	}
+};
+
+// The conversion loop of _Execute before CMeshOMeshData.
+static void ReferenceConversion( CoredVectorMeshData< PoissonVertex > &mesh , const XForm4x4< Scalarm > &iXForm , CMeshO &pm )
+{
+	typedef PoissonVertex Vertex;
+	typedef Scalarm Real;
+	mesh.resetIterator();
+	for(auto pt=mesh.inCorePoints.begin();pt!=mesh.inCorePoints.end();++pt) {
+		Point3D<Real> pp = iXForm*pt->point;
+		vcg::tri::Allocator<CMeshO>::AddVertex(pm,Point3m(pp[0],pp[1],pp[2]));
+		pm.vert.back().Q() = pt->value;
+		pm.vert.back().C()[0] = pt->color[0];
+		pm.vert.back().C()[1] = pt->color[1];
+		pm.vert.back().C()[2] = pt->color[2];
+	}
+	for (int ii=0; ii < mesh.outOfCorePointCount(); ii++) {
+		Vertex pt;
+		mesh.nextOutOfCorePoint(pt);
+		Point3D<Real> pp = iXForm*pt.point;
+		vcg::tri::Allocator<CMeshO>::AddVertex(pm,Point3m(pp[0],pp[1],pp[2]));
+		pm.vert.back().Q() = pt.value;
+		pm.vert.back().C()[0] = pt.color[0];
+		pm.vert.back().C()[1] = pt.color[1];
+		pm.vert.back().C()[2] = pt.color[2];
+	}
+
+	std::vector< CoredVertexIndex > polygon;
+	while(mesh.nextPolygon( polygon )) {
+		int indV[3];
+		for( int i=0 ; i<int(polygon.size()) ; i++ ) {
+			if( polygon[i].inCore )
+				indV[i] = polygon[i].idx;
+			else
+				indV[i]= polygon[i].idx + int( mesh.inCorePoints.size() );
+		}
+		vcg::tri::Allocator<CMeshO>::AddFace(pm, &pm.vert[indV[0]], &pm.vert[indV[1]], &pm.vert[indV[2]]);
+	}
+}
+
+static bool SameVertices( const CMeshO &a , const CMeshO &b )
+{
+	if( a.vn!=b.vn ) return false;
+	for( int i=0 ; i<a.vn ; i++ )
+		if( a.vert[i].cP()!=b.vert[i].cP() || a.vert[i].cQ()!=b.vert[i].cQ() || a.vert[i].cC()!=b.vert[i].cC() )
+			return false;
+	return true;
+}
+
+// Triangles as vertex index triples, sorted when the order of insertion is not defined.
+static std::vector< vcg::Point3i > Triangles( const CMeshO &m , bool sorted )
+{
+	std::vector< vcg::Point3i > t( m.fn );
+	for( int i=0 ; i<m.fn ; i++ )
+		t[i] = vcg::Point3i( int( vcg::tri::Index( m , m.face[i].cV(0) ) ) , int( vcg::tri::Index( m , m.face[i].cV(1) ) ) , int( vcg::tri::Index( m , m.face[i].cV(2) ) ) );
+	if( sorted ) std::sort( t.begin() , t.end() );
+	return t;
+}
+
+static bool Check( const char *name , bool ok )
+{
+	printf( "%-40s %s\n" , name , ok ? "ok" : "FAILED" );
+	return ok;
+}
+
+int main( int , char ** )
+{
+	const ExtractedSurface surface( 70000 , 30000 , 200000 );
+	Box3m bb( Point3m( -1 , -2 , 0.5 ) , Point3m( 3 , 1 , 2 ) );
+	const XForm4x4< Scalarm > iXForm = GetPointStreamScale( bb , 1.1f ).inverse();
+
+	CMeshO ref;
+	CoredVectorMeshData< PoissonVertex > refData;
+	surface.addTo( refData , 1 );
+	ReferenceConversion( refData , iXForm , ref );
+
+	int failed = 0;
+	{
+		CMeshO m;
+		CMeshOMeshData< PoissonVertex > data;
+		surface.addTo( data , 1 );
+		data.moveTo( m , iXForm );
+		failed += !Check( "moveTo vertices == previous" , SameVertices( m , ref ) );
+		failed += !Check( "moveTo triangles == previous" , Triangles( m , false )==Triangles( ref , false ) );
+		failed += !Check( "moveTo releases the mesh data" , data.inCorePoints.empty() && data.outOfCorePointCount()==0 && data.polygonCount()==0 );
+	}
+	{
+		CMeshO m;
+		CMeshOMeshData< PoissonVertex > data;
+		surface.addTo( data , 8 );
+		data.moveTo( m , iXForm );
+		failed += !Check( "concurrent triangles == previous" , SameVertices( m , ref ) && Triangles( m , true )==Triangles( ref , true ) );
+	}
+	if( failed ) printf( "%d checks FAILED\n" , failed );
+	return failed;
+}
@@ -28,6 +28,7 @@
 #include <Psapi.h>
 #endif
 #include <cstdio>
+#include <mutex>
 #include "Src/MyTime.h"
 #include "Src/MarchingCubes.h"
 #include "Src/Octree.h"
@@ -39,6 +40,7 @@
 #include "Src/MultiGridOctreeData.h"
 
 #include <vcg/space/box3.h>
+#include <wrap/system/parallel.h>
 #include <common/ml_document/cmesh.h>
 #include <common/ml_document/mesh_model.h>
 
@@ -176,113 +178,196 @@ public:
 		CSSolverAccuracyVal=1e-3f;
 
 		VerboseFlag=true;
-		ThreadsVal=omp_get_num_procs();
+		ThreadsVal=vcg::parallel::MaxThreads();
 		LinearFitFlag = false;
 		LowResIterMultiplierVal=1.f;
 		ColorVal=16.0f;
 	}
 };
 
+/** Point source over one or more meshes.
+    Points are handed to the tree a block at a time; each block is transformed in parallel
+    by the mesh Tr and by the transformation to the reconstruction unit cube (setXForm).
+*/
 template< class Real >
-class MeshModelPointStream : public OrientedPointStreamWithData< Real, Point3m >
+class MeshPointBlockStream : public OrientedPointBlockStream< Real , Point3D< Real > >
 {
-	CMeshO &_m;
-	size_t _curPos;
+	std::vector< CMeshO* > _meshes;
+	XForm4x4< Real > _xForm;
+	XForm3x3< Real > _normalXForm;
+	size_t _curMesh , _curPos;
+	std::vector< Real > _p[3] , _n[3];
+	std::vector< Point3D< Real > > _d;
 public:
-	MeshModelPointStream(  CMeshO &m):_m(m),_curPos(0)
+	static const int BLOCK_SIZE = 1<<16;
+
+	MeshPointBlockStream( CMeshO &m ) : _curMesh(0) , _curPos(0)
 	{
 		vcg::tri::RequireCompactness(m);
+		_meshes.push_back(&m);
+		setXForm( XForm4x4< Real >::Identity() );
 	}
 
-	~MeshModelPointStream( void ){}
+	// all the visible meshes of the document
+	MeshPointBlockStream( MeshDocument &md ) : _curMesh(0) , _curPos(0)
+	{
+		size_t totalSize = 0;
+		for(MeshModel *m = md.nextVisibleMesh(); m != nullptr; m = md.nextVisibleMesh(m)) {
+			vcg::tri::RequireCompactness(m->cm);
+			_meshes.push_back(&m->cm);
+			totalSize += m->cm.vn;
+		}
+		qDebug("TotalSize %lu",totalSize);
+		setXForm( XForm4x4< Real >::Identity() );
+	}
 
-	void reset( void ) { _curPos =0;}
+	void setXForm( const XForm4x4< Real > &xForm )
+	{
+		_xForm = xForm;
+		for( int i=0 ; i<3 ; i++ ) for( int j=0 ; j<3 ; j++ ) _normalXForm(i,j) = _xForm(i,j);
+		_normalXForm = _normalXForm.transpose().inverse();
+	}
+
+	void reset( void ) { _curMesh = 0; _curPos = 0; }
 
-	bool nextPoint( OrientedPoint3D< Real >& pt, Point3m &d)
+	bool nextBlock( OrientedPointBlock< Real , Point3D< Real > > &block )
 	{
-		if(_curPos>=(unsigned int)_m.vn)
+		while( _curMesh<_meshes.size() && _curPos>=size_t(_meshes[_curMesh]->vn) ) {
+			++_curMesh;
+			_curPos = 0;
+		}
+		if( _curMesh>=_meshes.size() )
 			return false;
-		Point3m &nn = _m.vert[_curPos].N();
-		Point3m tp = _m.Tr * _m.vert[_curPos].P();
-		Point4m np = _m.Tr *  Point4m(nn[0],nn[1],nn[2],0);
-
-		pt.p[0] = tp[0];
-		pt.p[1] = tp[1];
-		pt.p[2] = tp[2];
-		pt.n[0] = np[0];
-		pt.n[1] = np[1];
-		pt.n[2] = np[2];
-
-		d[0]=Real(_m.vert[_curPos].C()[0]);
-		d[1]=Real(_m.vert[_curPos].C()[1]);
-		d[2]=Real(_m.vert[_curPos].C()[2]);
-
-		++_curPos;
+
+		const CMeshO &m = *_meshes[_curMesh];
+		const int n = int( std::min< size_t >( BLOCK_SIZE , m.vn - _curPos ) );
+		for( int k=0 ; k<3 ; k++ ) _p[k].resize(n) , _n[k].resize(n);
+		_d.resize(n);
+
+		vcg::parallel::For( n , [&]( int i ) {
+			const CVertexO &v = m.vert[_curPos+i];
+			const Point3m &nn = v.cN();
+			Point3m tp = m.Tr * v.cP();
+			Point4m np = m.Tr * Point4m(nn[0],nn[1],nn[2],0);
+			Point3D< Real > p = _xForm * Point3D< Real >( tp[0] , tp[1] , tp[2] );
+			Point3D< Real > q = _normalXForm * Point3D< Real >( np[0] , np[1] , np[2] );
+			for( int k=0 ; k<3 ; k++ ) {
+				_p[k][i] = p[k];
+				_n[k][i] = q[k];
+				_d[i][k] = Real( v.cC()[k] );
+			}
+		} );
+		_curPos += n;
+
+		block.size = n;
+		block.px = &_p[0][0] , block.py = &_p[1][0] , block.pz = &_p[2][0];
+		block.nx = &_n[0][0] , block.ny = &_n[1][0] , block.nz = &_n[2][0];
+		block.data = &_d[0];
 		return true;
 	}
 };
 
-template< class Real >
-class MeshDocumentPointStream : public OrientedPointStreamWithData< Real, Point3m >
+/** In-memory sink of the iso-surface extraction, moved into a CMeshO by moveTo().
+    Vertex indices follow CoredMeshData: in-core points first, then the out-of-core ones.
+    The triangles are kept in a single index array, three entries each, where the in-core
+    point i is stored as i and the out-of-core point i as -i-1 (as CoredVectorMeshData does).
+*/
+template< class Vertex >
+class CMeshOMeshData : public CoredMeshData< Vertex >
 {
-	MeshDocument &_md;
-	MeshModel *_curMesh;
-	size_t _curPos;
-	size_t _totalSize;
+	std::vector< Vertex > _oocPoints;
+	std::vector< int > _triangles;
+	int _oocPointIndex , _triangleIndex;
+	std::mutex _mutex;
 public:
-	MeshDocumentPointStream(  MeshDocument &md):_md(md),_curMesh(0),_curPos(0)
+	CMeshOMeshData( void ) : _oocPointIndex(0) , _triangleIndex(0) { ; }
+
+	void resetIterator( void ) { _oocPointIndex = _triangleIndex = 0; }
+
+	int addOutOfCorePoint( const Vertex& p )
 	{
-		_totalSize=0;
-		MeshModel *m=0;
-		do {
-			m=_md.nextVisibleMesh(m);
-			if(m!=0) {
-				vcg::tri::RequireCompactness(m->cm);
-				_totalSize+=m->cm.vn;
-			}
-		} while(m);
-		qDebug("TotalSize %lu",_totalSize);
+		_oocPoints.push_back( p );
+		return int( _oocPoints.size() )-1;
+	}
+	int addOutOfCorePoint_s( const Vertex& p )
+	{
+		std::lock_guard< std::mutex > lock( _mutex );
+		return addOutOfCorePoint( p );
+	}
+	// the extraction is run without polygonMesh, so it only adds triangles
+	int addPolygon_s( const std::vector< int >& polygon )
+	{
+		assert( polygon.size()==3 );
+		std::lock_guard< std::mutex > lock( _mutex );
+		_triangles.insert( _triangles.end() , polygon.begin() , polygon.begin()+3 );
+		return 3;
+	}
+	int addPolygon_s( const std::vector< CoredVertexIndex >& vertices )
+	{
+		std::vector< int > polygon( vertices.size() );
+		for( size_t i=0 ; i<vertices.size() ; i++ )
+			polygon[i] = vertices[i].inCore ? vertices[i].idx : -vertices[i].idx-1;
+		return addPolygon_s( polygon );
 	}
 
-	~MeshDocumentPointStream( void ){}
+	int nextOutOfCorePoint( Vertex& p )
+	{
+		if( _oocPointIndex>=int( _oocPoints.size() ) ) return 0;
+		p = _oocPoints[ _oocPointIndex++ ];
+		return 1;
+	}
+	int nextPolygon( std::vector< CoredVertexIndex >& vertices )
+	{
+		if( _triangleIndex>=polygonCount() ) return 0;
+		vertices.resize( 3 );
+		for( int k=0 ; k<3 ; k++ ) {
+			const int idx = _triangles[ 3*_triangleIndex+k ];
+			vertices[k].inCore = idx>=0;
+			vertices[k].idx = idx>=0 ? idx : -idx-1;
+		}
+		_triangleIndex++;
+		return 1;
+	}
 
-	void reset( void ) { _curPos =0; _curMesh=0;}
+	int outOfCorePointCount( void ) { return int( _oocPoints.size() ); }
+	int polygonCount( void ) { return int( _triangles.size()/3 ); }
 
-	bool nextPoint( OrientedPoint3D< Real >& pt, Point3m &d )
+	/// Append the vertices (brought back by iXForm) and the triangles to m and release them.
+	template< class Real >
+	void moveTo( CMeshO &m , const XForm4x4< Real > &iXForm )
 	{
-		Point3m nn(0,0,0);
-		//    do
-		{
-			if((_curMesh==0) || (_curPos >= (std::size_t)_curMesh->cm.vn) ) {
-				_curMesh = _md.nextVisibleMesh(_curMesh);
-				_curPos = 0;
+		const int inCoreNum = int( this->inCorePoints.size() );
+		const int vn = inCoreNum + outOfCorePointCount();
+		const int fn = polygonCount();
+		const size_t vBase = m.vert.size();
+		vcg::tri::Allocator< CMeshO >::AddVertices( m , vn );
+		vcg::tri::Allocator< CMeshO >::AddFaces( m , fn );
+		const size_t fBase = m.face.size() - fn;
+
+		vcg::parallel::For( vn , [&]( int i ) {
+			const Vertex &p = i<inCoreNum ? this->inCorePoints[i] : _oocPoints[i-inCoreNum];
+			CVertexO &v = m.vert[vBase+i];
+			Point3D< Real > pp = iXForm * p.point;
+			v.P() = Point3m( pp[0] , pp[1] , pp[2] );
+			v.Q() = p.value;
+			v.C()[0] = p.color[0];
+			v.C()[1] = p.color[1];
+			v.C()[2] = p.color[2];
+		} );
+
+		vcg::parallel::For( fn , [&]( int i ) {
+			CFaceO &f = m.face[fBase+i];
+			for( int k=0 ; k<3 ; k++ ) {
+				const int idx = _triangles[ 3*i+k ];
+				f.V(k) = &m.vert[ vBase + ( idx>=0 ? idx : inCoreNum-idx-1 ) ];
 			}
+		} );
 
-			if(_curMesh==0)
-				return false;
-			if(_curPos < (std::size_t)_curMesh->cm.vn) {
-				nn = _curMesh->cm.vert[_curPos].N();
-				Point3m tp = _curMesh->cm.Tr * _curMesh->cm.vert[_curPos].P();
-				Point4m np = _curMesh->cm.Tr *  Point4m(nn[0],nn[1],nn[2],0);
-				//        Point3m tp = _curMesh->cm.vert[_curPos].P();
-				//        Point3m np = nn;
-				pt.p[0] = tp[0];
-				pt.p[1] = tp[1];
-				pt.p[2] = tp[2];
-				pt.n[0] = np[0];
-				pt.n[1] = np[1];
-				pt.n[2] = np[2];
-				d[0]=Real(_curMesh->cm.vert[_curPos].C()[0]);
-				d[1]=Real(_curMesh->cm.vert[_curPos].C()[1]);
-				d[2]=Real(_curMesh->cm.vert[_curPos].C()[2]);
-
-				++_curPos;
-			}
-		}
-		assert(nn!=Point3m(0,0,0));
-		return true;
+		std::vector< Vertex >().swap( this->inCorePoints );
+		std::vector< Vertex >().swap( _oocPoints );
+		std::vector< int >().swap( _triangles );
+		resetIterator();
 	}
-
 };
 
 template< class Real>
@@ -303,15 +388,13 @@ XForm4x4<Real> GetPointStreamScale(vcg::Box3<Real> &bb, float expFact)
 
 template< class Real , int Degree , BoundaryType BType , class Vertex >
 int _Execute(
-		OrientedPointStream< Real > *pointStream,
+		MeshPointBlockStream< Real > *pointStream,
 		Box3m bb, CMeshO &pm,
 		PoissonParam<Real> &pp,
 		vcg::CallBackPos* cb)
 {
 	typedef typename Octree< Real >::template DensityEstimator< WEIGHT_DEGREE > DensityEstimator;
 	typedef typename Octree< Real >::template InterpolationInfo< false > InterpolationInfo;
-	typedef OrientedPointStreamWithData< Real , Point3D< Real > > PointStreamWithData;
-	typedef TransformedOrientedPointStreamWithData< Real , Point3D< Real > > XPointStreamWithData;
 	Reset< Real >();
 	std::vector< char* > comments;
 
@@ -364,8 +447,8 @@ int _Execute(
 		//		}
 		//		delete[] ext;
 		sampleData = new std::vector< ProjectiveData< Point3D< Real > , Real > >();
-		XPointStreamWithData _pointStream( xForm , ( PointStreamWithData& )*pointStream );
-		pointCount = tree.template init< Point3D< Real > >( _pointStream , pp.MaxDepthVal , pp.ConfidenceFlag , *samples , sampleData );
+		pointStream->setXForm( xForm );
+		pointCount = tree.template init< Point3D< Real > >( *pointStream , pp.MaxDepthVal , pp.ConfidenceFlag , *samples , sampleData );
 
 		#pragma omp parallel for num_threads( pp.ThreadsVal )
 		for( int i=0 ; i<(int)samples->size() ; i++ )
@@ -451,7 +534,7 @@ int _Execute(
 		}
 	}
 
-	CoredFileMeshData< Vertex > mesh;
+	CMeshOMeshData< Vertex > mesh;
 
 	{
 		profiler.start();
@@ -488,39 +571,7 @@ int _Execute(
 	//        FreePointer( solution );
 
 	cb(90,"Creating Mesh");
-	mesh.resetIterator();
-	//int vm = mesh.outOfCorePointCount()+mesh.inCorePoints.size();
-	for(auto pt=mesh.inCorePoints.begin();pt!=mesh.inCorePoints.end();++pt) {
-		Point3D<Real> pp = iXForm*pt->point;
-		vcg::tri::Allocator<CMeshO>::AddVertex(pm,Point3m(pp[0],pp[1],pp[2]));
-		pm.vert.back().Q() = pt->value;
-		pm.vert.back().C()[0] = pt->color[0];
-		pm.vert.back().C()[1] = pt->color[1];
-		pm.vert.back().C()[2] = pt->color[2];
-	}
-	for (int ii=0; ii < mesh.outOfCorePointCount(); ii++) {
-		Vertex pt;
-		mesh.nextOutOfCorePoint(pt);
-		Point3D<Real> pp = iXForm*pt.point;
-		vcg::tri::Allocator<CMeshO>::AddVertex(pm,Point3m(pp[0],pp[1],pp[2]));
-		pm.vert.back().Q() = pt.value;
-		pm.vert.back().C()[0] = pt.color[0];
-		pm.vert.back().C()[1] = pt.color[1];
-		pm.vert.back().C()[2] = pt.color[2];
-	}
-
-	std::vector< CoredVertexIndex > polygon;
-	while(mesh.nextPolygon( polygon )) {
-		assert(polygon.size()==3);
-		int indV[3];
-		for( int i=0 ; i<int(polygon.size()) ; i++ ) {
-			if( polygon[i].inCore )
-				indV[i] = polygon[i].idx;
-			else
-				indV[i]= polygon[i].idx + int( mesh.inCorePoints.size() );
-		}
-		vcg::tri::Allocator<CMeshO>::AddFace(pm, &pm.vert[indV[0]], &pm.vert[indV[1]], &pm.vert[indV[2]]);
-	}
+	mesh.moveTo(pm, iXForm);
 	cb(100,"Done");
 
 	//if( colorData ) delete colorData , colorData = NULL;
@@ -65,7 +65,9 @@ SelectionFilterPlugin::SelectionFilterPlugin()
 		FP_SELECT_FACES_BY_EDGE,
 		FP_SELECT_BY_COLOR,
 		FP_SELECT_FOLD_FACE,
-		FP_SELECT_OUTLIER
+		FP_SELECT_OUTLIER,
+		FP_SELECT_SAVE,
+		FP_SELECT_RESTORE
 	};
 
 	QCoreApplication* app = QCoreApplication::instance();
@@ -153,6 +155,8 @@ QString SelectionFilterPlugin::pluginName() const
 	case FP_SELECT_FACES_BY_EDGE:         return tr("Select Faces with edges longer than...");
 	case FP_SELECT_FOLD_FACE :            return tr("Select Folded Faces");
 	case  FP_SELECT_OUTLIER:              return tr("Select Outliers");
+	case FP_SELECT_SAVE :                 return tr("Save Selection");
+	case FP_SELECT_RESTORE :              return tr("Restore Saved Selection");
  }
  assert(0);
  return QString("Unknown filter");
@@ -187,6 +191,8 @@ QString SelectionFilterPlugin::filterInfo(ActionIDType filterId) const
 	case CP_SELECT_NON_MANIFOLD_VERTEX: return tr("Select the non manifold vertices that do not belong to non manifold edges. For example two cones connected by their apex. Vertices incident on non manifold edges are ignored.");
 	case FP_SELECT_FOLD_FACE:           return tr("Select the folded faces created by the Quadric Edge Collapse decimation. The face is selected if the angle between the face normal and the normal of the best fitting plane of the neighbor vertices is above the selected threshold.");
 	case  FP_SELECT_OUTLIER:            return tr("Select the vertex classified as outlier using Local Outlier Propabilty measure described in:<br> <b>'LoOP: Local Outlier Probabilities'</b> Kriegel et al.<br>CIKM 2009");
+	case FP_SELECT_SAVE :               return tr("Save the current selection of vertices and faces of the mesh with the given name, replacing any selection previously saved with the same name. Saved selections refer to the element indices, so they are lost when the mesh is compacted or elements are added.");
+	case FP_SELECT_RESTORE :            return tr("Combine the current selection of vertices and faces with a selection saved with <i>Save Selection</i>: the saved selection can replace the current one, be added to it, intersected with it, subtracted from it or combined with it by symmetric difference.");
  }
  assert(0);
  return QString("Unknown filter");
@@ -298,6 +304,22 @@ RichParameterList SelectionFilterPlugin::initParameterList(const QAction *action
 		parlst.addParam(RichInt("KNearest", 32, tr("Number of neighbors"), tr("Number of neighbours used to compute the LoOP")));
 	} break;
 
+	case FP_SELECT_SAVE:
+	{
+		parlst.addParam(RichString("name", "selection", "Name", "Name of the saved selection."));
+	} break;
+
+	case FP_SELECT_RESTORE:
+	{
+		QStringList names;
+		for (const std::string& n : m.savedSelections.Names())
+			names << QString::fromStdString(n);
+		QStringList modes;
+		modes << "Replace" << "Union" << "Intersection" << "Subtraction" << "Symmetric Difference";
+		parlst.addParam(RichString("name", names.isEmpty() ? "selection" : names.last(), "Name", "Name of the saved selection. Saved selections: " + (names.isEmpty() ? "none" : names.join(", ")) + "."));
+		parlst.addParam(RichEnum("mode", 0, modes, "Mode", "How the saved selection is combined with the current one."));
+	} break;
+
 	case FP_SELECT_DELETE_ALL_FACE:
 	{
 		parlst.addParam(RichBool("allLayers", false, "Apply to all visible Layers", "If selected, the filter will be applied to all visible mesh Layers."));
@@ -650,6 +672,28 @@ std::map<std::string, QVariant> SelectionFilterPlugin::applyFilter(
 		log("Selected %d outlier vertices", selVertexNum);
 	} break;
 
+	case FP_SELECT_SAVE:
+	{
+		const std::string name = par.getString("name").toStdString();
+		m.savedSelections.Save(name);
+		log("Saved the selection '%s' (%i vertices, %i faces)", name.c_str(),
+			int(m.savedSelections.Get(name)->vert.Count()), int(m.savedSelections.Get(name)->face.Count()));
+	} break;
+
+	case FP_SELECT_RESTORE:
+	{
+		static const tri::SelectionStore<CMeshO>::RestoreMode modes[] = {
+			tri::SelectionStore<CMeshO>::REPLACE, tri::SelectionStore<CMeshO>::OR,
+			tri::SelectionStore<CMeshO>::AND, tri::SelectionStore<CMeshO>::SUBTRACT,
+			tri::SelectionStore<CMeshO>::XOR};
+		const std::string name = par.getString("name").toStdString();
+		if (!m.savedSelections.Has(name))
+			throw MLException("There is no saved selection named '" + par.getString("name") + "'.");
+		if (!m.savedSelections.Restore(name, modes[par.getEnum("mode")]))
+			throw MLException("The selection '" + par.getString("name") + "' was saved on a mesh with a different number of elements and has been discarded.");
+		log("Restored the selection '%s'", name.c_str());
+	} break;
+
 	default:
 		wrongActionCalled(action);
 	}
@@ -686,6 +730,8 @@ FilterPlugin::FilterClass SelectionFilterPlugin::getClass(const QAction *action)
 	case FP_SELECT_FACES_BY_EDGE:
 	case FP_SELECT_FOLD_FACE:
 	case FP_SELECT_OUTLIER:
+	case FP_SELECT_SAVE:
+	case FP_SELECT_RESTORE:
 	case FP_SELECT_BY_COLOR: 
 	case CP_SELECT_NON_MANIFOLD_VERTEX:
 	case CP_SELECT_NON_MANIFOLD_FACE:  return FilterClass(FilterPlugin::Selection);
@@ -733,7 +779,9 @@ int SelectionFilterPlugin::postCondition(const QAction *action) const
 		case FP_SELECT_FACES_BY_EDGE        :
 		case FP_SELECT_UGLY                 :
 		case FP_SELECT_FOLD_FACE            :
-		case FP_SELECT_OUTLIER              : return MeshModel::MM_VERTFLAGSELECT | MeshModel::MM_FACEFLAGSELECT;
+		case FP_SELECT_OUTLIER              :
+		case FP_SELECT_RESTORE              : return MeshModel::MM_VERTFLAGSELECT | MeshModel::MM_FACEFLAGSELECT;
+		case FP_SELECT_SAVE                 : return MeshModel::MM_NONE;
 		case FP_SELECT_DELETE_VERT          :
 		case FP_SELECT_DELETE_ALL_FACE      :
 		case FP_SELECT_DELETE_FACE          :
@@ -64,7 +64,9 @@ public:
 		CP_SELECT_NON_MANIFOLD_VERTEX,
 		FP_SELECT_FACES_BY_EDGE,
 		FP_SELECT_FOLD_FACE,
-		FP_SELECT_OUTLIER
+		FP_SELECT_OUTLIER,
+		FP_SELECT_SAVE,
+		FP_SELECT_RESTORE
 	} ;
 
 	SelectionFilterPlugin();
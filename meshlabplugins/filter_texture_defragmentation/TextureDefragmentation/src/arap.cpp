@@ -28,6 +28,11 @@
 #include <iomanip>
 #include <unordered_set>
 
+#include <wrap/system/parallel.h>
+
+// per-face loops are split in chunks of this size, small shells run on the calling thread
+static const int FACE_GRAIN = 256;
+
 
 ARAP::ARAP(Mesh& mesh)
     : m{mesh},
@@ -121,11 +126,15 @@ void ARAP::ComputeSystemMatrix(Mesh& m, const std::vector<Cot>& cotan, Eigen::Sp
     L.resize(m.VN(), m.VN());
     L.setZero();
     std::vector<Td> tri;
+    tri.reserve(9 * m.FN() + fixed_i.size());
+    std::vector<bool> isFixed(m.VN(), false);
+    for (auto vi : fixed_i)
+        isFixed[vi] = true;
     auto Idx = [&m](const Mesh::VertexPointer vp) { return (int) tri::Index(m, vp); };
     for (auto &f : m.face) {
         int fi = tri::Index(m, f);
         for (int i = 0; i < 3; ++i) {
-            if (std::find(fixed_i.begin(), fixed_i.end(), (int) tri::Index(m, f.V(i))) == fixed_i.end()) {
+            if (!isFixed[tri::Index(m, f.V(i))]) {
                 Mesh::VertexPointer vi = f.V0(i);
                 int j = (i+1)%3;
                 Mesh::VertexPointer vj = f.V1(i);
@@ -161,9 +170,9 @@ void ARAP::ComputeSystemMatrix(Mesh& m, const std::vector<Cot>& cotan, Eigen::Sp
 static std::vector<Eigen::Matrix2d> ComputeRotations(Mesh& m)
 {
     auto tsa = GetTargetShapeAttribute(m);
-    std::vector<Eigen::Matrix2d> rotations;
-    rotations.reserve(m.FN());
-    for (auto& f : m.face) {
+    std::vector<Eigen::Matrix2d> rotations(m.FN());
+    vcg::parallel::For(m.FN(), [&](int fi) {
+        Mesh::FaceType& f = m.face[fi];
         vcg::Point2d x10, x20;
         LocalIsometry(tsa[f].P[1] - tsa[f].P[0], tsa[f].P[2] - tsa[f].P[0], x10, x20);
         Eigen::Matrix2d Jf = ComputeTransformationMatrix(x10, x20, f.WT(1).P() - f.WT(0).P(), f.WT(2).P() - f.WT(0).P());
@@ -178,8 +187,8 @@ static std::vector<Eigen::Matrix2d> ComputeRotations(Mesh& m)
             R = U * V.transpose();
         }
 
-        rotations.push_back(R);
-    }
+        rotations[fi] = R;
+    }, 0, "", FACE_GRAIN);
 
     return rotations;
 }
@@ -271,24 +280,25 @@ double ARAP::ComputeEnergyFromStoredWedgeTC(const std::vector<Mesh::FacePointer>
 
 double ARAP::ComputeEnergyFromStoredWedgeTC(Mesh& m, double *num, double *denom)
 {
-    double e = 0;
-    double total_area = 0;
     auto tsa = GetWedgeTexCoordStorageAttribute(m);
-    for (auto& f : m.face) {
+    // (weighted energy, area) summed in face order, independently of the number of threads
+    vcg::Point2d sum = vcg::parallel::Reduce(m.FN(), vcg::Point2d(0, 0), [&](int fi) {
+        const Mesh::FaceType& f = m.face[fi];
         vcg::Point2d x10 = tsa[f].tc[1].P() - tsa[f].tc[0].P();
         vcg::Point2d x20 = tsa[f].tc[2].P() - tsa[f].tc[0].P();
         double area_f = std::abs(x10 ^ x20);
         if (area_f > 0) {
-            Eigen::Matrix2d Jf = ComputeTransformationMatrix(x10, x20, f.WT(1).P() - f.WT(0).P(), f.WT(2).P() - f.WT(0).P());
-            Eigen::Matrix2d U, V;
+            Eigen::Matrix2d Jf = ComputeTransformationMatrix(x10, x20, f.cWT(1).P() - f.cWT(0).P(), f.cWT(2).P() - f.cWT(0).P());
             Eigen::Vector2d sigma;
             Eigen::JacobiSVD<Eigen::Matrix2d> svd;
             svd.compute(Jf, Eigen::ComputeFullU | Eigen::ComputeFullV);
-            U = svd.matrixU(); V = svd.matrixV(); sigma = svd.singularValues();
-            total_area += area_f;
-            e += area_f * (std::pow(sigma[0] - 1.0, 2.0) + std::pow(sigma[1] - 1.0, 2.0));
+            sigma = svd.singularValues();
+            return vcg::Point2d(area_f * (std::pow(sigma[0] - 1.0, 2.0) + std::pow(sigma[1] - 1.0, 2.0)), area_f);
         }
-    }
+        return vcg::Point2d(0, 0);
+    }, std::plus<vcg::Point2d>(), FACE_GRAIN);
+    double e = sum[0];
+    double total_area = sum[1];
     if (num)
         *num = e;
     if (denom)
@@ -298,23 +308,20 @@ double ARAP::ComputeEnergyFromStoredWedgeTC(Mesh& m, double *num, double *denom)
 
 double ARAP::CurrentEnergy()
 {
-    double e = 0;
-    double total_area = 0;
     auto tsa = GetTargetShapeAttribute(m);
-    for (auto& f : m.face) {
+    vcg::Point2d sum = vcg::parallel::Reduce(m.FN(), vcg::Point2d(0, 0), [&](int fi) {
+        const Mesh::FaceType& f = m.face[fi];
         vcg::Point2d x10, x20;
         LocalIsometry(tsa[f].P[1] - tsa[f].P[0], tsa[f].P[2] - tsa[f].P[0], x10, x20);
-        Eigen::Matrix2d Jf = ComputeTransformationMatrix(x10, x20, f.WT(1).P() - f.WT(0).P(), f.WT(2).P() - f.WT(0).P());
-        Eigen::Matrix2d U, V;
+        Eigen::Matrix2d Jf = ComputeTransformationMatrix(x10, x20, f.cWT(1).P() - f.cWT(0).P(), f.cWT(2).P() - f.cWT(0).P());
         Eigen::Vector2d sigma;
         Eigen::JacobiSVD<Eigen::Matrix2d> svd;
         svd.compute(Jf, Eigen::ComputeFullU | Eigen::ComputeFullV);
-        U = svd.matrixU(); V = svd.matrixV(); sigma = svd.singularValues();
+        sigma = svd.singularValues();
         double area_f = 0.5 * ((tsa[f].P[1] - tsa[f].P[0]) ^ (tsa[f].P[2] - tsa[f].P[0])).Norm();
-        total_area += area_f;
-        e += area_f * (std::pow(sigma[0] - 1.0, 2.0) + std::pow(sigma[1] - 1.0, 2.0));
-    }
-    return e / total_area;
+        return vcg::Point2d(area_f * (std::pow(sigma[0] - 1.0, 2.0) + std::pow(sigma[1] - 1.0, 2.0)), area_f);
+    }, std::plus<vcg::Point2d>(), FACE_GRAIN);
+    return sum[0] / sum[1];
 }
 
 ARAPSolveInfo ARAP::Solve()
@@ -354,7 +361,11 @@ ARAPSolveInfo ARAP::Solve()
         Eigen::VectorXd bv(m.VN());
         ComputeRHS(m, rotations, cotan, bu, bv);
 
-        Eigen::VectorXd xu_iter = solver.solve(bu);
+        // solve for both coordinates with a single pass over the factors
+        Eigen::MatrixX2d b(m.VN(), 2);
+        b.col(0) = bu;
+        b.col(1) = bv;
+        Eigen::MatrixX2d x_iter = solver.solve(b);
 
         if (!(solver.info() == Eigen::Success)) {
             LOG_WARN << "ARAP solve failed";
@@ -362,13 +373,8 @@ ARAPSolveInfo ARAP::Solve()
             return si;
         }
 
-        Eigen::VectorXd xv_iter = solver.solve(bv);
-
-        if (!(solver.info() == Eigen::Success)) {
-            LOG_WARN << "ARAP solve failed";
-            si.numericalError = true;
-            return si;
-        }
+        Eigen::VectorXd xu_iter = x_iter.col(0);
+        Eigen::VectorXd xv_iter = x_iter.col(1);
 
         for (auto& f : m.face) {
             for (int i = 0; i < 3; ++i) {
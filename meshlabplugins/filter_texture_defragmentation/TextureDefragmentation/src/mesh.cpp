@@ -22,8 +22,6 @@
 #include <vcg/complex/complex.h>
 #include <vcg/complex/algorithms/attribute_seam.h>
 
-#include "gl_utils.h" // required for obj importer to use glu::tessellator
-
 #include <wrap/io_trimesh/import.h>
 #include <wrap/io_trimesh/export.h>
 
@@ -22,7 +22,6 @@
 #include "mesh_graph.h"
 
 #include "mesh.h"
-#include "gl_utils.h"
 #include "math_utils.h"
 #include "mesh_attribute.h"
 #include "timer.h"
@@ -29,6 +29,8 @@ typedef unsigned char byte;
 #include <QImage>
 #include <QRgb>
 
+#include <wrap/system/parallel.h>
+
 namespace vcg
 {
     /* pull push filling algorithm */
@@ -52,62 +54,81 @@ namespace vcg
     }
 
     // Genera una mipmap pesata
+    // (the rows of the mipmap are independent and computed in parallel, pixels are
+    // accessed through the 32 bit scanlines so that the images are never detached)
     static void PullPushMip( QImage & p, QImage & mip, QRgb  bkcolor )
     {
         assert(p.width()/2==mip.width());
         assert(p.height()/2==mip.height());
-        byte w1,w2,w3,w4;
-        int x,y;
-        for(y=0;y<mip.height();++y)
-            for(x=0;x<mip.width();++x)
+        const QRgb *pbits = (const QRgb *) p.constBits();
+        QRgb *mbits = (QRgb *) mip.bits();
+        const int pstride = p.bytesPerLine() / 4;
+        const int mstride = mip.bytesPerLine() / 4;
+        const int mw = mip.width();
+        parallel::For(mip.height(), [&](int y) {
+            const QRgb *p0 = pbits + (y*2)*pstride;
+            const QRgb *p1 = p0 + pstride;
+            QRgb *m = mbits + y*mstride;
+            for(int x=0;x<mw;++x)
             {
-                if(p.pixel(x*2  ,y*2  )==bkcolor) w1=0; else w1=255;
-                if(p.pixel(x*2+1,y*2  )==bkcolor) w2=0; else w2=255;
-                if(p.pixel(x*2  ,y*2+1)==bkcolor) w3=0; else w3=255;
-                if(p.pixel(x*2+1,y*2+1)==bkcolor) w4=0; else w4=255;
+                byte w1 = (p0[x*2  ]==bkcolor) ? 0 : 255;
+                byte w2 = (p0[x*2+1]==bkcolor) ? 0 : 255;
+                byte w3 = (p1[x*2  ]==bkcolor) ? 0 : 255;
+                byte w4 = (p1[x*2+1]==bkcolor) ? 0 : 255;
                 if(w1+w2+w3+w4>0        )
-                    mip.setPixel(x, y, mean4Pixelw(
-                                                   p.pixel(x*2  ,y*2  ),w1,
-                                                   p.pixel(x*2+1,y*2  ),w2,
-                                                   p.pixel(x*2  ,y*2+1),w3,
-                                                   p.pixel(x*2+1,y*2+1),w4 ));
+                    m[x] = mean4Pixelw(p0[x*2  ],w1,
+                                       p0[x*2+1],w2,
+                                       p1[x*2  ],w3,
+                                       p1[x*2+1],w4 );
             }
+        });
     }
 
     // interpola a partire da una mipmap
+    // (each mipmap pixel refills its own 2x2 block, so rows are filled in parallel)
     static void PullPushFill( QImage & p, QImage & mip, QRgb  bkg )
     {
         assert(p.width()/2==mip.width());
         assert(p.height()/2==mip.height());
-        //      byte w1,w2,w3,w4;
-        int x,y;
-        for(y=0;y<mip.height();++y)
-            for(x=0;x<mip.width();++x)
+        QRgb *pbits = (QRgb *) p.bits();
+        const QRgb *mbits = (const QRgb *) mip.constBits();
+        const int pstride = p.bytesPerLine() / 4;
+        const int mstride = mip.bytesPerLine() / 4;
+        const int mw = mip.width();
+        const int mh = mip.height();
+        parallel::For(mh, [&](int y) {
+            QRgb *p0 = pbits + (y*2)*pstride;
+            QRgb *p1 = p0 + pstride;
+            const QRgb *m = mbits + y*mstride;
+            const QRgb *mu = (y>0) ? m - mstride : m;    // row y-1
+            const QRgb *md = (y<mh-1) ? m + mstride : m; // row y+1
+            for(int x=0;x<mw;++x)
             {
-                if(p.pixel(x*2 ,y*2)==bkg)
-                    p.setPixel(x*2 ,y*2 ,mean4Pixelw( mip.pixel(x  ,y  ) ,  byte(144),
-                                                     (x>0 ? mip.pixel(x-1,y  ) : bkg),  (x>0 ? byte( 48) : 0),
-                                                     (y>0 ? mip.pixel(x  ,y-1) : bkg),  (y>0 ? byte( 48) : 0),
-                                                     ((x>0 && y>0 )? mip.pixel(x-1,y-1) : bkg), ((x>0 && y>0 )? byte( 16) : 0)));
-                if(p.pixel(x*2+1,y*2  )==bkg)
-                    p.setPixel(x*2+1,y*2  ,mean4Pixelw(mip.pixel(x  ,y  ) ,byte(144),
-                                                       (x<mip.width()-1 ? mip.pixel(x+1,y) : bkg),  (x<mip.width()-1 ? byte( 48) : 0),
-                                                       (y>0  ? mip.pixel(x  ,y-1) : bkg),  (y>0  ? byte( 48) : 0),
-                                                       ((x<mip.width()-1 && y>0) ? mip.pixel(x+1,y-1) : bkg), ((x<mip.width()-1 && y>0) ? byte( 16) : 0)));
-                if(p.pixel(x*2  ,y*2+1)==bkg)
-                    p.setPixel(x*2  ,y*2+1, mean4Pixelw( mip.pixel(x  ,y  ), byte(144),
-                                                        (x>0 ? mip.pixel(x-1,y  ) : bkg),  (x>0 ? byte( 48) : 0),
-                                                        (y<mip.height()-1  ? mip.pixel(x  ,y+1) : bkg),  (y<mip.height()-1  ? byte( 48) : 0),
-                                                        ((x>0 && y<mip.height()-1) ? mip.pixel(x-1,y+1) : bkg), ((x>0 && y<mip.height()-1 )? byte( 16) : 0)));
-                if(p.pixel(x*2+1,y*2+1)==bkg)
-                    p.setPixel(x*2+1,y*2+1, mean4Pixelw(mip.pixel(x  ,y  ), byte(144),
-                                                        (x<mip.width()-1 ? mip.pixel(x+1,y  ) : bkg), (x<mip.width()-1 ? byte( 48) : 0),
-                                                        (y<mip.height()-1  ? mip.pixel(x  ,y+1) : bkg), ( y<mip.height()-1  ? byte( 48) : 0),
-                                                        ((x<mip.width()-1  && y<mip.height()-1) ? mip.pixel(x+1,y+1) : bkg), ((x<mip.width()-1  && y<mip.height()-1) ? byte( 16) : 0)));
-
+                if(p0[x*2]==bkg)
+                    p0[x*2] = mean4Pixelw( m[x] ,  byte(144),
+                                          (x>0 ? m[x-1] : bkg),  (x>0 ? byte( 48) : 0),
+                                          (y>0 ? mu[x] : bkg),  (y>0 ? byte( 48) : 0),
+                                          ((x>0 && y>0 )? mu[x-1] : bkg), ((x>0 && y>0 )? byte( 16) : 0));
+                if(p0[x*2+1]==bkg)
+                    p0[x*2+1] = mean4Pixelw(m[x] ,byte(144),
+                                            (x<mw-1 ? m[x+1] : bkg),  (x<mw-1 ? byte( 48) : 0),
+                                            (y>0  ? mu[x] : bkg),  (y>0  ? byte( 48) : 0),
+                                            ((x<mw-1 && y>0) ? mu[x+1] : bkg), ((x<mw-1 && y>0) ? byte( 16) : 0));
+                if(p1[x*2]==bkg)
+                    p1[x*2] = mean4Pixelw( m[x], byte(144),
+                                          (x>0 ? m[x-1] : bkg),  (x>0 ? byte( 48) : 0),
+                                          (y<mh-1  ? md[x] : bkg),  (y<mh-1  ? byte( 48) : 0),
+                                          ((x>0 && y<mh-1) ? md[x-1] : bkg), ((x>0 && y<mh-1 )? byte( 16) : 0));
+                if(p1[x*2+1]==bkg)
+                    p1[x*2+1] = mean4Pixelw(m[x], byte(144),
+                                            (x<mw-1 ? m[x+1] : bkg), (x<mw-1 ? byte( 48) : 0),
+                                            (y<mh-1  ? md[x] : bkg), ( y<mh-1  ? byte( 48) : 0),
+                                            ((x<mw-1  && y<mh-1) ? md[x+1] : bkg), ((x<mw-1  && y<mh-1) ? byte( 16) : 0));
             }
+        });
 
         // avoid background bleeding on non power-of-two images
+        int x,y;
 
         if ((p.width() % 2) != 0) {
             for (y = 0; y < p.height(); ++y) {
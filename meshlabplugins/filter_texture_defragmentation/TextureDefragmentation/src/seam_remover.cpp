@@ -36,6 +36,7 @@
 #include <unordered_set>
 
 #include <vcg/complex/algorithms/clean.h>
+#include <wrap/system/parallel.h>
 
 
 constexpr double PENALTY_MULTIPLIER = 2.0;
@@ -58,6 +59,7 @@ struct Perf {
 
 
 static void InsertNewClusterInQueue(ClusteredSeamHandle csh, AlgoStateHandle state, GraphHandle graph, const AlgoParameters& params);
+static void InsertNewClusterInQueue(ClusteredSeamHandle csh, CostInfo ci, AlgoStateHandle state, GraphHandle graph, const AlgoParameters& params);
 static CostInfo ComputeCost(ClusteredSeamHandle csh, GraphHandle graph, const AlgoParameters& params, double penalty);
 static inline double GetPenalty(ClusteredSeamHandle csh, AlgoStateHandle state);
 static inline bool Valid(const WeightedSeam& ws, ConstAlgoStateHandle state);
@@ -278,13 +280,25 @@ AlgoStateHandle InitializeState(GraphHandle graph, const AlgoParameters& algoPar
     int ndisconnecting = 0;
     int nself = 0;
 
-    for (auto csh : cshvec) {
-        ChartPair charts = GetCharts(csh, graph);
+    // the initial costs only read the graph, so they are evaluated concurrently;
+    // chart caches and penalties are filled beforehand since they are lazily updated
+    for (auto& entry : graph->charts)
+        entry.second->UpdateCache();
+    std::vector<double> penalty(cshvec.size());
+    for (unsigned i = 0; i < cshvec.size(); ++i)
+        penalty[i] = GetPenalty(cshvec[i], state);
+    std::vector<CostInfo> costs(cshvec.size());
+    vcg::parallel::For((int) cshvec.size(), [&](int i) {
+        costs[i] = ComputeCost(cshvec[i], graph, algoParameters, penalty[i]);
+    });
+
+    for (unsigned i = 0; i < cshvec.size(); ++i) {
+        ChartPair charts = GetCharts(cshvec[i], graph);
         if (charts.first == charts.second)
             nself++;
         else
             ndisconnecting++;
-        InsertNewClusterInQueue(csh, state, graph, algoParameters);
+        InsertNewClusterInQueue(cshvec[i], costs[i], state, graph, algoParameters);
     }
     LOG_INFO << "Found " << ndisconnecting << " disconnecting seams";
     LOG_INFO << "Found " << nself << " non-disconnecting seams";
@@ -415,9 +429,12 @@ void Finalize(GraphHandle graph, int *vndup)
 
 static void InsertNewClusterInQueue(ClusteredSeamHandle csh, AlgoStateHandle state, GraphHandle graph, const AlgoParameters& params)
 {
-    ColorizeSeam(csh, vcg::Color4b::White);
+    InsertNewClusterInQueue(csh, ComputeCost(csh, graph, params, GetPenalty(csh, state)), state, graph, params);
+}
 
-    CostInfo ci = ComputeCost(csh, graph, params, GetPenalty(csh, state));
+static void InsertNewClusterInQueue(ClusteredSeamHandle csh, CostInfo ci, AlgoStateHandle state, GraphHandle graph, const AlgoParameters& params)
+{
+    ColorizeSeam(csh, vcg::Color4b::White);
 
     if (params.reduce) {
         while (ci.mvalue == CostInfo::UNFEASIBLE_MATCHING) {
@@ -22,7 +22,6 @@
 #include "texture_object.h"
 #include "logging.h"
 #include "utils.h"
-#include "gl_utils.h"
 
 #include <cmath>
 
@@ -36,8 +35,6 @@ TextureObject::TextureObject()
 
 TextureObject::~TextureObject()
 {
-    for (std::size_t i = 0; i < texNameVec.size(); ++i)
-        Release(i);
 }
 
 bool TextureObject::AddImage(std::string path)
@@ -46,7 +43,6 @@ bool TextureObject::AddImage(std::string path)
     if (qir.canRead()) {
         TextureImageInfo tii = {QImage(path.c_str())};
         texInfoVec.push_back(tii);
-        texNameVec.push_back(0);
         return true;
     } else return false;
 }
@@ -55,54 +51,9 @@ bool TextureObject::AddImage(const QImage& image)
 {
     TextureImageInfo tii = {QImage(image)};
     texInfoVec.push_back(tii);
-    texNameVec.push_back(0);
     return true;
 }
 
-void TextureObject::Bind(int i)
-{
-    ensure(i >= 0 && i < (int) texInfoVec.size());
-    // load texture from qimage on first use
-    if (texNameVec[i] == 0) {
-        QImage& img = texInfoVec[i].texture;
-        ensure(!img.isNull());
-        if ((img.format() != QImage::Format_RGB32) || (img.format() != QImage::Format_ARGB32)) {
-            QImage glimg = img.convertToFormat(QImage::Format_ARGB32);
-            img = glimg;
-        }
-        glGenTextures(1, &texNameVec[i]);
-
-        Mirror(img);
-        glBindTexture(GL_TEXTURE_2D, texNameVec[i]);
-        int miplevels = std::log2((float) img.width());
-        int width = img.width();
-        int height = img.height();
-        for (int m = 0; m < miplevels; m++) {
-            glTexImage2D(GL_TEXTURE_2D, m, GL_RGBA8, width, height, 0, GL_BGRA, GL_UNSIGNED_BYTE, NULL);
-            width = std::max(1, (width / 2));
-            height = std::max(1, (height / 2));
-        }
-        //glTexStorage2D(GL_TEXTURE_2D, miplevels, GL_RGBA8, img.width(), img.height());
-        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, img.width(), img.height(), GL_BGRA, GL_UNSIGNED_BYTE, img.constBits());
-        glGenerateMipmap(GL_TEXTURE_2D);
-        CheckGLError();
-        Mirror(img);
-    }
-    else {
-        glBindTexture(GL_TEXTURE_2D, texNameVec[i]);
-        CheckGLError();
-    }
-}
-
-void TextureObject::Release(int i)
-{
-    ensure(i >= 0 && i < (int) texInfoVec.size());
-    if (texNameVec[i]) {
-        glDeleteTextures(1, &texNameVec[i]);
-        texNameVec[i] = 0;
-    }
-}
-
 int TextureObject::TextureWidth(std::size_t i)
 {
     ensure(i < texInfoVec.size());
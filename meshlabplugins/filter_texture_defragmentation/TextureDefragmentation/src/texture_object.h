@@ -46,7 +46,6 @@ struct TextureImageInfo {
 struct TextureObject {
 
     std::vector<TextureImageInfo> texInfoVec;
-    std::vector<uint32_t> texNameVec;
 
     TextureObject();
     ~TextureObject();
@@ -58,12 +57,6 @@ struct TextureObject {
     bool AddImage(std::string path);
     bool AddImage(const QImage& image);
 
-    /* Binds the texture at index i */
-    void Bind(int i);
-
-    /* Releases the texture i, without unbinding it if it is bound */
-    void Release(int i);
-
     int TextureWidth(std::size_t i);
     int TextureHeight(std::size_t i);
 
@@ -27,79 +27,304 @@
 
 #include "mesh.h"
 #include "texture_rendering.h"
-#include "gl_utils.h"
 #include "pushpull.h"
 #include "mesh_attribute.h"
 #include "logging.h"
 
 #include <iostream>
 #include <algorithm>
+#include <cmath>
+#include <limits>
 
+#include <Eigen/Dense>
 #include <QImage>
 
+#include <wrap/system/parallel.h>
 
 
-static const char *vs_text[] = {
-    "attribute vec2 position;                                    \n"
-    "attribute vec2 texcoord;                                    \n"
-    "attribute vec4 color;                                       \n"
-    "varying vec2 uv;                                            \n"
-    "varying vec4 fcolor;                                        \n"
-    "                                                            \n"
-    "void main(void)                                             \n"
-    "{                                                           \n"
-    "    uv = texcoord;                                          \n"
-    "    fcolor = color;                                         \n"
-    "    //if (uv.s < 0) uv = vec2(0.0, 0.0);                    \n"
-    "    vec2 p = 2.0 * position - vec2(1.0, 1.0);               \n"
-    "    gl_Position = vec4(p, 0.5, 1.0);                        \n"
-    "}                                                           \n"
+/* The atlas is rendered on the CPU, following the OpenGL conventions of the
+ * original shader-based implementation: texture data is stored bottom-up, input
+ * textures are sampled with repeat wrapping and trilinear (mipmapped) filtering,
+ * and pixels are covered if their center is inside the triangle. The output rows
+ * are split in bands that are rasterized in parallel, each band drawing its
+ * triangles in submission order so that the result does not depend on the number
+ * of threads. */
+
+namespace {
+
+typedef vcg::Point4f Color;
+
+/* Mipmap pyramid of an input texture, rows stored bottom-up */
+struct TextureMipmap {
+    struct Level {
+        int w;
+        int h;
+        std::vector<QRgb> texels;
+    };
+    std::vector<Level> levels;
+
+    TextureMipmap(const QImage& image, bool buildMipmaps)
+    {
+        QImage img = image.convertToFormat(QImage::Format_ARGB32);
+        levels.resize(1);
+        Level& base = levels[0];
+        base.w = img.width();
+        base.h = img.height();
+        base.texels.resize(std::size_t(base.w) * base.h);
+        vcg::parallel::For(base.h, [&](int y) {
+            const QRgb *line = (const QRgb *) img.constScanLine(base.h - 1 - y);
+            std::copy(line, line + base.w, base.texels.begin() + std::size_t(y) * base.w);
+        });
+        while (buildMipmaps && (levels.back().w > 1 || levels.back().h > 1)) {
+            levels.push_back(Downsample(levels.back()));
+        }
+    }
+
+    static Level Downsample(const Level& src)
+    {
+        Level dst;
+        dst.w = std::max(1, src.w / 2);
+        dst.h = std::max(1, src.h / 2);
+        dst.texels.resize(std::size_t(dst.w) * dst.h);
+        vcg::parallel::For(dst.h, [&](int y) {
+            int y0 = std::min(2 * y, src.h - 1);
+            int y1 = std::min(2 * y + 1, src.h - 1);
+            for (int x = 0; x < dst.w; ++x) {
+                int x0 = std::min(2 * x, src.w - 1);
+                int x1 = std::min(2 * x + 1, src.w - 1);
+                QRgb t[4] = {
+                    src.texels[std::size_t(y0) * src.w + x0], src.texels[std::size_t(y0) * src.w + x1],
+                    src.texels[std::size_t(y1) * src.w + x0], src.texels[std::size_t(y1) * src.w + x1]
+                };
+                int r = 0, g = 0, b = 0, a = 0;
+                for (int k = 0; k < 4; ++k) {
+                    r += qRed(t[k]); g += qGreen(t[k]); b += qBlue(t[k]); a += qAlpha(t[k]);
+                }
+                dst.texels[std::size_t(y) * dst.w + x] = qRgba((r + 2) / 4, (g + 2) / 4, (b + 2) / 4, (a + 2) / 4);
+            }
+        });
+        return dst;
+    }
+
+    static int Wrap(int i, int n)
+    {
+        i %= n;
+        return (i < 0) ? i + n : i;
+    }
+
+    static Color Texel(const Level& l, int x, int y)
+    {
+        QRgb t = l.texels[std::size_t(Wrap(y, l.h)) * l.w + Wrap(x, l.w)];
+        return Color(qRed(t), qGreen(t), qBlue(t), qAlpha(t)) / 255.0f;
+    }
+
+    Color Nearest(const vcg::Point2d& uv) const
+    {
+        const Level& l = levels[0];
+        return Texel(l, (int) std::floor(uv.X() * l.w), (int) std::floor(uv.Y() * l.h));
+    }
+
+    Color Bilinear(int level, const vcg::Point2d& uv) const
+    {
+        const Level& l = levels[level];
+        double x = uv.X() * l.w - 0.5;
+        double y = uv.Y() * l.h - 0.5;
+        int x0 = (int) std::floor(x);
+        int y0 = (int) std::floor(y);
+        float fx = float(x - x0);
+        float fy = float(y - y0);
+        Color c0 = Texel(l, x0, y0) * (1 - fx) + Texel(l, x0 + 1, y0) * fx;
+        Color c1 = Texel(l, x0, y0 + 1) * (1 - fx) + Texel(l, x0 + 1, y0 + 1) * fx;
+        return c0 * (1 - fy) + c1 * fy;
+    }
+
+    Color Trilinear(const vcg::Point2d& uv, float lod) const
+    {
+        if (lod <= 0 || levels.size() == 1)
+            return Bilinear(0, uv);
+        lod = std::min(lod, float(levels.size() - 1));
+        int l0 = (int) std::floor(lod);
+        int l1 = std::min(l0 + 1, int(levels.size()) - 1);
+        float f = lod - l0;
+        return Bilinear(l0, uv) * (1 - f) + Bilinear(l1, uv) * f;
+    }
+
+    /* Cubic B-spline filtering with four bilinear lookups, as in the GPU version */
+    Color Cubic(const vcg::Point2d& uv, float lod) const
+    {
+        const Level& l = levels[0];
+        vcg::Point2d texsz(l.w, l.h);
+        vcg::Point2d coord(uv.X() * l.w - 0.5, uv.Y() * l.h - 0.5);
+        vcg::Point2d idx(std::floor(coord.X()), std::floor(coord.Y()));
+        vcg::Point2d g0, g1, h0, h1;
+        for (int i = 0; i < 2; ++i) {
+            double fraction = coord[i] - idx[i];
+            double one_frac = 1.0 - fraction;
+            double w0 = (1.0/6.0) * one_frac * one_frac * one_frac;
+            double w1 = (2.0/3.0) - 0.5 * fraction * fraction * (2.0 - fraction);
+            double w2 = (2.0/3.0) - 0.5 * one_frac * one_frac * (2.0 - one_frac);
+            double w3 = (1.0/6.0) * fraction * fraction * fraction;
+            g0[i] = w0 + w1;
+            g1[i] = w2 + w3;
+            h0[i] = (w1 / g0[i]) - 0.5 + idx[i];
+            h1[i] = (w3 / g1[i]) + 1.5 + idx[i];
+        }
+        Color tex00 = Trilinear(vcg::Point2d(h0.X() / texsz.X(), h0.Y() / texsz.Y()), lod);
+        Color tex10 = Trilinear(vcg::Point2d(h1.X() / texsz.X(), h0.Y() / texsz.Y()), lod);
+        Color tex01 = Trilinear(vcg::Point2d(h0.X() / texsz.X(), h1.Y() / texsz.Y()), lod);
+        Color tex11 = Trilinear(vcg::Point2d(h1.X() / texsz.X(), h1.Y() / texsz.Y()), lod);
+        float gy = float(g1.Y());
+        float gx = float(g1.X());
+        tex00 = tex00 * (1 - gy) + tex01 * gy;
+        tex10 = tex10 * (1 - gy) + tex11 * gy;
+        return tex00 * (1 - gx) + tex10 * gx;
+    }
 };
 
-static const char *fs_text[] = {
-    "uniform sampler2D img0;                                               \n"
-    "                                                                      \n"
-    "uniform vec2 texture_size;                                            \n"
-    "uniform int render_mode;                                              \n"
-    "                                                                      \n"
-    "varying vec2 uv;                                                      \n"
-    "varying vec4 fcolor;                                                  \n"
-    "                                                                      \n"
-    "void main(void)                                                       \n"
-    "{                                                                     \n"
-    "    if (render_mode == 0) {                                           \n"
-    "        if (uv.s < float(0))                                          \n"
-    "            gl_FragColor = vec4(0, 1, 0, 1);                          \n"
-    "        else                                                          \n"
-    "            gl_FragColor = vec4(texture2D(img0, uv).rgb, 1);          \n"
-    "    } else if (render_mode == 1) {                                    \n"
-    "        vec2 coord = uv * texture_size - vec2(0.5, 0.5);              \n"
-    "        vec2 idx = floor(coord);                                      \n"
-    "        vec2 fraction = coord - idx;                                  \n"
-    "        vec2 one_frac = vec2(1.0, 1.0) - fraction;                    \n"
-    "        vec2 one_frac2 = one_frac * one_frac;                         \n"
-    "        vec2 fraction2 = fraction * fraction;                         \n"
-    "        vec2 w0 = (1.0/6.0) * one_frac2 * one_frac;                   \n"
-    "        vec2 w1 = (2.0/3.0) - 0.5 * fraction2 * (2.0 - fraction);     \n"
-    "        vec2 w2 = (2.0/3.0) - 0.5 * one_frac2 * (2.0 - one_frac);     \n"
-    "        vec2 w3 = (1.0/6.0) * fraction2 * fraction;                   \n"
-    "        vec2 g0 = w0 + w1;                                            \n"
-    "        vec2 g1 = w2 + w3;                                            \n"
-    "        vec2 h0 = (w1 / g0) - 0.5 + idx;                              \n"
-    "        vec2 h1 = (w3 / g1) + 1.5 + idx;                              \n"
-    "        vec4 tex00 = texture2D(img0, vec2(h0.x, h0.y) / texture_size);\n"
-    "        vec4 tex10 = texture2D(img0, vec2(h1.x, h0.y) / texture_size);\n"
-    "        vec4 tex01 = texture2D(img0, vec2(h0.x, h1.y) / texture_size);\n"
-    "        vec4 tex11 = texture2D(img0, vec2(h1.x, h1.y) / texture_size);\n"
-    "        tex00 = mix(tex00, tex01, g1.y);                              \n"
-    "        tex10 = mix(tex10, tex11, g1.y);                              \n"
-    "        gl_FragColor = mix(tex00, tex10, g1.x);                       \n"
-    "    } else {                                                          \n"
-    "        gl_FragColor = fcolor;                                        \n"
-    "    }                                                                 \n"
-    "}                                                                     \n"
+/* A triangle in output pixel coordinates, counter-clockwise */
+struct RasterTriangle {
+    vcg::Point2d p[3];
+    vcg::Point2d uv[3];
+    double area2;
+    float lod;
+    Color color;
+    int rowBegin;
+    int rowEnd;
 };
 
+inline double EdgeFunction(const vcg::Point2d& a, const vcg::Point2d& b, const vcg::Point2d& p)
+{
+    return (b - a) ^ (p - a);
+}
+
+/* Tie-breaking rule for pixel centers that lie exactly on an edge: of the two
+ * triangles sharing the edge, only one covers them */
+inline bool IncludesEdge(const vcg::Point2d& a, const vcg::Point2d& b)
+{
+    vcg::Point2d d = b - a;
+    return d.Y() > 0 || (d.Y() == 0 && d.X() < 0);
+}
+
+inline QRgb ToQRgb(const Color& c)
+{
+    int v[4];
+    for (int i = 0; i < 4; ++i)
+        v[i] = (int) std::lround(std::min(1.0f, std::max(0.0f, c[i])) * 255.0f);
+    return qRgba(v[0], v[1], v[2], v[3]);
+}
+
+/* Sets up the triangle, returns false if it covers no pixel */
+bool SetupTriangle(const Mesh::FacePointer fptr, const TexCoordStorage& tcs, const TextureSize& inSize,
+                   int width, int height, RasterTriangle& t)
+{
+    for (int i = 0; i < 3; ++i) {
+        t.p[i] = vcg::Point2d(fptr->cWT(i).U() * width, fptr->cWT(i).V() * height);
+        t.uv[i] = vcg::Point2d(tcs.tc[i].U() / inSize.w, tcs.tc[i].V() / inSize.h);
+    }
+    t.area2 = EdgeFunction(t.p[0], t.p[1], t.p[2]);
+    if (t.area2 == 0 || !std::isfinite(t.area2))
+        return false;
+    if (t.area2 < 0) {
+        std::swap(t.p[1], t.p[2]);
+        std::swap(t.uv[1], t.uv[2]);
+        t.area2 = -t.area2;
+    }
+
+    double ymin = std::min(t.p[0].Y(), std::min(t.p[1].Y(), t.p[2].Y()));
+    double ymax = std::max(t.p[0].Y(), std::max(t.p[1].Y(), t.p[2].Y()));
+    t.rowBegin = std::max(0, (int) std::ceil(ymin - 0.5));
+    t.rowEnd = std::min(height, (int) std::floor(ymax - 0.5) + 1);
+    if (t.rowBegin >= t.rowEnd)
+        return false;
+
+    // level of detail from the texel footprint of a pixel, with 16x anisotropic filtering
+    Eigen::Matrix2d P, Q;
+    vcg::Point2d p10 = t.p[1] - t.p[0], p20 = t.p[2] - t.p[0];
+    vcg::Point2d q10 = (t.uv[1] - t.uv[0]), q20 = (t.uv[2] - t.uv[0]);
+    P << p10.X(), p20.X(), p10.Y(), p20.Y();
+    Q << q10.X() * inSize.w, q20.X() * inSize.w, q10.Y() * inSize.h, q20.Y() * inSize.h;
+    Eigen::Matrix2d J = Q * P.inverse();
+    double lx = J.col(0).norm();
+    double ly = J.col(1).norm();
+    double pmax = std::max(lx, ly);
+    double pmin = std::min(lx, ly);
+    double n = (pmin > 0) ? std::min(std::ceil(pmax / pmin), 16.0) : 16.0;
+    t.lod = (pmax > 0) ? float(std::log2(pmax / n)) : 0.0f;
+
+    const vcg::Color4b& fc = fptr->cC();
+    t.color = Color(fc[0], fc[1], fc[2], fc[3]) / 255.0f;
+    return true;
+}
+
+Color Shade(const RasterTriangle& t, const vcg::Point2d& uv, const TextureMipmap *tex, RenderMode imode)
+{
+    switch (imode) {
+    case Cubic:
+        return tex->Cubic(uv, t.lod);
+    case Linear:
+        if (uv.X() < 0)
+            return Color(0, 1, 0, 1);
+        else {
+            Color c = tex->Trilinear(uv, t.lod);
+            c[3] = 1;
+            return c;
+        }
+    case Nearest:
+        if (uv.X() < 0)
+            return Color(0, 1, 0, 1);
+        else {
+            Color c = tex->Nearest(uv);
+            c[3] = 1;
+            return c;
+        }
+    case FaceColor:
+        return t.color;
+    default:
+        ensure(0 && "Should never happen");
+    }
+    return Color(0, 0, 0, 0);
+}
+
+/* Rasterizes the rows [rowBegin, rowEnd) of the triangle */
+void RasterizeRows(const RasterTriangle& t, int rowBegin, int rowEnd, int width,
+                   const TextureMipmap *tex, RenderMode imode, QRgb *pixels)
+{
+    const bool inc[3] = {
+        IncludesEdge(t.p[1], t.p[2]), IncludesEdge(t.p[2], t.p[0]), IncludesEdge(t.p[0], t.p[1])
+    };
+    for (int y = std::max(rowBegin, t.rowBegin); y < std::min(rowEnd, t.rowEnd); ++y) {
+        double yc = y + 0.5;
+        // span of the row inside the triangle, pixels are then tested exactly
+        double xmin = std::numeric_limits<double>::max();
+        double xmax = std::numeric_limits<double>::lowest();
+        for (int i = 0; i < 3; ++i) {
+            const vcg::Point2d& a = t.p[i];
+            const vcg::Point2d& b = t.p[(i+1)%3];
+            // horizontal edges are bounded by the endpoints of the other two
+            if (a.Y() != b.Y() && std::min(a.Y(), b.Y()) <= yc && yc <= std::max(a.Y(), b.Y())) {
+                double x = a.X() + (yc - a.Y()) * (b.X() - a.X()) / (b.Y() - a.Y());
+                xmin = std::min(xmin, x);
+                xmax = std::max(xmax, x);
+            }
+        }
+        if (xmin > xmax)
+            continue;
+        int xb = std::max(0, (int) std::floor(xmin - 0.5));
+        int xe = std::min(width, (int) std::ceil(xmax - 0.5) + 1);
+        for (int x = xb; x < xe; ++x) {
+            vcg::Point2d pc(x + 0.5, yc);
+            double e0 = EdgeFunction(t.p[1], t.p[2], pc);
+            double e1 = EdgeFunction(t.p[2], t.p[0], pc);
+            double e2 = EdgeFunction(t.p[0], t.p[1], pc);
+            if ((e0 > 0 || (e0 == 0 && inc[0])) && (e1 > 0 || (e1 == 0 && inc[1])) && (e2 > 0 || (e2 == 0 && inc[2]))) {
+                vcg::Point2d uv = (t.uv[0] * e0 + t.uv[1] * e1 + t.uv[2] * e2) / t.area2;
+                pixels[std::size_t(y) * width + x] = ToQRgb(Shade(t, uv, tex, imode));
+            }
+        }
+    }
+}
+
+} // namespace
 
 
 static std::shared_ptr<QImage> RenderTexture(std::vector<Mesh::FacePointer>& fvec,
@@ -160,22 +385,6 @@ static std::shared_ptr<QImage> RenderTexture(std::vector<Mesh::FacePointer>& fve
 
     std::sort(fvec.begin(), fvec.end(), FaceComparatorByInputTexIndex);
 
-    // OpenGL setup
-
-    GLuint vao;
-    glGenVertexArrays(1, &vao);
-    glBindVertexArray(vao);
-
-    GLint program = CompileShaders(vs_text, fs_text);
-    glUseProgram(program);
-
-    CheckGLError();
-
-    // Allocate vertex data
-
-    GLuint vertexbuf;
-    glGenBuffers(1, &vertexbuf);
-
     std::vector<TextureSize> inTexSizes;
     for (std::size_t i = 0; i < textureObject->ArraySize(); ++i) {
         int iw = textureObject->TextureWidth(i);
@@ -183,153 +392,52 @@ static std::shared_ptr<QImage> RenderTexture(std::vector<Mesh::FacePointer>& fve
         inTexSizes.push_back({iw, ih});
     }
 
-    glBindBuffer(GL_ARRAY_BUFFER, vertexbuf);
-    glBufferData(GL_ARRAY_BUFFER, m.FN()*15*sizeof(float), NULL, GL_STATIC_DRAW);
-    float *p = (float *) glMapBuffer(GL_ARRAY_BUFFER, GL_WRITE_ONLY);
-    for (auto fptr : fvec) {
-        int ti = WTCSh[fptr].tc[0].N();
-        for (int i = 0; i < 3; ++i) {
-            *p++ = fptr->cWT(i).U();
-            *p++ = fptr->cWT(i).V();
-            vcg::Point2d uv = WTCSh[fptr].tc[i].P();
-            *p++ = uv.X() / inTexSizes[ti].w;
-            *p++ = uv.Y() / inTexSizes[ti].h;
-            unsigned char *colorptr = (unsigned char *) p;
-            *colorptr++ = fptr->C()[0];
-            *colorptr++ = fptr->C()[1];
-            *colorptr++ = fptr->C()[2];
-            *colorptr++ = fptr->C()[3];
-            p++;
-
-        }
-    }
-    glUnmapBuffer(GL_ARRAY_BUFFER);
-
-    GLint pos_location = glGetAttribLocation(program, "position");
-    glVertexAttribPointer(pos_location, 2, GL_FLOAT, GL_FALSE, 5*sizeof(float), 0);
-    glEnableVertexAttribArray(pos_location);
+    std::shared_ptr<QImage> textureImage = std::make_shared<QImage>(textureWidth, textureHeight, QImage::Format_ARGB32);
+    textureImage->fill(qRgba(0, 255, 0, 128));
+    QRgb *pixels = (QRgb *) textureImage->bits();
 
-    GLint tc_location = glGetAttribLocation(program, "texcoord");
-    glVertexAttribPointer(tc_location, 2, GL_FLOAT, GL_FALSE, 5*sizeof(float), (void *) (2*sizeof(float)));
-    glEnableVertexAttribArray(tc_location);
+    const int bandHeight = 16;
+    const int bandNum = (textureHeight + bandHeight - 1) / bandHeight;
 
-    GLint color_location = glGetAttribLocation(program, "color");
-    glVertexAttribPointer(color_location, 4, GL_UNSIGNED_BYTE, GL_TRUE, 5*sizeof(float), (void *) (4*sizeof(float)));
-    glEnableVertexAttribArray(color_location);
-
-    p = nullptr;
-    glBindBuffer(GL_ARRAY_BUFFER, 0); // done, unbind
-
-    int renderedTexWidth = textureWidth;
-    int renderedTexHeight = textureHeight;
-
-    GLint drawBuffer;
-    glGetIntegerv(GL_DRAW_BUFFER, &drawBuffer);
-
-    GLuint fbo;
-    glGenFramebuffers(1, &fbo);
-    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
-
-    glViewport(0, 0, renderedTexWidth, renderedTexHeight);
-
-    GLuint renderTarget;
-    glGenTextures(1, &renderTarget);
-    glBindTexture(GL_TEXTURE_2D, renderTarget);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, renderedTexWidth, renderedTexHeight, 0, GL_BGRA, GL_UNSIGNED_BYTE, NULL);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, renderTarget, 0);
-    glBindTexture(GL_TEXTURE_2D, 0);
-
-    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
-        LOG_ERR << "Framebuffer is not complete " << glCheckFramebufferStatus(GL_FRAMEBUFFER);
-        std::exit(-1);
-    }
-
-    std::shared_ptr<QImage> textureImage = std::make_shared<QImage>(renderedTexWidth, renderedTexHeight, QImage::Format_ARGB32);
-
-    // disable depth and stencil test (if they were enabled) as the render target does not have the buffers attached
-    glDisable(GL_DEPTH_TEST);
-    glDisable(GL_STENCIL_TEST);
-
-    glDrawBuffer(GL_COLOR_ATTACHMENT0);
-
-    glClearColor(0.0f, 1.0f, 0.0f, 128 / float(255));
-
-    glClear(GL_COLOR_BUFFER_BIT);
-
-    auto f0 = fvec.begin();
-    auto fbase = f0;
+    auto fbase = fvec.begin();
     while (fbase != fvec.end()) {
         auto fcurr = fbase;
         int currTexIndex = WTCSh[*fcurr].tc[0].N();
         while (fcurr != fvec.end() && WTCSh[*fcurr].tc[0].N() == currTexIndex)
             fcurr++;
-        int baseIndex = std::distance(f0, fbase) * 3;
-        int count = std::distance(fbase, fcurr) * 3;
-
-        // Load texture image
-        glActiveTexture(GL_TEXTURE0);
-        LOG_DEBUG << "Binding texture unit " << currTexIndex;
-        textureObject->Bind(currTexIndex);
-
-        GLint loc_img0 = glGetUniformLocation(program, "img0");
-        glUniform1i(loc_img0, 0);
-        GLint loc_texture_size = glGetUniformLocation(program, "texture_size");
-        glUniform2f(loc_texture_size, float(textureObject->TextureWidth(currTexIndex)), float(textureObject->TextureHeight(currTexIndex)));
-
-
-        GLint loc_render_mode = glGetUniformLocation(program, "render_mode");
-        glUniform1i(loc_render_mode, 0);
-        switch (imode) {
-        case Cubic:
-            glUniform1i(loc_render_mode, 1);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-            glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, 16.0f);
-            break;
-        case Linear:
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-            glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, 16.0f);
-            //glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-            //glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, 1.0f);
-            break;
-        case Nearest:
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-            break;
-        case FaceColor:
-            glUniform1i(loc_render_mode, 2);
-            break;
-        default:
-            ensure(0 && "Should never happen");
+        int count = std::distance(fbase, fcurr);
+
+        LOG_DEBUG << "Rendering faces of texture unit " << currTexIndex;
+        std::shared_ptr<TextureMipmap> tex;
+        if (imode != FaceColor) {
+            ensure(currTexIndex < (int) textureObject->ArraySize());
+            tex = std::make_shared<TextureMipmap>(textureObject->texInfoVec[currTexIndex].texture, imode != Nearest);
         }
 
-        glDrawArrays(GL_TRIANGLES, baseIndex, count);
-        CheckGLError();
+        std::vector<RasterTriangle> triangles(count);
+        std::vector<char> visible(count);
+        vcg::parallel::For(count, [&](int i) {
+            Mesh::FacePointer fptr = *(fbase + i);
+            visible[i] = SetupTriangle(fptr, WTCSh[fptr], inTexSizes[currTexIndex], textureWidth, textureHeight, triangles[i]);
+        });
+
+        // bin the triangles by band, keeping the submission order within each band
+        std::vector<std::vector<int>> bands(bandNum);
+        for (int i = 0; i < count; ++i) {
+            if (visible[i]) {
+                for (int b = triangles[i].rowBegin / bandHeight; b <= (triangles[i].rowEnd - 1) / bandHeight; ++b)
+                    bands[b].push_back(i);
+            }
+        }
 
-        textureObject->Release(currTexIndex);
+        vcg::parallel::For(bandNum, [&](int b) {
+            for (int i : bands[b])
+                RasterizeRows(triangles[i], b * bandHeight, (b + 1) * bandHeight, textureWidth, tex.get(), imode, pixels);
+        }, 0, "", 1);
 
         fbase = fcurr;
     }
 
-    glReadBuffer(GL_COLOR_ATTACHMENT0);
-    glReadPixels(0, 0, renderedTexWidth, renderedTexHeight, GL_BGRA, GL_UNSIGNED_BYTE, textureImage->bits());
-
-    // clean up
-    glUseProgram(0);
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    glBindVertexArray(0);
-
-    glDeleteTextures(1, &renderTarget);
-    glDeleteFramebuffers(1, &fbo);
-    glDeleteBuffers(1, &vertexbuf);
-    glDeleteProgram(program);
-    glDeleteVertexArrays(1, &vao);
-
-    glDrawBuffer(drawBuffer);
-
     if (filter)
         vcg::PullPush(*textureImage, qRgba(0, 255, 0, 128));
 
@@ -32,8 +32,6 @@
 #include <vcg/complex/algorithms/update/topology.h>
 #include <vcg/complex/algorithms/update/normal.h>
 
-#include <common/GLExtensionsManager.h>
-
 #include "TextureDefragmentation/src/mesh.h"
 #include "TextureDefragmentation/src/texture_object.h"
 #include "TextureDefragmentation/src/mesh_attribute.h"
@@ -112,17 +110,6 @@ int FilterTextureDefragPlugin::getRequirements(const QAction *a)
 	return MeshModel::MM_NONE;
 }
 
-bool FilterTextureDefragPlugin::requiresGLContext(const QAction* a) const
-{
-	switch (ID(a)) {
-	case FP_TEXTURE_DEFRAG:
-		return true;
-	default:
-		assert(0);
-		return false;
-	}
-}
-
 int FilterTextureDefragPlugin::postCondition(const QAction *a) const
 {
 	switch (ID(a)) {
@@ -364,10 +351,8 @@ std::map<std::string, QVariant> FilterTextureDefragPlugin::applyFilter(
 
 		IntegerShift(defragMesh, chartsToPack, texszVec, anchorMap, flipped);
 
-		glContext->makeCurrent();
-		GLExtensionsManager::initializeGLextensions();
+		cb(80, "Rendering textures...");
 		std::vector<std::shared_ptr<QImage>> newTextures = RenderTexture(defragMesh, textureObject, texszVec, true, RenderMode::Linear);
-		glContext->doneCurrent();
 
 		// Copy wedge tex coords from defragMesh to cm
 		if (mm.cm.FN() != defragMesh.FN())
@@ -9,3 +9,5 @@ SOURCES += \
 		
 TARGET = filter_unsharp
 
+
+linux:QMAKE_LFLAGS += -fopenmp -lgomp
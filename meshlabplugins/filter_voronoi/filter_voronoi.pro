@@ -7,3 +7,5 @@ SOURCES += \
     filter_voronoi.cpp
 		
 TARGET = filter_voronoi
+
+linux:QMAKE_LFLAGS += -fopenmp -lgomp
@@ -25,6 +25,8 @@
 #include "load_project.h"
 #include "save_project.h"
 
+#include <QFileInfo>
+#include <QMutex>
 #include <QTextStream>
 
 #include <wrap/io_trimesh/import_ply.h>
@@ -87,6 +89,130 @@ const static std::list<FileFormat> exportImageFormatList = {
 	FileFormat("X11 Bitmap", "XPM")
 };
 
+namespace {
+
+// ImporterVMI and ExporterVMI keep their read/write state in static variables
+QMutex vmiMutex;
+
+const char* vmiCacheMaskAttribute = "vmi_cache_source_mask";
+const char* vmiCacheSizeAttribute = "vmi_cache_source_size";
+const char* vmiCacheTimeAttribute = "vmi_cache_source_time";
+
+QString vmiCacheFileName(const QString& fileName)
+{
+	return fileName + ".vmi";
+}
+
+// Opens a VMI image mapping the file in memory: the header is parsed in place
+// and vertices, faces and attributes are copied out with a memcpy each, after
+// checking that they lie within the file.
+// Falls back to the plain file reader if the file cannot be mapped.
+int openVMI(const QString& fileName, MeshModel& m, int& mask, CallBackPos* cb)
+{
+	QMutexLocker locker(&vmiMutex);
+	QFile file(fileName);
+	const char* data = nullptr;
+	if (file.open(QIODevice::ReadOnly))
+		data = reinterpret_cast<const char*>(file.map(0, file.size()));
+
+	int loadMask = 0;
+	if (data == nullptr) {
+		std::string filename = QFile::encodeName(fileName).constData();
+		if (!tri::io::ImporterVMI<CMeshO>::LoadMask(filename.c_str(), loadMask))
+			return tri::io::ImporterVMI<CMeshO>::VMI_FAILED_OPEN;
+		m.enable(loadMask);
+		return tri::io::ImporterVMI<CMeshO>::Open(m.cm, filename.c_str(), mask, cb);
+	}
+	const size_t size = size_t(file.size());
+	if (!tri::io::ImporterVMI<CMeshO>::LoadMaskFromMem(data, size, loadMask))
+		return tri::io::ImporterVMI<CMeshO>::VMI_FAILED_OPEN;
+	m.enable(loadMask);
+	return tri::io::ImporterVMI<CMeshO>::ReadFromMem(m.cm, mask, data, size);
+}
+
+// Reads and removes from the mesh the per mesh attribute with the given name;
+// returns false if it is missing.
+template <typename T>
+bool takeVMICacheAttribute(CMeshO& m, const char* name, T& value)
+{
+	CMeshO::PerMeshAttributeHandle<T> h =
+		tri::Allocator<CMeshO>::FindPerMeshAttribute<T>(m, name);
+	if (!tri::Allocator<CMeshO>::IsValidHandle(m, h))
+		return false;
+	value = h();
+	tri::Allocator<CMeshO>::DeletePerMeshAttribute(m, h);
+	return true;
+}
+
+// The cache of "mesh.ply" is "mesh.ply.vmi"; it stores, as per mesh attributes,
+// the import mask of the source and the size and modification time the source
+// had when the cache was written, and it is used only while they still match.
+// Returns false, leaving the mesh empty, if the cache is missing, stale, was
+// written by a build with a different vertex/face layout or is corrupted; in
+// the last cases the cache file is removed.
+bool openVMICache(const QString& fileName, MeshModel& m, int& mask)
+{
+	QFileInfo sourceInfo(fileName);
+	QFileInfo cacheInfo(vmiCacheFileName(fileName));
+	if (!cacheInfo.exists() || cacheInfo.lastModified() < sourceInfo.lastModified())
+		return false;
+
+	int vmiMask = 0;
+	int sourceMask = 0;
+	qint64 sourceSize = -1, sourceTime = -1;
+	if (openVMI(cacheInfo.filePath(), m, vmiMask, nullptr) == tri::io::ImporterVMI<CMeshO>::VMI_NO_ERROR) {
+		bool valid = takeVMICacheAttribute(m.cm, vmiCacheMaskAttribute, sourceMask);
+		valid = takeVMICacheAttribute(m.cm, vmiCacheSizeAttribute, sourceSize) && valid;
+		valid = takeVMICacheAttribute(m.cm, vmiCacheTimeAttribute, sourceTime) && valid;
+		if (valid && sourceSize == sourceInfo.size() &&
+				sourceTime == sourceInfo.lastModified().toMSecsSinceEpoch()) {
+			mask = sourceMask;
+			m.enable(mask);
+			return true;
+		}
+	}
+	m.cm.Clear();
+	m.cm.ClearAttributes();
+	QFile::remove(cacheInfo.filePath());
+	return false;
+}
+
+// VMI does not store texture names, so textured meshes are never cached.
+// The image is written aside and renamed, so that an interrupted write never
+// leaves a truncated cache behind.
+void saveVMICache(const QString& fileName, MeshModel& m, int mask)
+{
+	if (!m.cm.textures.empty() || !m.cm.normalmaps.empty())
+		return;
+
+	QString cacheName = vmiCacheFileName(fileName);
+	QString tmpName = cacheName + ".tmp";
+	QFileInfo sourceInfo(fileName);
+	CMeshO::PerMeshAttributeHandle<int> h =
+		tri::Allocator<CMeshO>::GetPerMeshAttribute<int>(m.cm, vmiCacheMaskAttribute);
+	CMeshO::PerMeshAttributeHandle<qint64> hs =
+		tri::Allocator<CMeshO>::GetPerMeshAttribute<qint64>(m.cm, vmiCacheSizeAttribute);
+	CMeshO::PerMeshAttributeHandle<qint64> ht =
+		tri::Allocator<CMeshO>::GetPerMeshAttribute<qint64>(m.cm, vmiCacheTimeAttribute);
+	h() = mask;
+	hs() = sourceInfo.size();
+	ht() = sourceInfo.lastModified().toMSecsSinceEpoch();
+	int result;
+	{
+		QMutexLocker locker(&vmiMutex);
+		result = tri::io::ExporterVMI<CMeshO>::Save(m.cm, QFile::encodeName(tmpName).constData());
+	}
+	tri::Allocator<CMeshO>::DeletePerMeshAttribute(m.cm, h);
+	tri::Allocator<CMeshO>::DeletePerMeshAttribute(m.cm, hs);
+	tri::Allocator<CMeshO>::DeletePerMeshAttribute(m.cm, ht);
+
+	QFile::remove(cacheName);
+	if (result != 0 || !QFile::rename(tmpName, cacheName))
+		QFile::remove(tmpName);
+}
+
+} // namespace
+
 BaseMeshIOPlugin::BaseMeshIOPlugin() : IOPlugin()
 {
 }
@@ -183,9 +309,26 @@ RichParameterList BaseMeshIOPlugin::initPreOpenParameter(const QString &formatNa
 			"composed by independent vertices, so, usually, duplicated vertices "
 			"should be unified"));
 	}
+	if (formatName.toUpper() == tr("PLY") || formatName.toUpper() == tr("OBJ") ||
+			formatName.toUpper() == tr("OFF")) {
+		parlst.addParam(RichBool(
+			"vmi_cache", false, "Use a binary cache",
+			"Keep a VMI image of the mesh next to the file (as <filename>.vmi) "
+			"and, when it is newer than the file, map it in memory instead of "
+			"parsing the file again. Textured meshes are not cached."));
+	}
 	return parlst;
 }
 
+// PLY, STL and OFF importers are reentrant and do not depend on the current
+// directory; OBJ looks for its material library relative to it and VMI keeps
+// its read state in static variables.
+bool BaseMeshIOPlugin::supportsConcurrentOpen(const QString& formatName) const
+{
+	return formatName.toUpper() == tr("PLY") || formatName.toUpper() == tr("STL") ||
+			formatName.toUpper() == tr("OFF");
+}
+
 void BaseMeshIOPlugin::open(const QString &formatName, const QString &fileName, MeshModel &m, int& mask, const RichParameterList &parlst, CallBackPos *cb)
 {
 	//bool normalsUpdated = false;
@@ -202,6 +345,12 @@ void BaseMeshIOPlugin::open(const QString &formatName, const QString &fileName,
 		(*cb)(0, "Loading...");
 
 	
+	bool useVMICache = parlst.hasParameter("vmi_cache") && parlst.getBool("vmi_cache");
+	if (useVMICache && openVMICache(fileName, m, mask)) {
+		if (cb != NULL)	(*cb)(99, "Done");
+		return;
+	}
+
 	//string filename = fileName.toUtf8().data();
 	string filename = QFile::encodeName(fileName).constData();
 
@@ -318,16 +467,10 @@ void BaseMeshIOPlugin::open(const QString &formatName, const QString &fileName,
 	}
 	else if (formatName.toUpper() == tr("VMI"))
 	{
-		int loadMask;
-		if (!tri::io::ImporterVMI<CMeshO>::LoadMask(filename.c_str(), loadMask)) {
-			throw MLException("Error while loading VMI mask.");
-		}
-		m.enable(loadMask);
-
-		int result = tri::io::ImporterVMI<CMeshO>::Open(m.cm, filename.c_str(), mask, cb);
+		int result = openVMI(fileName, m, mask, cb);
 		if (result != 0)
 		{
-			throw MLException(errorMsgFormat.arg(fileName, tri::io::ImporterOFF<CMeshO>::ErrorMsg(result)));
+			throw MLException(errorMsgFormat.arg(fileName, tri::io::ImporterVMI<CMeshO>::ErrorMsg(result)));
 		}
 	}
 	else if (formatName.toUpper() == tr("GTS"))
@@ -369,6 +512,9 @@ void BaseMeshIOPlugin::open(const QString &formatName, const QString &fileName,
 	{
 		std::replace(i->begin(), i->end(), '\\', '/');
 	}
+
+	if (useVMICache)
+		saveVMICache(fileName, m, mask);
 //	// verify if texture files are present
 //	QString missingTextureFilesMsg = "The following texture files were not found:\n";
 //	bool someTextureNotFound = false;
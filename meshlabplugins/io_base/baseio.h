@@ -58,6 +58,8 @@ public:
 			const RichParameterList& par,
 			vcg::CallBackPos* cb);
 
+	bool supportsConcurrentOpen(const QString& format) const;
+
 	void save(
 			const QString &formatName,
 			const QString &fileName,
@@ -28,3 +28,5 @@ SOURCES += \
 INCLUDEPATH += $$MESHLAB_EXTERNAL_DIRECTORY/easyexif
 
 TARGET = io_base
+
+linux:QMAKE_LFLAGS += -fopenmp -lgomp
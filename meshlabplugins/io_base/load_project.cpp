@@ -25,19 +25,23 @@ std::vector<MeshModel*> loadALN(
 	QString curr_path = QDir::currentPath();
 	QDir::setCurrent(fi.absolutePath());
 
-	for(const RangeMap& rm : rmv) {
-		QString relativeToProj = fi.absoluteDir().absolutePath() + "/" + rm.filename.c_str();
-		try {
-			std::list<MeshModel*> tmp =
-					meshlab::loadMeshWithStandardParameters(relativeToProj, md, cb);
-			md.mm()->cm.Tr.Import(rm.transformation);
-			meshList.insert(meshList.end(), tmp.begin(), tmp.end());
-		}
-		catch (const MLException& e){
-			for (MeshModel* m : meshList)
-				md.delMesh(m);
-			throw e;
-		}
+	QStringList filenames;
+	for(const RangeMap& rm : rmv)
+		filenames.push_back(fi.absoluteDir().absolutePath() + "/" + rm.filename.c_str());
+
+	std::vector<std::list<MeshModel*>> loaded;
+	try {
+		loaded = meshlab::loadMeshesWithStandardParameters(filenames, md, cb);
+	}
+	catch (const MLException& e){
+		QDir::setCurrent(curr_path);
+		throw e;
+	}
+
+	for(size_t i = 0; i < rmv.size(); ++i) {
+		if (!loaded[i].empty())
+			loaded[i].back()->cm.Tr.Import(rmv[i].transformation);
+		meshList.insert(meshList.end(), loaded[i].begin(), loaded[i].end());
 	}
 	QDir::setCurrent(curr_path);
 	return meshList;
@@ -48,7 +52,7 @@ std::vector<MeshModel*> loadOUT(
 		const QString& imageListFile,
 		MeshDocument& md,
 		std::vector<std::string>& unloadedImgList,
-		vcg::CallBackPos*)
+		vcg::CallBackPos* cb)
 {
 	std::vector<MeshModel*> meshList;
 	unloadedImgList.clear();
@@ -77,20 +81,17 @@ std::vector<MeshModel*> loadOUT(
 	}
 
 
+	QStringList shot_image_filenames;
+	for(size_t i=0 ; i<shots.size() ; i++)
+		shot_image_filenames.push_back(image_filenames_q[int(i)]);
+	std::vector<QImage> images = meshlab::loadImages(shot_image_filenames, unloadedImgList, cb);
+
 	for(size_t i=0 ; i<shots.size() ; i++)
 	{
 		md.addNewRaster();
 		const QString fullpath_image_filename = image_filenames_q[int(i)];
 
-		QImage img(":/img/dummy.png");
-		try {
-			img = meshlab::loadImage(fullpath_image_filename);
-		}
-		catch(const MLException& e){
-			unloadedImgList.push_back(fullpath_image_filename.toStdString());
-		}
-
-		md.rm()->addPlane(new RasterPlane(img, fullpath_image_filename, RasterPlane::RGBA));
+		md.rm()->addPlane(new RasterPlane(images[i], fullpath_image_filename, RasterPlane::RGBA));
 		int count=fullpath_image_filename.count('\\');
 		if (count==0)
 		{
@@ -112,7 +113,7 @@ std::vector<MeshModel*> loadNVM(
 		const QString& filename,
 		MeshDocument& md,
 		std::vector<std::string>& unloadedImgList,
-		vcg::CallBackPos*)
+		vcg::CallBackPos* cb)
 {
 	std::vector<MeshModel*> meshList;
 	unloadedImgList.clear();
@@ -133,18 +134,16 @@ std::vector<MeshModel*> loadNVM(
 	for(size_t i  = 0; i < image_filenames.size(); ++i)
 		image_filenames_q.push_back(QString::fromStdString(image_filenames[int(i)]));
 
+	QStringList shot_image_filenames;
+	for(size_t i=0 ; i<shots.size() ; i++)
+		shot_image_filenames.push_back(image_filenames_q[int(i)]);
+	std::vector<QImage> images = meshlab::loadImages(shot_image_filenames, unloadedImgList, cb);
+
 	for(size_t i=0 ; i<shots.size() ; i++){
 		md.addNewRaster();
 		const QString fullpath_image_filename = image_filenames_q[int(i)];
-		QImage img(":/img/dummy.png");
-		try {
-			img = meshlab::loadImage(fullpath_image_filename);
-		}
-		catch(const MLException& e){
-			unloadedImgList.push_back(fullpath_image_filename.toStdString());
-		}
 
-		md.rm()->addPlane(new RasterPlane(fullpath_image_filename,RasterPlane::RGBA));
+		md.rm()->addPlane(new RasterPlane(images[i], fullpath_image_filename, RasterPlane::RGBA));
 		md.rm()->setLabel(image_filenames_q[int(i)].section('/',1,2));
 		md.rm()->shot = shots[int(i)];
 	}
@@ -160,7 +159,7 @@ std::vector<MeshModel*> loadMLP(
 		MeshDocument& md,
 		std::vector<MLRenderingData>& rendOpt,
 		std::vector<std::string>& unloadedImgList,
-		vcg::CallBackPos*)
+		vcg::CallBackPos* cb)
 {
 	std::vector<MeshModel*> meshList;
 	unloadedImgList.clear();
@@ -185,6 +184,22 @@ std::vector<MeshModel*> loadMLP(
 
 	QDir tmpDir = QDir::current();
 	QDir::setCurrent(qfInfo.absoluteDir().absolutePath());
+
+	// meshes and raster planes are collected while parsing the project and
+	// then loaded all together
+	struct MeshEntry {
+		int file; // index in meshFiles of the file containing the layer
+		int idInFile;
+		QString label;
+		bool visible;
+		bool hasMatrix;
+		Matrix44m tr;
+	};
+	std::vector<MeshEntry> meshEntries;
+	QStringList meshFiles;
+	std::vector<RasterModel*> planeRasters;
+	QStringList planeFiles;
+
 	//Devices
 	while (!node.isNull()) {
 		if (QString::compare(node.nodeName(), "MeshGroup") == 0) {
@@ -209,26 +224,21 @@ std::vector<MeshModel*> loadMLP(
 				if (idInFile <= 0){
 					//load the file just if it is the first layer contained
 					//in the file (or it is the only one)
-					try {
-						auto tmp = meshlab::loadMeshWithStandardParameters(filen, md);
-						for (auto m : tmp){
-							m->setVisible(visible);
-							m->setLabel(label);
-						}
-						meshList.insert(meshList.end(), tmp.begin(), tmp.end());
-					}
-					catch(const MLException& e) {
-						for (MeshModel* mm : meshList)
-							md.delMesh(mm);
-						throw MLException(filen + " mesh file not found.");
-					}
+					meshFiles.push_back(filen);
 				}
+				MeshEntry entry;
+				entry.file = meshFiles.size() - 1;
+				entry.idInFile = idInFile;
+				entry.label = label;
+				entry.visible = visible;
+				entry.hasMatrix = false;
+				entry.tr.SetIdentity();
 
 				QDomNode tr = mesh.firstChildElement("MLMatrix44");
 
 				if (!tr.isNull()) {
-					vcg::Matrix44f trm;
 					if (tr.childNodes().size() == 1) {
+						entry.hasMatrix = true;
 						if (!binary) {
 							QStringList rows = tr.firstChild().nodeValue().split("\n", QString::SkipEmptyParts);
 							int i = 0;
@@ -238,7 +248,7 @@ std::vector<MeshModel*> loadMLP(
 									int j = 0;
 									for (const QString& value : qAsConst(values)) {
 										if (i < 4 && j < 4) {
-											md.mm()->cm.Tr[i][j] = value.toFloat();
+											entry.tr[i][j] = value.toFloat();
 											j++;
 										}
 									}
@@ -249,7 +259,7 @@ std::vector<MeshModel*> loadMLP(
 						else {
 							QString str = tr.firstChild().nodeValue();
 							QByteArray value = QByteArray::fromBase64(str.toLocal8Bit());
-							memcpy(md.mm()->cm.Tr.V(), value.data(), sizeof(Matrix44m::ScalarType) * 16);
+							memcpy(entry.tr.V(), value.data(), sizeof(Matrix44m::ScalarType) * 16);
 						}
 					}
 				}
@@ -289,6 +299,7 @@ std::vector<MeshModel*> loadMLP(
 						rendOpt.push_back(data);
 				}
 
+				meshEntries.push_back(entry);
 				mesh = mesh.nextSibling();
 			}
 		}
@@ -312,14 +323,8 @@ std::vector<MeshModel*> loadMLP(
 					QString filen = el.attribute("fileName");
 					QFileInfo fi(filen);
 					QString nm = fi.absoluteFilePath();
-					QImage img(":/img/dummy.png");
-					try {
-						img = meshlab::loadImage(nm);
-					}
-					catch(const MLException& e){
-						unloadedImgList.push_back(nm.toStdString());
-					}
-					md.rm()->addPlane(new RasterPlane(img, nm, RasterPlane::RGBA));
+					planeRasters.push_back(md.rm());
+					planeFiles.push_back(nm);
 					el = node.nextSiblingElement("Plane");
 				}
 				raster = raster.nextSibling();
@@ -328,6 +333,38 @@ std::vector<MeshModel*> loadMLP(
 		node = node.nextSibling();
 	}
 
+	std::vector<std::list<MeshModel*>> loaded;
+	try {
+		loaded = meshlab::loadMeshesWithStandardParameters(meshFiles, md, cb);
+	}
+	catch(const MLException& e) {
+		QDir::setCurrent(tmpDir.absolutePath());
+		throw e;
+	}
+	for (const std::list<MeshModel*>& fileMeshes : loaded)
+		meshList.insert(meshList.end(), fileMeshes.begin(), fileMeshes.end());
+
+	for (const MeshEntry& entry : meshEntries) {
+		if (entry.file < 0)
+			continue;
+		const std::list<MeshModel*>& fileMeshes = loaded[entry.file];
+		if (entry.idInFile <= 0) {
+			for (MeshModel* m : fileMeshes) {
+				m->setVisible(entry.visible);
+				m->setLabel(entry.label);
+			}
+		}
+		if (entry.hasMatrix) {
+			auto it = fileMeshes.begin();
+			std::advance(it, std::min<int>(std::max(entry.idInFile, 0), int(fileMeshes.size()) - 1));
+			(*it)->cm.Tr = entry.tr;
+		}
+	}
+
+	std::vector<QImage> planeImages = meshlab::loadImages(planeFiles, unloadedImgList, cb);
+	for (size_t i = 0; i < planeRasters.size(); ++i)
+		planeRasters[i]->addPlane(new RasterPlane(planeImages[i], planeFiles[int(i)], RasterPlane::RGBA));
+
 	QDir::setCurrent(tmpDir.absolutePath());
 	qf.close();
 
@@ -0,0 +1,764 @@
+/****************************************************************************
+* VCGLib                                                            o o     *
+* Visual and Computer Graphics Library                            o     o   *
+*                                                                _   O  _   *
+* Copyright(C) 2004-2016                                           \/)\/    *
+* Visual Computing Lab                                            /\/|      *
+* ISTI - Italian National Research Council                           |      *
+*                                                                    \      *
+* All rights reserved.                                                      *
+*                                                                           *
+* This program is free software; you can redistribute it and/or modify      *
+* it under the terms of the GNU General Public License as published by      *
+* the Free Software Foundation; either version 2 of the License, or         *
+* (at your option) any later version.                                       *
+*                                                                           *
+* This program is distributed in the hope that it will be useful,           *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)          *
+* for more details.                                                         *
+*                                                                           *
+****************************************************************************/
+/*! \file benchmark.cpp
+
+\brief Timing of the most used vcglib algorithms on procedurally generated meshes.
+
+Every benchmark copies (or builds) its input outside of the timed section, runs the
+algorithm a few times and reports the minimum and the median time. Inputs are bumpy tori
+whose size only depends on the chosen scale and random generators are always seeded,
+so two runs of the same build do the same work and can be compared.
+Results can be saved as CSV and compared against a previously saved baseline.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <vcg/complex/complex.h>
+#include <vcg/complex/algorithms/clean.h>
+#include <vcg/complex/algorithms/closest.h>
+#include <vcg/complex/algorithms/clustering.h>
+#include <vcg/complex/algorithms/create/platonic.h>
+#include <vcg/complex/algorithms/create/marching_cubes.h>
+#include <vcg/complex/algorithms/create/mc_trivial_walker.h>
+#include <vcg/complex/algorithms/local_optimization.h>
+#include <vcg/complex/algorithms/local_optimization/tri_edge_collapse_quadric.h>
+#include <vcg/complex/algorithms/point_sampling.h>
+#include <vcg/complex/algorithms/smooth.h>
+#include <vcg/complex/algorithms/update/bounding.h>
+#include <vcg/complex/algorithms/update/flag.h>
+#include <vcg/complex/algorithms/update/normal.h>
+#include <vcg/complex/algorithms/update/topology.h>
+#include <vcg/space/index/grid_static_ptr.h>
+#include <vcg/space/index/kdtree/kdtree.h>
+
+#include <wrap/io_trimesh/import_obj.h>
+#include <wrap/io_trimesh/import_ply.h>
+#include <wrap/io_trimesh/import_stl.h>
+#include <wrap/io_trimesh/export_obj.h>
+#include <wrap/io_trimesh/export_ply.h>
+#include <wrap/io_trimesh/export_stl.h>
+#include <wrap/system/parallel.h>
+
+using namespace vcg;
+
+class BenchVertex;
+class BenchFace;
+struct BenchUsedTypes : public UsedTypes<	Use<BenchVertex>::AsVertexType,
+                                            Use<BenchFace>::AsFaceType>{};
+
+class BenchVertex : public Vertex<BenchUsedTypes, vertex::Coord3f, vertex::Normal3f, vertex::VFAdj,
+                                  vertex::Mark, vertex::Qualityf, vertex::Color4b, vertex::BitFlags>
+{
+public:
+  math::Quadric<double> &Qd() {return q;}
+private:
+  math::Quadric<double> q;
+};
+
+class BenchFace : public Face<BenchUsedTypes, face::VertexRef, face::Normal3f, face::FFAdj, face::VFAdj,
+                              face::Mark, face::BitFlags> {};
+
+class BenchMesh : public tri::TriMesh<std::vector<BenchVertex>, std::vector<BenchFace> > {};
+
+typedef BasicVertexPair<BenchVertex> BenchVertexPair;
+
+class BenchTriEdgeCollapse : public tri::TriEdgeCollapseQuadric<BenchMesh, BenchVertexPair, BenchTriEdgeCollapse, tri::QInfoStandard<BenchVertex> >
+{
+public:
+  typedef tri::TriEdgeCollapseQuadric<BenchMesh, BenchVertexPair, BenchTriEdgeCollapse, tri::QInfoStandard<BenchVertex> > TECQ;
+  inline BenchTriEdgeCollapse(const BenchVertexPair &p, int i, BaseParameterClass *pp) : TECQ(p, i, pp) {}
+};
+
+typedef SimpleVolume<SimpleVoxel<float> > BenchVolume;
+typedef tri::TrivialWalker<BenchMesh, BenchVolume> BenchWalker;
+typedef tri::MarchingCubes<BenchMesh, BenchWalker> BenchMarchingCubes;
+
+typedef tri::SurfaceSampling<BenchMesh, tri::TrivialSampler<BenchMesh> > PointSampling;
+typedef tri::SurfaceSampling<BenchMesh, tri::MeshSampler<BenchMesh> > MeshSampling;
+typedef tri::SurfaceSampling<BenchMesh, tri::HausdorffSampler<BenchMesh> > HausdorffSampling;
+
+static const unsigned int RandomSeed = 1234;
+
+// Input sizes: faces of the input tori and side of the marching cubes volume.
+struct BenchScale
+{
+  const char *name;
+  int faceNum;
+  int volumeSize;
+};
+
+static const BenchScale Scales[] = {
+  { "small",    32768,  64 },
+  { "medium",  524288, 160 },
+  { "large",  2097152, 256 }
+};
+
+struct BenchInput
+{
+  const BenchScale *scale;
+  BenchMesh mesh;     // bumpy torus with per vertex normals and bbox
+  BenchMesh other;    // the same torus with shifted bumps, for distance and query benchmarks
+  std::string tmpDir;
+
+  std::string TmpFile(const char *ext) const { return tmpDir + "/vcg_benchmark_tmp." + ext; }
+};
+
+class Stopwatch
+{
+public:
+  Stopwatch() : start(std::chrono::steady_clock::now()) {}
+  double Ms() const { return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count(); }
+private:
+  std::chrono::steady_clock::time_point start;
+};
+
+/// Torus of about faceNum triangles displaced along the tube normal by a regular
+/// pattern of bumps, so that decimation and smoothing have something to work on.
+static void BuildBumpyTorus(BenchMesh &m, int faceNum, float phase)
+{
+  const int vDiv = std::max(8, int(sqrt(faceNum / 8.0)));
+  tri::Torus(m, 1.0f, 0.3f, 4 * vDiv, vDiv);
+  for (size_t i = 0; i < m.vert.size(); ++i)
+  {
+    Point3f &p = m.vert[i].P();
+    const float u = atan2(p[1], p[0]);
+    const Point3f axis(cos(u), sin(u), 0);
+    Point3f n = p - axis;
+    const float v = atan2(p[2], n * axis);
+    n.Normalize();
+    p += n * (0.03f * sin(12 * u + phase) * sin(8 * v));
+  }
+  tri::UpdateBounding<BenchMesh>::Box(m);
+  tri::UpdateNormal<BenchMesh>::PerVertexNormalizedPerFaceNormalized(m);
+}
+
+static void CopyInput(BenchMesh &m, const BenchMesh &src)
+{
+  tri::Append<BenchMesh, BenchMesh>::MeshCopyConst(m, src);
+  m.bbox = src.bbox;
+}
+
+static long long FileSize(const std::string &fileName)
+{
+  FILE *fp = fopen(fileName.c_str(), "rb");
+  if (!fp) return -1;
+  fseek(fp, 0, SEEK_END);
+  long long size = ftell(fp);
+  fclose(fp);
+  return size;
+}
+
+static void Decimate(BenchMesh &m, int targetFaceNum)
+{
+  tri::TriEdgeCollapseQuadricParameter qparams;
+  qparams.QualityThr = .3;
+  tri::UpdateBounding<BenchMesh>::Box(m);
+  LocalOptimization<BenchMesh> deciSession(m, &qparams);
+  deciSession.Init<BenchTriEdgeCollapse>();
+  deciSession.SetTargetSimplices(targetFaceNum);
+  while (deciSession.DoOptimization() && m.fn > targetFaceNum)
+    ;
+}
+
+// Each benchmark returns the time in ms of its timed section and sets result to a
+// size of its output (faces, samples, bytes...), used to check that two runs did the same work.
+typedef double (*BenchFunc)(const BenchInput &in, long long &result);
+
+/********************************* Import / export *********************************/
+
+static double PlyExport(const BenchInput &in, long long &result, bool binary)
+{
+  const std::string fileName = in.TmpFile(binary ? "bin.ply" : "ascii.ply");
+  Stopwatch t;
+  tri::io::ExporterPLY<BenchMesh>::Save(in.mesh, fileName.c_str(), tri::io::Mask::IOM_VERTNORMAL, binary);
+  const double ms = t.Ms();
+  result = FileSize(fileName);
+  remove(fileName.c_str());
+  return ms;
+}
+
+static double PlyImport(const BenchInput &in, long long &result, bool binary)
+{
+  const std::string fileName = in.TmpFile(binary ? "bin.ply" : "ascii.ply");
+  tri::io::ExporterPLY<BenchMesh>::Save(in.mesh, fileName.c_str(), tri::io::Mask::IOM_VERTNORMAL, binary);
+  BenchMesh m;
+  Stopwatch t;
+  tri::io::ImporterPLY<BenchMesh>::Open(m, fileName.c_str());
+  const double ms = t.Ms();
+  result = m.FN();
+  remove(fileName.c_str());
+  return ms;
+}
+
+static double PlyBinExport(const BenchInput &in, long long &result)   { return PlyExport(in, result, true); }
+static double PlyBinImport(const BenchInput &in, long long &result)   { return PlyImport(in, result, true); }
+static double PlyAsciiExport(const BenchInput &in, long long &result) { return PlyExport(in, result, false); }
+static double PlyAsciiImport(const BenchInput &in, long long &result) { return PlyImport(in, result, false); }
+
+static double ObjExport(const BenchInput &in, long long &result)
+{
+  const std::string fileName = in.TmpFile("obj");
+  BenchMesh m;
+  CopyInput(m, in.mesh);
+  Stopwatch t;
+  tri::io::ExporterOBJ<BenchMesh>::Save(m, fileName.c_str(), tri::io::Mask::IOM_VERTNORMAL);
+  const double ms = t.Ms();
+  result = FileSize(fileName);
+  remove(fileName.c_str());
+  return ms;
+}
+
+static double ObjImport(const BenchInput &in, long long &result)
+{
+  const std::string fileName = in.TmpFile("obj");
+  BenchMesh m;
+  CopyInput(m, in.mesh);
+  tri::io::ExporterOBJ<BenchMesh>::Save(m, fileName.c_str(), tri::io::Mask::IOM_VERTNORMAL);
+  m.Clear();
+  int loadMask = 0;
+  Stopwatch t;
+  tri::io::ImporterOBJ<BenchMesh>::Open(m, fileName.c_str(), loadMask);
+  const double ms = t.Ms();
+  result = m.FN();
+  remove(fileName.c_str());
+  remove((fileName + ".mtl").c_str());
+  return ms;
+}
+
+static double StlExport(const BenchInput &in, long long &result)
+{
+  const std::string fileName = in.TmpFile("stl");
+  Stopwatch t;
+  tri::io::ExporterSTL<BenchMesh>::Save(in.mesh, fileName.c_str(), true);
+  const double ms = t.Ms();
+  result = FileSize(fileName);
+  remove(fileName.c_str());
+  return ms;
+}
+
+static double StlImport(const BenchInput &in, long long &result)
+{
+  const std::string fileName = in.TmpFile("stl");
+  tri::io::ExporterSTL<BenchMesh>::Save(in.mesh, fileName.c_str(), true);
+  BenchMesh m;
+  int loadMask = 0;
+  Stopwatch t;
+  tri::io::ImporterSTL<BenchMesh>::Open(m, fileName.c_str(), loadMask);
+  const double ms = t.Ms();
+  result = m.FN();
+  remove(fileName.c_str());
+  return ms;
+}
+
+/********************************* Topology and normals *********************************/
+
+static double TopologyFF(const BenchInput &in, long long &result)
+{
+  BenchMesh m;
+  CopyInput(m, in.mesh);
+  Stopwatch t;
+  tri::UpdateTopology<BenchMesh>::FaceFace(m);
+  const double ms = t.Ms();
+  result = tri::Clean<BenchMesh>::CountNonManifoldEdgeFF(m);
+  return ms;
+}
+
+static double TopologyVF(const BenchInput &in, long long &result)
+{
+  BenchMesh m;
+  CopyInput(m, in.mesh);
+  Stopwatch t;
+  tri::UpdateTopology<BenchMesh>::VertexFace(m);
+  const double ms = t.Ms();
+  result = m.FN();
+  return ms;
+}
+
+static double Normals(const BenchInput &in, long long &result)
+{
+  BenchMesh m;
+  CopyInput(m, in.mesh);
+  Stopwatch t;
+  tri::UpdateNormal<BenchMesh>::PerVertexNormalizedPerFaceNormalized(m);
+  const double ms = t.Ms();
+  result = m.VN();
+  return ms;
+}
+
+/********************************* Simplification *********************************/
+
+static double QuadricDecimation(const BenchInput &in, long long &result)
+{
+  BenchMesh m;
+  CopyInput(m, in.mesh);
+  Stopwatch t;
+  Decimate(m, m.FN() / 10);
+  const double ms = t.Ms();
+  result = m.FN();
+  return ms;
+}
+
+static double VertexClustering(const BenchInput &in, long long &result)
+{
+  BenchMesh m, out;
+  CopyInput(m, in.mesh);
+  tri::UpdateNormal<BenchMesh>::PerFace(m);
+  Stopwatch t;
+  tri::Clustering<BenchMesh, tri::AverageColorCell<BenchMesh> > grid;
+  grid.Init(m.bbox, m.FN() / 4);
+  grid.AddMesh(m);
+  grid.ExtractMesh(out);
+  const double ms = t.Ms();
+  result = out.FN();
+  return ms;
+}
+
+/********************************* Sampling and distance *********************************/
+
+static double MontecarloSampling(const BenchInput &in, long long &result)
+{
+  BenchMesh m;
+  CopyInput(m, in.mesh);
+  std::vector<Point3f> samples;
+  tri::TrivialSampler<BenchMesh> ps(samples);
+  PointSampling::SamplingRandomGenerator().initialize(RandomSeed);
+  Stopwatch t;
+  PointSampling::Montecarlo(m, ps, m.FN());
+  const double ms = t.Ms();
+  result = samples.size();
+  return ms;
+}
+
+static double PoissonDiskSampling(const BenchInput &in, long long &result)
+{
+  BenchMesh m, montecarloMesh, poissonMesh;
+  CopyInput(m, in.mesh);
+  const int sampleNum = m.FN() / 16;
+  MeshSampling::SamplingRandomGenerator().initialize(RandomSeed);
+  Stopwatch t;
+  const float radius = MeshSampling::ComputePoissonDiskRadius(m, sampleNum);
+  tri::MeshSampler<BenchMesh> mcSampler(montecarloMesh);
+  MeshSampling::Montecarlo(m, mcSampler, sampleNum * 20);
+  tri::UpdateBounding<BenchMesh>::Box(montecarloMesh);
+  tri::MeshSampler<BenchMesh> pdSampler(poissonMesh);
+  MeshSampling::PoissonDiskParam pp;
+  pp.randomSeed = RandomSeed;
+  MeshSampling::PoissonDiskPruning(pdSampler, montecarloMesh, radius, pp);
+  const double ms = t.Ms();
+  result = poissonMesh.VN();
+  return ms;
+}
+
+static double Hausdorff(const BenchInput &in, long long &result)
+{
+  BenchMesh a, b;
+  CopyInput(a, in.mesh);
+  CopyInput(b, in.other);
+  HausdorffSampling::SamplingRandomGenerator().initialize(RandomSeed);
+  Stopwatch t;
+  tri::HausdorffSampler<BenchMesh> hs(&b);
+  hs.dist_upper_bound = b.bbox.Diag() / 10;
+  HausdorffSampling::Montecarlo(a, hs, a.FN());
+  const double ms = t.Ms();
+  result = hs.n_total_samples;
+  return ms;
+}
+
+/********************************* Spatial indexing *********************************/
+
+static double KdTreeBuild(const BenchInput &in, long long &result)
+{
+  BenchMesh m;
+  CopyInput(m, in.mesh);
+  VertexConstDataWrapper<BenchMesh> ww(m);
+  Stopwatch t;
+  KdTree<float> tree(ww);
+  const double ms = t.Ms();
+  result = m.VN();
+  return ms;
+}
+
+static double KdTreeQuery(const BenchInput &in, long long &result)
+{
+  BenchMesh m;
+  CopyInput(m, in.mesh);
+  VertexConstDataWrapper<BenchMesh> ww(m);
+  KdTree<float> tree(ww);
+  KdTree<float>::PriorityQueue queue;
+  result = 0;
+  Stopwatch t;
+  for (size_t i = 0; i < in.other.vert.size(); ++i)
+  {
+    tree.doQueryK(in.other.vert[i].cP(), 8, queue);
+    result += queue.getNofElements();
+  }
+  return t.Ms();
+}
+
+static double GridBuild(const BenchInput &in, long long &result)
+{
+  BenchMesh m;
+  CopyInput(m, in.mesh);
+  Stopwatch t;
+  GridStaticPtr<BenchFace, float> grid;
+  grid.Set(m.face.begin(), m.face.end());
+  const double ms = t.Ms();
+  result = m.FN();
+  return ms;
+}
+
+static double GridClosest(const BenchInput &in, long long &result)
+{
+  BenchMesh m;
+  CopyInput(m, in.mesh);
+  GridStaticPtr<BenchFace, float> grid;
+  grid.Set(m.face.begin(), m.face.end());
+  const float maxDist = m.bbox.Diag() / 10;
+  result = 0;
+  Stopwatch t;
+  for (size_t i = 0; i < in.other.vert.size(); ++i)
+  {
+    float minDist;
+    Point3f closest;
+    if (tri::GetClosestFaceBase(m, grid, in.other.vert[i].cP(), maxDist, minDist, closest))
+      ++result;
+  }
+  return t.Ms();
+}
+
+/********************************* Reconstruction and smoothing *********************************/
+
+static double MarchingCubesExtraction(const BenchInput &in, long long &result)
+{
+  const int n = in.scale->volumeSize;
+  BenchVolume volume;
+  volume.Init(Point3i(n, n, n), Box3f(Point3f(-1.5, -1.5, -1.5), Point3f(1.5, 1.5, 1.5)));
+  for (int i = 0; i < n; ++i)
+    for (int j = 0; j < n; ++j)
+      for (int k = 0; k < n; ++k)
+      {
+        Point3f p;
+        volume.IPiToPf(Point3i(i, j, k), p);
+        const float r = sqrt(p[0] * p[0] + p[1] * p[1]) - 1.0f;
+        volume.Val(i, j, k) = sqrt(r * r + p[2] * p[2]) - 0.3f - 0.03f * sin(12 * atan2(p[1], p[0]));
+      }
+  BenchMesh m;
+  BenchWalker walker;
+  BenchMarchingCubes mc(m, walker);
+  Stopwatch t;
+  walker.BuildMesh<BenchMarchingCubes>(m, volume, mc, 0);
+  const double ms = t.Ms();
+  result = m.FN();
+  return ms;
+}
+
+static double LaplacianSmooth(const BenchInput &in, long long &result)
+{
+  BenchMesh m;
+  CopyInput(m, in.mesh);
+  tri::UpdateFlags<BenchMesh>::FaceBorderFromNone(m);
+  Stopwatch t;
+  tri::Smooth<BenchMesh>::VertexCoordLaplacian(m, 3);
+  const double ms = t.Ms();
+  result = m.VN();
+  return ms;
+}
+
+static double TaubinSmooth(const BenchInput &in, long long &result)
+{
+  BenchMesh m;
+  CopyInput(m, in.mesh);
+  tri::UpdateFlags<BenchMesh>::FaceBorderFromNone(m);
+  Stopwatch t;
+  tri::Smooth<BenchMesh>::VertexCoordTaubin(m, 10, 0.5f, -0.53f);
+  const double ms = t.Ms();
+  result = m.VN();
+  return ms;
+}
+
+/// The sequence of library calls made by a typical cleanup and simplification
+/// filter script: merge close vertices, remove unreferenced ones, rebuild the topology,
+/// Taubin smoothing, quadric simplification to half the faces, normals and binary PLY.
+static double CleanupScript(const BenchInput &in, long long &result)
+{
+  const std::string fileName = in.TmpFile("script.ply");
+  BenchMesh m;
+  CopyInput(m, in.mesh);
+  Stopwatch t;
+  tri::Clean<BenchMesh>::MergeCloseVertex(m, m.bbox.Diag() * 1e-6f);
+  tri::Clean<BenchMesh>::RemoveUnreferencedVertex(m);
+  tri::Allocator<BenchMesh>::CompactEveryVector(m);
+  tri::UpdateTopology<BenchMesh>::FaceFace(m);
+  tri::UpdateFlags<BenchMesh>::FaceBorderFromFF(m);
+  tri::Smooth<BenchMesh>::VertexCoordTaubin(m, 5, 0.5f, -0.53f);
+  Decimate(m, m.FN() / 2);
+  tri::Allocator<BenchMesh>::CompactEveryVector(m);
+  tri::UpdateNormal<BenchMesh>::PerVertexNormalizedPerFaceNormalized(m);
+  tri::io::ExporterPLY<BenchMesh>::Save(m, fileName.c_str(), tri::io::Mask::IOM_VERTNORMAL, true);
+  const double ms = t.Ms();
+  result = m.FN();
+  remove(fileName.c_str());
+  return ms;
+}
+
+struct Benchmark
+{
+  const char *name;
+  BenchFunc func;
+};
+
+static const Benchmark Benchmarks[] = {
+  { "io_ply_bin_export",     PlyBinExport },
+  { "io_ply_bin_import",     PlyBinImport },
+  { "io_ply_ascii_export",   PlyAsciiExport },
+  { "io_ply_ascii_import",   PlyAsciiImport },
+  { "io_obj_export",         ObjExport },
+  { "io_obj_import",         ObjImport },
+  { "io_stl_export",         StlExport },
+  { "io_stl_import",         StlImport },
+  { "topology_ff",           TopologyFF },
+  { "topology_vf",           TopologyVF },
+  { "normals_per_vertex",    Normals },
+  { "decimation_quadric",    QuadricDecimation },
+  { "clustering",            VertexClustering },
+  { "sampling_montecarlo",   MontecarloSampling },
+  { "sampling_poisson_disk", PoissonDiskSampling },
+  { "distance_hausdorff",    Hausdorff },
+  { "kdtree_build",          KdTreeBuild },
+  { "kdtree_knn_query",      KdTreeQuery },
+  { "grid_build",            GridBuild },
+  { "grid_closest_query",    GridClosest },
+  { "marching_cubes",        MarchingCubesExtraction },
+  { "smooth_laplacian",      LaplacianSmooth },
+  { "smooth_taubin",         TaubinSmooth },
+  { "script_cleanup",        CleanupScript }
+};
+
+/********************************* Results *********************************/
+
+struct BenchResult
+{
+  std::string name;
+  std::string scale;
+  int faces;
+  int threads;
+  int reps;
+  double minMs;
+  double medianMs;
+  long long result;
+};
+
+static const char *CsvHeader = "benchmark,scale,faces,threads,reps,min_ms,median_ms,result";
+
+static bool SaveResults(const std::vector<BenchResult> &results, const char *fileName)
+{
+  FILE *fp = fopen(fileName, "w");
+  if (!fp) return false;
+  fprintf(fp, "%s\n", CsvHeader);
+  for (size_t i = 0; i < results.size(); ++i)
+  {
+    const BenchResult &r = results[i];
+    fprintf(fp, "%s,%s,%d,%d,%d,%.3f,%.3f,%lld\n", r.name.c_str(), r.scale.c_str(),
+            r.faces, r.threads, r.reps, r.minMs, r.medianMs, r.result);
+  }
+  fclose(fp);
+  return true;
+}
+
+static bool LoadResults(std::vector<BenchResult> &results, const char *fileName)
+{
+  FILE *fp = fopen(fileName, "r");
+  if (!fp) return false;
+  char line[1024];
+  while (fgets(line, sizeof(line), fp))
+  {
+    char name[256], scale[256];
+    BenchResult r;
+    if (sscanf(line, "%255[^,],%255[^,],%d,%d,%d,%lf,%lf,%lld", name, scale, &r.faces,
+               &r.threads, &r.reps, &r.minMs, &r.medianMs, &r.result) != 8)
+      continue; // header or malformed line
+    r.name = name;
+    r.scale = scale;
+    results.push_back(r);
+  }
+  fclose(fp);
+  return true;
+}
+
+/// Print the ratio of the minimum times with respect to the baseline (the minimum is less
+/// affected by the system load than the median) and return the number of benchmarks
+/// slower than the baseline by more than tolerance.
+static int CompareResults(const std::vector<BenchResult> &results, const std::vector<BenchResult> &baseline, double tolerance)
+{
+  std::map<std::string, const BenchResult *> baseMap;
+  for (size_t i = 0; i < baseline.size(); ++i)
+    baseMap[baseline[i].name + "/" + baseline[i].scale] = &baseline[i];
+
+  int slower = 0;
+  printf("\n%-22s %-7s %12s %12s %8s\n", "benchmark", "scale", "base min ms", "min ms", "ratio");
+  for (size_t i = 0; i < results.size(); ++i)
+  {
+    const BenchResult &r = results[i];
+    std::map<std::string, const BenchResult *>::const_iterator bi = baseMap.find(r.name + "/" + r.scale);
+    if (bi == baseMap.end())
+    {
+      printf("%-22s %-7s %12s %12.3f %8s\n", r.name.c_str(), r.scale.c_str(), "-", r.minMs, "new");
+      continue;
+    }
+    const BenchResult &b = *bi->second;
+    const double ratio = r.minMs / std::max(b.minMs, 1e-3);
+    const char *status = "";
+    if (b.result != r.result || b.faces != r.faces)
+      status = "different output, not comparable";
+    else if (ratio > 1.0 + tolerance) { status = "SLOWER"; ++slower; }
+    else if (ratio < 1.0 - tolerance) status = "faster";
+    printf("%-22s %-7s %12.3f %12.3f %8.3f %s%s\n", r.name.c_str(), r.scale.c_str(), b.minMs, r.minMs, ratio,
+           status, b.threads != r.threads ? " (different thread count)" : "");
+  }
+  return slower;
+}
+
+static void Usage()
+{
+  printf(
+        "---------------------------------\n"
+        "        VCG Benchmark 1.0 \n"
+        "     http://vcg.isti.cnr.it\n"
+        "   release date: " __DATE__
+        "\n---------------------------------\n\n"
+        "Usage: vcg_benchmark [opt]\n"
+        "Where opt can be:\n"
+        "     -s<list>  comma separated scales: small (%d faces), medium (%d), large (%d)\n"
+        "               (default small,medium)\n"
+        "     -r#       repetitions of each benchmark (default 5)\n"
+        "     -f<text>  run only the benchmarks whose name contains text\n"
+        "     -t#       number of threads (default OMP_NUM_THREADS or one per processor)\n"
+        "     -o<file>  save the results as CSV\n"
+        "     -c<file>  compare with a baseline saved with -o, exit code 1 if something is slower\n"
+        "     -T#       relative tolerance of the comparison (default 0.1)\n"
+        "     -d<dir>   directory for the temporary files (default .)\n"
+        "     -l        list the benchmarks\n",
+        Scales[0].faceNum, Scales[1].faceNum, Scales[2].faceNum);
+  exit(-1);
+}
+
+int main(int argc, char **argv)
+{
+  std::string scaleList = "small,medium";
+  std::string filter;
+  std::string tmpDir = ".";
+  const char *outFile = 0;
+  const char *baseFile = 0;
+  int reps = 5;
+  int threads = 0;
+  double tolerance = 0.1;
+
+  for (int i = 1; i < argc; ++i)
+  {
+    if (argv[i][0] != '-') Usage();
+    switch (argv[i][1])
+    {
+      case 's' : scaleList = argv[i] + 2; break;
+      case 'r' : reps = std::max(1, atoi(argv[i] + 2)); break;
+      case 'f' : filter = argv[i] + 2; break;
+      case 't' : threads = atoi(argv[i] + 2); break;
+      case 'o' : outFile = argv[i] + 2; break;
+      case 'c' : baseFile = argv[i] + 2; break;
+      case 'T' : tolerance = atof(argv[i] + 2); break;
+      case 'd' : tmpDir = argv[i] + 2; break;
+      case 'l' :
+        for (size_t b = 0; b < sizeof(Benchmarks) / sizeof(Benchmarks[0]); ++b)
+          printf("%s\n", Benchmarks[b].name);
+        return 0;
+      default : Usage();
+    }
+  }
+
+  std::vector<const BenchScale *> scales;
+  for (size_t s = 0; s < sizeof(Scales) / sizeof(Scales[0]); ++s)
+    if (("," + scaleList + ",").find(std::string(",") + Scales[s].name + ",") != std::string::npos)
+      scales.push_back(&Scales[s]);
+  if (scales.empty()) Usage();
+
+  std::vector<BenchResult> baseline;
+  if (baseFile && !LoadResults(baseline, baseFile))
+  {
+    printf("Unable to read baseline %s\n", baseFile);
+    return -1;
+  }
+
+  parallel::SetMaxThreads(threads);
+  threads = parallel::MaxThreads();
+#ifndef NDEBUG
+  printf("Warning: assertions are enabled, timings are not representative\n");
+#endif
+  printf("threads %d, repetitions %d\n\n", threads, reps);
+  printf("%-22s %-7s %9s %12s %12s %12s\n", "benchmark", "scale", "faces", "min ms", "median ms", "result");
+
+  std::vector<BenchResult> results;
+  for (size_t s = 0; s < scales.size(); ++s)
+  {
+    BenchInput in;
+    in.scale = scales[s];
+    in.tmpDir = tmpDir;
+    BuildBumpyTorus(in.mesh, in.scale->faceNum, 0);
+    BuildBumpyTorus(in.other, in.scale->faceNum, 1.0f);
+
+    for (size_t b = 0; b < sizeof(Benchmarks) / sizeof(Benchmarks[0]); ++b)
+    {
+      if (!filter.empty() && std::string(Benchmarks[b].name).find(filter) == std::string::npos)
+        continue;
+      BenchResult r;
+      r.name = Benchmarks[b].name;
+      r.scale = in.scale->name;
+      r.faces = in.mesh.FN();
+      r.threads = threads;
+      r.reps = reps;
+      std::vector<double> times(reps);
+      for (int k = 0; k < reps; ++k)
+        times[k] = Benchmarks[b].func(in, r.result);
+      std::sort(times.begin(), times.end());
+      r.minMs = times.front();
+      r.medianMs = times[reps / 2];
+      printf("%-22s %-7s %9d %12.3f %12.3f %12lld\n", r.name.c_str(), r.scale.c_str(), r.faces, r.minMs, r.medianMs, r.result);
+      fflush(stdout);
+      results.push_back(r);
+    }
+  }
+
+  if (outFile && !SaveResults(results, outFile))
+  {
+    printf("Unable to write %s\n", outFile);
+    return -1;
+  }
+  if (baseFile && CompareResults(results, baseline, tolerance) > 0)
+    return 1;
+  return 0;
+}
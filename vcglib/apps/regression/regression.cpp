@@ -0,0 +1,781 @@
+/****************************************************************************
+* VCGLib                                                            o o     *
+* Visual and Computer Graphics Library                            o     o   *
+*                                                                _   O  _   *
+* Copyright(C) 2004-2016                                           \/)\/    *
+* Visual Computing Lab                                            /\/|      *
+* ISTI - Italian National Research Council                           |      *
+*                                                                    \      *
+* All rights reserved.                                                      *
+*                                                                           *
+* This program is free software; you can redistribute it and/or modify      *
+* it under the terms of the GNU General Public License as published by      *
+* the Free Software Foundation; either version 2 of the License, or         *
+* (at your option) any later version.                                       *
+*                                                                           *
+* This program is distributed in the hope that it will be useful,           *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)          *
+* for more details.                                                         *
+*                                                                           *
+****************************************************************************/
+/*! \file regression.cpp
+
+\brief Checks that the parallel and optimized code paths of vcglib give the same results of the
+code they replaced.
+
+Every check runs an algorithm on a procedurally generated mesh and compares its output with:
+- the same algorithm run on a single thread, for the algorithms whose result must not depend
+  on the number of threads;
+- a serial implementation kept here, written as the library code was before it was
+  parallelized;
+- the digest of the output of the previous implementation, for the outputs that cannot be
+  rebuilt from what is left in the library (file exporters, serial ball pivoting, Voronoi
+  remeshing). Their inputs have coordinates that are exact binary fractions, so that they do
+  not depend on the math library; a different compiler or floating point model (e.g. with
+  fused multiply-add) can still change the rounding of the algorithms, -v prints the digests.
+
+The exit code is the number of failed checks, so that it can be run by ctest.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <vcg/complex/complex.h>
+#include <vcg/complex/algorithms/clean.h>
+#include <vcg/complex/algorithms/clustering.h>
+#include <vcg/complex/algorithms/create/ball_pivoting.h>
+#include <vcg/complex/algorithms/create/marching_cubes.h>
+#include <vcg/complex/algorithms/create/mc_trivial_walker.h>
+#include <vcg/complex/algorithms/create/platonic.h>
+#include <vcg/complex/algorithms/isotropic_remeshing.h>
+#include <vcg/complex/algorithms/local_optimization/tri_edge_collapse_quadric.h>
+#include <vcg/complex/algorithms/refine.h>
+#include <vcg/complex/algorithms/smooth.h>
+#include <vcg/complex/algorithms/update/bounding.h>
+#include <vcg/complex/algorithms/update/flag.h>
+#include <vcg/complex/algorithms/update/normal.h>
+#include <vcg/complex/algorithms/update/topology.h>
+#include <vcg/complex/algorithms/voronoi_remesher.h>
+
+#include <wrap/io_trimesh/export_obj.h>
+#include <wrap/io_trimesh/export_off.h>
+#include <wrap/io_trimesh/export_ply.h>
+#include <wrap/io_trimesh/import_ply.h>
+#include <wrap/system/parallel.h>
+
+using namespace vcg;
+
+class RegVertex;
+class RegEdge;
+class RegFace;
+struct RegUsedTypes : public UsedTypes<	Use<RegVertex>::AsVertexType,
+                                        Use<RegEdge>::AsEdgeType,
+                                        Use<RegFace>::AsFaceType>{};
+
+class RegVertex : public Vertex<RegUsedTypes, vertex::Coord3f, vertex::Normal3f, vertex::Color4b, vertex::Qualityf,
+                                vertex::VFAdj, vertex::VEAdj, vertex::Mark, vertex::BitFlags> {};
+class RegEdge : public Edge<RegUsedTypes, edge::VertexRef, edge::BitFlags, edge::EEAdj, edge::VEAdj> {};
+class RegFace : public Face<RegUsedTypes, face::VertexRef, face::Normal3f, face::Color4b, face::Qualityf,
+                            face::FFAdj, face::VFAdj, face::Mark, face::BitFlags> {};
+class RegMesh : public tri::TriMesh<std::vector<RegVertex>, std::vector<RegFace> > {};
+
+// Two meshes with the optional components of MeshLab CMeshO, one with the vertex references stored
+// as pointers and one as 32 bit indices (as MeshLab built with BUILD_WITH_COMPACT_FACES).
+class PtrVertex;
+class PtrFace;
+struct PtrUsedTypes : public UsedTypes<	Use<PtrVertex>::AsVertexType,
+                                        Use<PtrFace>::AsFaceType>{};
+
+class PtrVertex : public Vertex<PtrUsedTypes, vertex::InfoOcf, vertex::Coord3f, vertex::BitFlags, vertex::Normal3f, vertex::Qualityf,
+                                vertex::Color4b, vertex::VFAdjOcf, vertex::MarkOcf, vertex::CurvaturefOcf, vertex::CurvatureDirfOcf>
+{
+public:
+  math::Quadric<double> &Qd() {return q;}
+private:
+  math::Quadric<double> q;
+};
+class PtrFace : public Face<PtrUsedTypes, face::InfoOcf, face::VertexRef, face::BitFlags, face::Normal3f, face::QualityfOcf,
+                            face::MarkOcf, face::Color4bOcf, face::FFAdjOcf, face::VFAdjOcf, face::CurvatureDirfOcf,
+                            face::WedgeTexCoordfOcf> {};
+class PtrMesh : public tri::TriMesh<vertex::vector_ocf<PtrVertex>, face::vector_ocf<PtrFace> > {};
+
+class IdxVertex;
+class IdxFace;
+struct IdxUsedTypes : public UsedTypes<	Use<IdxVertex>::AsVertexType,
+                                        Use<IdxFace>::AsFaceType>{};
+
+class IdxVertex : public Vertex<IdxUsedTypes, vertex::InfoOcf, vertex::Coord3f, vertex::BitFlags, vertex::Normal3f, vertex::Qualityf,
+                                vertex::Color4b, vertex::VFAdjOcf, vertex::MarkOcf, vertex::CurvaturefOcf, vertex::CurvatureDirfOcf>
+{
+public:
+  math::Quadric<double> &Qd() {return q;}
+private:
+  math::Quadric<double> q;
+};
+class IdxFace : public Face<IdxUsedTypes, face::InfoOcf, face::VertexRefIdxOcf, face::BitFlags, face::Normal3f, face::QualityfOcf,
+                            face::MarkOcf, face::Color4bOcf, face::FFAdjOcf, face::VFAdjOcf, face::CurvatureDirfOcf,
+                            face::WedgeTexCoordfOcf> {};
+class IdxMesh : public tri::TriMesh<vertex::vector_ocf<IdxVertex>, face::vector_ocf<IdxFace> > {};
+
+template <class MeshType>
+class OcfTriEdgeCollapse : public tri::TriEdgeCollapseQuadric<MeshType, BasicVertexPair<typename MeshType::VertexType>, OcfTriEdgeCollapse<MeshType>,
+                                                              tri::QInfoStandard<typename MeshType::VertexType> >
+{
+public:
+  typedef BasicVertexPair<typename MeshType::VertexType> VertexPair;
+  typedef tri::TriEdgeCollapseQuadric<MeshType, VertexPair, OcfTriEdgeCollapse, tri::QInfoStandard<typename MeshType::VertexType> > TECQ;
+  inline OcfTriEdgeCollapse(const VertexPair &p, int i, BaseParameterClass *pp) : TECQ(p, i, pp) {}
+};
+
+typedef SimpleVolume<SimpleVoxel<float> > RegVolume;
+typedef tri::TrivialWalker<RegMesh, RegVolume> RegWalker;
+typedef tri::MarchingCubes<RegMesh, RegWalker> RegMarchingCubes;
+
+static bool verbose = false;
+static std::string tmpDir = ".";
+static int threadNum = 4;
+
+/// 64 bit FNV-1a hash, used to compare meshes and files.
+class Digest
+{
+public:
+  Digest() : h(1469598103934665603ULL) {}
+  void Add(const void *data, size_t size)
+  {
+    const unsigned char *p = static_cast<const unsigned char *>(data);
+    for (size_t i = 0; i < size; ++i)
+      h = (h ^ p[i]) * 1099511628211ULL;
+  }
+  template <class T> void AddValue(const T &v) { Add(&v, sizeof(T)); }
+  uint64_t Value() const { return h; }
+private:
+  uint64_t h;
+};
+
+/// Digest of the vertex positions (optional) and of the faces of the mesh.
+template <class MeshType>
+static uint64_t MeshDigest(const MeshType &m, bool positions = true)
+{
+  Digest d;
+  d.AddValue(m.vn);
+  d.AddValue(m.fn);
+  std::vector<int> remap(m.vert.size(), -1);
+  int vi = 0;
+  for (size_t i = 0; i < m.vert.size(); ++i)
+    if (!m.vert[i].IsD())
+    {
+      remap[i] = vi++;
+      if (positions)
+        d.AddValue(m.vert[i].cP());
+    }
+  for (size_t i = 0; i < m.face.size(); ++i)
+    if (!m.face[i].IsD())
+      for (int j = 0; j < 3; ++j)
+        d.AddValue(remap[tri::Index(m, m.face[i].cV(j))]);
+  return d.Value();
+}
+
+static uint64_t FileDigest(const std::string &fileName)
+{
+  Digest d;
+  FILE *fp = fopen(fileName.c_str(), "rb");
+  if (!fp) return 0;
+  char buf[1 << 16];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), fp)) > 0)
+    d.Add(buf, n);
+  fclose(fp);
+  return d.Value();
+}
+
+static bool Expect(const char *what, uint64_t value, uint64_t expected)
+{
+  if (verbose || value != expected)
+    printf("    %-28s %016llx (expected %016llx)\n", what, (unsigned long long)value, (unsigned long long)expected);
+  return value == expected;
+}
+
+/// Run func(out) with one thread and with threadNum threads and compare the digests of the results.
+template <class Func>
+static bool SameWithAnyThreads(const char *what, Func func)
+{
+  parallel::SetMaxThreads(1);
+  const uint64_t serial = func();
+  parallel::SetMaxThreads(threadNum);
+  const uint64_t threaded = func();
+  return Expect(what, threaded, serial);
+}
+
+/********************************* Inputs *********************************/
+
+/// Deterministic pseudo random integers, independent of the standard library.
+class IntRandom
+{
+public:
+  IntRandom(unsigned int seed) : s(seed) {}
+  int operator()(int n) { s = s * 1664525u + 1013904223u; return int((s >> 8) % unsigned(n)); }
+private:
+  unsigned int s;
+};
+
+/// Jittered n x n height field over [0,1]^2 or larger (plus offset), triangulated along the grid.
+/// Coordinates, normals, colors and qualities are all exact binary fractions.
+static void BuildHeightField(RegMesh &m, int n, int offset, unsigned int seed)
+{
+  IntRandom rnd(seed);
+  tri::Allocator<RegMesh>::AddVertices(m, n * n);
+  const int step = std::max(8, 1024 / (n - 1));
+  const int half = step * (n - 1) / 2;
+  for (int j = 0; j < n; ++j)
+    for (int i = 0; i < n; ++i)
+    {
+      RegVertex &v = m.vert[j * n + i];
+      const int x = i * step + ((i > 0 && i < n - 1) ? rnd(step / 4) - step / 8 : 0);
+      const int y = j * step + ((j > 0 && j < n - 1) ? rnd(step / 4) - step / 8 : 0);
+      const int dx = (x - half) * 512 / half, dy = (y - half) * 512 / half;
+      const int z = ((dx * dx + dy * dy) >> 9) + rnd(16);
+      v.P() = Point3f(x / 1024.0f + offset, y / 1024.0f, z / 1024.0f);
+      v.N() = Point3f((rnd(64) - 32) / 64.0f, (rnd(64) - 32) / 64.0f, 1.0f);
+      v.C() = Color4b(rnd(256), rnd(256), rnd(256), 255);
+      v.Q() = (rnd(4096) - 2048) / 8.0f;
+    }
+  for (int j = 0; j < n - 1; ++j)
+    for (int i = 0; i < n - 1; ++i)
+    {
+      RegVertex *v00 = &m.vert[j * n + i], *v10 = &m.vert[j * n + i + 1];
+      RegVertex *v01 = &m.vert[(j + 1) * n + i], *v11 = &m.vert[(j + 1) * n + i + 1];
+      tri::Allocator<RegMesh>::AddFace(m, v00, v10, v11);
+      tri::Allocator<RegMesh>::AddFace(m, v00, v11, v01);
+    }
+  for (size_t i = 0; i < m.face.size(); ++i)
+  {
+    m.face[i].C() = Color4b(rnd(256), rnd(256), rnd(256), 255);
+    m.face[i].Q() = rnd(1024) / 4.0f;
+    m.face[i].N() = Point3f(0, 0, 1);
+  }
+  tri::UpdateBounding<RegMesh>::Box(m);
+}
+
+/// Closed torus with bumps, for the checks that compare against the same binary.
+static void BuildBumpyTorus(RegMesh &m, int faceNum)
+{
+  const int vDiv = std::max(8, int(sqrt(faceNum / 8.0)));
+  tri::Torus(m, 1.0f, 0.3f, 4 * vDiv, vDiv);
+  for (size_t i = 0; i < m.vert.size(); ++i)
+  {
+    Point3f &p = m.vert[i].P();
+    const float u = atan2(p[1], p[0]);
+    const Point3f axis(cos(u), sin(u), 0);
+    Point3f n = p - axis;
+    const float v = atan2(p[2], n * axis);
+    n.Normalize();
+    p += n * (0.03f * sin(12 * u) * sin(8 * v));
+    m.vert[i].C() = Color4b((i * 37) % 256, (i * 101) % 256, (i * 13) % 256, 255);
+    m.vert[i].Q() = p[2];
+  }
+  tri::Clean<RegMesh>::RemoveDuplicateVertex(m);
+  tri::Allocator<RegMesh>::CompactEveryVector(m);
+  tri::UpdateBounding<RegMesh>::Box(m);
+  tri::UpdateNormal<RegMesh>::PerVertexNormalizedPerFaceNormalized(m);
+}
+
+static void Copy(RegMesh &m, const RegMesh &src)
+{
+  tri::Append<RegMesh, RegMesh>::MeshCopyConst(m, src);
+  m.bbox = src.bbox;
+}
+
+/// Torus and height field in a single mesh: a closed component and one with borders.
+static void BuildSmoothingInput(RegMesh &m)
+{
+  RegMesh field;
+  BuildBumpyTorus(m, 20000);
+  BuildHeightField(field, 64, 2, 1);
+  tri::Append<RegMesh, RegMesh>::Mesh(m, field);
+  tri::UpdateTopology<RegMesh>::FaceFace(m);
+  tri::UpdateFlags<RegMesh>::FaceBorderFromFF(m);
+}
+
+/********************************* Smoothing *********************************/
+
+// Serial laplacian and Taubin smoothing, as they were before the gather based kernels.
+static void ReferenceLaplacian(RegMesh &m, int step, bool cotangentWeight)
+{
+  typedef tri::Smooth<RegMesh>::LaplacianInfo LaplacianInfo;
+  LaplacianInfo lpz(Point3f(0, 0, 0), 0);
+  SimpleTempData<RegMesh::VertContainer, LaplacianInfo> TD(m.vert, lpz);
+  for (int i = 0; i < step; ++i)
+  {
+    TD.Init(lpz);
+    tri::Smooth<RegMesh>::AccumulateLaplacianInfo(m, TD, cotangentWeight);
+    for (RegMesh::VertexIterator vi = m.vert.begin(); vi != m.vert.end(); ++vi)
+      if (!(*vi).IsD() && TD[*vi].cnt > 0)
+        (*vi).P() = ((*vi).P() + TD[*vi].sum) / (TD[*vi].cnt + 1);
+  }
+}
+
+static void ReferenceTaubin(RegMesh &m, int step, float lambda, float mu)
+{
+  typedef tri::Smooth<RegMesh>::LaplacianInfo LaplacianInfo;
+  LaplacianInfo lpz(Point3f(0, 0, 0), 0);
+  SimpleTempData<RegMesh::VertContainer, LaplacianInfo> TD(m.vert, lpz);
+  for (int i = 0; i < step; ++i)
+    for (int k = 0; k < 2; ++k)
+    {
+      TD.Init(lpz);
+      tri::Smooth<RegMesh>::AccumulateLaplacianInfo(m, TD);
+      for (RegMesh::VertexIterator vi = m.vert.begin(); vi != m.vert.end(); ++vi)
+        if (!(*vi).IsD() && TD[*vi].cnt > 0)
+        {
+          Point3f delta = TD[*vi].sum / TD[*vi].cnt - (*vi).P();
+          (*vi).P() = (*vi).P() + delta * (k == 0 ? lambda : mu);
+        }
+    }
+}
+
+static bool SmoothLaplacian()
+{
+  RegMesh in;
+  BuildSmoothingInput(in);
+  bool ok = true;
+  for (int cot = 0; cot < 2; ++cot)
+  {
+    RegMesh ref;
+    Copy(ref, in);
+    ReferenceLaplacian(ref, 5, cot == 1);
+    ok = SameWithAnyThreads(cot ? "cotangent == serial" : "uniform == serial", [&]() {
+      RegMesh m;
+      Copy(m, in);
+      tri::Smooth<RegMesh>::VertexCoordLaplacian(m, 5, false, cot == 1);
+      return MeshDigest(m);
+    }) && ok;
+    RegMesh m;
+    Copy(m, in);
+    tri::Smooth<RegMesh>::VertexCoordLaplacian(m, 5, false, cot == 1);
+    ok = Expect(cot ? "cotangent == previous" : "uniform == previous", MeshDigest(m), MeshDigest(ref)) && ok;
+  }
+  return ok;
+}
+
+static bool SmoothTaubin()
+{
+  RegMesh in, ref;
+  BuildSmoothingInput(in);
+  Copy(ref, in);
+  ReferenceTaubin(ref, 5, 0.5f, -0.53f);
+  RegMesh m;
+  Copy(m, in);
+  tri::Smooth<RegMesh>::VertexCoordTaubin(m, 5, 0.5f, -0.53f);
+  bool ok = Expect("taubin == previous", MeshDigest(m), MeshDigest(ref));
+  return SameWithAnyThreads("taubin == serial", [&]() {
+    RegMesh t;
+    Copy(t, in);
+    tri::Smooth<RegMesh>::VertexCoordTaubin(t, 5, 0.5f, -0.53f);
+    return MeshDigest(t);
+  }) && ok;
+}
+
+static bool SmoothOther()
+{
+  RegMesh in;
+  BuildSmoothingInput(in);
+  bool ok = SameWithAnyThreads("laplacian HC == serial", [&]() {
+    RegMesh m;
+    Copy(m, in);
+    tri::Smooth<RegMesh>::VertexCoordLaplacianHC(m, 3);
+    return MeshDigest(m);
+  });
+  ok = SameWithAnyThreads("color, quality, normal == serial", [&]() {
+    RegMesh m;
+    Copy(m, in);
+    tri::Smooth<RegMesh>::VertexColorLaplacian(m, 3);
+    tri::Smooth<RegMesh>::VertexQualityLaplacian(m, 3);
+    tri::Smooth<RegMesh>::VertexNormalLaplacian(m, 3);
+    Digest d;
+    for (size_t i = 0; i < m.vert.size(); ++i)
+    {
+      d.AddValue(m.vert[i].C());
+      d.AddValue(m.vert[i].Q());
+      d.AddValue(m.vert[i].N());
+    }
+    return d.Value();
+  }) && ok;
+  return ok;
+}
+
+/********************************* Exporters *********************************/
+
+// Digests of the files written by the exporters before they were buffered and parallelized.
+static const uint64_t PlyBinaryDigest = 0xab472d41dfcfa19fULL;
+static const uint64_t PlyAsciiDigest  = 0x2318b9897dea4fddULL;
+static const uint64_t ObjDigest       = 0x62ccc909d0019f6aULL;
+static const uint64_t OffDigest       = 0xc808eedbcc5e8053ULL;
+
+// Large enough for several batches of chunks of the exporters.
+static void BuildExportInput(RegMesh &m)
+{
+  BuildHeightField(m, 513, 0, 2);
+}
+
+template <class SaveFunc>
+static bool CheckExport(const char *ext, uint64_t expected, SaveFunc save)
+{
+  RegMesh m;
+  BuildExportInput(m);
+  const std::string fileName = tmpDir + "/vcg_regression_tmp." + ext;
+  bool ok = SameWithAnyThreads("threads == serial", [&]() {
+    save(m, fileName.c_str());
+    return FileDigest(fileName);
+  });
+  ok = Expect("file == previous", FileDigest(fileName), expected) && ok;
+  remove(fileName.c_str());
+  return ok;
+}
+
+static const int PlyMask = tri::io::Mask::IOM_VERTNORMAL | tri::io::Mask::IOM_VERTCOLOR | tri::io::Mask::IOM_VERTQUALITY |
+                           tri::io::Mask::IOM_FACECOLOR | tri::io::Mask::IOM_FACEQUALITY;
+
+static bool ExportPlyBinary()
+{
+  return CheckExport("bin.ply", PlyBinaryDigest, [](RegMesh &m, const char *fileName) {
+    tri::io::ExporterPLY<RegMesh>::Save(m, fileName, PlyMask, true);
+  });
+}
+
+static bool ExportPlyAscii()
+{
+  return CheckExport("ascii.ply", PlyAsciiDigest, [](RegMesh &m, const char *fileName) {
+    tri::io::ExporterPLY<RegMesh>::Save(m, fileName, PlyMask, false);
+  });
+}
+
+static bool ExportObj()
+{
+  return CheckExport("obj", ObjDigest, [](RegMesh &m, const char *fileName) {
+    tri::io::ExporterOBJ<RegMesh>::Save(m, fileName, tri::io::Mask::IOM_VERTNORMAL | tri::io::Mask::IOM_VERTCOLOR);
+  });
+}
+
+static bool ExportOff()
+{
+  return CheckExport("off", OffDigest, [](RegMesh &m, const char *fileName) {
+    tri::io::ExporterOFF<RegMesh>::Save(m, fileName, tri::io::Mask::IOM_VERTCOLOR);
+  });
+}
+
+/********************************* Reconstruction and remeshing *********************************/
+
+// Digests of the faces built by the serial ball pivoting and by the Voronoi remeshing
+// before they were optimized and parallelized.
+static const uint64_t BallPivotingDigest  = 0x831a821213e832d1ULL;
+static const uint64_t VoronoiRemeshDigest = 0x35a38d57a006436cULL;
+
+static void BuildPointCloud(RegMesh &m)
+{
+  BuildHeightField(m, 96, 0, 3);
+  for (size_t i = 0; i < m.face.size(); ++i)
+    tri::Allocator<RegMesh>::DeleteFace(m, m.face[i]);
+  tri::Allocator<RegMesh>::CompactEveryVector(m);
+}
+
+static bool BallPivotingSerial()
+{
+  RegMesh m;
+  BuildPointCloud(m);
+  tri::BallPivoting<RegMesh> pivot(m, 0.03f, 0.05f);
+  pivot.BuildMesh();
+  return Expect("faces == previous", MeshDigest(m, false), BallPivotingDigest);
+}
+
+static bool BallPivotingPartitioned()
+{
+  RegMesh in;
+  BuildPointCloud(in);
+  return SameWithAnyThreads("faces threads == serial", [&]() {
+    RegMesh m;
+    Copy(m, in);
+    tri::BallPivoting<RegMesh> pivot(m, 0.03f, 0.05f);
+    pivot.BuildMeshPartitioned(0, 2000);
+    return MeshDigest(m, false);
+  });
+}
+
+/// Two height fields, so that the connected components are remeshed concurrently.
+static void BuildRemeshInput(RegMesh &m)
+{
+  RegMesh other;
+  BuildHeightField(m, 48, 0, 4);
+  BuildHeightField(other, 32, 2, 5);
+  tri::Append<RegMesh, RegMesh>::Mesh(m, other);
+  tri::UpdateBounding<RegMesh>::Box(m);
+  tri::UpdateTopology<RegMesh>::VertexFace(m);
+}
+
+static bool VoronoiRemesh()
+{
+  RegMesh in;
+  BuildRemeshInput(in);
+  uint64_t faces = 0;
+  bool ok = SameWithAnyThreads("threads == serial", [&]() {
+    RegMesh m;
+    Copy(m, in);
+    tri::UpdateTopology<RegMesh>::VertexFace(m);
+    std::shared_ptr<RegMesh> out = tri::Remesher<RegMesh>::Remesh(m, 0.05f, 70.0f);
+    faces = out ? MeshDigest(*out, false) : 0;
+    return out ? MeshDigest(*out) : 0;
+  });
+  return Expect("faces == previous", faces, VoronoiRemeshDigest) && ok;
+}
+
+/********************************* Other parallel algorithms *********************************/
+
+static bool MarchingCubesSlabs()
+{
+  const int n = 96;
+  RegVolume volume;
+  volume.Init(Point3i(n, n, n), Box3f(Point3f(-1.5, -1.5, -1.5), Point3f(1.5, 1.5, 1.5)));
+  for (int i = 0; i < n; ++i)
+    for (int j = 0; j < n; ++j)
+      for (int k = 0; k < n; ++k)
+      {
+        Point3f p;
+        volume.IPiToPf(Point3i(i, j, k), p);
+        const float r = sqrt(p[0] * p[0] + p[1] * p[1]) - 1.0f;
+        volume.Val(i, j, k) = sqrt(r * r + p[2] * p[2]) - 0.3f - 0.03f * sin(12 * atan2(p[1], p[0]));
+      }
+  // BuildMeshParallel gives the same triangles up to the vertex order
+  std::vector<std::vector<Point3f> > tris[2];
+  for (int k = 0; k < 2; ++k)
+  {
+    RegMesh m;
+    RegWalker walker;
+    if (k == 0)
+    {
+      RegMarchingCubes mc(m, walker);
+      walker.BuildMesh<RegMarchingCubes>(m, volume, mc, 0);
+    }
+    else
+      walker.BuildMeshParallel<RegMarchingCubes>(m, volume, 0);
+    for (size_t i = 0; i < m.face.size(); ++i)
+    {
+      std::vector<Point3f> t(3);
+      for (int j = 0; j < 3; ++j) t[j] = m.face[i].cP(j);
+      std::rotate(t.begin(), std::min_element(t.begin(), t.end()), t.end());
+      tris[k].push_back(t);
+    }
+    std::sort(tris[k].begin(), tris[k].end());
+  }
+  const bool ok = !tris[0].empty() && tris[0] == tris[1];
+  if (verbose || !ok)
+    printf("    %-28s %d / %d triangles\n", "slabs == serial", int(tris[1].size()), int(tris[0].size()));
+  return ok;
+}
+
+static bool CleanAndClustering()
+{
+  RegMesh in;
+  BuildBumpyTorus(in, 100000);
+  bool ok = SameWithAnyThreads("clean == serial", [&]() {
+    RegMesh m;
+    Copy(m, in);
+    tri::Append<RegMesh, RegMesh>::MeshAppendConst(m, in);
+    tri::Clean<RegMesh>::RemoveDuplicateVertex(m);
+    tri::Clean<RegMesh>::RemoveDuplicateFace(m);
+    tri::Clean<RegMesh>::RemoveUnreferencedVertex(m);
+    tri::Allocator<RegMesh>::CompactEveryVector(m);
+    return MeshDigest(m);
+  });
+  ok = SameWithAnyThreads("clustering == serial", [&]() {
+    RegMesh m, out;
+    Copy(m, in);
+    tri::UpdateNormal<RegMesh>::PerFace(m);
+    tri::Clustering<RegMesh, tri::AverageColorCell<RegMesh> > grid;
+    grid.Init(m.bbox, m.FN() / 4);
+    grid.AddMesh(m);
+    grid.ExtractMesh(out);
+    return MeshDigest(out);
+  }) && ok;
+  return ok;
+}
+
+static bool IsotropicRemeshingThreads()
+{
+  RegMesh in;
+  BuildBumpyTorus(in, 20000);
+  return SameWithAnyThreads("threads == serial", [&]() {
+    RegMesh m;
+    Copy(m, in);
+    tri::UpdateTopology<RegMesh>::FaceFace(m);
+    tri::IsotropicRemeshing<RegMesh>::Params params;
+    params.SetTargetLen(in.bbox.Diag() * 0.01f);
+    params.maxSurfDist = in.bbox.Diag() * 0.001f;
+    params.iter = 3;
+    tri::IsotropicRemeshing<RegMesh>::Do(m, params);
+    tri::Allocator<RegMesh>::CompactEveryVector(m);
+    return MeshDigest(m);
+  });
+}
+
+/********************************* Compact faces *********************************/
+
+// Runs the main algorithms that add, delete and reorder vertices and faces and returns
+// the digest of the mesh after each of them.
+template <class MeshType>
+static std::vector<uint64_t> CompactFacesPipeline(const RegMesh &in, const std::string &fileName)
+{
+  std::vector<uint64_t> digests;
+  MeshType m;
+  m.vert.EnableVFAdjacency();
+  m.vert.EnableMark();
+  m.face.EnableFFAdjacency();
+  m.face.EnableVFAdjacency();
+  m.face.EnableMark();
+  m.face.EnableQuality();
+  m.face.EnableColor();
+
+  // appending reallocates the vertex vector after the faces refer to it
+  tri::Append<MeshType, RegMesh>::MeshCopyConst(m, in);
+  tri::Append<MeshType, RegMesh>::MeshAppendConst(m, in);
+  tri::Clean<MeshType>::RemoveDuplicateVertex(m);
+  tri::Clean<MeshType>::RemoveDuplicateFace(m);
+  tri::Clean<MeshType>::RemoveUnreferencedVertex(m);
+  tri::Allocator<MeshType>::CompactEveryVector(m);
+  digests.push_back(MeshDigest(m));
+
+  tri::UpdateTopology<MeshType>::FaceFace(m);
+  tri::UpdateFlags<MeshType>::FaceBorderFromFF(m);
+  tri::Smooth<MeshType>::VertexCoordLaplacian(m, 2);
+  tri::UpdateBounding<MeshType>::Box(m);
+  tri::Refine<MeshType, tri::MidPoint<MeshType> >(m, tri::MidPoint<MeshType>(&m), m.bbox.Diag() * 0.01f);
+  digests.push_back(MeshDigest(m));
+
+  tri::TriEdgeCollapseQuadricParameter qparams;
+  qparams.QualityThr = .3;
+  tri::UpdateTopology<MeshType>::VertexFace(m);
+  LocalOptimization<MeshType> deciSession(m, &qparams);
+  deciSession.template Init<OcfTriEdgeCollapse<MeshType> >();
+  const int targetFaceNum = m.fn / 4;
+  deciSession.SetTargetSimplices(targetFaceNum);
+  while (deciSession.DoOptimization() && m.fn > targetFaceNum)
+    ;
+  tri::Allocator<MeshType>::CompactEveryVector(m);
+  digests.push_back(MeshDigest(m));
+
+  tri::UpdateTopology<MeshType>::FaceFace(m);
+  typename tri::IsotropicRemeshing<MeshType>::Params params;
+  params.SetTargetLen(m.bbox.Diag() * 0.01f);
+  params.maxSurfDist = m.bbox.Diag() * 0.001f;
+  params.iter = 2;
+  tri::IsotropicRemeshing<MeshType>::Do(m, params);
+  tri::Allocator<MeshType>::CompactEveryVector(m);
+  digests.push_back(MeshDigest(m));
+
+  tri::io::ExporterPLY<MeshType>::Save(m, fileName.c_str(), tri::io::Mask::IOM_VERTCOLOR, true);
+  MeshType r;
+  int mask = 0;
+  tri::io::ImporterPLY<MeshType>::Open(r, fileName.c_str(), mask);
+  remove(fileName.c_str());
+  digests.push_back(MeshDigest(r));
+  return digests;
+}
+
+static bool CompactFaces()
+{
+  RegMesh in;
+  BuildBumpyTorus(in, 20000);
+  const std::vector<uint64_t> ptr = CompactFacesPipeline<PtrMesh>(in, tmpDir + "/vcg_regression_tmp.ptr.ply");
+  const std::vector<uint64_t> idx = CompactFacesPipeline<IdxMesh>(in, tmpDir + "/vcg_regression_tmp.idx.ply");
+  const char *stages[] = { "clean", "smooth, refine", "quadric collapse", "isotropic remeshing", "ply save, load" };
+  bool ok = true;
+  for (size_t i = 0; i < ptr.size(); ++i)
+    ok = Expect((std::string(stages[i]) + " == pointers").c_str(), idx[i], ptr[i]) && ok;
+  return ok;
+}
+
+/********************************* Main *********************************/
+
+struct Check
+{
+  const char *name;
+  bool (*func)();
+};
+
+static const Check Checks[] = {
+  { "smooth_laplacian",         SmoothLaplacian },
+  { "smooth_taubin",            SmoothTaubin },
+  { "smooth_other",             SmoothOther },
+  { "io_ply_binary",            ExportPlyBinary },
+  { "io_ply_ascii",             ExportPlyAscii },
+  { "io_obj",                   ExportObj },
+  { "io_off",                   ExportOff },
+  { "ball_pivoting",            BallPivotingSerial },
+  { "ball_pivoting_partitioned", BallPivotingPartitioned },
+  { "voronoi_remesh",           VoronoiRemesh },
+  { "marching_cubes",           MarchingCubesSlabs },
+  { "clean_clustering",         CleanAndClustering },
+  { "isotropic_remeshing",      IsotropicRemeshingThreads },
+  { "compact_faces",            CompactFaces }
+};
+
+static void Usage()
+{
+  printf(
+        "---------------------------------\n"
+        "      VCG Regression Checks 1.0 \n"
+        "     http://vcg.isti.cnr.it\n"
+        "   release date: " __DATE__
+        "\n---------------------------------\n\n"
+        "Usage: vcg_regression [opt]\n"
+        "Where opt can be:\n"
+        "     -f<text>  run only the checks whose name contains text\n"
+        "     -t#       number of threads compared with the serial runs (default 4)\n"
+        "     -d<dir>   directory for the temporary files (default .)\n"
+        "     -v        print all the compared digests\n"
+        "     -l        list the checks\n");
+  exit(-1);
+}
+
+int main(int argc, char **argv)
+{
+  std::string filter;
+  for (int i = 1; i < argc; ++i)
+  {
+    if (argv[i][0] != '-') Usage();
+    switch (argv[i][1])
+    {
+      case 'f' : filter = argv[i] + 2; break;
+      case 't' : threadNum = std::max(2, atoi(argv[i] + 2)); break;
+      case 'd' : tmpDir = argv[i] + 2; break;
+      case 'v' : verbose = true; break;
+      case 'l' :
+        for (size_t c = 0; c < sizeof(Checks) / sizeof(Checks[0]); ++c)
+          printf("%s\n", Checks[c].name);
+        return 0;
+      default : Usage();
+    }
+  }
+
+  int failed = 0;
+  for (size_t c = 0; c < sizeof(Checks) / sizeof(Checks[0]); ++c)
+  {
+    if (!filter.empty() && std::string(Checks[c].name).find(filter) == std::string::npos)
+      continue;
+    printf("%-28s\n", Checks[c].name);
+    fflush(stdout);
+    const bool ok = Checks[c].func();
+    printf("%-28s %s\n", Checks[c].name, ok ? "ok" : "FAILED");
+    fflush(stdout);
+    if (!ok) ++failed;
+  }
+  parallel::SetMaxThreads(0);
+  if (failed > 0)
+    printf("%d checks FAILED\n", failed);
+  return failed;
+}
@@ -24,6 +24,7 @@
 #ifndef __VCGLIB_CLEAN
 #define __VCGLIB_CLEAN
 
+#include <atomic>
 #include <unordered_set>
 
 // VCG headers
@@ -34,6 +35,8 @@
 #include <vcg/complex/algorithms/update/normal.h>
 #include <vcg/space/triangle3.h>
 #include <vcg/complex/append.h>
+#include <vcg/complex/algorithms/radix_sort.h>
+#include <wrap/system/parallel.h>
 
 namespace vcg {
 namespace tri{
@@ -207,65 +210,67 @@ public:
 	{
 		if(m.vert.size()==0 || m.vn==0) return 0;
 
-		std::map<VertexPointer, VertexPointer> mp;
-		size_t i,j;
-		VertexIterator vi;
-		int deleted=0;
-		int k=0;
-		size_t num_vert = m.vert.size();
-		std::vector<VertexPointer> perm(num_vert);
-		for(vi=m.vert.begin(); vi!=m.vert.end(); ++vi, ++k)
-			perm[k] = &(*vi);
-
-		RemoveDuplicateVert_Compare c_obj;
+		// radix sort of the vertex indices by position (z most significant);
+		// the sort is stable so in each group of coincident vertices the first one is kept.
+		std::vector<unsigned int> perm;
+		perm.reserve(m.vn);
+		for(size_t i=0; i<m.vert.size(); ++i)
+		{
+			const CoordType &p = m.vert[i].cP();
+			if(!m.vert[i].IsD() && !math::IsNAN(p[0]) && !math::IsNAN(p[1]) && !math::IsNAN(p[2]))
+				perm.push_back((unsigned int)i);
+		}
+		for(int c=0; c<3; ++c)
+			RadixSortIndex(perm, [&m,c](unsigned int i) { return RadixSortFloatKey(m.vert[i].cP()[c]); }, int(sizeof(ScalarType))*8);
 
-		std::sort(perm.begin(),perm.end(),c_obj);
+		std::vector<unsigned int> remap(m.vert.size());
+		for(size_t i=0; i<remap.size(); ++i)
+			remap[i] = (unsigned int)i;
 
-		j = 0;
-		i = j;
-		mp[perm[i]] = perm[j];
-		++i;
-		for(;i!=num_vert;)
+		int deleted=0;
+		size_t j=0;
+		for(size_t i=1; i<perm.size(); ++i)
 		{
-			if( (! (*perm[i]).IsD()) &&
-			    (! (*perm[j]).IsD()) &&
-			    (*perm[i]).P() == (*perm[j]).cP() )
+			if(m.vert[perm[i]].cP() == m.vert[perm[j]].cP())
 			{
-				VertexPointer t = perm[i];
-				mp[perm[i]] = perm[j];
-				++i;
-				Allocator<MeshType>::DeleteVertex(m,*t);
+				remap[perm[i]] = perm[j];
+				Allocator<MeshType>::DeleteVertex(m,m.vert[perm[i]]);
 				deleted++;
 			}
 			else
-			{
 				j = i;
-				++i;
-			}
 		}
 
-		for(FaceIterator fi = m.face.begin(); fi!=m.face.end(); ++fi)
-			if( !(*fi).IsD() )
-				for(k = 0; k < (*fi).VN(); ++k)
-					if( mp.find( (typename MeshType::VertexPointer)(*fi).V(k) ) != mp.end() )
+		if(deleted>0)
+		{
+			parallel::For(int(m.face.size()), [&](int i) {
+				FaceType &f = m.face[i];
+				if(!f.IsD())
+					for(int k=0; k<f.VN(); ++k)
 					{
-						(*fi).V(k) = &*mp[ (*fi).V(k) ];
+						const size_t vi = tri::Index(m,f.cV(k));
+						if(remap[vi]!=vi) f.V(k) = &m.vert[remap[vi]];
 					}
+			});
 
-
-		for(EdgeIterator ei = m.edge.begin(); ei!=m.edge.end(); ++ei)
-			if( !(*ei).IsD() )
-				for(k = 0; k < 2; ++k)
-					if( mp.find( (typename MeshType::VertexPointer)(*ei).V(k) ) != mp.end() )
+			parallel::For(int(m.edge.size()), [&](int i) {
+				if(!m.edge[i].IsD())
+					for(int k=0; k<2; ++k)
 					{
-						(*ei).V(k) = &*mp[ (*ei).V(k) ];
+						const size_t vi = tri::Index(m,m.edge[i].V(k));
+						if(remap[vi]!=vi) m.edge[i].V(k) = &m.vert[remap[vi]];
 					}
+			});
 
-		for (TetraIterator ti = m.tetra.begin(); ti != m.tetra.end(); ++ti)
-			if (!(*ti).IsD())
-				for (k = 0; k < 4; ++k)
-					if (mp.find((typename MeshType::VertexPointer)(*ti).V(k)) != mp.end())
-						(*ti).V(k) = &*mp[ (*ti).V(k) ];
+			parallel::For(int(m.tetra.size()), [&](int i) {
+				if(!m.tetra[i].IsD())
+					for(int k=0; k<4; ++k)
+					{
+						const size_t vi = tri::Index(m,m.tetra[i].V(k));
+						if(remap[vi]!=vi) m.tetra[i].V(k) = &m.vert[remap[vi]];
+					}
+			});
+		}
 
 		if(RemoveDegenerateFlag) RemoveDegenerateFace(m);
 		if(RemoveDegenerateFlag && m.en>0) {
@@ -333,23 +338,31 @@ public:
 	 */
 	static int RemoveDuplicateFace( MeshType & m)    // V1.0
 	{
-		std::vector<SortedTriple> fvec;
-		for(FaceIterator fi=m.face.begin();fi!=m.face.end();++fi)
-			if(!(*fi).IsD())
-			{
-				fvec.push_back(SortedTriple(    tri::Index(m,(*fi).V(0)),
-				                                tri::Index(m,(*fi).V(1)),
-				                                tri::Index(m,(*fi).V(2)),
-				                                &*fi));
-			}
-		std::sort(fvec.begin(),fvec.end());
+		std::vector<SortedTriple> fvec(m.face.size());
+		parallel::For(int(m.face.size()), [&](int i) {
+			if(!m.face[i].IsD())
+				fvec[i] = SortedTriple(tri::Index(m,m.face[i].cV(0)),
+				                       tri::Index(m,m.face[i].cV(1)),
+				                       tri::Index(m,m.face[i].cV(2)),
+				                       &m.face[i]);
+		});
+
+		// radix sort of the face indices by sorted vertex triple; the first face of each group is kept
+		std::vector<unsigned int> perm;
+		perm.reserve(m.fn);
+		for(size_t i=0; i<m.face.size(); ++i)
+			if(!m.face[i].IsD())
+				perm.push_back((unsigned int)i);
+		RadixSortIndex(perm, [&fvec](unsigned int i) { return (uint64_t(fvec[i].v[1])<<32) | fvec[i].v[0]; });
+		RadixSortIndex(perm, [&fvec](unsigned int i) { return uint64_t(fvec[i].v[2]); }, 32);
+
 		int total=0;
-		for(int i=0;i<int(fvec.size())-1;++i)
+		for(size_t i=1; i<perm.size(); ++i)
 		{
-			if(fvec[i]==fvec[i+1])
+			if(fvec[perm[i]]==fvec[perm[i-1]])
 			{
 				total++;
-				tri::Allocator<MeshType>::DeleteFace(m, *(fvec[i].fp) );
+				tri::Allocator<MeshType>::DeleteFace(m, *(fvec[perm[i]].fp) );
 			}
 		}
 		return total;
@@ -397,36 +410,37 @@ public:
 	{
 		tri::RequirePerVertexFlags(m);
 
-		std::vector<bool> referredVec(m.vert.size(),false);
+		// marked concurrently by the faces, edges and tetras sharing a vertex
+		std::vector<std::atomic<bool> > referredVec(m.vert.size());
 		int deleted = 0;
 
-		for(auto fi = m.face.begin(); fi != m.face.end(); ++fi)
-			if( !(*fi).IsD() )
-				for(auto j=0; j < (*fi).VN(); ++j)
-					referredVec[tri::Index(m, (*fi).V(j))]=true;
+		parallel::For(int(m.face.size()), [&](int i) {
+			if( !m.face[i].IsD() )
+				for(int j=0; j < m.face[i].VN(); ++j)
+					referredVec[tri::Index(m, m.face[i].cV(j))].store(true, std::memory_order_relaxed);
+		});
 
-		for(auto ei=m.edge.begin();ei!=m.edge.end();++ei)
-			if( !(*ei).IsD() ){
-				referredVec[tri::Index(m, (*ei).V(0))]=true;
-				referredVec[tri::Index(m, (*ei).V(1))]=true;
-			}
-
-		for(auto ti=m.tetra.begin(); ti!=m.tetra.end();++ti)
-			if( !(*ti).IsD() ){
-				referredVec[tri::Index(m, (*ti).V(0))]=true;
-				referredVec[tri::Index(m, (*ti).V(1))]=true;
-				referredVec[tri::Index(m, (*ti).V(2))]=true;
-				referredVec[tri::Index(m, (*ti).V(3))]=true;
+		parallel::For(int(m.edge.size()), [&](int i) {
+			if( !m.edge[i].IsD() ){
+				referredVec[tri::Index(m, m.edge[i].V(0))].store(true, std::memory_order_relaxed);
+				referredVec[tri::Index(m, m.edge[i].V(1))].store(true, std::memory_order_relaxed);
 			}
+		});
 
+		parallel::For(int(m.tetra.size()), [&](int i) {
+			if( !m.tetra[i].IsD() )
+				for(int j=0; j<4; ++j)
+					referredVec[tri::Index(m, m.tetra[i].V(j))].store(true, std::memory_order_relaxed);
+		});
 
 		if(!DeleteVertexFlag)
-			return std::count(referredVec.begin(),referredVec.end(),false);
+			return int(std::count_if(referredVec.begin(),referredVec.end(),
+			                         [](const std::atomic<bool> &r) { return !r.load(std::memory_order_relaxed); }));
 
-		for(auto vi=m.vert.begin();vi!=m.vert.end();++vi)
-			if( (!(*vi).IsD()) && (!referredVec[tri::Index(m,*vi)]) )
+		for(size_t i=0; i<m.vert.size(); ++i)
+			if( (!m.vert[i].IsD()) && (!referredVec[i].load(std::memory_order_relaxed)) )
 			{
-				Allocator<MeshType>::DeleteVertex(m,*vi);
+				Allocator<MeshType>::DeleteVertex(m,m.vert[i]);
 				++deleted;
 			}
 		return deleted;
@@ -1273,6 +1287,73 @@ public:
 		return int(CCV.size());
 	}
 
+	/// Size, area, bounding box and first face of a connected component.
+	struct ConnectedComponentInfo
+	{
+		ConnectedComponentInfo() : faceNum(0), area(0), first(0) {}
+		int faceNum;
+		ScalarType area;
+		Box3Type bbox;
+		FacePointer first;
+	};
+
+	/**
+  Compute the connected components of the faces of a mesh as the classes of the
+  relation "two faces share a vertex". It does not need FF adjacency (and differs from
+  ConnectedComponents() only where faces touch at non manifold vertices).
+  The vertices are merged with a lock-free union-find processed in parallel over the faces.
+  faceCC is filled with the index of the component of each face (-1 for deleted faces),
+  CCV with the size, area and bounding box of each component; components are numbered
+  in the order of their first face. Returns the number of components.
+ */
+	static int FaceVertexConnectedComponents(MeshType &m, std::vector<int> &faceCC, std::vector<ConnectedComponentInfo> &CCV)
+	{
+		const int vn = int(m.vert.size());
+		const int fn = int(m.face.size());
+		std::vector<std::atomic<int> > parent(vn);
+		parallel::For(vn, [&](int i) {
+			parent[i].store(i, std::memory_order_relaxed);
+		});
+
+		parallel::For(fn, [&](int i) {
+			const FaceType &f = m.face[i];
+			if (f.IsD()) return;
+			const int v0 = int(tri::Index(m, f.cV(0)));
+			for (int j = 1; j < f.VN(); ++j)
+				UnionFindMerge(parent, v0, int(tri::Index(m, f.cV(j))));
+		}, 0, "", 4096);
+
+		// roots are numbered in face order, then the per component data is gathered
+		std::vector<int> rootCC(vn, -1);
+		faceCC.assign(fn, -1);
+		CCV.clear();
+		for (int i = 0; i < fn; ++i)
+		{
+			FaceType &f = m.face[i];
+			if (f.IsD()) continue;
+			const int r = UnionFindRoot(parent, int(tri::Index(m, f.cV(0))));
+			if (rootCC[r] == -1)
+			{
+				rootCC[r] = int(CCV.size());
+				CCV.push_back(ConnectedComponentInfo());
+				CCV.back().first = &f;
+			}
+			const int cc = faceCC[i] = rootCC[r];
+			ConnectedComponentInfo &info = CCV[cc];
+			++info.faceNum;
+			info.area += DoubleArea(f) / ScalarType(2);
+			for (int j = 0; j < f.VN(); ++j)
+				info.bbox.Add(f.cP(j));
+		}
+		return int(CCV.size());
+	}
+
+	static int FaceVertexConnectedComponents(MeshType &m, std::vector<int> &faceCC)
+	{
+		std::vector<ConnectedComponentInfo> CCV;
+		return FaceVertexConnectedComponents(m, faceCC, CCV);
+	}
+
 	static int edgeMeshConnectedComponents(MeshType & poly,  std::vector<std::pair<int, typename MeshType::EdgePointer> > &eCC)
 	{
 		typedef typename MeshType::EdgePointer EdgePointer;
@@ -1915,26 +1996,13 @@ public:
 
 	static std::pair<int,int>  RemoveSmallConnectedComponentsSize(MeshType &m, int maxCCSize)
 	{
-		std::vector< std::pair<int, typename MeshType::FacePointer> > CCV;
-		int TotalCC=ConnectedComponents(m, CCV);
-		int DeletedCC=0;
-
-		ConnectedComponentIterator<MeshType> ci;
-		for(unsigned int i=0;i<CCV.size();++i)
-		{
-			std::vector<typename MeshType::FacePointer> FPV;
-			if(CCV[i].first<maxCCSize)
-			{
-				DeletedCC++;
-				for(ci.start(m,CCV[i].second);!ci.completed();++ci)
-					FPV.push_back(*ci);
-
-				typename std::vector<typename MeshType::FacePointer>::iterator fpvi;
-				for(fpvi=FPV.begin(); fpvi!=FPV.end(); ++fpvi)
-					Allocator<MeshType>::DeleteFace(m,(**fpvi));
-			}
-		}
-		return std::make_pair(TotalCC,DeletedCC);
+		std::vector<int> faceCC;
+		std::vector<ConnectedComponentInfo> CCV;
+		int TotalCC=FaceVertexConnectedComponents(m, faceCC, CCV);
+		std::vector<bool> toDelete(CCV.size());
+		for(size_t i=0;i<CCV.size();++i)
+			toDelete[i] = CCV[i].faceNum<maxCCSize;
+		return std::make_pair(TotalCC,DeleteConnectedComponents(m,faceCC,toDelete));
 	}
 
 
@@ -1942,60 +2010,36 @@ public:
 	// it returns a pair with the number of connected components and the number of deleted ones.
 	static std::pair<int,int> RemoveSmallConnectedComponentsDiameter(MeshType &m, ScalarType maxDiameter)
 	{
-		std::vector< std::pair<int, typename MeshType::FacePointer> > CCV;
-		int TotalCC=ConnectedComponents(m, CCV);
-		int DeletedCC=0;
-		tri::ConnectedComponentIterator<MeshType> ci;
-		for(unsigned int i=0;i<CCV.size();++i)
-		{
-			Box3<ScalarType> bb;
-			std::vector<typename MeshType::FacePointer> FPV;
-			for(ci.start(m,CCV[i].second);!ci.completed();++ci)
-			{
-				FPV.push_back(*ci);
-				bb.Add((*ci)->P(0));
-				bb.Add((*ci)->P(1));
-				bb.Add((*ci)->P(2));
-			}
-			if(bb.Diag()<maxDiameter)
-			{
-				DeletedCC++;
-				typename std::vector<typename MeshType::FacePointer>::iterator fpvi;
-				for(fpvi=FPV.begin(); fpvi!=FPV.end(); ++fpvi)
-					tri::Allocator<MeshType>::DeleteFace(m,(**fpvi));
-			}
-		}
-		return std::make_pair(TotalCC,DeletedCC);
+		std::vector<int> faceCC;
+		std::vector<ConnectedComponentInfo> CCV;
+		int TotalCC=FaceVertexConnectedComponents(m, faceCC, CCV);
+		std::vector<bool> toDelete(CCV.size());
+		for(size_t i=0;i<CCV.size();++i)
+			toDelete[i] = CCV[i].bbox.Diag()<maxDiameter;
+		return std::make_pair(TotalCC,DeleteConnectedComponents(m,faceCC,toDelete));
 	}
 
 	/// Remove the connected components greater than a given diameter
 	// it returns a pair with the number of connected components and the number of deleted ones.
 	static std::pair<int,int> RemoveHugeConnectedComponentsDiameter(MeshType &m, ScalarType minDiameter)
 	{
-		std::vector< std::pair<int, typename MeshType::FacePointer> > CCV;
-		int TotalCC=ConnectedComponents(m, CCV);
-		int DeletedCC=0;
-		tri::ConnectedComponentIterator<MeshType> ci;
-		for(unsigned int i=0;i<CCV.size();++i)
-		{
-			Box3f bb;
-			std::vector<typename MeshType::FacePointer> FPV;
-			for(ci.start(m,CCV[i].second);!ci.completed();++ci)
-			{
-				FPV.push_back(*ci);
-				bb.Add((*ci)->P(0));
-				bb.Add((*ci)->P(1));
-				bb.Add((*ci)->P(2));
-			}
-			if(bb.Diag()>minDiameter)
-			{
-				DeletedCC++;
-				typename std::vector<typename MeshType::FacePointer>::iterator fpvi;
-				for(fpvi=FPV.begin(); fpvi!=FPV.end(); ++fpvi)
-					tri::Allocator<MeshType>::DeleteFace(m,(**fpvi));
-			}
-		}
-		return std::make_pair(TotalCC,DeletedCC);
+		std::vector<int> faceCC;
+		std::vector<ConnectedComponentInfo> CCV;
+		int TotalCC=FaceVertexConnectedComponents(m, faceCC, CCV);
+		std::vector<bool> toDelete(CCV.size());
+		for(size_t i=0;i<CCV.size();++i)
+			toDelete[i] = CCV[i].bbox.Diag()>minDiameter;
+		return std::make_pair(TotalCC,DeleteConnectedComponents(m,faceCC,toDelete));
+	}
+
+	/// Delete the faces of the components flagged in toDelete (faceCC as computed by
+	/// FaceVertexConnectedComponents). Returns the number of deleted components.
+	static int DeleteConnectedComponents(MeshType &m, const std::vector<int> &faceCC, const std::vector<bool> &toDelete)
+	{
+		for(size_t i=0;i<m.face.size();++i)
+			if(faceCC[i]>=0 && toDelete[faceCC[i]])
+				tri::Allocator<MeshType>::DeleteFace(m,m.face[i]);
+		return int(std::count(toDelete.begin(),toDelete.end(),true));
 	}
 
 
@@ -2093,6 +2137,38 @@ public:
 		return selCnt;
 	}
 
+private:
+	// Root of the set of v, with path halving; concurrent calls only shorten paths.
+	static int UnionFindRoot(std::vector<std::atomic<int> > &parent, int v)
+	{
+		int p = parent[v].load(std::memory_order_relaxed);
+		while (p != v)
+		{
+			int gp = parent[p].load(std::memory_order_relaxed);
+			if (gp != p)
+				parent[v].compare_exchange_weak(p, gp, std::memory_order_relaxed);
+			v = p;
+			p = parent[v].load(std::memory_order_relaxed);
+		}
+		return v;
+	}
+
+	// Merge the sets of a and b linking the larger root below the smaller one;
+	// the link is retried whenever another thread has changed the root meanwhile.
+	static void UnionFindMerge(std::vector<std::atomic<int> > &parent, int a, int b)
+	{
+		for (;;)
+		{
+			a = UnionFindRoot(parent, a);
+			b = UnionFindRoot(parent, b);
+			if (a == b) return;
+			if (a < b) std::swap(a, b);
+			int expected = a;
+			if (parent[a].compare_exchange_strong(expected, b, std::memory_order_relaxed))
+				return;
+		}
+	}
+
 }; // end class
 /*@}*/
 
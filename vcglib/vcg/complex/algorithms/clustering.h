@@ -26,11 +26,15 @@
 
 #include<vcg/complex/complex.h>
 #include <vcg/complex/algorithms/clean.h>
+#include <vcg/complex/algorithms/radix_sort.h>
+#include <wrap/system/parallel.h>
 #include<vcg/space/triangle3.h>
 #include<vcg/space/index/grid_util.h>
 
 #include <iostream>
 #include <math.h>
+#include <algorithm>
+#include <vector>
 #include <unordered_set>
 #include <unordered_map>
 
@@ -143,6 +147,13 @@ public:
 
 /*
   Metodo di clustering
+
+  Every vertex (or face corner) is assigned to the grid cell it falls in; cells
+  are identified by a 64 bit key, the linear index of the cell. Keys are computed
+  in parallel, grouped with a stable radix sort and every cell is then reduced
+  independently, so the elements of a cell are always accumulated in their
+  original order and the result does not depend on the number of threads.
+  Clustered triangles are stored as triples of cell keys, sorted and made unique.
 */
 template<class MeshType, class CellType>
 class Clustering
@@ -155,6 +166,9 @@ class Clustering
   typedef typename MeshType::VertexPointer  VertexPointer;
   typedef typename MeshType::VertexIterator VertexIterator;
   typedef typename MeshType::FaceIterator   FaceIterator;
+  typedef unsigned long long CellKeyType;
+
+  Clustering() : DuplicateFaceParam(false) {}
 
   // DuplicateFace == bool means that during the clustering doublesided surface (like a thin shell) that would be clustered to a single surface
   // will be merged into two identical but opposite faces.
@@ -164,12 +178,11 @@ class Clustering
 
   bool DuplicateFaceParam;
 
-  // This class keeps the references to the three cells where a face has its vertexes.
+  // This class keeps the keys of the three cells where a face has its vertexes.
     class SimpleTri
   {
   public:
-    CellType *v[3];
-    int ii(int i) const {return *((int *)(&(v[i])));}
+    CellKeyType v[3];
     bool operator < ( const SimpleTri &p) const {
       return	(v[2]!=p.v[2])?(v[2]<p.v[2]):
                 (v[1]!=p.v[1])?(v[1]<p.v[1]):
@@ -195,12 +208,6 @@ class Clustering
           && (pt.v[1] == v[1])
           && (pt.v[2] == v[2]);
     }
-    // Hashing Function;
-    size_t operator () (const SimpleTri &pt) const
-    {
-     // return (ii(0)*HASH_P0 ^ ii(1)*HASH_P1 ^ ii(2)*HASH_P2);
-      return std::hash<CellType*>()(pt.v[0]) ^ std::hash<CellType*>()(pt.v[1]) ^ std::hash<CellType*>()(pt.v[2]);
-    }
   };
 
   // The init function Take two parameters
@@ -217,7 +224,8 @@ class Clustering
 
   void Init(Box3<ScalarType> _mbb, int _size, ScalarType _cellsize=0)
   {
-        GridCell.clear();
+        CellKeys.clear();
+        Cells.clear();
         TriSet.clear();
     Grid.bbox=_mbb;
     ///inflate the bb calculated
@@ -238,55 +246,75 @@ class Clustering
 
   BasicGrid<ScalarType> Grid;
 
-  std::unordered_set<SimpleTri,SimpleTri> TriSet;
-  typedef typename std::unordered_set<SimpleTri,SimpleTri>::iterator TriHashSetIterator;
-  std::unordered_map<Point3i,CellType> GridCell;
+  // The occupied cells sorted by key: Cells[i] is the cell with key CellKeys[i]
+  std::vector<CellKeyType> CellKeys;
+  std::vector<CellType> Cells;
+  // The clustered triangles, sorted and without duplicates
+  std::vector<SimpleTri> TriSet;
 
 
     void AddPointSet(MeshType &m, bool UseOnlySelected=false)
     {
-        for(VertexIterator vi=m.vert.begin();vi!=m.vert.end();++vi)
-            if(!(*vi).IsD())
-                if(!UseOnlySelected || (*vi).IsS())
-                    {
-                        Point3i pi;
-                        Grid.PToIP((*vi).cP(), pi );
-                        GridCell[pi].AddVertex(m,Grid,pi,*(vi));
-                    }
+        std::vector<KeyIndex> vk;
+        vk.reserve(m.vert.size());
+        for(size_t i=0;i<m.vert.size();++i)
+            if(!m.vert[i].IsD())
+                if(!UseOnlySelected || m.vert[i].IsS())
+                    vk.push_back(KeyIndex(0,i));
+
+        parallel::For(int(vk.size()),[&](int i){
+            vk[i].first=CellKey(m.vert[vk[i].second].cP());
+        });
+        SortByKey(vk);
+        AccumulateCells(vk,[&](CellType &c, CellKeyType k, size_t vi){
+            Point3i pi=KeyToIP(k);
+            c.AddVertex(m,Grid,pi,m.vert[vi]);
+        });
     }
 
   void AddMesh(MeshType &m)
   {
-    FaceIterator fi;
-    for(fi=m.face.begin();fi!=m.face.end();++fi) if(!(*fi).IsD())
-            {
-                Point3i pi;
-                SimpleTri st;
-                for(int i=0;i<3;++i)
-                {
-                    Grid.PToIP((*fi).cV(i)->cP(), pi );
-                    st.v[i]=&(GridCell[pi]);
-                    st.v[i]->AddFaceVertex(m,*(fi),i);
-                }
-                if( (st.v[0]!=st.v[1]) && (st.v[0]!=st.v[2]) && (st.v[1]!=st.v[2]) )
-                { // if we allow the duplication of faces we sort the vertex only partially (to maintain the original face orientation)
-                    if(DuplicateFaceParam) st.sortOrient();
-                                        else st.sort();
-                    TriSet.insert(st);
-                }
-            //  printf("Inserted %8i triangles, clustered to %8i tri and %i cells\n",distance(m.face.begin(),fi),TriSet.size(),GridCell.size());
-            }
+    std::vector<size_t> faceInd;
+    faceInd.reserve(m.face.size());
+    for(size_t i=0;i<m.face.size();++i)
+      if(!m.face[i].IsD()) faceInd.push_back(i);
+
+    // one entry for each face corner, the element index is 3*face+corner
+    const size_t fn=faceInd.size();
+    std::vector<KeyIndex> wk(3*fn);
+    std::vector<SimpleTri> tri(fn);
+    std::vector<char> valid(fn);
+    parallel::For(int(fn),[&](int i){
+      SimpleTri &st=tri[i];
+      for(int j=0;j<3;++j)
+      {
+        st.v[j]=CellKey(m.face[faceInd[i]].cV(j)->cP());
+        wk[3*i+j]=KeyIndex(st.v[j],3*i+j);
+      }
+      valid[i] = (st.v[0]!=st.v[1]) && (st.v[0]!=st.v[2]) && (st.v[1]!=st.v[2]);
+      // if we allow the duplication of faces we sort the vertex only partially (to maintain the original face orientation)
+      if(DuplicateFaceParam) st.sortOrient();
+                        else st.sort();
+    });
+
+    SortByKey(wk);
+    AccumulateCells(wk,[&](CellType &c, CellKeyType, size_t w){
+      c.AddFaceVertex(m,m.face[faceInd[w/3]],int(w%3));
+    });
+
+    for(size_t i=0;i<fn;++i)
+      if(valid[i]) TriSet.push_back(tri[i]);
+    SortUniqueTriangles();
   }
 
-  int CountPointSet() {return GridCell.size(); }
+  int CountPointSet() {return int(Cells.size()); }
 
   void SelectPointSet(MeshType &m)
   {
-        typename std::unordered_map<Point3i,CellType>::iterator gi;
                 UpdateSelection<MeshType>::VertexClear(m);
-        for(gi=GridCell.begin();gi!=GridCell.end();++gi)
+        for(size_t i=0;i<Cells.size();++i)
     {
-      VertexType *ptr=(*gi).second.Ptr();
+      VertexType *ptr=Cells[i].Ptr();
             if(ptr && ( ptr >= &*m.vert.begin() )  &&  ( ptr <= &*(m.vert.end() - 1) )  )
                     ptr->SetS();
     }
@@ -295,64 +323,166 @@ class Clustering
   {
     m.Clear();
 
-        if (GridCell.empty()) return;
-
-    Allocator<MeshType>::AddVertices(m,GridCell.size());
-    typename std::unordered_map<Point3i,CellType>::iterator gi;
-    int i=0;
-    for(gi=GridCell.begin();gi!=GridCell.end();++gi)
-    {
-      m.vert[i].P()=(*gi).second.Pos();
-      m.vert[i].N()=(*gi).second.N();
-     if(HasPerVertexColor(m))
-        m.vert[i].C()=(*gi).second.Col();
-            ++i;
-    }
+        if (Cells.empty()) return;
 
+    Allocator<MeshType>::AddVertices(m,Cells.size());
+    parallel::For(int(Cells.size()),[&](int i){
+      m.vert[i].P()=Cells[i].Pos();
+      m.vert[i].N()=Cells[i].N();
+      if(HasPerVertexColor(m))
+        m.vert[i].C()=Cells[i].Col();
+    });
   }
 
   void ExtractMesh(MeshType &m)
   {
     m.Clear();
 
-    if (GridCell.empty())  return;
+    if (Cells.empty())  return;
 
-    Allocator<MeshType>::AddVertices(m,GridCell.size());
-    typename std::unordered_map<Point3i,CellType>::iterator gi;
-    int i=0;
-    for(gi=GridCell.begin();gi!=GridCell.end();++gi)
-    {
-      m.vert[i].P()=(*gi).second.Pos();
-      m.vert[i].N()=(*gi).second.N();
+    Allocator<MeshType>::AddVertices(m,Cells.size());
+    parallel::For(int(Cells.size()),[&](int i){
+      m.vert[i].P()=Cells[i].Pos();
+      m.vert[i].N()=Cells[i].N();
       if(HasPerVertexColor(m))
-        m.vert[i].C()=(*gi).second.Col();
-      (*gi).second.id=i;
-      ++i;
-    }
+        m.vert[i].C()=Cells[i].Col();
+      Cells[i].id=int(i);
+    });
+
+    if (TriSet.empty())  return;
 
     Allocator<MeshType>::AddFaces(m,TriSet.size());
-    TriHashSetIterator ti;
-    i=0;
-    for(ti=TriSet.begin();ti!=TriSet.end();++ti)
-    {
-      m.face[i].V(0)=&(m.vert[(*ti).v[0]->id]);
-      m.face[i].V(1)=&(m.vert[(*ti).v[1]->id]);
-      m.face[i].V(2)=&(m.vert[(*ti).v[2]->id]);
+    parallel::For(int(TriSet.size()),[&](int i){
+      const SimpleTri &st=TriSet[i];
+      size_t ci[3];
+      for(int j=0;j<3;++j)
+      {
+        ci[j]=CellIndex(st.v[j]);
+        m.face[i].V(j)=&(m.vert[ci[j]]);
+      }
       // if we are merging faces even when opposite we choose
       // the best orientation according to the averaged normal
       if(!DuplicateFaceParam)
       {
-          CoordType N=TriangleNormal(m.face[i]);
-      int badOrient=0;
-      if( N.dot((*ti).v[0]->N()) <0) ++badOrient;
-      if( N.dot((*ti).v[1]->N()) <0) ++badOrient;
-      if( N.dot((*ti).v[2]->N()) <0) ++badOrient;
-      if(badOrient>2)
-          std::swap(m.face[i].V(0),m.face[i].V(1));
+        CoordType N=TriangleNormal(m.face[i]);
+        int badOrient=0;
+        if( N.dot(Cells[ci[0]].N()) <0) ++badOrient;
+        if( N.dot(Cells[ci[1]].N()) <0) ++badOrient;
+        if( N.dot(Cells[ci[2]].N()) <0) ++badOrient;
+        if(badOrient>2)
+        {
+          VertexPointer tmp = m.face[i].V(0);
+          m.face[i].V(0) = m.face[i].V(1);
+          m.face[i].V(1) = tmp;
+        }
+      }
+    });
+  }
+
+ private:
+  typedef std::pair<CellKeyType,size_t> KeyIndex;
+
+  // Cell keys are the linear index of the cell in the grid extended by one
+  // cell on every side; points outside it are clamped to the border cells.
+  CellKeyType CellKey(const CoordType &p) const
+  {
+    Point3i pi;
+    Grid.PToIP(p, pi);
+    CellKeyType k=0;
+    for(int i=0;i<3;++i)
+    {
+      int c = std::max(-1,std::min(Grid.siz[i],pi[i]));
+      k = k*CellKeyType(Grid.siz[i]+2) + CellKeyType(c+1);
+    }
+    return k;
+  }
+
+  Point3i KeyToIP(CellKeyType k) const
+  {
+    Point3i pi;
+    for(int i=2;i>=0;--i)
+    {
+      pi[i] = int(k % CellKeyType(Grid.siz[i]+2)) - 1;
+      k /= CellKeyType(Grid.siz[i]+2);
+    }
+    return pi;
+  }
+
+  size_t CellIndex(CellKeyType k) const
+  {
+    typename std::vector<CellKeyType>::const_iterator it=std::lower_bound(CellKeys.begin(),CellKeys.end(),k);
+    assert(it!=CellKeys.end() && *it==k);
+    return size_t(it-CellKeys.begin());
+  }
+
+  // Stable radix sort of the pairs by key
+  static void SortByKey(std::vector<KeyIndex> &v)
+  {
+    RadixSort(v,[](const KeyIndex &k){return uint64_t(k.first);});
+  }
+
+  // Given the pairs sorted by key, creates the cells that do not exist yet and
+  // calls add(cell,key,element) for every pair. Cells are reduced in parallel,
+  // the elements of each cell in their sorted (i.e. original) order.
+  template<class AddFunc>
+  void AccumulateCells(const std::vector<KeyIndex> &vk, AddFunc add)
+  {
+    std::vector<size_t> start;
+    for(size_t i=0;i<vk.size();++i)
+      if(i==0 || vk[i].first!=vk[i-1].first)
+        start.push_back(i);
+    const size_t groupNum=start.size();
+    start.push_back(vk.size());
+
+    std::vector<CellKeyType> newKeys;
+    for(size_t g=0;g<groupNum;++g)
+      if(!std::binary_search(CellKeys.begin(),CellKeys.end(),vk[start[g]].first))
+        newKeys.push_back(vk[start[g]].first);
+    if(!newKeys.empty())
+    {
+      std::vector<CellKeyType> keys(CellKeys.size()+newKeys.size());
+      std::vector<CellType> cells(keys.size());
+      size_t i=0,j=0;
+      for(size_t k=0;k<keys.size();++k)
+      {
+        if(j==newKeys.size() || (i<CellKeys.size() && CellKeys[i]<newKeys[j]))
+        {
+          keys[k]=CellKeys[i];
+          cells[k]=Cells[i++];
+        }
+        else keys[k]=newKeys[j++];
       }
-      i++;
+      CellKeys.swap(keys);
+      Cells.swap(cells);
     }
 
+    parallel::For(int(groupNum),[&](int g){
+      const CellKeyType k=vk[start[g]].first;
+      CellType &c=Cells[CellIndex(k)];
+      for(size_t i=start[g];i<start[g+1];++i)
+        add(c,k,vk[i].second);
+    });
+  }
+
+  // Sorts the triangles lexicographically with three stable radix sorts
+  // (last vertex first) and removes the duplicates.
+  void SortUniqueTriangles()
+  {
+    std::vector<KeyIndex> order(TriSet.size());
+    for(size_t i=0;i<order.size();++i) order[i].second=i;
+    for(int j=2;j>=0;--j)
+    {
+      parallel::For(int(order.size()),[&](int i){
+        order[i].first=TriSet[order[i].second].v[j];
+      });
+      SortByKey(order);
+    }
+    std::vector<SimpleTri> sorted(TriSet.size());
+    parallel::For(int(order.size()),[&](int i){
+      sorted[i]=TriSet[order[i].second];
+    });
+    sorted.erase(std::unique(sorted.begin(),sorted.end()),sorted.end());
+    TriSet.swap(sorted);
   }
 }; //end class clustering
  } // namespace tri
@@ -26,6 +26,8 @@
 
 #include <iostream>
 #include <list>
+#include <map>
+#include <vector>
 
 namespace vcg {
   namespace tri {
@@ -78,6 +80,7 @@ template <class MESH> class AdvancingFront {
   std::vector<int> nb; //number of fronts a vertex is into,
                        //this is used for the Visited and Border flags
                        //but adding topology may not be needed anymore
+  std::vector<std::vector<int> > vf; //faces around each vertex, kept only when the mesh has no VF adjacency
 
  public:
 
@@ -85,14 +88,15 @@ template <class MESH> class AdvancingFront {
 
   AdvancingFront(MESH &_mesh): mesh(_mesh) {
 
+    if(!tri::HasVFAdjacency(mesh))
+    {
+      vf.resize(mesh.vert.size());
+      for(size_t i = 0; i < mesh.face.size(); i++)
+        for(int k = 0; k < 3; k++)
+          vf[tri::Index(mesh,mesh.face[i].V(k))].push_back(int(i));
+    }
 
-    UpdateFlags<MESH>::FaceBorderFromNone(mesh);
-    UpdateFlags<MESH>::VertexBorderFromFaceBorder(mesh);
-
-    nb.clear();
-    nb.resize(mesh.vert.size(), 0);
-
-    CreateLoops();
+    ResetFront();
   }
   virtual ~AdvancingFront() {}
 
@@ -115,6 +119,20 @@ template <class MESH> class AdvancingFront {
     }
   }
 
+  //rebuild the front from the border of the faces of the mesh
+  void ResetFront()
+  {
+    UpdateFlags<MESH>::FaceBorderFromNone(mesh);
+    UpdateFlags<MESH>::VertexBorderFromFaceBorder(mesh);
+
+    front.clear();
+    deads.clear();
+    nb.clear();
+    nb.resize(mesh.vert.size(), 0);
+
+    CreateLoops();
+  }
+
 protected:
   //Implement these functions in your subclass
   enum ListID {FRONT,DEADS};
@@ -144,11 +162,16 @@ protected:
       (*s).previous = front.end();
       (*s).next = front.end();
     }
-    //now create loops:
+    //now create loops: the edges starting from each vertex, in front order
+    std::map<int, std::vector<std::list<FrontEdge>::iterator> > starting;
+    for(std::list<FrontEdge>::iterator s = front.begin(); s != front.end(); s++)
+      starting[(*s).v0].push_back(s);
     for(std::list<FrontEdge>::iterator s = front.begin(); s != front.end(); s++) {
-      for(std::list<FrontEdge>::iterator j = front.begin(); j != front.end(); j++) {
+      std::map<int, std::vector<std::list<FrontEdge>::iterator> >::iterator si = starting.find((*s).v1);
+      if(si == starting.end()) continue;
+      for(size_t i = 0; i < si->second.size(); i++) {
+        std::list<FrontEdge>::iterator j = si->second[i];
         if(s == j) continue;
-        if((*s).v1 != (*j).v0) continue;
         if((*j).previous != front.end()) continue;
         (*s).next = j;
         (*j).previous = s;
@@ -376,6 +399,12 @@ protected:
         (*fi).V(j)->VFi() = j;
       }
     }
+    else
+    {
+      vf.resize(mesh.vert.size());
+      for(int j=0;j<3;++j)
+        vf[tri::Index(mesh,(*fi).V(j))].push_back(int(tri::Index(mesh,*fi)));
+    }
   }
 
   void AddVertex(VertexType &vertex) {
@@ -384,7 +413,8 @@ protected:
     mesh.vert.push_back(vertex);
     mesh.vn++;
     VertexType *newstart = &*mesh.vert.begin();
-    if(oldstart && oldstart != newstart) {
+    FaceVectorSetVertexBase(mesh.face, mesh.vert);
+    if(oldstart && oldstart != newstart && !FaceType::HasVertexRefIdx()) {
       for(int i = 0; i < mesh.face.size(); i++) {
         FaceType &face = mesh.face[i];
         for(int k = 0; k < 3; k++)
@@ -392,6 +422,7 @@ protected:
       }
     }
     nb.push_back(0);
+    if(!vf.empty()) vf.push_back(std::vector<int>());
   }
 
   // Given a possible new edge v0-v1
@@ -417,8 +448,10 @@ protected:
       }
       return true;
     }
-    for(int i = 0; i < (int)mesh.face.size(); i++) {
-      FaceType &f = mesh.face[i];
+    //an edge with v0 can only be in the faces around v0
+    const std::vector<int> &faces = vf[v0];
+    for(size_t i = 0; i < faces.size(); i++) {
+      FaceType &f = mesh.face[faces[i]];
       for(int k = 0; k < 3; k++) {
         if(vv0 == f.V0(k) && vv1 == f.V1(k))  //orientation non constistent
            return false;
@@ -443,12 +476,10 @@ protected:
     if (e->active)
     {
         (*e).active = false;
-        //std::list<FrontEdge>::iterator res = std::find(front.begin(),front.end(),e);
-        FrontEdge tmp = *e;
+        //splice does not invalidate e, that now points into deads
         deads.splice(deads.end(), front, e);
-        std::list<FrontEdge>::iterator newe = std::find(deads.begin(),deads.end(),tmp);
-        tmp.previous->next = newe;
-        tmp.next->previous = newe;
+        (*e).previous->next = e;
+        (*e).next->previous = e;
     }
   }
 
@@ -27,6 +27,8 @@
 #include <vcg/space/index/kdtree/kdtree.h>
 
 #include <vcg/complex/algorithms/closest.h>
+#include <wrap/system/parallel.h>
+#include <algorithm>
 
 /* Ball pivoting algorithm:
    1) the vertices used in the new mesh are marked as visited
@@ -34,6 +36,8 @@
    3) the vector nb is used to keep track of the number of borders a vertex belongs to
    4) usedBit flag is used to select the points in the mesh already processed
 
+   BuildMeshPartitioned() is a variant for large point clouds: the space is split in cells
+   that are reconstructed in parallel, then a usual BuildMesh() stitches them together.
 */
 namespace vcg {
   namespace tri {
@@ -45,6 +49,7 @@ template <class MESH> class BallPivoting: public AdvancingFront<MESH> {
   typedef typename MESH::ScalarType     ScalarType;
   typedef typename MESH::VertexIterator     VertexIterator;
   typedef typename MESH::VertexType::CoordType   Point3x;
+  typedef Box3<ScalarType> BoxType;
 
   float radius;          //radius of the ball
   float min_edge;        //min length of an edge
@@ -61,7 +66,7 @@ template <class MESH> class BallPivoting: public AdvancingFront<MESH> {
 
     AdvancingFront<MESH>(_mesh), radius(_radius),
     min_edge(minr), max_edge(1.8), max_angle(cos(angle)),
-    last_seed(-1) {
+    last_seed(-1), ownUsedBit(true) {
 
     //compute bbox
     baricenter = Point3x(0, 0, 0);
@@ -79,28 +84,84 @@ template <class MESH> class BallPivoting: public AdvancingFront<MESH> {
     min_edge *= radius;
     max_edge *= radius;
 
-    VertexConstDataWrapper<MESH> ww(this->mesh);
-    tree = new KdTree<ScalarType>(ww);
-//    tree->setMaxNofNeighbors(16);
-
     usedBit = VertexType::NewBitFlag();
-    UpdateFlags<MESH>::VertexClear(this->mesh,usedBit);
-    UpdateFlags<MESH>::VertexClearV(this->mesh);
-
-    for(int i = 0; i < (int)this->mesh.face.size(); i++) {
-      FaceType &f = this->mesh.face[i];
-      if(f.IsD()) continue;
-      for(int k = 0; k < 3; k++) {
-        Mark(f.V(k));
-      }
-    }
+    Init();
   }
 
   ~BallPivoting() {
-    VertexType::DeleteBitFlag(usedBit);
+    if(ownUsedBit) VertexType::DeleteBitFlag(usedBit);
     delete tree;
   }
 
+  /* Partitioned reconstruction, for large point clouds.
+     The bounding box is split in cubic cells of about pointsPerCell points. A cell is
+     coloured with the parity of its coordinates, so that two cells of the same colour are
+     never adjacent, and the cells of a colour are reconstructed concurrently. Each cell works
+     on a private copy of the points (and of the faces built so far) within a margin around it,
+     so that its fronts continue from the faces of the cells already done; only the new faces
+     near the cell are kept. A final BuildMesh() stitches the fronts left across the cells.
+     The result does not depend on the number of threads, but it is not the same of BuildMesh().
+  */
+  void BuildMeshPartitioned(CallBackPos call = NULL, int pointsPerCell = 100000)
+  {
+    // faces are kept up to keep from the cell, the margin leaves room for two more edges
+    const ScalarType keep = 2*radius;
+    const ScalarType halo = keep + 2*max_edge;
+    const BoxType &bb = this->mesh.bbox;
+    const ScalarType side = std::max(ScalarType(8*halo),
+                                     ScalarType(bb.Diag()*sqrt(double(pointsPerCell)/std::max(1,this->mesh.vn))));
+
+    CellGrid grid;
+    grid.origin = bb.min;
+    grid.side = side;
+    for(int k = 0; k < 3; k++)
+      grid.siz[k] = std::max(1, int(ceil(bb.Dim()[k]/side)));
+
+    if(grid.siz[0] > 1 || grid.siz[1] > 1 || grid.siz[2] > 1)
+    {
+      std::vector<char> inFace(this->mesh.vert.size(), 0);
+      for(size_t i = 0; i < this->mesh.vert.size(); i++)
+        if(!this->mesh.vert[i].IsD())
+          grid.verts[grid.AddCell(this->mesh.vert[i].cP())].push_back(int(i));
+      for(size_t i = 0; i < this->mesh.face.size(); i++)
+        if(!this->mesh.face[i].IsD())
+          AddCellFace(grid, int(i), inFace);
+
+      std::vector<std::vector<int> > newFaces;
+      for(int color = 0; color < 8; color++)
+      {
+        // faces may have added cells with no vertices
+        newFaces.resize(grid.cells.size());
+        std::vector<int> cells;
+        for(size_t c = 0; c < grid.cells.size(); c++)
+          if(grid.Color(grid.cells[c]) == color)
+            cells.push_back(int(c));
+
+        if(call) (*call)(color*100/8, "Reconstructing cells");
+        parallel::For(int(cells.size()), [&](int i) {
+          BuildCell(grid, cells[i], keep, halo, inFace, newFaces[cells[i]]);
+        }, 0, "", 1);
+
+        for(size_t i = 0; i < cells.size(); i++)
+        {
+          std::vector<int> &nf = newFaces[cells[i]];
+          for(size_t j = 0; j < nf.size(); j += 3)
+          {
+            this->AddFace(nf[j], nf[j+1], nf[j+2]);
+            AddCellFace(grid, int(this->mesh.face.size()) - 1, inFace);
+          }
+          std::vector<int>().swap(nf);
+        }
+      }
+
+      // restart from the borders of all the cells
+      this->ResetFront();
+      MarkFaceVertices();
+      last_seed = -1;
+    }
+    this->BuildMesh(call);
+  }
+
   bool Seed(int &v0, int &v1, int &v2) {
     //get a sphere of neighbours
     while(++last_seed < (int)(this->mesh.vert.size())) {
@@ -320,21 +381,24 @@ template <class MESH> class BallPivoting: public AdvancingFront<MESH> {
       return -1;
     }
 
-    //test if id is in some border (to return touch
-    for(std::list<FrontEdge>::iterator k = this->front.begin(); k != this->front.end(); k++)
+    //test if id is in some border (to return touch); only border vertices can be
+    if(candidate->IsB())
     {
-      if((*k).v0 == candidateIndex)
+      for(std::list<FrontEdge>::iterator k = this->front.begin(); k != this->front.end(); k++)
       {
-        touch.first = AdvancingFront<MESH>::FRONT;
-        touch.second = k;
+        if((*k).v0 == candidateIndex)
+        {
+          touch.first = AdvancingFront<MESH>::FRONT;
+          touch.second = k;
+        }
       }
-    }
-    for(std::list<FrontEdge>::iterator k = this->deads.begin(); k != this->deads.end(); k++)
-    {
-      if((*k).v0 == candidateIndex)
+      for(std::list<FrontEdge>::iterator k = this->deads.begin(); k != this->deads.end(); k++)
       {
-        touch.first = AdvancingFront<MESH>::DEADS;
-        touch.second = k;
+        if((*k).v0 == candidateIndex)
+        {
+          touch.first = AdvancingFront<MESH>::DEADS;
+          touch.second = k;
+        }
       }
     }
 
@@ -346,9 +410,178 @@ template <class MESH> class BallPivoting: public AdvancingFront<MESH> {
  private:
   int last_seed;     //used for new seeds when front is empty
   int usedBit;       //use to detect if a vertex has been already processed.
+  bool ownUsedBit;   //false for the cells of BuildMeshPartitioned, that use the bit of the whole mesh
   Point3x baricenter;//used for the first seed.
   KdTree<ScalarType> *tree;
 
+  // cells of BuildMeshPartitioned
+  struct CellGrid
+  {
+    Point3x origin;
+    ScalarType side;
+    Point3i siz;
+    std::map<long long, int> index;         // cell key -> position in cells
+    std::vector<Point3i> cells;             // non empty cells
+    std::vector<std::vector<int> > verts;   // vertices in each cell
+    std::vector<std::vector<int> > faces;   // faces with the barycenter in each cell
+
+    Point3i CellOf(const Point3x &p) const {
+      Point3i c;
+      for(int k = 0; k < 3; k++)
+        c[k] = std::min(siz[k]-1, std::max(0, int(floor((p[k]-origin[k])/side))));
+      return c;
+    }
+    long long Key(const Point3i &c) const {
+      return c[0] + siz[0]*((long long)c[1] + siz[1]*(long long)c[2]);
+    }
+    int Find(const Point3i &c) const {
+      for(int k = 0; k < 3; k++)
+        if(c[k] < 0 || c[k] >= siz[k]) return -1;
+      typename std::map<long long, int>::const_iterator ci = index.find(Key(c));
+      return ci == index.end() ? -1 : ci->second;
+    }
+    int AddCell(const Point3x &p) {
+      const Point3i c = CellOf(p);
+      std::pair<typename std::map<long long, int>::iterator, bool> res = index.insert(std::make_pair(Key(c), int(cells.size())));
+      if(res.second) {
+        cells.push_back(c);
+        verts.push_back(std::vector<int>());
+        faces.push_back(std::vector<int>());
+      }
+      return res.first->second;
+    }
+    int Color(const Point3i &c) const {
+      return (c[0]&1) | ((c[1]&1)<<1) | ((c[2]&1)<<2);
+    }
+    BoxType Box(int i) const {
+      const Point3x p0 = origin + Point3x(cells[i][0], cells[i][1], cells[i][2])*side;
+      return BoxType(p0, p0 + Point3x(side, side, side));
+    }
+  };
+
+  // Used for the cells of BuildMeshPartitioned: same parameters and used bit of parent.
+  BallPivoting(MESH &_mesh, const BallPivoting &parent):
+    AdvancingFront<MESH>(_mesh), radius(parent.radius),
+    min_edge(parent.min_edge), max_edge(parent.max_edge), max_angle(parent.max_angle),
+    last_seed(-1), usedBit(parent.usedBit), ownUsedBit(false), baricenter(parent.baricenter) {
+    Init();
+  }
+
+  void Init() {
+    VertexConstDataWrapper<MESH> ww(this->mesh);
+    tree = new KdTree<ScalarType>(ww);
+//    tree->setMaxNofNeighbors(16);
+
+    UpdateFlags<MESH>::VertexClear(this->mesh,usedBit);
+    UpdateFlags<MESH>::VertexClearV(this->mesh);
+    MarkFaceVertices();
+  }
+
+  // Mark the vertices of the faces of the mesh. The neighbours of a batch of vertices are
+  // searched in parallel (the tree is only read), the flags are then set serially.
+  void MarkFaceVertices() {
+    std::vector<int> toMark;
+    std::vector<char> added(this->mesh.vert.size(), 0);
+    for(size_t i = 0; i < this->mesh.face.size(); i++) {
+      FaceType &f = this->mesh.face[i];
+      if(f.IsD()) continue;
+      for(int k = 0; k < 3; k++) {
+        const size_t vi = tri::Index(this->mesh, f.V(k));
+        if(!added[vi] && !f.V(k)->IsV()) {
+          added[vi] = 1;
+          toMark.push_back(int(vi));
+        }
+      }
+    }
+
+    const int batchSize = 1<<16;
+    std::vector<std::vector<int> > close(std::min<size_t>(batchSize, toMark.size()));
+    for(size_t b = 0; b < toMark.size(); b += batchSize) {
+      const int n = int(std::min<size_t>(batchSize, toMark.size() - b));
+      parallel::For(n, [&](int i) {
+        CloseVertices(this->mesh.vert[toMark[b+i]], close[i]);
+      });
+      for(int i = 0; i < n; i++) {
+        for(size_t j = 0; j < close[i].size(); j++)
+          this->mesh.vert[close[i][j]].SetUserBit(usedBit);
+        this->mesh.vert[toMark[b+i]].SetV();
+      }
+    }
+  }
+
+  void AddCellFace(CellGrid &grid, int fi, std::vector<char> &inFace) {
+    FaceType &f = this->mesh.face[fi];
+    grid.faces[grid.AddCell((f.cP(0)+f.cP(1)+f.cP(2))/3)].push_back(fi);
+    for(int k = 0; k < 3; k++)
+      inFace[tri::Index(this->mesh, f.V(k))] = 1;
+  }
+
+  // Reconstruct cell c on a copy of the points and faces within halo from it; the new faces
+  // whose barycenter is within keep from the cell are appended to newFaces as global vertex indices.
+  void BuildCell(const CellGrid &grid, int c, ScalarType keep, ScalarType halo,
+                 const std::vector<char> &inFace, std::vector<int> &newFaces) const {
+    const BoxType core = grid.Box(c);
+    BoxType region = core;  region.Offset(halo);
+    BoxType keepBox = core; keepBox.Offset(keep);
+
+    std::vector<int> gv, gf;
+    bool freePoints = false;
+    for(int dz = -1; dz <= 1; dz++)
+      for(int dy = -1; dy <= 1; dy++)
+        for(int dx = -1; dx <= 1; dx++) {
+          const int n = grid.Find(grid.cells[c] + Point3i(dx, dy, dz));
+          if(n < 0) continue;
+          for(size_t i = 0; i < grid.verts[n].size(); i++) {
+            const int vi = grid.verts[n][i];
+            if(!region.IsIn(this->mesh.vert[vi].cP())) continue;
+            gv.push_back(vi);
+            if(n == c && !inFace[vi]) freePoints = true;
+          }
+          for(size_t i = 0; i < grid.faces[n].size(); i++) {
+            const FaceType &f = this->mesh.face[grid.faces[n][i]];
+            if(region.IsIn(f.cP(0)) && region.IsIn(f.cP(1)) && region.IsIn(f.cP(2)))
+              gf.push_back(grid.faces[n][i]);
+          }
+        }
+    if(!freePoints || gv.size() < 4) return;
+    std::sort(gv.begin(), gv.end());
+    std::sort(gf.begin(), gf.end());
+
+    MESH cellMesh;
+    Allocator<MESH>::AddVertices(cellMesh, gv.size());
+    for(size_t i = 0; i < gv.size(); i++) {
+      cellMesh.vert[i].ImportData(this->mesh.vert[gv[i]]);
+      cellMesh.vert[i].Flags() = 0;
+    }
+    Allocator<MESH>::AddFaces(cellMesh, gf.size());
+    for(size_t i = 0; i < gf.size(); i++)
+      for(int k = 0; k < 3; k++) {
+        const int vi = int(tri::Index(this->mesh, this->mesh.face[gf[i]].cV(k)));
+        cellMesh.face[i].V(k) = &cellMesh.vert[std::lower_bound(gv.begin(), gv.end(), vi) - gv.begin()];
+      }
+    UpdateBounding<MESH>::Box(cellMesh);
+
+    BallPivoting<MESH> pivot(cellMesh, *this);
+    pivot.BuildMesh();
+
+    for(size_t i = gf.size(); i < cellMesh.face.size(); i++) {
+      const FaceType &f = cellMesh.face[i];
+      if(!keepBox.IsIn((f.cP(0)+f.cP(1)+f.cP(2))/3)) continue;
+      for(int k = 0; k < 3; k++)
+        newFaces.push_back(gv[tri::Index(cellMesh, f.cV(k))]);
+    }
+  }
+
+  // vertices of the mesh closer than min_edge to v, as found by Mark
+  void CloseVertices(const VertexType &v, std::vector<int> &close) const {
+    typename KdTree<ScalarType>::PriorityQueue pq;
+    tree->doQueryK(v.cP(),16,pq);
+    close.clear();
+    for (int i = 0; i < pq.getNofElements(); i++)
+      if(Distance(v.cP(),this->mesh.vert[pq.getIndex(i)].cP())<min_edge)
+        close.push_back(pq.getIndex(i));
+  }
+
 
   /* returns the sphere touching p0, p1, p2 of radius r such that
      the normal of the face points toward the center of the sphere */
@@ -415,14 +648,12 @@ template <class MESH> class BallPivoting: public AdvancingFront<MESH> {
   }
 
   void Mark(VertexType *v) {
-    typename KdTree<ScalarType>::PriorityQueue pq;
-    tree->doQueryK(v->cP(),16,pq);
-    int n = pq.getNofElements();
-    for (int i = 0; i < n; i++) {
-      VertexType *vp = &this->mesh.vert[pq.getIndex(i)];
-      if(Distance(v->cP(),vp->cP())<min_edge)
-        vp->SetUserBit(usedBit);
-    }
+    // a visited vertex has already marked its neighbours
+    if(v->IsV()) return;
+    std::vector<int> close;
+    CloseVertices(*v, close);
+    for (size_t i = 0; i < close.size(); i++)
+      this->mesh.vert[close[i]].SetUserBit(usedBit);
     v->SetV();
   }
 };
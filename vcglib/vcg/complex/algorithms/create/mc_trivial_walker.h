@@ -24,6 +24,9 @@
 #define __VCG_TRIVIAL_WALKER
 
 #include<vcg/space/index/grid_util.h>
+#include<algorithm>
+#include<unordered_map>
+#include<wrap/system/parallel.h>
 
 namespace vcg {
 
@@ -178,6 +181,9 @@ private:
     { 
       _bbox.SetNull();
       _slice_dimension=0;
+      _track_seams=false;
+      _keep_from_slice=0;
+      _warmup_vn=_warmup_fn=0;
     }
 
     template<class EXTRACTOR_TYPE>
@@ -211,6 +217,103 @@ private:
     _mesh		= NULL;
   }
 
+    // Slab parallel version of BuildMesh.
+    // The Y range of the extraction box is split in <slabNum> bands of slices; each band
+    // is walked by its own walker and extractor into a private mesh, then the bands are
+    // concatenated in order into <mesh>. Every band but the first also walks the slice
+    // preceding it (its output is discarded) so that it starts with the same cached edge
+    // vertices the serial walk would have; those vertices are shared with the previous
+    // band and are merged using their edge key. The result is the same mesh BuildMesh
+    // produces, up to vertex order, and depends only on the number of bands (chosen from
+    // the volume size when slabNum<=0), not on the number of threads.
+    // The volume must support concurrent reads and the extractor must be constructible
+    // from a (mesh, walker) pair, as MarchingCubes is.
+    template<class EXTRACTOR_TYPE>
+  void BuildMeshParallel(MeshType &mesh, VolumeType &volume, const float threshold, int slabNum=0, vcg::CallBackPos * cb=0)
+  {
+    Box3i box = _bbox;
+    if(box.IsNull() || _slice_dimension==0)
+      box = Box3i(Point3i(0,0,0),volume.ISize());
+    mesh.Clear();
+    const int firstSlice = box.min.Y();
+    const int sliceNum = (box.max.Y()-1)-1 - firstSlice; // same cells visited by BuildMesh
+    if(sliceNum<=0) return;
+    if(slabNum<=0) slabNum = std::min(64, std::max(1, sliceNum/16));
+    slabNum = std::min(slabNum, sliceNum);
+
+    std::vector<MeshType> slabMesh(slabNum);
+    std::vector<TrivialWalker> slabWalker(slabNum);
+    parallel::For(slabNum, [&](int s) {
+      Box3i slabBox = box;
+      const int keepFrom = firstSlice + (sliceNum*s)/slabNum;
+      slabBox.min.Y() = (s==0) ? keepFrom : keepFrom-1;
+      slabBox.max.Y() = firstSlice + (sliceNum*(s+1))/slabNum + 2;
+      TrivialWalker &w = slabWalker[s];
+      w.SetExtractionBox(slabBox);
+      w._track_seams = true;
+      w._keep_from_slice = keepFrom;
+      EXTRACTOR_TYPE extractor(slabMesh[s], w);
+      w.BuildMesh(slabMesh[s], volume, extractor, threshold);
+      w.ReleaseSlices();
+    }, cb, "Marching volume", 1);
+
+    // For each vertex of each band: -1 if it is a new vertex, -2 if it was produced
+    // only by the warm up slice, otherwise the index of the same vertex in the previous band.
+    std::vector<std::vector<VertexIndex> > dupOf(slabNum);
+    std::vector<int> newVertNum(slabNum), vertOffset(slabNum+1,0), faceOffset(slabNum+1,0);
+    parallel::For(slabNum, [&](int s) {
+      const TrivialWalker &w = slabWalker[s];
+      dupOf[s].assign(slabMesh[s].vert.size(),-1);
+      std::fill(dupOf[s].begin(),dupOf[s].begin()+w._warmup_vn,-2);
+      if(s>0)
+      {
+        std::unordered_map<long long,VertexIndex> prevSeam(slabWalker[s-1]._hi_seam.begin(),slabWalker[s-1]._hi_seam.end());
+        for(const auto &sv : w._lo_seam)
+        {
+          auto pi = prevSeam.find(sv.first);
+          dupOf[s][sv.second] = (pi!=prevSeam.end()) ? pi->second : -1;
+        }
+      }
+      newVertNum[s] = int(std::count(dupOf[s].begin(),dupOf[s].end(),-1));
+    }, 0, "", 1);
+    for(int s=0;s<slabNum;++s)
+    {
+      vertOffset[s+1] = vertOffset[s] + newVertNum[s];
+      faceOffset[s+1] = faceOffset[s] + int(slabMesh[s].face.size()) - slabWalker[s]._warmup_fn;
+    }
+    Allocator<MeshType>::AddVertices(mesh, vertOffset[slabNum]);
+    Allocator<MeshType>::AddFaces(mesh, faceOffset[slabNum]);
+
+    std::vector<std::vector<VertexIndex> > remap(slabNum);
+    parallel::For(slabNum, [&](int s) {
+      remap[s].assign(slabMesh[s].vert.size(),-1);
+      VertexIndex pos = vertOffset[s];
+      for(size_t i=0;i<slabMesh[s].vert.size();++i)
+        if(dupOf[s][i]==-1)
+        {
+          mesh.vert[pos].ImportData(slabMesh[s].vert[i]);
+          remap[s][i] = pos++;
+        }
+    }, 0, "", 1);
+    parallel::For(slabNum, [&](int s) {
+      for(size_t i=0;i<slabMesh[s].vert.size();++i)
+        if(dupOf[s][i]>=0)
+          remap[s][i] = remap[s-1][dupOf[s][i]];
+      const int warmupFN = slabWalker[s]._warmup_fn;
+      for(size_t i=warmupFN;i<slabMesh[s].face.size();++i)
+      {
+        typename MeshType::FaceType &f = mesh.face[faceOffset[s]+i-warmupFN];
+        f.ImportData(slabMesh[s].face[i]);
+        for(int j=0;j<3;++j)
+        {
+          assert(remap[s][tri::Index(slabMesh[s],slabMesh[s].face[i].V(j))]>=0);
+          f.V(j) = &mesh.vert[remap[s][tri::Index(slabMesh[s],slabMesh[s].face[i].V(j))]];
+        }
+      }
+      slabMesh[s].Clear();
+    }, 0, "", 1);
+  }
+
     float V(int pi, int pj, int pk)
     {
     return _volume->Val(pi, pj, pk)-_thr;
@@ -247,6 +350,7 @@ private:
                 _x_cs[index] = (VertexIndex) _mesh->vert.size();
                 pos = _x_cs[index];
                 Allocator<MeshType>::AddVertices( *_mesh, 1 );
+                if(_track_seams) TrackSeamVertex(p1, 0, index, pos);
                 v = &_mesh->vert[pos];
                 _volume->GetXIntercept(p1, p2, v, _thr);
                 return;
@@ -259,6 +363,7 @@ private:
                 _x_ns[index] = (VertexIndex) _mesh->vert.size();
                 pos = _x_ns[index];
                 Allocator<MeshType>::AddVertices( *_mesh, 1 );
+                if(_track_seams) TrackSeamVertex(p1, 0, index, pos);
                 v = &_mesh->vert[pos];
                 _volume->GetXIntercept(p1, p2, v,_thr);
                 return;
@@ -296,6 +401,7 @@ private:
                 _z_cs[index] = (VertexIndex) _mesh->vert.size();
                 pos = _z_cs[index];
                 Allocator<MeshType>::AddVertices( *_mesh, 1 );
+                if(_track_seams) TrackSeamVertex(p1, 1, index, pos);
                 v = &_mesh->vert[pos];
                 _volume->GetZIntercept(p1, p2, v,_thr);
                 return;
@@ -308,6 +414,7 @@ private:
                 _z_ns[index] = (VertexIndex) _mesh->vert.size();
                 pos = _z_ns[index];
                 Allocator<MeshType>::AddVertices( *_mesh, 1 );
+                if(_track_seams) TrackSeamVertex(p1, 1, index, pos);
                 v = &_mesh->vert[pos];
                 _volume->GetZIntercept(p1, p2, v,_thr);
                 return;
@@ -332,6 +439,27 @@ protected:
     VolumeType	*_volume;
 
   float _thr;
+
+    // Used by BuildMeshParallel. The slices before <_keep_from_slice> are walked only to warm up
+    // the edge caches: the vertices and faces created there (_warmup_vn, _warmup_fn) are dropped,
+    // except the X and Z edge vertices lying on <_keep_from_slice> (_lo_seam).
+    // _hi_seam are the X and Z edge vertices on the last slice. Both are (edge key, vertex index) pairs.
+    bool _track_seams;
+    int _keep_from_slice;
+    int _warmup_vn;
+    int _warmup_fn;
+    std::vector<std::pair<long long,VertexIndex> > _lo_seam;
+    std::vector<std::pair<long long,VertexIndex> > _hi_seam;
+
+    void TrackSeamVertex(const vcg::Point3i &p1, int axis, VertexIndex index, VertexIndex pos)
+    {
+        const long long key = 2*(long long)index + axis;
+        if (p1.Y()==_keep_from_slice && _current_slice<_keep_from_slice)
+            _lo_seam.push_back(std::make_pair(key,pos));
+        else if (p1.Y()==(_bbox.max.Y()-1)-1)
+            _hi_seam.push_back(std::make_pair(key,pos));
+    }
+
     void NextYSlice()
     {
         memset(_x_cs, -1, _slice_dimension*sizeof(VertexIndex));
@@ -342,11 +470,27 @@ protected:
         std::swap(_z_cs, _z_ns);
 
         _current_slice += 1;
+        if (_track_seams && _current_slice==_keep_from_slice)
+        {
+            _warmup_vn = int(_mesh->vert.size());
+            _warmup_fn = int(_mesh->face.size());
+        }
+    }
+
+    void ReleaseSlices()
+    {
+        delete [] _x_cs; delete [] _y_cs; delete [] _z_cs;
+        delete [] _x_ns; delete [] _z_ns;
+        _x_cs = _y_cs = _z_cs = _x_ns = _z_ns = NULL;
+        _slice_dimension = 0;
     }
 
     void Begin()
     {
         _current_slice = _bbox.min.Y();
+        _lo_seam.clear();
+        _hi_seam.clear();
+        _warmup_vn = _warmup_fn = 0;
 
         memset(_x_cs, -1, _slice_dimension*sizeof(VertexIndex));
         memset(_y_cs, -1, _slice_dimension*sizeof(VertexIndex));
@@ -473,13 +473,12 @@ bool Process(vcg::CallBackPos *cb=0)
             typedef vcg::tri::MarchingCubes<MCMesh, Walker>             MarchingCubes;
 
             Walker walker;
-            MarchingCubes	mc(me, walker);
             /**********************/
             if(cb) cb(50,"Step 2: Marching Cube...");
             else printf("Step 2: Marching Cube...\n");
             /**********************/
             walker.SetExtractionBox(VV.SubPartSafe);
-            walker.BuildMesh(me,VV,mc,0);
+            walker.template BuildMeshParallel<MarchingCubes>(me,VV,0);
 
             typename MCMesh::VertexIterator vi;
             Box3f bbb; bbb.Import(VV.SubPart);
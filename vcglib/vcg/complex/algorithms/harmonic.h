@@ -24,6 +24,8 @@
 #define __VCGLIB_HARMONIC_FIELD
 
 #include <vcg/complex/complex.h>
+#include <vcg/complex/algorithms/operator_cache.h>
+#include <wrap/system/parallel.h>
 #include <Eigen/Sparse>
 
 namespace vcg {
@@ -44,6 +46,34 @@ public:
     typedef typename std::vector<Constraint>         ConstraintVec;
     typedef typename ConstraintVec::const_iterator   ConstraintIt;
 
+    /**
+     * @brief The Cache class keeps the laplacian matrix and the factorization
+     * computed by the last call of ComputeScalarField that received it.
+     * When the mesh (topology and vertex positions) is unchanged the laplacian
+     * is not rebuilt, and if the constrained vertices are also the same the system
+     * is not factorized again: only the new constraint values are solved for.
+     * The cache is invalidated automatically when the mesh changes.
+     */
+    class Cache
+    {
+    public:
+        Cache() : valid(false) {}
+        void Clear()
+        {
+            valid = false;
+            key.Clear();
+            laplacian = Eigen::SparseMatrix<CoeffScalar>();
+            factorization.Clear();
+        }
+    private:
+        friend class Harmonic;
+        bool valid;
+        bool biharmonic;
+        MeshOperatorKey<MeshType> key;
+        Eigen::SparseMatrix<CoeffScalar> laplacian;
+        CachedFactorization<Eigen::SimplicialLDLT<Eigen::SparseMatrix<CoeffScalar> > > factorization;
+    };
+
     /**
      * @brief ComputeScalarField
      * Generates a scalar harmonic field over the mesh.
@@ -51,14 +81,14 @@ public:
      * @param m the mesh
      * @param constraints the Dirichlet boundary conditions in the form of vector of pairs <vertex pointer, value>.
      * @param field the accessor to use to write the computed per-vertex values (must have the [ ] operator).
+     * @param cache optional cache reused among calls on the same mesh (see Cache).
      * @return true if the algorithm succeeds, false otherwise.
      * @note the algorithm has unexpected behavior if the mesh contains unreferenced vertices.
      */
     template <typename ACCESSOR>
-    static bool ComputeScalarField(MeshType & m, const ConstraintVec & constraints, ACCESSOR field, bool biharmonic = false)
+    static bool ComputeScalarField(MeshType & m, const ConstraintVec & constraints, ACCESSOR field, bool biharmonic = false, Cache * cache = NULL)
     {
         typedef Eigen::SparseMatrix<CoeffScalar> SpMat;  // sparse matrix type
-        typedef Eigen::Triplet<CoeffScalar>      Triple; // triplet type to fill the matrix
 
         RequirePerVertexFlags(m);
         RequireCompactness(m);
@@ -71,57 +101,21 @@ public:
 
         int n  = m.VN();
 
-        // Generate coefficients
-        std::vector<Triple>          coeffs;   // coefficients of the system
-        std::map<size_t,CoeffScalar> sums;     // row sum of the coefficient matrix
-
-        vcg::tri::UpdateFlags<MeshType>::FaceClearV(m);
-        for (size_t i = 0; i < m.face.size(); ++i)
+        SpMat laplaceMat;        // the system to be solved
+        if (cache != NULL)
         {
-            FaceType & f = m.face[i];
-            assert(!f.IsV());
-
-            f.SetV();
-
-            // Generate coefficients for each edge
-            for (int edge = 0; edge < 3; ++edge)
+            if (!cache->valid || cache->biharmonic != biharmonic || !cache->key.Matches(m))
             {
-                CoeffScalar weight;
-                WeightInfo res = CotangentWeightIfNotVisited(f, edge, weight);
-
-                if (res == EdgeAlreadyVisited) continue;
-                assert(res == Success);
-
-                // Add the weight to the coefficients vector for both the vertices of the considered edge
-                size_t v0_idx = vcg::tri::Index(m, f.V0(edge));
-                size_t v1_idx = vcg::tri::Index(m, f.V1(edge));
-
-                coeffs.push_back(Triple(v0_idx, v1_idx, -weight));
-                coeffs.push_back(Triple(v1_idx, v0_idx, -weight));
-
-                // Add the weight to the row sum
-                sums[v0_idx] += weight;
-                sums[v1_idx] += weight;
+                cache->Clear();
+                LaplacianMatrix(m, cache->laplacian, biharmonic);
+                cache->valid      = true;
+                cache->biharmonic = biharmonic;
+                cache->key.Set(m);
             }
+            laplaceMat = cache->laplacian;
         }
-
-        // Setup the system matrix
-        SpMat laplaceMat;        // the system to be solved
-        laplaceMat.resize(n, n); // eigen initializes it to zero
-        laplaceMat.reserve(coeffs.size());
-        for (std::map<size_t,CoeffScalar>::const_iterator it = sums.begin(); it != sums.end(); ++it)
-        {
-            coeffs.push_back(Triple(it->first, it->first, it->second));
-        }
-        laplaceMat.setFromTriplets(coeffs.begin(), coeffs.end());
-
-        if (biharmonic)
-        {
-            SpMat lap_t = laplaceMat;
-            lap_t.transpose();
-            laplaceMat = lap_t * laplaceMat;
-        }
-
+        else
+            LaplacianMatrix(m, laplaceMat, biharmonic);
 
         // Setting the constraints
         const CoeffScalar alpha = pow(10.0, 8.0); // penalty factor alpha
@@ -138,8 +132,13 @@ public:
         }
 
         // Perform matrix decomposition
-        Eigen::SimplicialLDLT<SpMat> solver;
-        solver.compute(laplaceMat);
+        // (the penalties lie on the diagonal, so the pattern of the system only
+        // depends on the mesh and the symbolic analysis is reused by the cache)
+        CachedFactorization<Eigen::SimplicialLDLT<SpMat> > localFactorization;
+        CachedFactorization<Eigen::SimplicialLDLT<SpMat> > & factorization =
+                (cache != NULL) ? cache->factorization : localFactorization;
+        factorization.Factorize(laplaceMat);
+        Eigen::SimplicialLDLT<SpMat> & solver = factorization.Solver();
         // TODO eventually use another solver (e.g. CHOLMOD for dynamic setups)
         if(solver.info() != Eigen::Success)
         {
@@ -170,6 +169,84 @@ public:
         return true;
     }
 
+    /**
+     * @brief LaplacianMatrix builds the cotangent laplacian (or its square) of the mesh
+     * @param m the mesh
+     * @param laplaceMat the n x n output matrix
+     * @param biharmonic if true the bilaplacian is returned
+     * @note the mesh must have the face-face topology updated
+     */
+    static void LaplacianMatrix(MeshType & m, Eigen::SparseMatrix<CoeffScalar> & laplaceMat, bool biharmonic = false)
+    {
+        typedef Eigen::SparseMatrix<CoeffScalar> SpMat;  // sparse matrix type
+        typedef Eigen::Triplet<CoeffScalar>      Triple; // triplet type to fill the matrix
+
+        int n  = m.VN();
+
+        // The weight of an edge shared by two faces is computed only from the face
+        // with the lowest index; the weights are computed in parallel and then
+        // gathered in face order
+        std::vector<CoeffScalar> weights(m.face.size() * 3);
+        std::vector<char>        owned(m.face.size() * 3);
+        parallel::For(int(m.face.size()), [&](int i) {
+            const FaceType & f = m.face[i];
+            for (int edge = 0; edge < 3; ++edge)
+            {
+                const FaceType * fp = f.cFFp(edge);
+                owned[i*3+edge] = (fp == NULL || fp == &f || vcg::tri::Index(m, fp) > size_t(i));
+                if (owned[i*3+edge])
+                    weights[i*3+edge] = CotangentWeight<CoeffScalar>(f, edge);
+            }
+        });
+
+        // Generate coefficients
+        std::vector<Triple>      coeffs;   // coefficients of the system
+        std::vector<CoeffScalar> sums(n, 0); // row sum of the coefficient matrix
+        std::vector<bool>        hasSum(n, false);
+        coeffs.reserve(m.face.size() * 3 + n);
+
+        for (size_t i = 0; i < m.face.size(); ++i)
+        {
+            const FaceType & f = m.face[i];
+
+            // Generate coefficients for each edge
+            for (int edge = 0; edge < 3; ++edge)
+            {
+                if (!owned[i*3+edge]) continue;
+                CoeffScalar weight = weights[i*3+edge];
+
+                // Add the weight to the coefficients vector for both the vertices of the considered edge
+                size_t v0_idx = vcg::tri::Index(m, f.cV0(edge));
+                size_t v1_idx = vcg::tri::Index(m, f.cV1(edge));
+
+                coeffs.push_back(Triple(v0_idx, v1_idx, -weight));
+                coeffs.push_back(Triple(v1_idx, v0_idx, -weight));
+
+                // Add the weight to the row sum
+                sums[v0_idx] += weight;
+                sums[v1_idx] += weight;
+                hasSum[v0_idx] = hasSum[v1_idx] = true;
+            }
+        }
+
+        // Setup the system matrix
+        laplaceMat.resize(n, n); // eigen initializes it to zero
+        laplaceMat.reserve(coeffs.size());
+        for (int i = 0; i < n; ++i)
+        {
+            if (hasSum[i])
+                coeffs.push_back(Triple(i, i, sums[i]));
+        }
+        laplaceMat.setFromTriplets(coeffs.begin(), coeffs.end());
+
+        if (biharmonic)
+        {
+            SpMat lap_t = laplaceMat;
+            lap_t.transpose();
+            laplaceMat = lap_t * laplaceMat;
+        }
+    }
+
     enum WeightInfo
     {
         Success            = 0,
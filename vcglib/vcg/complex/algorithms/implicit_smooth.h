@@ -25,6 +25,7 @@
 
 #include <Eigen/Sparse>
 #include <vcg/complex/algorithms/mesh_to_matrix.h>
+#include <vcg/complex/algorithms/operator_cache.h>
 #include <vcg/complex/algorithms/update/quality.h>
 #include <vcg/complex/algorithms/smooth.h>
 
@@ -132,8 +133,7 @@ private:
 
     static void CollectHardConstraints(MeshType &mesh,const Parameter &SParam,
                                        std::vector<std::pair<int,int> > &IndexC,
-                                       std::vector<ScalarType> &WeightC,
-                                       bool SmoothQ=false)
+                                       std::vector<ScalarType> &WeightC)
     {
         std::vector<int> To_Fix;
 
@@ -157,21 +157,9 @@ private:
 
         for (size_t i=0;i<To_Fix.size();i++)
         {
-            if (!SmoothQ)
-            {
-                for (int j=0;j<3;j++)
-                {
-                    int IndexV=(To_Fix[i]*3)+j;
-                    IndexC.push_back(std::pair<int,int>(IndexV,IndexV));
-                    WeightC.push_back((ScalarType)PENALTY);
-                }
-            }else
-            {
-                int IndexV=To_Fix[i];
-                IndexC.push_back(std::pair<int,int>(IndexV,IndexV));
-                WeightC.push_back((ScalarType)PENALTY);
-            }
-
+            int IndexV=To_Fix[i];
+            IndexC.push_back(std::pair<int,int>(IndexV,IndexV));
+            WeightC.push_back((ScalarType)PENALTY);
         }
     }
 
@@ -180,7 +168,7 @@ private:
                                               std::vector<std::pair<int,int> > &IndexC,
                                               std::vector<ScalarType> &WeightC,
                                               std::vector<int> &IndexRhs,
-                                              std::vector<ScalarType> &ValueRhs)
+                                              std::vector<CoordType> &ValueRhs)
     {
         ScalarType penalty;
         int baseIndex=mesh.vert.size();
@@ -206,47 +194,34 @@ private:
                 //get the index of the current vertex
                 int FaceVert=vcg::tri::Index(mesh,mesh.face[FaceN].V(j));
 
-                //then add the constraints componentwise
-                for (int k=0;k<3;k++)
-                {
-                    //multiply times 3 per component
-                    int IndexV=(FaceVert*3)+k;
-
-                    //get the index of the current constraint
-                    int ComponentConstraint=(IndexConstraint*3)+k;
-                    IndexC.push_back(std::pair<int,int>(ComponentConstraint,IndexV));
-
-                    WeightC.push_back(currW*penalty);
-
-                    IndexC.push_back(std::pair<int,int>(IndexV,ComponentConstraint));
-                    WeightC.push_back(currW*penalty);
-
-                    //this to avoid the 1 on diagonal last entry of mass matrix
-                    IndexC.push_back(std::pair<int,int>(ComponentConstraint,ComponentConstraint));
-                    WeightC.push_back(-1);
-                }
-            }
-
-            for (int j=0;j<3;j++)
-            {
-                //get the index of the current constraint
-                int ComponentConstraint=(IndexConstraint*3)+j;
+                IndexC.push_back(std::pair<int,int>(IndexConstraint,FaceVert));
+                WeightC.push_back(currW*penalty);
 
-                //get per component value
-                ScalarType ComponentV=SParam.ConstrainedF[i].TargetPos.V(j);
+                IndexC.push_back(std::pair<int,int>(FaceVert,IndexConstraint));
+                WeightC.push_back(currW*penalty);
 
-                //add the diagonal value
-                IndexRhs.push_back(ComponentConstraint);
-                ValueRhs.push_back(ComponentV*penalty);
+                //this to avoid the 1 on diagonal last entry of mass matrix
+                IndexC.push_back(std::pair<int,int>(IndexConstraint,IndexConstraint));
+                WeightC.push_back(-1);
             }
 
+            //the right hand side, one column per component
+            IndexRhs.push_back(IndexConstraint);
+            ValueRhs.push_back(SParam.ConstrainedF[i].TargetPos*penalty);
         }
     }
 
 public:
 
+    //keeps the factorization of the last system between calls of Compute;
+    //when the mesh and the parameters are unchanged (e.g. uniform weights without
+    //mass matrix) the factorization is reused as it is, otherwise only the numeric
+    //factorization is recomputed as long as the connectivity is the same
+    typedef tri::CachedFactorization<Eigen::SimplicialCholesky<Eigen::SparseMatrix<ScalarType> > > Cache;
 
-    static void Compute(MeshType &mesh, Parameter &SParam)
+    //the three coordinates are smoothed with the same weights, so the system is
+    //built once per vertex and solved with one right hand side per component
+    static void Compute(MeshType &mesh, Parameter &SParam, Cache *cache=NULL)
     {
         //calculate the size of the system
         int matr_size=mesh.vert.size()+SParam.ConstrainedF.size();
@@ -260,66 +235,42 @@ public:
 
         //add the entries for mass matrix
         if (SParam.useMassMatrix)
-            MeshToMatrix<MeshType>::MassMatrixEntry(mesh,IndexM,ValuesM,!SParam.SmoothQ);
+            MeshToMatrix<MeshType>::MassMatrixEntry(mesh,IndexM,ValuesM,false);
 
         //then add entries for lagrange mult due to barycentric constraints
         for (size_t i=0;i<SParam.ConstrainedF.size();i++)
         {
-            int baseIndex=(mesh.vert.size()+i)*3;
-
-            if (SParam.SmoothQ)
-                baseIndex=(mesh.vert.size()+i);
-
-            if (SParam.SmoothQ)
-            {
-                IndexM.push_back(std::pair<int,int>(baseIndex,baseIndex));
-                ValuesM.push_back(1);
-            }
-            else
-            {
-                for (int j=0;j<3;j++)
-                {
-                    IndexM.push_back(std::pair<int,int>(baseIndex+j,baseIndex+j));
-                    ValuesM.push_back(1);
-                }
-            }
+            int baseIndex=(mesh.vert.size()+i);
+            IndexM.push_back(std::pair<int,int>(baseIndex,baseIndex));
+            ValuesM.push_back(1);
         }
         //add the hard constraints
-        CollectHardConstraints(mesh,SParam,IndexM,ValuesM,SParam.SmoothQ);
+        CollectHardConstraints(mesh,SParam,IndexM,ValuesM);
 
         //initialize sparse mass matrix
-        if (!SParam.SmoothQ)
-            InitSparse(IndexM,ValuesM,matr_size*3,matr_size*3,M);
-        else
-            InitSparse(IndexM,ValuesM,matr_size,matr_size,M);
+        InitSparse(IndexM,ValuesM,matr_size,matr_size,M);
 
         //initialize the barycentric matrix
         std::vector<std::pair<int,int> > IndexB;
         std::vector<ScalarType> ValuesB;
 
         std::vector<int> IndexRhs;
-        std::vector<ScalarType> ValuesRhs;
+        std::vector<CoordType> ValuesRhs;
 
         //then also collect hard constraints
         if (!SParam.SmoothQ)
-        {
             CollectBarycentricConstraints(mesh,SParam,IndexB,ValuesB,IndexRhs,ValuesRhs);
-            //initialize sparse constraint matrix
-            InitSparse(IndexB,ValuesB,matr_size*3,matr_size*3,B);
-        }
-        else
-            InitSparse(IndexB,ValuesB,matr_size,matr_size,B);
+
+        //initialize sparse constraint matrix
+        InitSparse(IndexB,ValuesB,matr_size,matr_size,B);
 
         //get the entries for laplacian matrix
         std::vector<std::pair<int,int> > IndexL;
         std::vector<ScalarType> ValuesL;
-        MeshToMatrix<MeshType>::GetLaplacianMatrix(mesh,IndexL,ValuesL,SParam.useCotWeight,SParam.lapWeight,!SParam.SmoothQ);
+        MeshToMatrix<MeshType>::GetLaplacianMatrix(mesh,IndexL,ValuesL,SParam.useCotWeight,SParam.lapWeight,false);
 
         //initialize sparse laplacian matrix
-        if (!SParam.SmoothQ)
-            InitSparse(IndexL,ValuesL,matr_size*3,matr_size*3,L);
-        else
-            InitSparse(IndexL,ValuesL,matr_size,matr_size,L);
+        InitSparse(IndexL,ValuesL,matr_size,matr_size,L);
 
         for (int i=0;i<(SParam.degree-1);i++)L=L*L;
 
@@ -327,63 +278,50 @@ public:
         Eigen::SparseMatrix<ScalarType> S = (M + B + SParam.lambda*L);
 
         //SimplicialLDLT
-        Eigen::SimplicialCholesky<Eigen::SparseMatrix<ScalarType > > solver(S);
-        assert(solver.info() == Eigen::Success);
+        Cache localCache;
+        if (cache==NULL) cache=&localCache;
+        cache->Factorize(S);
+        assert(cache->Solver().info() == Eigen::Success);
 
-        MatrixXm V;
-        if (!SParam.SmoothQ)
-            V=MatrixXm(matr_size*3,1);
-        else
-            V=MatrixXm(matr_size,1);
+        const int compN=SParam.SmoothQ?1:3;
+        MatrixXm V(matr_size,compN);
+        V.setZero();
 
         //set the first part of the matrix with vertex values
-        if (!SParam.SmoothQ)
+        for (int i=0;i<int(mesh.vert.size());i++)
         {
-            for (size_t i=0;i<mesh.vert.size();i++)
+            if (!SParam.SmoothQ)
             {
-                int index=i*3;
-                V(index,0)=mesh.vert[i].P().X();
-                V(index+1,0)=mesh.vert[i].P().Y();
-                V(index+2,0)=mesh.vert[i].P().Z();
-            }
-        }
-        else
-        {
-            for (size_t i=0;i<mesh.vert.size();i++)
-            {
-                int index=i;
-                V(index,0)=mesh.vert[i].Q();
+                V(i,0)=mesh.vert[i].P().X();
+                V(i,1)=mesh.vert[i].P().Y();
+                V(i,2)=mesh.vert[i].P().Z();
             }
+            else
+                V(i,0)=mesh.vert[i].Q();
         }
 
         //then set the second part by considering RHS gien by barycentric constraint
         for (size_t i=0;i<IndexRhs.size();i++)
         {
             int index=IndexRhs[i];
-            ScalarType val=ValuesRhs[i];
-            V(index,0)=val;
+            for (int j=0;j<compN;j++)
+                V(index,j)=ValuesRhs[i][j];
         }
 
         //solve the system
-        V = solver.solve(M*V).eval();
+        V = cache->Solver().solve(M*V).eval();
 
         //then copy back values
-        if (!SParam.SmoothQ)
+        for (int i=0;i<int(mesh.vert.size());i++)
         {
-            for (size_t i=0;i<mesh.vert.size();i++)
+            if (!SParam.SmoothQ)
             {
-                int index=i*3;
-                mesh.vert[i].P().X()=V(index,0);
-                mesh.vert[i].P().Y()=V(index+1,0);
-                mesh.vert[i].P().Z()=V(index+2,0);
-            }
-        }else
-        {
-            for (size_t i=0;i<mesh.vert.size();i++)
-            {
-                int index=i;
-                mesh.vert[i].Q()=V(index,0);
+                mesh.vert[i].P().X()=V(i,0);
+                mesh.vert[i].P().Y()=V(i,1);
+                mesh.vert[i].P().Z()=V(i,2);
             }
+            else
+                mesh.vert[i].Q()=V(i,0);
         }
     }
 };
@@ -35,6 +35,7 @@
 #include <vcg/complex/append.h>
 #include <vcg/complex/allocate.h>
 #include <wrap/io_trimesh/export.h>
+#include <wrap/system/parallel.h>
 
 namespace vcg {
 namespace tri {
@@ -572,13 +573,24 @@ private:
         return (int)(std::ceil(angleSumRad / (M_PI/3.0f)));
     }
 
-    static bool testHausdorff (MeshType & m, StaticGrid & grid, const std::vector<CoordType> & verts, const ScalarType maxD, const CoordType checkOrientation = CoordType(0,0,0))
+    // Closest face query that can be issued concurrently from many threads:
+    // the default FaceTmark marker writes into the faces of the mesh, so the grid
+    // is visited with the empty marker (faces may be tested twice, results are the same).
+    static FaceType * getClosestFaceReentrant(StaticGrid & grid, const CoordType & p, const ScalarType maxD, ScalarType & dist, CoordType & closest)
+    {
+        tri::EmptyTMark<MeshType> mf;
+        vcg::face::PointDistanceBaseFunctor<ScalarType> PDistFunct;
+        dist = maxD;
+        return grid.GetClosest(PDistFunct, mf, p, maxD, dist, closest);
+    }
+
+    static bool testHausdorff (MeshType & /*m*/, StaticGrid & grid, const std::vector<CoordType> & verts, const ScalarType maxD, const CoordType checkOrientation = CoordType(0,0,0))
     {
         for (CoordType v : verts)
         {
             CoordType closest, normal, ip;
             ScalarType dist = 0;
-            FaceType* fp = GetClosestFaceBase(m, grid, v, maxD, dist, closest);
+            FaceType* fp = getClosestFaceReentrant(grid, v, maxD, dist, closest);
 
             //you can't use this kind of orientation check, since when you stand on edges it fails
             if (fp == NULL || (checkOrientation != CoordType(0,0,0) && checkOrientation * fp->N() < 0.7))
@@ -669,55 +681,104 @@ private:
         return pos == start;
     }
 
+    // Returns the first edge of f that should be flipped, -1 if none.
+    // It only reads the mesh, so it can be evaluated concurrently on many faces.
+    static int findSwapEdge(FaceType & f, Params & params)
+    {
+        //			if (face::IsManifold(f, 0) && face::IsManifold(f, 1) && face::IsManifold(f, 2))
+        for (int i = 0; i < 3; ++i)
+        {
+            if (&f > f.cFFp(i))
+            {
+                PosType pi(&f, i);
+                CoordType swapEdgeMidPoint = (f.cP2(i) + f.cFFp(i)->cP2(f.cFFi(i))) / 2.;
+                std::vector<CoordType> toCheck(1, swapEdgeMidPoint);
+
+
+                if(((!params.selectedOnly) || (f.IsS() && f.cFFp(i)->IsS())) &&
+                        !face::IsBorder(f, i) &&
+                        face::IsManifold(f, i) && /*checkManifoldness(f, i) &&*/
+                        face::checkFlipEdgeNotManifold(f, i) &&
+                        testSwap(pi, params.creaseAngleCosThr) &&
+//                        face::CheckFlipEdge(f, i) &&
+                        face::CheckFlipEdgeNormal(f, i, params.creaseAngleRadThr) && //vcg::math::ToRad(5.)) &&
+                        (!params.surfDistCheck || testHausdorff(*params.mProject, params.grid, toCheck, params.maxSurfDist)))
+                    return i;
+            }
+        }
+        return -1;
+    }
+
     // Edge swap step: edges are flipped in order to optimize valence and triangle quality across the mesh
+    // The faces are tested in parallel, then the flips are done in face order skipping the ones
+    // that share a vertex with a flip already done in the same round: a flip changes only the
+    // valence and the adjacency of its four vertices, so the test of a vertex-disjoint flip is
+    // still valid. The skipped faces are tested again in the next round.
     static void ImproveValence(MeshType &m, Params &params)
     {
-        static ScalarType foldCheckRad = math::ToRad(5.);
         tri::UpdateTopology<MeshType>::FaceFace(m);
         tri::UpdateTopology<MeshType>::VertexFace(m);
-        ForEachFace(m, [&] (FaceType & f) {
-            //			if (face::IsManifold(f, 0) && face::IsManifold(f, 1) && face::IsManifold(f, 2))
-            for (int i = 0; i < 3; ++i)
+
+        std::vector<int> toTest;
+        for (size_t i = 0; i < m.face.size(); ++i)
+            if (!m.face[i].IsD())
+                toTest.push_back(int(i));
+
+        std::vector<char> vertUsed(m.vert.size(), 0);
+        std::vector<size_t> usedList;
+        std::vector<int> swapEdge;
+        while (!toTest.empty())
+        {
+            swapEdge.resize(toTest.size());
+            parallel::For(int(toTest.size()), [&](int k) {
+                swapEdge[k] = findSwapEdge(m.face[toTest[k]], params);
+            });
+
+            std::vector<int> deferred;
+            for (size_t k = 0; k < toTest.size(); ++k)
             {
-                if (&f > f.cFFp(i))
+                const int i = swapEdge[k];
+                if (i < 0)
+                    continue;
+                FaceType & f = m.face[toTest[k]];
+                FaceType* g = f.FFp(i);
+                int w = f.FFi(i);
+
+                const size_t quad[4] = { tri::Index(m, f.V0(i)), tri::Index(m, f.V1(i)),
+                                         tri::Index(m, f.V2(i)), tri::Index(m, g->V2(w)) };
+                if (vertUsed[quad[0]] || vertUsed[quad[1]] || vertUsed[quad[2]] || vertUsed[quad[3]])
                 {
-                    PosType pi(&f, i);
-                    CoordType swapEdgeMidPoint = (f.cP2(i) + f.cFFp(i)->cP2(f.cFFi(i))) / 2.;
-                    std::vector<CoordType> toCheck(1, swapEdgeMidPoint);
-
-
-                    if(((!params.selectedOnly) || (f.IsS() && f.cFFp(i)->IsS())) &&
-                            !face::IsBorder(f, i) &&
-                            face::IsManifold(f, i) && /*checkManifoldness(f, i) &&*/
-                            face::checkFlipEdgeNotManifold(f, i) &&
-                            testSwap(pi, params.creaseAngleCosThr) &&
-//                            face::CheckFlipEdge(f, i) &&
-                            face::CheckFlipEdgeNormal(f, i, params.creaseAngleRadThr) && //vcg::math::ToRad(5.)) &&
-                            (!params.surfDistCheck || testHausdorff(*params.mProject, params.grid, toCheck, params.maxSurfDist)))
-                    {
-                        //When doing the swap we need to preserve and update the crease info accordingly
-                        FaceType* g = f.cFFp(i);
-                        int w = f.FFi(i);
+                    deferred.push_back(toTest[k]);
+                    continue;
+                }
+                for (size_t vi : quad)
+                {
+                    vertUsed[vi] = 1;
+                    usedList.push_back(vi);
+                }
 
-                        bool creaseF = g->IsFaceEdgeS((w + 1) % 3);
-                        bool creaseG = f.IsFaceEdgeS((i + 1) % 3);
+                //When doing the swap we need to preserve and update the crease info accordingly
+                bool creaseF = g->IsFaceEdgeS((w + 1) % 3);
+                bool creaseG = f.IsFaceEdgeS((i + 1) % 3);
 
-                        face::FlipEdgeNotManifold(f, i);
+                face::FlipEdgeNotManifold(f, i);
 
-                        f.ClearFaceEdgeS((i + 1) % 3);
-                        g->ClearFaceEdgeS((w + 1) % 3);
+                f.ClearFaceEdgeS((i + 1) % 3);
+                g->ClearFaceEdgeS((w + 1) % 3);
 
-                        if (creaseF)
-                            f.SetFaceEdgeS(i);
-                        if (creaseG)
-                            g->SetFaceEdgeS(w);
+                if (creaseF)
+                    f.SetFaceEdgeS(i);
+                if (creaseG)
+                    g->SetFaceEdgeS(w);
 
-                        ++params.stat.flipNum;
-                        break;
-                    }
-                }
+                ++params.stat.flipNum;
             }
-        });
+
+            for (size_t vi : usedList)
+                vertUsed[vi] = 0;
+            usedList.clear();
+            toTest.swap(deferred);
+        }
     }
 
     // The predicate that defines which edges should be split
@@ -807,21 +868,23 @@ private:
 
         int incidentFeatures = 0;
 
-        vcg::tri::UnMarkAll(*params.m);
+        // the feature vertices already counted; a local list instead of the mesh marks,
+        // so that the collapse tests can run concurrently
+        std::vector<VertexType*> featureVerts;
 
         for (size_t i = 0; i < faces.size(); ++i)
         {
-            if (faces[i]->IsFaceEdgeS(VtoE(vIdxes[i], (vIdxes[i]+1)%3)) && !vcg::tri::IsMarked(*params.m, faces[i]->cV1(vIdxes[i])))
+            if (faces[i]->IsFaceEdgeS(VtoE(vIdxes[i], (vIdxes[i]+1)%3)) && std::find(featureVerts.begin(), featureVerts.end(), faces[i]->cV1(vIdxes[i])) == featureVerts.end())
             {
-				vcg::tri::Mark(*params.m,faces[i]->V1(vIdxes[i]));
+                featureVerts.push_back(faces[i]->V1(vIdxes[i]));
                 incidentFeatures++;
                 CoordType movingEdgeVector0 = (faces[i]->cP1(vIdxes[i]) - faces[i]->cP(vIdxes[i])).Normalize();
                 if (std::fabs(movingEdgeVector0 * dEdgeVector) < .9f || !p.IsEdgeS())
                     return false;
             }
-            if (faces[i]->IsFaceEdgeS(VtoE(vIdxes[i], (vIdxes[i]+2)%3)) && !vcg::tri::IsMarked(*params.m, faces[i]->cV2(vIdxes[i])))
+            if (faces[i]->IsFaceEdgeS(VtoE(vIdxes[i], (vIdxes[i]+2)%3)) && std::find(featureVerts.begin(), featureVerts.end(), faces[i]->cV2(vIdxes[i])) == featureVerts.end())
             {
-				vcg::tri::Mark(*params.m,faces[i]->V2(vIdxes[i]));
+                featureVerts.push_back(faces[i]->V2(vIdxes[i]));
                 incidentFeatures++;
                 CoordType movingEdgeVector1 = (faces[i]->cP2(vIdxes[i]) - faces[i]->cP(vIdxes[i])).Normalize();
                 if (std::fabs(movingEdgeVector1 * dEdgeVector) < .9f || !p.IsEdgeS())
@@ -934,7 +997,8 @@ private:
         return false;
     }
 
-    static bool testCollapse1(PosType &p, VertexPair & pair, Point3<ScalarType> &mp, ScalarType minQ, ScalarType maxQ, Params &params, bool relaxed = false)
+    // the cheap part of testCollapse1: the edge (or its face) is small enough to be collapsed
+    static bool isCollapseCandidate(PosType &p, ScalarType minQ, ScalarType maxQ, Params &params)
     {
         ScalarType quality = (((math::Abs(p.V()->Q())+math::Abs(p.VFlip()->Q()))/(ScalarType)2.0)-minQ)/(maxQ-minQ);
         ScalarType mult = computeLengthThrMult(params, quality);
@@ -942,7 +1006,12 @@ private:
 
         ScalarType dist = Distance(p.V()->P(), p.VFlip()->P());
         ScalarType area = DoubleArea(*(p.F()))/2.f;
-        if(relaxed || (dist < thr || area < params.minLength*params.minLength/100.f))//if to collapse
+        return dist < thr || area < params.minLength*params.minLength/100.f;
+    }
+
+    static bool testCollapse1(PosType &p, VertexPair & pair, Point3<ScalarType> &mp, ScalarType minQ, ScalarType maxQ, Params &params, bool relaxed = false)
+    {
+        if(relaxed || isCollapseCandidate(p, minQ, maxQ, params))//if to collapse
         {
             return checkCollapseFacesAroundVert1(p, pair, mp, params, relaxed);
         }
@@ -982,10 +1051,14 @@ private:
 
     //The actual collapse step: foreach edge it is collapse iff TestCollapse returns true AND
     // the linkConditions are preserved
+    // The pass runs in rounds. Each round picks, in face order, the first short edge of each face
+    // whose vertex stars do not overlap the stars of the edges already picked; the quality and
+    // link tests read only those stars, so all the picked edges are tested in parallel and the ones
+    // that pass are collapsed. Faces skipped for an overlap, or whose edge failed the tests (from
+    // their next edge), are considered again in the next round.
     static void CollapseShortEdges(MeshType &m, Params &params)
     {
         ScalarType minQ, maxQ;
-        int candidates = 0;
 
         if(params.adapt)
             computeVQualityDistrMinMax(m, minQ, maxQ);
@@ -1003,25 +1076,83 @@ private:
 
             //FROM NOW ON VSelection is NotManifold
 
-            for(auto fi=m.face.begin(); fi!=m.face.end(); ++fi)
-                if(!(*fi).IsD() && (params.selectedOnly == false || fi->IsS()))
+            // faces to consider, with the first edge to consider
+            std::vector<std::pair<int,int> > toTest;
+            for(size_t i=0; i<m.face.size(); ++i)
+                if(!m.face[i].IsD() && (params.selectedOnly == false || m.face[i].IsS()))
+                    toTest.push_back(std::make_pair(int(i), 0));
+
+            std::vector<char> faceUsed(m.face.size(), 0);
+            std::vector<size_t> usedList;
+            std::vector<FaceType*> ff, ff1;
+            std::vector<int> vi;
+            while(!toTest.empty())
+            {
+                std::vector<std::pair<int,int> > picked, deferred;
+                for(const std::pair<int,int> & t : toTest)
                 {
-                    for(auto i=0; i<3; ++i)
+                    FaceType & f = m.face[t.first];
+                    if(f.IsD())
+                        continue;
+                    int e = t.second;
+                    for(; e<3; ++e)
                     {
-                        PosType pi(&*fi, i);
-                        ++candidates;
-                        VertexPair  bp = VertexPair(pi.V(), pi.VFlip());
-                        Point3<ScalarType> mp = (pi.V()->P()+pi.VFlip()->P())/2.f;
-
-                        if(testCollapse1(pi, bp, mp, minQ, maxQ, params) && Collapser::LinkConditions(bp))
-                        {
-                            Collapser::Do(m, bp, mp, true);
-                            ++params.stat.collapseNum;
+                        PosType pi(&f, e);
+                        if(isCollapseCandidate(pi, minQ, maxQ, params))
                             break;
-                        }
+                    }
+                    if(e == 3)
+                        continue;
+
+                    // the faces around the two vertices of the edge
+                    face::VFStarVF<FaceType>(f.V0(e), ff, vi);
+                    face::VFStarVF<FaceType>(f.V1(e), ff1, vi);
+                    ff.insert(ff.end(), ff1.begin(), ff1.end());
+                    bool overlap = false;
+                    for(size_t j=0; j<ff.size() && !overlap; ++j)
+                        overlap = faceUsed[tri::Index(m, ff[j])] != 0;
+                    if(overlap)
+                    {
+                        deferred.push_back(std::make_pair(t.first, e));
+                        continue;
+                    }
+                    for(FaceType * fp : ff)
+                    {
+                        faceUsed[tri::Index(m, fp)] = 1;
+                        usedList.push_back(tri::Index(m, fp));
+                    }
+                    picked.push_back(std::make_pair(t.first, e));
+                }
 
+                const int n = int(picked.size());
+                std::vector<VertexPair> collapsePair(n);
+                std::vector<CoordType> collapsePos(n);
+                std::vector<char> collapseOk(n);
+                parallel::For(n, [&](int k) {
+                    PosType pi(&m.face[picked[k].first], picked[k].second);
+                    collapsePair[k] = VertexPair(pi.V(), pi.VFlip());
+                    collapsePos[k] = (pi.V()->P()+pi.VFlip()->P())/2.f;
+                    collapseOk[k] = checkCollapseFacesAroundVert1(pi, collapsePair[k], collapsePos[k], params, false) &&
+                                    Collapser::LinkConditions(collapsePair[k]);
+                });
+
+                for(int k=0; k<n; ++k)
+                {
+                    if(collapseOk[k])
+                    {
+                        Collapser::Do(m, collapsePair[k], collapsePos[k], true);
+                        ++params.stat.collapseNum;
                     }
+                    else if(picked[k].second < 2)
+                        deferred.push_back(std::make_pair(picked[k].first, picked[k].second + 1));
                 }
+
+                for(size_t fi : usedList)
+                    faceUsed[fi] = 0;
+                usedList.clear();
+                std::sort(deferred.begin(), deferred.end());
+                toTest.swap(deferred);
+            }
         }
         ss.pop();
     }
@@ -1348,13 +1479,17 @@ private:
 //                }
 //            }
 
-            for (auto vi = m.vert.begin(); vi != m.vert.end(); ++vi)
-                if (!(*vi).IsD() && TD[*vi].cnt > 0)
+            // each vertex reads only its own accumulated info: the (expensive) surface checks run in parallel
+            parallel::For(int(m.vert.size()), [&](int vInd)
+            {
+                VertexType & v = m.vert[vInd];
+                if (!v.IsD() && TD[v].cnt > 0 && v.IsS())
                 {
-                    std::vector<CoordType> newPos(1, TD[*vi].sum);
-                    if ((*vi).IsS() && testHausdorff(*params.mProject, params.grid, newPos, params.maxSurfDist))
-                        (*vi).P() = (*vi).P() * (1-delta) + TD[*vi].sum * (delta);
+                    std::vector<CoordType> newPos(1, TD[v].sum);
+                    if (testHausdorff(*params.mProject, params.grid, newPos, params.maxSurfDist))
+                        v.P() = v.P() * (1-delta) + TD[v].sum * (delta);
                 }
+            });
         } // end step
     }
 
@@ -1405,18 +1540,21 @@ private:
     //		crease verts should reproject only on creases.
     static void ProjectToSurface(MeshType &m, Params & params)
     {
-        for(auto vi=m.vert.begin();vi!=m.vert.end();++vi)
-            if(!(*vi).IsD())
+        parallel::For(int(m.vert.size()), [&](int vInd)
+        {
+            VertexType & v = m.vert[vInd];
+            if(!v.IsD())
             {
-                Point3<ScalarType> newP, normP, barP;
+                Point3<ScalarType> newP;
                 ScalarType maxDist = params.maxSurfDist * 2.5f, minDist = 0.f;
-                FaceType* fp = GetClosestFaceBase(*params.mProject, params.grid, vi->cP(), maxDist, minDist, newP/*, normP, barP*/);
+                FaceType* fp = getClosestFaceReentrant(params.grid, v.cP(), maxDist, minDist, newP);
 
                 if (fp != NULL)
                 {
-                    vi->P() = newP;
+                    v.P() = newP;
                 }
             }
+        });
     }
 };
 } // end namespace tri
@@ -0,0 +1,80 @@
+/****************************************************************************
+* VCGLib                                                            o o     *
+* Visual and Computer Graphics Library                            o     o   *
+*                                                                _   O  _   *
+* Copyright(C) 2004-2016                                           \/)\/    *
+* Visual Computing Lab                                            /\/|      *
+* ISTI - Italian National Research Council                           |      *
+*                                                                    \      *
+* All rights reserved.                                                      *
+*                                                                           *
+* This program is free software; you can redistribute it and/or modify      *
+* it under the terms of the GNU General Public License as published by      *
+* the Free Software Foundation; either version 2 of the License, or         *
+* (at your option) any later version.                                       *
+*                                                                           *
+* This program is distributed in the hope that it will be useful,           *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)          *
+* for more details.                                                         *
+*                                                                           *
+****************************************************************************/
+#ifndef __VCG_TRI_MEMORY_USAGE
+#define __VCG_TRI_MEMORY_USAGE
+
+#include <vcg/complex/complex.h>
+
+namespace vcg {
+namespace tri {
+
+/** Bytes allocated by the element containers and the user attributes of a mesh.
+    The containers are measured by their capacity; for the optional component vectors
+    (vertex::vector_ocf and face::vector_ocf) the enabled components are included.
+    Memory allocated by the elements themselves (e.g. polygonal faces) is not counted.
+*/
+template <class MeshType>
+class MemoryUsage
+{
+public:
+    static size_t Vertex(const MeshType &m) { return Container(m.vert); }
+    static size_t Edge(const MeshType &m)   { return Container(m.edge); }
+    static size_t Face(const MeshType &m)   { return Container(m.face); }
+    static size_t Tetra(const MeshType &m)  { return Container(m.tetra); }
+
+    static size_t Attribute(const MeshType &m)
+    {
+        return AttributeSet(m.vert_attr, m.vert.size()) +
+               AttributeSet(m.edge_attr, m.edge.size()) +
+               AttributeSet(m.face_attr, m.face.size()) +
+               AttributeSet(m.tetra_attr, m.tetra.size()) +
+               AttributeSet(m.mesh_attr, 1);
+    }
+
+    static size_t Total(const MeshType &m)
+    {
+        return Vertex(m) + Edge(m) + Face(m) + Tetra(m) + Attribute(m);
+    }
+
+private:
+    template <class T>
+    static size_t Container(const std::vector<T> &c) { return c.capacity() * sizeof(T); }
+    template <class T>
+    static size_t Container(const vertex::vector_ocf<T> &c) { return c.MemoryUsage(); }
+    template <class T>
+    static size_t Container(const face::vector_ocf<T> &c) { return c.MemoryUsage(); }
+
+    static size_t AttributeSet(const std::set<PointerToAttribute> &attr, size_t n)
+    {
+        size_t bytes = 0;
+        for (std::set<PointerToAttribute>::const_iterator ai = attr.begin(); ai != attr.end(); ++ai)
+            if (ai->_handle != 0)
+                bytes += n * ai->_handle->SizeOf();
+        return bytes;
+    }
+};
+
+} // end namespace tri
+} // end namespace vcg
+
+#endif // __VCG_TRI_MEMORY_USAGE
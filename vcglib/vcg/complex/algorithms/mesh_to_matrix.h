@@ -313,6 +313,52 @@ public:
     {
         if (cotangent) vcg::tri::MeshAssert<MeshType>::OnlyTriFace(mesh);
 
+        const size_t base=index.size();
+        index.resize(base+LaplacianEntryNum(f,vertexCoord));
+        entry.resize(index.size());
+        SetLaplacianEntry(mesh,f,&index[base],&entry[base],cotangent,weight,vertexCoord);
+    }
+
+
+    static void GetLaplacianMatrix(MeshType &mesh,
+                                   std::vector<std::pair<int,int> > &index,
+                                   std::vector<ScalarType> &entry,
+                                   bool cotangent,
+                                   ScalarType weight = 1,
+                                   bool vertexCoord=true )
+    {
+        if (cotangent) vcg::tri::MeshAssert<MeshType>::OnlyTriFace(mesh);
+
+        //each face writes its entries in its own slot, so the order is
+        //the same as a sequential visit of the faces
+        std::vector<size_t> offset(mesh.face.size()+1,index.size());
+        for (size_t i=0;i<mesh.face.size();i++)
+            offset[i+1]=offset[i]+LaplacianEntryNum(mesh.face[i],vertexCoord);
+        index.resize(offset.back());
+        entry.resize(offset.back());
+
+        //store the index and the scalar for the sparse matrix
+        parallel::For(int(mesh.face.size()), [&](int i) {
+            if (offset[i+1]!=offset[i])
+                SetLaplacianEntry(mesh,mesh.face[i],&index[offset[i]],&entry[offset[i]],cotangent,weight,vertexCoord);
+        });
+    }
+
+private:
+
+    static size_t LaplacianEntryNum(const FaceType &f, bool vertexCoord)
+    {
+        return size_t(f.VN())*(vertexCoord?12:4);
+    }
+
+    static void SetLaplacianEntry(MeshType &mesh,
+                                  FaceType &f,
+                                  std::pair<int,int> *index,
+                                  ScalarType *entry,
+                                  bool cotangent,
+                                  ScalarType weight,
+                                  bool vertexCoord)
+    {
         for (int i=0;i<f.VN();i++)
         {
 
@@ -325,59 +371,27 @@ public:
             int indexV0=Index(mesh,f.V0(i));
             int indexV1=Index(mesh,f.V1(i));
 
-            if (vertexCoord)
+            //then assemble the matrix, one component at a time
+            //(multiplied by 3) if the vertex coordinates are stored
+            const int compN=vertexCoord?3:1;
+            for (int j=0;j<compN;j++)
             {
-                //then assemble the matrix
-                for (int j=0;j<3;j++)
-                {
-                    //multiply by 3 and add the component
-                    int currI0=(indexV0*3)+j;
-                    int currI1=(indexV1*3)+j;
-
-                    index.push_back(std::pair<int,int>(currI0,currI0));
-                    entry.push_back(weight);
-                    index.push_back(std::pair<int,int>(currI0,currI1));
-                    entry.push_back(-weight);
-
-                    index.push_back(std::pair<int,int>(currI1,currI1));
-                    entry.push_back(weight);
-                    index.push_back(std::pair<int,int>(currI1,currI0));
-                    entry.push_back(-weight);
-                }
-            }
-            else
-            {
-                int currI0=(indexV0);
-                int currI1=(indexV1);
-
-                index.push_back(std::pair<int,int>(currI0,currI0));
-                entry.push_back(weight);
-                index.push_back(std::pair<int,int>(currI0,currI1));
-                entry.push_back(-weight);
-
-                index.push_back(std::pair<int,int>(currI1,currI1));
-                entry.push_back(weight);
-                index.push_back(std::pair<int,int>(currI1,currI0));
-                entry.push_back(-weight);
+                int currI0=(indexV0*compN)+j;
+                int currI1=(indexV1*compN)+j;
+
+                *index++=std::pair<int,int>(currI0,currI0);
+                *entry++=weight;
+                *index++=std::pair<int,int>(currI0,currI1);
+                *entry++=-weight;
+
+                *index++=std::pair<int,int>(currI1,currI1);
+                *entry++=weight;
+                *index++=std::pair<int,int>(currI1,currI0);
+                *entry++=-weight;
             }
         }
     }
 
-
-    static void GetLaplacianMatrix(MeshType &mesh,
-                                   std::vector<std::pair<int,int> > &index,
-                                   std::vector<ScalarType> &entry,
-                                   bool cotangent,
-                                   ScalarType weight = 1,
-                                   bool vertexCoord=true )
-    {
-        //store the index and the scalar for the sparse matrix
-        for (size_t i=0;i<mesh.face.size();i++)
-            GetLaplacianEntry(mesh,mesh.face[i],index,entry,cotangent,weight,vertexCoord);
-    }
-
-
-
 };
 
 } // end namespace tri
@@ -0,0 +1,163 @@
+/****************************************************************************
+* VCGLib                                                            o o     *
+* Visual and Computer Graphics Library                            o     o   *
+*                                                                _   O  _   *
+* Copyright(C) 2004-2016                                           \/)\/    *
+* Visual Computing Lab                                            /\/|      *
+* ISTI - Italian National Research Council                           |      *
+*                                                                    \      *
+* All rights reserved.                                                      *
+*                                                                           *
+* This program is free software; you can redistribute it and/or modify      *
+* it under the terms of the GNU General Public License as published by      *
+* the Free Software Foundation; either version 2 of the License, or         *
+* (at your option) any later version.                                       *
+*                                                                           *
+* This program is distributed in the hope that it will be useful,           *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)          *
+* for more details.                                                         *
+*                                                                           *
+****************************************************************************/
+#ifndef __VCG_OPERATOR_CACHE
+#define __VCG_OPERATOR_CACHE
+
+#include <vector>
+#include <vcg/complex/complex.h>
+#include <Eigen/Sparse>
+
+namespace vcg {
+namespace tri {
+
+/** Key used to tell if a sparse operator built on a mesh is still valid.
+    Meshes carry no modification counter, so the key is a copy of the face-vertex
+    relation (topology) and of the vertex positions (geometry) the operator was
+    built from. It is compared exactly: a hash could match a different mesh and
+    make a cached factorization solve the wrong system.
+*/
+template <class MeshType>
+class MeshOperatorKey
+{
+public:
+    typedef typename MeshType::ScalarType ScalarType;
+
+    void Clear()
+    {
+        topology.clear();
+        geometry.clear();
+    }
+
+    void Set(const MeshType &m)
+    {
+        Clear();
+        topology.reserve(2 + m.face.size() * 4);
+        topology.push_back(m.vert.size());
+        topology.push_back(m.face.size());
+        for (size_t i = 0; i < m.face.size(); ++i)
+        {
+            const typename MeshType::FaceType &f = m.face[i];
+            topology.push_back(f.IsD() ? size_t(-1) : size_t(f.VN()));
+            if (f.IsD()) continue;
+            for (int j = 0; j < f.VN(); ++j)
+                topology.push_back(tri::Index(m, f.cV(j)));
+        }
+        geometry.reserve(m.vert.size() * 3);
+        for (size_t i = 0; i < m.vert.size(); ++i)
+            for (int j = 0; j < 3; ++j)
+                geometry.push_back(m.vert[i].cP()[j]);
+    }
+
+    /// true if the mesh has the same topology and vertex positions given to Set
+    bool Matches(const MeshType &m) const
+    {
+        if (topology.size() < 2 || topology[0] != m.vert.size() || topology[1] != m.face.size() ||
+            geometry.size() != m.vert.size() * 3)
+            return false;
+        // the cheap geometry test first: it fails on most edits
+        for (size_t i = 0; i < m.vert.size(); ++i)
+            for (int j = 0; j < 3; ++j)
+                if (geometry[i * 3 + j] != m.vert[i].cP()[j])
+                    return false;
+        size_t k = 2;
+        for (size_t i = 0; i < m.face.size(); ++i)
+        {
+            const typename MeshType::FaceType &f = m.face[i];
+            if (k >= topology.size() || topology[k++] != (f.IsD() ? size_t(-1) : size_t(f.VN())))
+                return false;
+            if (f.IsD()) continue;
+            for (int j = 0; j < f.VN(); ++j)
+                if (k >= topology.size() || topology[k++] != tri::Index(m, f.cV(j)))
+                    return false;
+        }
+        return k == topology.size();
+    }
+
+private:
+    std::vector<size_t> topology;
+    std::vector<ScalarType> geometry;
+};
+
+/** A sparse solver that remembers the last matrix it factorized.
+    Factorize() does nothing if the matrix is the same as the previous one and
+    reuses the symbolic analysis (fill-reducing ordering and elimination tree)
+    when only the values have changed.
+*/
+template <class SolverType>
+class CachedFactorization
+{
+public:
+    typedef typename SolverType::MatrixType MatrixType;
+
+    CachedFactorization() : analyzed(false), factorized(false) {}
+
+    void Clear()
+    {
+        analyzed = factorized = false;
+        last = MatrixType();
+    }
+
+    Eigen::ComputationInfo Factorize(const MatrixType &A)
+    {
+        MatrixType C = A;
+        C.makeCompressed();
+        const bool samePattern = analyzed && SamePattern(C, last);
+        if (samePattern && factorized && SameValues(C, last))
+            return Eigen::Success;
+
+        if (!samePattern)
+            solver.analyzePattern(C);
+        solver.factorize(C);
+        analyzed = true;
+        factorized = (solver.info() == Eigen::Success);
+        if (factorized)
+            last.swap(C);
+        else
+            Clear();
+        return solver.info();
+    }
+
+    SolverType &Solver() { return solver; }
+
+private:
+    static bool SamePattern(const MatrixType &a, const MatrixType &b)
+    {
+        return a.rows() == b.rows() && a.cols() == b.cols() &&
+               a.nonZeros() == b.nonZeros() &&
+               std::equal(a.outerIndexPtr(), a.outerIndexPtr() + a.outerSize() + 1, b.outerIndexPtr()) &&
+               std::equal(a.innerIndexPtr(), a.innerIndexPtr() + a.nonZeros(), b.innerIndexPtr());
+    }
+
+    static bool SameValues(const MatrixType &a, const MatrixType &b)
+    {
+        return std::equal(a.valuePtr(), a.valuePtr() + a.nonZeros(), b.valuePtr());
+    }
+
+    SolverType solver;
+    MatrixType last;
+    bool analyzed, factorized;
+};
+
+} // end namespace tri
+} // end namespace vcg
+#endif // __VCG_OPERATOR_CACHE
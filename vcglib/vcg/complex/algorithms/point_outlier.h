@@ -24,6 +24,7 @@
 #define VCG_TRI_OUTLIERS__H
 
 #include <vcg/space/index/kdtree/kdtree.h>
+#include <wrap/system/parallel.h>
 
 namespace vcg
 {
@@ -56,8 +57,8 @@ class OutlierRemoval
       typename MeshType::template PerVertexAttributeHandle<ScalarType> sigma =        tri::Allocator<MeshType>:: template GetPerVertexAttribute<ScalarType>(mesh, std::string("sigma"));
       typename MeshType::template PerVertexAttributeHandle<ScalarType> plof =         tri::Allocator<MeshType>:: template GetPerVertexAttribute<ScalarType>(mesh, std::string("plof"));
 
-#pragma omp parallel for schedule(dynamic, 10) //MSVC supports only OMP 2 -> no unsigned int allowed in parallel for...
-      for (int i = 0; i < (int)mesh.vert.size(); i++)
+      const int vn = int(mesh.vert.size());
+      parallel::For(vn, [&](int i)
       {
         PriorityQueue queue;
         kdTree.doQueryK(mesh.vert[i].cP(), kNearest, queue);
@@ -66,11 +67,10 @@ class OutlierRemoval
           sum += queue.getWeight(j);
         sum /= (queue.getNofElements());
         sigma[i] = sqrt(sum);
-      }
+      }, 0, "", 10);
 
-      float mean = 0;
-#pragma omp parallel for reduction(+: mean) schedule(dynamic, 10)
-      for (int i = 0; i < (int)mesh.vert.size(); i++)
+      // the sum is combined in index order, so the scores do not depend on the number of threads
+      float mean = parallel::Reduce(vn, 0.0f, [&](int i)
       {
         PriorityQueue queue;
         kdTree.doQueryK(mesh.vert[i].cP(), kNearest, queue);
@@ -79,14 +79,13 @@ class OutlierRemoval
           sum += sigma[queue.getIndex(j)];
         sum /= (queue.getNofElements());
         plof[i] = sigma[i] / sum  - 1.0f;
-        mean += plof[i] * plof[i];
-      }
+        return float(plof[i] * plof[i]);
+      }, std::plus<float>());
 
       mean /= mesh.vert.size();
       mean = sqrt(mean);
 
-#pragma omp parallel for schedule(dynamic, 10)
-      for (int i = 0; i < (int)mesh.vert.size(); i++)
+      parallel::For(vn, [&](int i)
       {
         ScalarType value = plof[i] / (mean * sqrt(2.0f));
         double dem = 1.0 + 0.278393 * value;
@@ -95,7 +94,7 @@ class OutlierRemoval
         dem += 0.078108 * value * value * value * value;
         ScalarType op = std::max(0.0, 1.0 - 1.0 / dem);
         outlierScore[i] = op;
-      }
+      });
 
       tri::Allocator<MeshType>::DeletePerVertexAttribute(mesh, std::string("sigma"));
       tri::Allocator<MeshType>::DeletePerVertexAttribute(mesh, std::string("plof"));
@@ -489,9 +489,11 @@ class SurfaceSampling
 
 public:
 
+// One generator per thread, so that meshes sampled concurrently get the same samples
+// they would get alone.
 static math::MarsenneTwisterRNG &SamplingRandomGenerator()
 {
-    static math::MarsenneTwisterRNG rnd;
+    static thread_local math::MarsenneTwisterRNG rnd;
     return rnd;
 }
 
@@ -0,0 +1,147 @@
+/****************************************************************************
+* VCGLib                                                            o o     *
+* Visual and Computer Graphics Library                            o     o   *
+*                                                                _   O  _   *
+* Copyright(C) 2004-2016                                           \/)\/    *
+* Visual Computing Lab                                            /\/|      *
+* ISTI - Italian National Research Council                           |      *
+*                                                                    \      *
+* All rights reserved.                                                      *
+*                                                                           *
+* This program is free software; you can redistribute it and/or modify      *
+* it under the terms of the GNU General Public License as published by      *
+* the Free Software Foundation; either version 2 of the License, or         *
+* (at your option) any later version.                                       *
+*                                                                           *
+* This program is distributed in the hope that it will be useful,           *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)          *
+* for more details.                                                         *
+*                                                                           *
+****************************************************************************/
+#ifndef __VCG_RADIX_SORT
+#define __VCG_RADIX_SORT
+
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include <wrap/system/parallel.h>
+
+namespace vcg {
+
+/** Stable LSD radix sort of a vector by an unsigned integer key, eight bits per pass.
+    key(e) returns the (at most 64 bit) key of element e and should be cheap, as it is
+    evaluated in every pass; only the lowest keyBits bits are used.
+    Elements with equal keys keep their relative order, so sorting by a secondary key
+    and then by a primary key gives the lexicographic order.
+    The array is split in a fixed number of blocks that are counted and scattered in
+    parallel, so the result does not depend on the number of threads. Passes beyond the
+    highest key and passes where all the keys share the digit are skipped; short arrays
+    are sorted with std::stable_sort.
+*/
+template <class T, class KeyFunc>
+void RadixSort(std::vector<T> &v, KeyFunc key, int keyBits = 64)
+{
+    const int n = int(v.size());
+    if (n < 2) return;
+
+    const uint64_t mask = keyBits >= 64 ? ~uint64_t(0) : (uint64_t(1) << keyBits) - 1;
+    if (n < (1 << 16))
+    {
+        std::stable_sort(v.begin(), v.end(), [&](const T &a, const T &b) { return (key(a) & mask) < (key(b) & mask); });
+        return;
+    }
+
+    const int blockSize = 1 << 16;
+    const int blockNum = (n + blockSize - 1) / blockSize;
+
+    const uint64_t maxKey = parallel::Reduce(n, uint64_t(0),
+        [&](int i) { return key(v[i]) & mask; },
+        [](uint64_t a, uint64_t b) { return std::max(a, b); }, blockSize);
+
+    std::vector<T> tmp(n);
+    std::vector<int> count(blockNum * 256);
+    for (int shift = 0; shift < keyBits && (maxKey >> shift) != 0; shift += 8)
+    {
+        std::fill(count.begin(), count.end(), 0);
+        parallel::For(blockNum, [&](int b) {
+            int *c = &count[b * 256];
+            const int end = std::min(n, (b + 1) * blockSize);
+            for (int i = b * blockSize; i < end; ++i)
+                ++c[(key(v[i]) >> shift) & 0xff];
+        }, 0, "", 1);
+
+        // a digit shared by all the keys does not change the order
+        bool constantDigit = false;
+        for (int d = 0; d < 256 && !constantDigit; ++d)
+        {
+            int tot = 0;
+            for (int b = 0; b < blockNum; ++b)
+                tot += count[b * 256 + d];
+            if (tot == n) constantDigit = true;
+            else if (tot != 0) break;
+        }
+        if (constantDigit) continue;
+
+        // exclusive prefix sum in (digit, block) order gives where each block writes each digit
+        int sum = 0;
+        for (int d = 0; d < 256; ++d)
+            for (int b = 0; b < blockNum; ++b)
+            {
+                const int c = count[b * 256 + d];
+                count[b * 256 + d] = sum;
+                sum += c;
+            }
+
+        parallel::For(blockNum, [&](int b) {
+            int *c = &count[b * 256];
+            const int end = std::min(n, (b + 1) * blockSize);
+            for (int i = b * blockSize; i < end; ++i)
+                tmp[c[(key(v[i]) >> shift) & 0xff]++] = v[i];
+        }, 0, "", 1);
+        v.swap(tmp);
+    }
+}
+
+/** Stable radix sort of a vector of indices by key(i), see RadixSort().
+    The keys are computed once, so key can be expensive.
+*/
+template <class KeyFunc>
+void RadixSortIndex(std::vector<unsigned int> &idx, KeyFunc key, int keyBits = 64)
+{
+    typedef std::pair<uint64_t, unsigned int> KeyIndex;
+    const int n = int(idx.size());
+    if (n < 2) return;
+
+    std::vector<KeyIndex> ki(n);
+    parallel::For(n, [&](int i) { ki[i] = KeyIndex(key(idx[i]), idx[i]); });
+    RadixSort(ki, [](const KeyIndex &p) { return p.first; }, keyBits);
+    parallel::For(n, [&](int i) { idx[i] = ki[i].second; });
+}
+
+/** Key of a floating point value that orders as the value itself when compared as unsigned integer.
+    -0 and +0 get the same key.
+*/
+inline uint64_t RadixSortFloatKey(float v)
+{
+    if (v == 0) v = 0;
+    uint32_t u;
+    memcpy(&u, &v, sizeof(u));
+    return (u & 0x80000000u) ? ~u : (u | 0x80000000u);
+}
+
+inline uint64_t RadixSortFloatKey(double v)
+{
+    if (v == 0) v = 0;
+    uint64_t u;
+    memcpy(&u, &v, sizeof(u));
+    return (u & 0x8000000000000000ull) ? ~u : (u | 0x8000000000000000ull);
+}
+
+} // end namespace vcg
+
+#endif // __VCG_RADIX_SORT
@@ -29,6 +29,7 @@
 #include <vcg/complex/algorithms/update/halfedge_topology.h>
 #include <vcg/complex/algorithms/closest.h>
 #include <vcg/space/index/kdtree/kdtree.h>
+#include <wrap/system/parallel.h>
 
 namespace vcg
 {
@@ -331,23 +332,216 @@ class Smooth
         }
     }
 
+    // Gather form of the face loops used by the laplacian kernels.
+    // For each vertex it stores the adjacent vertices whose values are added to it,
+    // in the same order in which the face loops scatter them, so that the sums
+    // can be computed independently (and in parallel) for each vertex with exactly
+    // the same results of the serial loops.
+    // It depends only on the topology and on the face border flags, so it is built
+    // once and reused for all the iterations of a kernel.
+    class LaplacianStencil
+    {
+      public:
+        std::vector<int> start;  // the entries of vertex i are in [start[i], start[i+1])
+        std::vector<int> adj;    // index of the vertex whose value is added
+        std::vector<int> edge;   // face*3+j of the face edge generating the entry
+        std::vector<char> reset; // vertex on a border edge
+    };
+
+    // Two rules are supported:
+    // - the default one of AccumulateLaplacianInfo: the vertices on a border edge
+    //   are averaged only with their adjacent vertices along the border, all the others
+    //   with the vertices adjacent through non-border edges;
+    // - the HC one (hcRule) where all the edges are used and border edges count twice.
+    // If polygonal is true all the VN() edges of each face are visited instead of three.
+    static void BuildLaplacianStencil(MeshType &m, LaplacianStencil &ls, bool hcRule = false, bool polygonal = false)
+    {
+        const size_t vn = m.vert.size();
+        ls.reset.assign(vn, 0);
+        if (!hcRule)
+        {
+            for (FaceIterator fi = m.face.begin(); fi != m.face.end(); ++fi)
+                if (!(*fi).IsD())
+                    for (int j = 0; j < (polygonal ? (*fi).VN() : 3); ++j)
+                        if ((*fi).IsB(j))
+                        {
+                            ls.reset[tri::Index(m, (*fi).V0(j))] = 1;
+                            ls.reset[tri::Index(m, (*fi).V1(j))] = 1;
+                        }
+        }
+
+        // first count the entries of each vertex, then fill them in the same order
+        ls.start.assign(vn + 1, 0);
+        VisitLaplacianStencil(m, ls.reset, hcRule, polygonal, [&](int i, int, int) { ++ls.start[i + 1]; });
+        for (size_t i = 0; i < vn; ++i)
+            ls.start[i + 1] += ls.start[i];
+        ls.adj.resize(ls.start[vn]);
+        ls.edge.resize(ls.start[vn]);
+        std::vector<int> pos(ls.start.begin(), ls.start.end() - 1);
+        VisitLaplacianStencil(m, ls.reset, hcRule, polygonal, [&](int i, int k, int e) {
+            ls.adj[pos[i]] = k;
+            ls.edge[pos[i]] = e;
+            ++pos[i];
+        });
+    }
+
+  private:
+    template <class EmitFunc>
+    static void VisitLaplacianStencil(MeshType &m, const std::vector<char> &reset, bool hcRule, bool polygonal, EmitFunc emit)
+    {
+        for (size_t f = 0; f < m.face.size(); ++f)
+        {
+            FaceType &fa = m.face[f];
+            if (fa.IsD())
+                continue;
+            for (int j = 0; j < (polygonal ? fa.VN() : 3); ++j)
+            {
+                const int i0 = int(tri::Index(m, fa.V0(j)));
+                const int i1 = int(tri::Index(m, fa.V1(j)));
+                const int e = int(f * 3 + j);
+                if (hcRule)
+                {
+                    for (int r = 0; r < (fa.IsB(j) ? 2 : 1); ++r)
+                    {
+                        emit(i0, i1, e);
+                        emit(i1, i0, e);
+                    }
+                }
+                else if (!fa.IsB(j))
+                {
+                    if (!reset[i0])
+                        emit(i0, i1, e);
+                    if (!reset[i1])
+                        emit(i1, i0, e);
+                }
+            }
+        }
+        if (hcRule)
+            return;
+        for (size_t f = 0; f < m.face.size(); ++f)
+        {
+            FaceType &fa = m.face[f];
+            if (fa.IsD())
+                continue;
+            for (int j = 0; j < (polygonal ? fa.VN() : 3); ++j)
+                if (fa.IsB(j))
+                {
+                    const int i0 = int(tri::Index(m, fa.V0(j)));
+                    const int i1 = int(tri::Index(m, fa.V1(j)));
+                    emit(i0, i1, int(f * 3 + j));
+                    emit(i1, i0, int(f * 3 + j));
+                }
+        }
+    }
+
+  public:
+    // Same of AccumulateLaplacianInfo (for meshes without tetrahedra) on a packed copy
+    // of the vertex positions: TD[i] is set to the sum and to the count of vertex i.
+    static void GatherLaplacianInfo(MeshType &m, const LaplacianStencil &ls, const std::vector<CoordType> &pos,
+                                    std::vector<LaplacianInfo> &TD, bool cotangentFlag = false)
+    {
+        std::vector<float> cotW;
+        if (cotangentFlag)
+        {
+            cotW.resize(m.face.size() * 3);
+            parallel::For(int(m.face.size()), [&](int f) {
+                const FaceType &fa = m.face[f];
+                if (fa.IsD())
+                    return;
+                for (int j = 0; j < 3; ++j)
+                {
+                    const CoordType &p0 = pos[tri::Index(m, fa.cV0(j))];
+                    const CoordType &p1 = pos[tri::Index(m, fa.cV1(j))];
+                    const CoordType &p2 = pos[tri::Index(m, fa.cV2(j))];
+                    float angle = Angle(p1 - p2, p0 - p2);
+                    cotW[f * 3 + j] = tan((M_PI * 0.5) - angle);
+                }
+            });
+        }
+
+        TD.resize(pos.size());
+        parallel::For(int(pos.size()), [&](int i) {
+            LaplacianInfo lpz(CoordType(0, 0, 0), 0);
+            if (ls.reset[i])
+            {
+                lpz.sum = pos[i];
+                lpz.cnt = 1;
+                for (int k = ls.start[i]; k < ls.start[i + 1]; ++k)
+                {
+                    lpz.sum += pos[ls.adj[k]];
+                    ++lpz.cnt;
+                }
+            }
+            else
+            {
+                for (int k = ls.start[i]; k < ls.start[i + 1]; ++k)
+                {
+                    const float weight = cotangentFlag ? cotW[ls.edge[k]] : 1.0f;
+                    lpz.sum += pos[ls.adj[k]] * weight;
+                    lpz.cnt += weight;
+                }
+            }
+            TD[i] = lpz;
+        });
+    }
+
+    static void GetPackedPositions(MeshType &m, std::vector<CoordType> &pos)
+    {
+        pos.resize(m.vert.size());
+        parallel::For(int(m.vert.size()), [&](int i) {
+            pos[i] = m.vert[i].cP();
+        });
+    }
+
+    static void SetPackedPositions(MeshType &m, const std::vector<CoordType> &pos)
+    {
+        parallel::For(int(m.vert.size()), [&](int i) {
+            if (!m.vert[i].IsD())
+                m.vert[i].P() = pos[i];
+        });
+    }
+
     static void VertexCoordLaplacian(MeshType &m, int step, bool SmoothSelected = false, bool cotangentWeight = false, vcg::CallBackPos *cb = 0)
     {
         LaplacianInfo lpz(CoordType(0, 0, 0), 0);
-        SimpleTempData<typename MeshType::VertContainer, LaplacianInfo> TD(m.vert, lpz);
+        if (m.tn > 0)
+        {
+            SimpleTempData<typename MeshType::VertContainer, LaplacianInfo> TD(m.vert, lpz);
+            for (int i = 0; i < step; ++i)
+            {
+                if (cb)
+                    cb(100 * i / step, "Classic Laplacian Smoothing");
+                TD.Init(lpz);
+                AccumulateLaplacianInfo(m, TD, cotangentWeight);
+                for (auto vi = m.vert.begin(); vi != m.vert.end(); ++vi)
+                    if (!(*vi).IsD() && TD[*vi].cnt > 0)
+                    {
+                        if (!SmoothSelected || (*vi).IsS())
+                            (*vi).P() = ((*vi).P() + TD[*vi].sum) / (TD[*vi].cnt + 1);
+                    }
+            }
+            return;
+        }
+
+        LaplacianStencil ls;
+        BuildLaplacianStencil(m, ls);
+        std::vector<CoordType> pos;
+        std::vector<LaplacianInfo> TD;
+        GetPackedPositions(m, pos);
         for (int i = 0; i < step; ++i)
         {
             if (cb)
                 cb(100 * i / step, "Classic Laplacian Smoothing");
-            TD.Init(lpz);
-            AccumulateLaplacianInfo(m, TD, cotangentWeight);
-            for (auto vi = m.vert.begin(); vi != m.vert.end(); ++vi)
-                if (!(*vi).IsD() && TD[*vi].cnt > 0)
+            GatherLaplacianInfo(m, ls, pos, TD, cotangentWeight);
+            parallel::For(int(pos.size()), [&](int v) {
+                if (!m.vert[v].IsD() && TD[v].cnt > 0)
                 {
-                    if (!SmoothSelected || (*vi).IsS())
-                        (*vi).P() = ((*vi).P() + TD[*vi].sum) / (TD[*vi].cnt + 1);
+                    if (!SmoothSelected || m.vert[v].IsS())
+                        pos[v] = (pos[v] + TD[v].sum) / (TD[v].cnt + 1);
                 }
+            });
         }
+        SetPackedPositions(m, pos);
     }
 
     // Same of above but moves only the vertices that do not change FaceOrientation more that the given threshold
@@ -446,6 +640,38 @@ So if
 
     static void VertexCoordTaubin(MeshType &m, int step, float lambda, float mu, bool SmoothSelected = false, vcg::CallBackPos *cb = 0)
     {
+        if (m.tn == 0)
+        {
+            // both the lambda and the mu steps work on the same packed positions
+            LaplacianStencil ls;
+            BuildLaplacianStencil(m, ls);
+            std::vector<CoordType> pos;
+            std::vector<LaplacianInfo> TD;
+            GetPackedPositions(m, pos);
+            for (int i = 0; i < step; ++i)
+            {
+                if (cb)
+                    cb(100 * i / step, "Taubin Smoothing");
+                for (int k = 0; k < 2; ++k)
+                {
+                    const float scale = (k == 0) ? lambda : mu;
+                    GatherLaplacianInfo(m, ls, pos, TD);
+                    parallel::For(int(pos.size()), [&](int v) {
+                        if (!m.vert[v].IsD() && TD[v].cnt > 0)
+                        {
+                            if (!SmoothSelected || m.vert[v].IsS())
+                            {
+                                CoordType Delta = TD[v].sum / TD[v].cnt - pos[v];
+                                pos[v] = pos[v] + Delta * scale;
+                            }
+                        }
+                    });
+                }
+            }
+            SetPackedPositions(m, pos);
+            return;
+        }
+
         LaplacianInfo lpz(CoordType(0, 0, 0), 0);
         SimpleTempData<typename MeshType::VertContainer, LaplacianInfo> TD(m.vert, lpz);
         VertexIterator vi;
@@ -556,60 +782,38 @@ So if
         lpz.sum = CoordType(0, 0, 0);
         lpz.dif = CoordType(0, 0, 0);
         lpz.cnt = 0;
+        LaplacianStencil ls;
+        BuildLaplacianStencil(m, ls, true);
+        std::vector<HCSmoothInfo> TD(m.vert.size());
         for (int i = 0; i < step; ++i)
         {
-            SimpleTempData<typename MeshType::VertContainer, HCSmoothInfo> TD(m.vert, lpz);
             // First Loop compute the laplacian
-            FaceIterator fi;
-            for (fi = m.face.begin(); fi != m.face.end(); ++fi)
-                if (!(*fi).IsD())
+            // (border edges are summed twice, see BuildLaplacianStencil)
+            parallel::For(int(m.vert.size()), [&](int v) {
+                TD[v] = lpz;
+                for (int k = ls.start[v]; k < ls.start[v + 1]; ++k)
                 {
-                    for (int j = 0; j < 3; ++j)
-                    {
-                        TD[(*fi).V(j)].sum += (*fi).V1(j)->P();
-                        TD[(*fi).V1(j)].sum += (*fi).V(j)->P();
-                        ++TD[(*fi).V(j)].cnt;
-                        ++TD[(*fi).V1(j)].cnt;
-                        // se l'edge j e' di bordo si deve sommare due volte
-                        if ((*fi).IsB(j))
-                        {
-                            TD[(*fi).V(j)].sum += (*fi).V1(j)->P();
-                            TD[(*fi).V1(j)].sum += (*fi).V(j)->P();
-                            ++TD[(*fi).V(j)].cnt;
-                            ++TD[(*fi).V1(j)].cnt;
-                        }
-                    }
+                    TD[v].sum += m.vert[ls.adj[k]].cP();
+                    ++TD[v].cnt;
                 }
-            VertexIterator vi;
-            for (vi = m.vert.begin(); vi != m.vert.end(); ++vi)
-                if (!(*vi).IsD())
-                    TD[*vi].sum /= (float)TD[*vi].cnt;
+                if (!m.vert[v].IsD())
+                    TD[v].sum /= (float)TD[v].cnt;
+            });
 
             // Second Loop compute average difference
-            for (fi = m.face.begin(); fi != m.face.end(); ++fi)
-                if (!(*fi).IsD())
+            parallel::For(int(m.vert.size()), [&](int v) {
+                for (int k = ls.start[v]; k < ls.start[v + 1]; ++k)
+                    TD[v].dif += TD[ls.adj[k]].sum - m.vert[ls.adj[k]].cP();
+            });
+
+            parallel::For(int(m.vert.size()), [&](int v) {
+                if (TD[v].cnt > 0)
                 {
-                    for (int j = 0; j < 3; ++j)
-                    {
-                        TD[(*fi).V(j)].dif += TD[(*fi).V1(j)].sum - (*fi).V1(j)->P();
-                        TD[(*fi).V1(j)].dif += TD[(*fi).V(j)].sum - (*fi).V(j)->P();
-                        // se l'edge j e' di bordo si deve sommare due volte
-                        if ((*fi).IsB(j))
-                        {
-                            TD[(*fi).V(j)].dif += TD[(*fi).V1(j)].sum - (*fi).V1(j)->P();
-                            TD[(*fi).V1(j)].dif += TD[(*fi).V(j)].sum - (*fi).V(j)->P();
-                        }
-                    }
+                    TD[v].dif /= (float)TD[v].cnt;
+                    if (!SmoothSelected || m.vert[v].IsS())
+                        m.vert[v].P() = TD[v].sum - (TD[v].sum - m.vert[v].P()) * beta + (TD[v].dif) * (1.f - beta);
                 }
-
-            for (vi = m.vert.begin(); vi != m.vert.end(); ++vi)
-            {
-				if (TD[*vi].cnt > 0){
-					TD[*vi].dif /= (float)TD[*vi].cnt;
-					if (!SmoothSelected || (*vi).IsS())
-						(*vi).P() = TD[*vi].sum - (TD[*vi].sum - (*vi).P()) * beta + (TD[*vi].dif) * (1.f - beta);
-				}
-            }
+            });
         } // end for step
     };
 
@@ -631,76 +835,41 @@ So if
         csi.r = 0;
         csi.g = 0;
         csi.b = 0;
+        csi.a = 0;
         csi.cnt = 0;
-        SimpleTempData<typename MeshType::VertContainer, ColorSmoothInfo> TD(m.vert, csi);
+        LaplacianStencil ls;
+        BuildLaplacianStencil(m, ls);
+        std::vector<ColorSmoothInfo> TD(m.vert.size(), csi);
 
         for (int i = 0; i < step; ++i)
         {
             if (cb)
                 cb(100 * i / step, "Vertex Color Laplacian Smoothing");
-            VertexIterator vi;
-            for (vi = m.vert.begin(); vi != m.vert.end(); ++vi)
-                TD[*vi] = csi;
-
-            FaceIterator fi;
-            for (fi = m.face.begin(); fi != m.face.end(); ++fi)
-                if (!(*fi).IsD())
-                    for (int j = 0; j < 3; ++j)
-                        if (!(*fi).IsB(j))
-                        {
-                            TD[(*fi).V(j)].r += (*fi).V1(j)->C()[0];
-                            TD[(*fi).V(j)].g += (*fi).V1(j)->C()[1];
-                            TD[(*fi).V(j)].b += (*fi).V1(j)->C()[2];
-                            TD[(*fi).V(j)].a += (*fi).V1(j)->C()[3];
-
-                            TD[(*fi).V1(j)].r += (*fi).V(j)->C()[0];
-                            TD[(*fi).V1(j)].g += (*fi).V(j)->C()[1];
-                            TD[(*fi).V1(j)].b += (*fi).V(j)->C()[2];
-                            TD[(*fi).V1(j)].a += (*fi).V(j)->C()[3];
-
-                            ++TD[(*fi).V(j)].cnt;
-                            ++TD[(*fi).V1(j)].cnt;
-                        }
-
-            // si azzaera i dati per i vertici di bordo
-            for (fi = m.face.begin(); fi != m.face.end(); ++fi)
-                if (!(*fi).IsD())
-                    for (int j = 0; j < 3; ++j)
-                        if ((*fi).IsB(j))
-                        {
-                            TD[(*fi).V(j)] = csi;
-                            TD[(*fi).V1(j)] = csi;
-                        }
-
-            // se l'edge j e' di bordo si deve mediare solo con gli adiacenti
-            for (fi = m.face.begin(); fi != m.face.end(); ++fi)
-                if (!(*fi).IsD())
-                    for (int j = 0; j < 3; ++j)
-                        if ((*fi).IsB(j))
-                        {
-                            TD[(*fi).V(j)].r += (*fi).V1(j)->C()[0];
-                            TD[(*fi).V(j)].g += (*fi).V1(j)->C()[1];
-                            TD[(*fi).V(j)].b += (*fi).V1(j)->C()[2];
-                            TD[(*fi).V(j)].a += (*fi).V1(j)->C()[3];
 
-                            TD[(*fi).V1(j)].r += (*fi).V(j)->C()[0];
-                            TD[(*fi).V1(j)].g += (*fi).V(j)->C()[1];
-                            TD[(*fi).V1(j)].b += (*fi).V(j)->C()[2];
-                            TD[(*fi).V1(j)].a += (*fi).V(j)->C()[3];
-
-                            ++TD[(*fi).V(j)].cnt;
-                            ++TD[(*fi).V1(j)].cnt;
-                        }
+            // the vertices on a border edge are averaged only with the adjacent ones on the border
+            parallel::For(int(m.vert.size()), [&](int v) {
+                TD[v] = csi;
+                for (int k = ls.start[v]; k < ls.start[v + 1]; ++k)
+                {
+                    const typename VertexType::ColorType &c = m.vert[ls.adj[k]].cC();
+                    TD[v].r += c[0];
+                    TD[v].g += c[1];
+                    TD[v].b += c[2];
+                    TD[v].a += c[3];
+                    ++TD[v].cnt;
+                }
+            });
 
-            for (vi = m.vert.begin(); vi != m.vert.end(); ++vi)
-                if (!(*vi).IsD() && TD[*vi].cnt > 0)
-                    if (!SmoothSelected || (*vi).IsS())
+            parallel::For(int(m.vert.size()), [&](int v) {
+                if (!m.vert[v].IsD() && TD[v].cnt > 0)
+                    if (!SmoothSelected || m.vert[v].IsS())
                     {
-                        (*vi).C()[0] = (unsigned int)ceil((double)(TD[*vi].r / TD[*vi].cnt));
-                        (*vi).C()[1] = (unsigned int)ceil((double)(TD[*vi].g / TD[*vi].cnt));
-                        (*vi).C()[2] = (unsigned int)ceil((double)(TD[*vi].b / TD[*vi].cnt));
-                        (*vi).C()[3] = (unsigned int)ceil((double)(TD[*vi].a / TD[*vi].cnt));
+                        m.vert[v].C()[0] = (unsigned int)ceil((double)(TD[v].r / TD[v].cnt));
+                        m.vert[v].C()[1] = (unsigned int)ceil((double)(TD[v].g / TD[v].cnt));
+                        m.vert[v].C()[2] = (unsigned int)ceil((double)(TD[v].b / TD[v].cnt));
+                        m.vert[v].C()[3] = (unsigned int)ceil((double)(TD[v].a / TD[v].cnt));
                     }
+            });
         } // end for step
     };
 
@@ -804,56 +973,27 @@ So if
         QualitySmoothInfo lpz;
         lpz.sum = 0;
         lpz.cnt = 0;
-        SimpleTempData<typename MeshType::VertContainer, QualitySmoothInfo> TD(m.vert, lpz);
-        //TD.Start(lpz);
+        LaplacianStencil ls;
+        BuildLaplacianStencil(m, ls, false, true);
+        std::vector<QualitySmoothInfo> TD(m.vert.size(), lpz);
         for (int i = 0; i < step; ++i)
         {
-            VertexIterator vi;
-            for (vi = m.vert.begin(); vi != m.vert.end(); ++vi)
-                TD[*vi] = lpz;
-
-            FaceIterator fi;
-            for (fi = m.face.begin(); fi != m.face.end(); ++fi)
-                if (!(*fi).IsD())
-                    for (int j = 0; j < (*fi).VN(); ++j)
-                        if (!(*fi).IsB(j))
-                        {
-                            TD[(*fi).V(j)].sum += (*fi).V1(j)->Q();
-                            TD[(*fi).V1(j)].sum += (*fi).V(j)->Q();
-                            ++TD[(*fi).V(j)].cnt;
-                            ++TD[(*fi).V1(j)].cnt;
-                        }
-
-            // si azzaera i dati per i vertici di bordo
-            for (fi = m.face.begin(); fi != m.face.end(); ++fi)
-                if (!(*fi).IsD())
-                    for (int j = 0; j < (*fi).VN(); ++j)
-                        if ((*fi).IsB(j))
-                        {
-                            TD[(*fi).V(j)] = lpz;
-                            TD[(*fi).V1(j)] = lpz;
-                        }
-
-            // se l'edge j e' di bordo si deve mediare solo con gli adiacenti
-            for (fi = m.face.begin(); fi != m.face.end(); ++fi)
-                if (!(*fi).IsD())
-                    for (int j = 0; j < (*fi).VN(); ++j)
-                        if ((*fi).IsB(j))
-                        {
-                            TD[(*fi).V(j)].sum += (*fi).V1(j)->Q();
-                            TD[(*fi).V1(j)].sum += (*fi).V(j)->Q();
-                            ++TD[(*fi).V(j)].cnt;
-                            ++TD[(*fi).V1(j)].cnt;
-                        }
+            // the vertices on a border edge are averaged only with the adjacent ones on the border
+            parallel::For(int(m.vert.size()), [&](int v) {
+                TD[v] = lpz;
+                for (int k = ls.start[v]; k < ls.start[v + 1]; ++k)
+                {
+                    TD[v].sum += m.vert[ls.adj[k]].cQ();
+                    ++TD[v].cnt;
+                }
+            });
 
-            //VertexIterator vi;
-            for (vi = m.vert.begin(); vi != m.vert.end(); ++vi)
-                if (!(*vi).IsD() && TD[*vi].cnt > 0)
-                    if (!SmoothSelected || (*vi).IsS())
-                        (*vi).Q() = TD[*vi].sum / TD[*vi].cnt;
+            parallel::For(int(m.vert.size()), [&](int v) {
+                if (!m.vert[v].IsD() && TD[v].cnt > 0)
+                    if (!SmoothSelected || m.vert[v].IsS())
+                        m.vert[v].Q() = TD[v].sum / TD[v].cnt;
+            });
         }
-
-        //TD.Stop();
     };
 
     static void VertexNormalLaplacian(MeshType &m, int step, bool SmoothSelected = false)
@@ -861,52 +1001,26 @@ So if
         LaplacianInfo lpz;
         lpz.sum = CoordType(0, 0, 0);
         lpz.cnt = 0;
-        SimpleTempData<typename MeshType::VertContainer, LaplacianInfo> TD(m.vert, lpz);
+        LaplacianStencil ls;
+        BuildLaplacianStencil(m, ls);
+        std::vector<LaplacianInfo> TD(m.vert.size(), lpz);
         for (int i = 0; i < step; ++i)
         {
-            VertexIterator vi;
-            for (vi = m.vert.begin(); vi != m.vert.end(); ++vi)
-                TD[*vi] = lpz;
-
-            FaceIterator fi;
-            for (fi = m.face.begin(); fi != m.face.end(); ++fi)
-                if (!(*fi).IsD())
-                    for (int j = 0; j < 3; ++j)
-                        if (!(*fi).IsB(j))
-                        {
-                            TD[(*fi).V(j)].sum += (*fi).V1(j)->N();
-                            TD[(*fi).V1(j)].sum += (*fi).V(j)->N();
-                            ++TD[(*fi).V(j)].cnt;
-                            ++TD[(*fi).V1(j)].cnt;
-                        }
-
-            // si azzaera i dati per i vertici di bordo
-            for (fi = m.face.begin(); fi != m.face.end(); ++fi)
-                if (!(*fi).IsD())
-                    for (int j = 0; j < 3; ++j)
-                        if ((*fi).IsB(j))
-                        {
-                            TD[(*fi).V(j)] = lpz;
-                            TD[(*fi).V1(j)] = lpz;
-                        }
-
-            // se l'edge j e' di bordo si deve mediare solo con gli adiacenti
-            for (fi = m.face.begin(); fi != m.face.end(); ++fi)
-                if (!(*fi).IsD())
-                    for (int j = 0; j < 3; ++j)
-                        if ((*fi).IsB(j))
-                        {
-                            TD[(*fi).V(j)].sum += (*fi).V1(j)->N();
-                            TD[(*fi).V1(j)].sum += (*fi).V(j)->N();
-                            ++TD[(*fi).V(j)].cnt;
-                            ++TD[(*fi).V1(j)].cnt;
-                        }
+            // the vertices on a border edge are averaged only with the adjacent ones on the border
+            parallel::For(int(m.vert.size()), [&](int v) {
+                TD[v] = lpz;
+                for (int k = ls.start[v]; k < ls.start[v + 1]; ++k)
+                {
+                    TD[v].sum += m.vert[ls.adj[k]].cN();
+                    ++TD[v].cnt;
+                }
+            });
 
-            //VertexIterator vi;
-            for (vi = m.vert.begin(); vi != m.vert.end(); ++vi)
-                if (!(*vi).IsD() && TD[*vi].cnt > 0)
-                    if (!SmoothSelected || (*vi).IsS())
-                        (*vi).N() = TD[*vi].sum / TD[*vi].cnt;
+            parallel::For(int(m.vert.size()), [&](int v) {
+                if (!m.vert[v].IsD() && TD[v].cnt > 0)
+                    if (!SmoothSelected || m.vert[v].IsS())
+                        m.vert[v].N() = TD[v].sum / TD[v].cnt;
+            });
         }
     };
 
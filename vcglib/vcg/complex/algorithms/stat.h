@@ -32,6 +32,7 @@
 #include <vcg/space/index/grid_static_ptr.h>
 #include <vcg/complex/algorithms/inertia.h>
 #include <vcg/space/polygon3.h>
+#include <wrap/system/parallel.h>
 
 
 namespace vcg {
@@ -77,12 +78,11 @@ public:
 
     std::pair<ScalarType, ScalarType> minmax = std::make_pair(std::numeric_limits<ScalarType>::max(), -std::numeric_limits<ScalarType>::max());
 
-    for(ConstVertexIterator vi = m.vert.begin(); vi != m.vert.end(); ++vi)
-      if(!(*vi).IsD())
-      {
-        if( (*vi).Q() < minmax.first)  minmax.first  = (*vi).Q();
-        if( (*vi).Q() > minmax.second) minmax.second = (*vi).Q();
-      }
+    ParallelChunkAccumulate(m.vert, minmax, minmax, 64,
+                            [](std::pair<ScalarType, ScalarType> &mm, const VertexType &v){
+      if( v.Q() < mm.first)  mm.first  = v.Q();
+      if( v.Q() > mm.second) mm.second = v.Q();
+    }, MergeMinMax);
 
     //mmqH() = minmax;
     return minmax;
@@ -101,13 +101,11 @@ public:
     tri::RequirePerFaceQuality(m);
     std::pair<ScalarType,ScalarType> minmax = std::make_pair(std::numeric_limits<ScalarType>::max(),-std::numeric_limits<ScalarType>::max());
 
-    ConstFaceIterator fi;
-    for(fi = m.face.begin(); fi != m.face.end(); ++fi)
-      if(!(*fi).IsD())
-      {
-        if( (*fi).Q() < minmax.first)  minmax.first  = (*fi).Q();
-        if( (*fi).Q() > minmax.second) minmax.second = (*fi).Q();
-      }
+    ParallelChunkAccumulate(m.face, minmax, minmax, 64,
+                            [](std::pair<ScalarType, ScalarType> &mm, const FaceType &f){
+      if( f.Q() < mm.first)  mm.first  = f.Q();
+      if( f.Q() > mm.second) mm.second = f.Q();
+    }, MergeMinMax);
     return minmax;
   }
 
@@ -307,6 +305,34 @@ public:
       }
   }
 
+  // Single parallel pass, bounded memory version: the vertices are split in chunks,
+  // each chunk fills its own sketch and the sketches are merged in order.
+  static void ComputePerVertexQualityDistribution(const MeshType & m, StreamingDistribution<ScalarType> & h, bool selectionOnly = false)
+  {
+    tri::RequirePerVertexQuality(m);
+    ParallelChunkAccumulate(m.vert, StreamingDistribution<ScalarType>(h.K()), h, 64,
+                            [selectionOnly](StreamingDistribution<ScalarType> &d, const VertexType &v){
+      if((!selectionOnly) || v.IsS())
+      {
+        assert(!math::IsNAN(v.Q()) && "You should never try to compute Histogram with Invalid Floating points numbers (NaN)");
+        d.Add(v.Q());
+      }
+    }, MergeDistribution);
+  }
+
+  static void ComputePerFaceQualityDistribution( const MeshType & m, StreamingDistribution<ScalarType> & h, bool selectionOnly = false)
+  {
+    tri::RequirePerFaceQuality(m);
+    ParallelChunkAccumulate(m.face, StreamingDistribution<ScalarType>(h.K()), h, 64,
+                            [selectionOnly](StreamingDistribution<ScalarType> &d, const FaceType &f){
+      if((!selectionOnly) || f.IsS())
+      {
+        assert(!math::IsNAN(f.Q()) && "You should never try to compute Histogram with Invalid Floating points numbers (NaN)");
+        d.Add(f.Q());
+      }
+    }, MergeDistribution);
+  }
+
   static void ComputePerFaceQualityDistribution( const MeshType & m,  Distribution<typename MeshType::ScalarType> &h,
                                                  bool selectionOnly = false)    // V1.0
   {
@@ -354,11 +380,13 @@ public:
     std::pair<ScalarType, ScalarType> minmax = tri::Stat<MeshType>::ComputePerFaceQualityMinMax(m);
     h.Clear();
     h.SetRange( minmax.first,minmax.second, HistSize );
-    for(ConstFaceIterator fi = m.face.begin(); fi != m.face.end(); ++fi)
-      if(!(*fi).IsD() &&  ((!selectionOnly) || (*fi).IsS()) ){
-        assert(!math::IsNAN((*fi).Q()) && "You should never try to compute Histogram with Invalid Floating points numbers (NaN)");
-        h.Add((*fi).Q());
+    ParallelChunkAccumulate(m.face, h, h, 8,
+                            [selectionOnly](Histogram<ScalarType> &ph, const FaceType &f){
+      if((!selectionOnly) || f.IsS()){
+        assert(!math::IsNAN(f.Q()) && "You should never try to compute Histogram with Invalid Floating points numbers (NaN)");
+        ph.Add(f.Q());
       }
+    }, MergeHistogram);
   }
 
   static void ComputePerVertexQualityHistogram( const MeshType & m, Histogram<ScalarType> &h, bool selectionOnly = false, int HistSize=10000 )    // V1.0
@@ -368,12 +396,14 @@ public:
 
     h.Clear();
     h.SetRange( minmax.first,minmax.second, HistSize);
-    for(ConstVertexIterator vi = m.vert.begin(); vi != m.vert.end(); ++vi)
-      if(!(*vi).IsD() &&  ((!selectionOnly) || (*vi).IsS()) )
+    auto addVertexQuality = [selectionOnly](Histogram<ScalarType> &ph, const VertexType &v){
+      if((!selectionOnly) || v.IsS())
       {
-        assert(!math::IsNAN((*vi).Q()) && "You should never try to compute Histogram with Invalid Floating points numbers (NaN)");
-        h.Add((*vi).Q());
+        assert(!math::IsNAN(v.Q()) && "You should never try to compute Histogram with Invalid Floating points numbers (NaN)");
+        ph.Add(v.Q());
       }
+    };
+    ParallelChunkAccumulate(m.vert, h, h, 8, addVertexQuality, MergeHistogram);
     // Sanity check; If some very wrong value has happened in the Q value,
     // the histogram is messed. If a significant percentage (20% )of the values are all in a single bin
     // we should try to solve the problem. No easy solution here.
@@ -394,9 +424,7 @@ public:
 
       h.Clear();
       h.SetRange(newmin, newmax, HistSize*50);
-      for(ConstVertexIterator vi = m.vert.begin(); vi != m.vert.end(); ++vi)
-        if(!(*vi).IsD() && ((!selectionOnly) || (*vi).IsS()) )
-          h.Add((*vi).Q());
+      ParallelChunkAccumulate(m.vert, h, h, 8, addVertexQuality, MergeHistogram);
     }
   }
 
@@ -452,6 +480,37 @@ public:
     return sum/(m.fn*3.0);
   }
 
+private:
+  // Accumulates addFunc(chunkAcc, elem) over the non deleted elements of <cont>, split in contiguous chunks
+  // processed in parallel, each chunk starting from a copy of <init>; the chunk results are then merged
+  // in order into <acc> with mergeFunc(acc, chunkAcc).
+  // The number of chunks depends only on the number of elements (and <maxChunkNum>, that bounds the memory
+  // when the accumulator is big), so the result does not depend on the number of threads.
+  // parallel::Reduce() does not fit here: it would copy the (possibly big) accumulator for every element.
+  template <class ContainerType, class AccumulatorType, class AddFunc, class MergeFunc>
+  static void ParallelChunkAccumulate(const ContainerType & cont, const AccumulatorType & init, AccumulatorType & acc,
+                                      int maxChunkNum, AddFunc addFunc, MergeFunc mergeFunc)
+  {
+    const int n = int(cont.size());
+    const int chunkNum = std::max(1, std::min(maxChunkNum, n/(1<<15)));
+    const int grain = std::max(1, (n + chunkNum - 1)/chunkNum);
+    std::vector<AccumulatorType> partial(parallel::ChunkNum(n, grain), init);
+    parallel::ForRange(n, grain, [&](int c, int b, int e){
+      for(int i=b; i<e; ++i)
+        if(!cont[i].IsD()) addFunc(partial[c], cont[i]);
+    });
+    for(size_t c=0; c<partial.size(); ++c)
+      mergeFunc(acc, partial[c]);
+  }
+
+  static void MergeMinMax(std::pair<ScalarType, ScalarType> &mm, const std::pair<ScalarType, ScalarType> &pm)
+  {
+    mm.first  = std::min(mm.first,  pm.first);
+    mm.second = std::max(mm.second, pm.second);
+  }
+  static void MergeHistogram(Histogram<ScalarType> &h, const Histogram<ScalarType> &ph) { h.Merge(ph); }
+  static void MergeDistribution(StreamingDistribution<ScalarType> &d, const StreamingDistribution<ScalarType> &pd) { d.Merge(pd); }
+
 }; // end class
 
 } //End Namespace tri
@@ -32,6 +32,7 @@
 #include <vcg/math/random_generator.h>
 #include <vcg/complex/algorithms/clean.h>
 #include <vcg/complex/algorithms/stat.h>
+#include <wrap/system/parallel.h>
 
 namespace vcg {
 namespace tri {
@@ -396,24 +397,19 @@ vcg::tri::UpdateColor<Mesh>::PerVertexBorderFlag(m.cm);
 
 	/*! \brief This function colores the faces of connected components of a mesh randomly.
 
-It require FaceFace Adjacency becouse it relies on the output of the ConnecteComponents();
+Components are computed by Clean::FaceVertexConnectedComponents(), so no adjacency is required.
 */
 	static void PerFaceRandomConnectedComponent( MeshType &m)
 	{
 		RequirePerFaceColor(m);
-		RequireFFAdjacency(m);
 
-		std::vector< std::pair<int, typename MeshType::FacePointer> > CCV;
-		int ScatterSize= std::min (100,tri::Clean<MeshType>::ConnectedComponents(m, CCV)); // number of random color to be used. Never use too many.
+		std::vector<int> faceCC;
+		int ScatterSize= std::min (100,tri::Clean<MeshType>::FaceVertexConnectedComponents(m, faceCC)); // number of random color to be used. Never use too many.
 
-		ConnectedComponentIterator<MeshType> ci;
-		for(unsigned int i=0;i<CCV.size();++i)
-		{
-			Color4b BaseColor = Color4b::Scatter(ScatterSize, i%ScatterSize,.4f,.7f);
-			std::vector<typename MeshType::FacePointer> FPV;
-			for(ci.start(m,CCV[i].second);!ci.completed();++ci)
-				(*ci)->C()=BaseColor;
-		}
+		parallel::For(int(m.face.size()), [&](int i) {
+			if(faceCC[i]>=0)
+				m.face[i].C() = Color4b::Scatter(ScatterSize, faceCC[i]%ScatterSize,.4f,.7f);
+		});
 	}
 
 	/*! \brief This function colores the face of a mesh randomly.
@@ -346,6 +346,13 @@ static void PerBitPolygonFaceNormalized(ComputeMeshType &m)
 }
 /// \brief Multiply the vertex normals by the matrix passed. By default, the scale component is removed.
 static void PerVertexMatrix(ComputeMeshType &m, const Matrix44<ScalarType> &mat, bool remove_scaling= true)
+{
+  PerVertexMatrix(m,mat,0,m.vert.size(),remove_scaling);
+}
+
+/// \brief Multiply the normals of the vertices in the index range [vBegin,vEnd) by the matrix passed.
+/// Disjoint ranges can be updated concurrently.
+static void PerVertexMatrix(ComputeMeshType &m, const Matrix44<ScalarType> &mat, size_t vBegin, size_t vEnd, bool remove_scaling= true)
 {
   tri::RequirePerVertexNormal(m);
     float scale;
@@ -361,13 +368,20 @@ static void PerVertexMatrix(ComputeMeshType &m, const Matrix44<ScalarType> &mat,
         mat33*=S;
     }
 
-  for(VertexIterator vi=m.vert.begin();vi!=m.vert.end();++vi)
-   if( !(*vi).IsD() && (*vi).IsRW() )
-     (*vi).N()  = mat33*(*vi).N();
+  for(size_t i=vBegin;i<vEnd;++i)
+   if( !m.vert[i].IsD() && m.vert[i].IsRW() )
+     m.vert[i].N()  = mat33*m.vert[i].N();
 }
 
 /// \brief Multiply the face normals by the matrix passed. By default, the scale component is removed.
 static void PerFaceMatrix(ComputeMeshType &m, const Matrix44<ScalarType> &mat, bool remove_scaling= true)
+{
+  PerFaceMatrix(m,mat,0,m.face.size(),remove_scaling);
+}
+
+/// \brief Multiply the normals of the faces in the index range [fBegin,fEnd) by the matrix passed.
+/// Disjoint ranges can be updated concurrently.
+static void PerFaceMatrix(ComputeMeshType &m, const Matrix44<ScalarType> &mat, size_t fBegin, size_t fEnd, bool remove_scaling= true)
 {
   tri::RequirePerFaceNormal(m);
   float scale;
@@ -383,9 +397,9 @@ static void PerFaceMatrix(ComputeMeshType &m, const Matrix44<ScalarType> &mat, b
         mat33[2][2]/=scale;
     }
 
-  for(FaceIterator fi=m.face.begin();fi!=m.face.end();++fi)
-   if( !(*fi).IsD() && (*fi).IsRW() )
-     (*fi).N() = mat33* (*fi).N();
+  for(size_t i=fBegin;i<fEnd;++i)
+   if( !m.face[i].IsD() && m.face[i].IsRW() )
+     m.face[i].N() = mat33* m.face[i].N();
 }
 
 /// \brief Compute per wedge normals taking into account the angle between adjacent faces.
@@ -59,16 +59,22 @@ typedef typename MeshType::FaceIterator   FaceIterator;
 /// \brief Multiply 
 static void Matrix(ComputeMeshType &m, const Matrix44<ScalarType> &M, bool update_also_normals = true)
 {
-	VertexIterator vi;
-	for(vi=m.vert.begin();vi!=m.vert.end();++vi)
-	        if(!(*vi).IsD()) (*vi).P()=M*(*vi).cP();
+	Matrix(m,M,0,m.vert.size(),0,m.face.size(),update_also_normals);
+}
+
+/// \brief Multiply only the vertices in the index range [vBegin,vEnd) and the face normals in [fBegin,fEnd),
+/// e.g. the part of a mesh added by an Append. Disjoint ranges can be transformed concurrently.
+static void Matrix(ComputeMeshType &m, const Matrix44<ScalarType> &M, size_t vBegin, size_t vEnd, size_t fBegin, size_t fEnd, bool update_also_normals = true)
+{
+	for(size_t i=vBegin;i<vEnd;++i)
+	        if(!m.vert[i].IsD()) m.vert[i].P()=M*m.vert[i].cP();
 
 	if(update_also_normals){
 		if(HasPerVertexNormal(m)){
-			UpdateNormal<ComputeMeshType>::PerVertexMatrix(m,M);
+			UpdateNormal<ComputeMeshType>::PerVertexMatrix(m,M,vBegin,vEnd);
 		}
 		if(HasPerFaceNormal(m)){
-			UpdateNormal<ComputeMeshType>::PerFaceMatrix(m,M);
+			UpdateNormal<ComputeMeshType>::PerFaceMatrix(m,M,fBegin,fEnd);
 		}
 	}
 }
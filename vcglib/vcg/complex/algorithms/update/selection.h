@@ -23,15 +23,277 @@
 #ifndef __VCG_TRI_UPDATE_SELECTION
 #define __VCG_TRI_UPDATE_SELECTION
 
+#include <atomic>
+#include <bitset>
 #include <deque>
+#include <map>
+#include <string>
+#include <stdint.h>
 
 #include <vcg/complex/base.h>
 #include <vcg/simplex/face/topology.h>
+#include <wrap/system/parallel.h>
 
 #include "flag.h"
 
 namespace vcg {
 namespace tri {
+/// \ingroup trimesh
+/// \brief A packed set of selection bits, one per element of a mesh container.
+/**
+  Bits are stored in 64 bit words, so that a selection of n elements takes n/8 bytes and
+  the set operations (and, or, xor, invert, count) work on whole words in parallel.
+  Bits past Size() in the last word are always kept to zero.
+  The selection flags of the mesh stay the authoritative selection: a bitset is a snapshot
+  taken with FromFlags() and written back with ToFlags(), it is not updated when the flags change.
+*/
+class SelectionBitSet
+{
+public:
+  typedef uint64_t WordType;
+  static const int WordBits = 64;
+
+  SelectionBitSet() : n(0) {}
+  explicit SelectionBitSet(size_t size) { Resize(size); }
+
+  void Resize(size_t size)
+  {
+    n = size;
+    w.assign((n + WordBits - 1) / WordBits, WordType(0));
+  }
+
+  size_t Size() const { return n; }
+  int WordNum() const { return int(w.size()); }
+  WordType &Word(int i) { return w[i]; }
+  WordType Word(int i) const { return w[i]; }
+
+  bool Test(size_t i) const { return (w[i / WordBits] >> (i % WordBits)) & 1; }
+  void Set(size_t i)        { w[i / WordBits] |=  (WordType(1) << (i % WordBits)); }
+  void Reset(size_t i)      { w[i / WordBits] &= ~(WordType(1) << (i % WordBits)); }
+
+  void SetAll()
+  {
+    std::fill(w.begin(), w.end(), ~WordType(0));
+    ClearTail();
+  }
+  void Clear() { std::fill(w.begin(), w.end(), WordType(0)); }
+
+  void Invert()
+  {
+    const int wn = WordNum();
+    parallel::For(wn, [&](int i) {
+      w[i] = ~w[i];
+    });
+    ClearTail();
+  }
+
+  /// the set operations require two sets of the same size
+  void And(const SelectionBitSet &b)
+  {
+    assert(b.n == n);
+    const int wn = WordNum();
+    parallel::For(wn, [&](int i) {
+      w[i] &= b.w[i];
+    });
+  }
+  void Or(const SelectionBitSet &b)
+  {
+    assert(b.n == n);
+    const int wn = WordNum();
+    parallel::For(wn, [&](int i) {
+      w[i] |= b.w[i];
+    });
+  }
+  void Xor(const SelectionBitSet &b)
+  {
+    assert(b.n == n);
+    const int wn = WordNum();
+    parallel::For(wn, [&](int i) {
+      w[i] ^= b.w[i];
+    });
+  }
+  void AndNot(const SelectionBitSet &b)
+  {
+    assert(b.n == n);
+    const int wn = WordNum();
+    parallel::For(wn, [&](int i) {
+      w[i] &= ~b.w[i];
+    });
+  }
+
+  size_t Count() const
+  {
+    const int wn = WordNum();
+    return parallel::Reduce(wn, size_t(0), [&](int i) {
+      return size_t(std::bitset<WordBits>(w[i]).count());
+    }, std::plus<size_t>());
+  }
+
+  bool operator==(const SelectionBitSet &b) const { return n == b.n && w == b.w; }
+  bool operator!=(const SelectionBitSet &b) const { return !(*this == b); }
+
+  /// Fill idx with the (increasing) positions of the set bits.
+  void Indices(std::vector<unsigned int> &idx) const
+  {
+    const int wn = WordNum();
+    std::vector<size_t> offset(wn + 1, 0);
+    parallel::For(wn, [&](int i) {
+      offset[i + 1] = std::bitset<WordBits>(w[i]).count();
+    });
+    for (int i = 0; i < wn; ++i)
+      offset[i + 1] += offset[i];
+    idx.resize(offset[wn]);
+    parallel::For(wn, [&](int i) {
+      size_t k = offset[i];
+      for (WordType b = w[i]; b != 0; b &= b - 1)
+        idx[k++] = (unsigned int)(size_t(i) * WordBits + LowestBit(b));
+    });
+  }
+
+  /// Store the selection flag of the elements of a container (e.g. m.vert or m.face).
+  /// Deleted elements get a zero bit.
+  /// Each word gathers its own 64 elements, so the flags are only read.
+  template <class ContainerType>
+  void FromFlags(const ContainerType &c)
+  {
+    Resize(c.size());
+    const int wn = WordNum();
+    parallel::For(wn, [&](int i) {
+      const size_t begin = size_t(i) * WordBits;
+      const size_t end = std::min(n, begin + WordBits);
+      WordType word = 0;
+      for (size_t j = begin; j < end; ++j)
+        if (!c[j].IsD() && c[j].IsS())
+          word |= WordType(1) << (j - begin);
+      w[i] = word;
+    });
+  }
+
+  /// Set the selection flag of the non deleted elements of a container to the stored bits.
+  template <class ContainerType>
+  void ToFlags(ContainerType &c) const
+  {
+    assert(c.size() == n);
+    const int sz = int(n);
+    parallel::For(sz, [&](int i) {
+      if (!c[i].IsD())
+      {
+        if (Test(i)) c[i].SetS();
+        else         c[i].ClearS();
+      }
+    });
+  }
+
+private:
+  void ClearTail()
+  {
+    if (n % WordBits != 0)
+      w.back() &= (WordType(1) << (n % WordBits)) - 1;
+  }
+
+  static int LowestBit(WordType b)
+  {
+    int pos = 0;
+    while (!(b & 1)) { b >>= 1; ++pos; }
+    return pos;
+  }
+
+  size_t n;
+  std::vector<WordType> w;
+};
+
+/// \ingroup trimesh
+/// \brief A set of selections saved by name.
+/**
+  Each saved selection keeps a SelectionBitSet for vertices, edges, faces and tetras,
+  so saving the selection of a mesh costs a bit per element and no per-element attribute.
+  Saved selections refer to element indices: they are dropped when restored on a mesh
+  whose containers have a different size (e.g. after a compaction).
+*/
+template <class ComputeMeshType>
+class SelectionStore
+{
+public:
+  enum RestoreMode { REPLACE, OR, AND, XOR, SUBTRACT };
+
+  struct Snapshot
+  {
+    SelectionBitSet vert, edge, face, tetra;
+  };
+
+  SelectionStore(ComputeMeshType &m) : _m(&m) {}
+
+  void Save(const std::string &name)
+  {
+    Snapshot &s = store[name];
+    s.vert.FromFlags(_m->vert);
+    s.edge.FromFlags(_m->edge);
+    s.face.FromFlags(_m->face);
+    s.tetra.FromFlags(_m->tetra);
+  }
+
+  /// Combine the current selection with the saved one according to the mode.
+  bool Restore(const std::string &name, RestoreMode mode = REPLACE)
+  {
+    typename std::map<std::string, Snapshot>::iterator si = store.find(name);
+    if (si == store.end()) return false;
+    Snapshot &s = si->second;
+    if (s.vert.Size() != _m->vert.size() || s.edge.Size() != _m->edge.size() ||
+        s.face.Size() != _m->face.size() || s.tetra.Size() != _m->tetra.size())
+    {
+      store.erase(si);
+      return false;
+    }
+    RestoreContainer(_m->vert, s.vert, mode);
+    RestoreContainer(_m->edge, s.edge, mode);
+    RestoreContainer(_m->face, s.face, mode);
+    RestoreContainer(_m->tetra, s.tetra, mode);
+    return true;
+  }
+
+  bool Has(const std::string &name) const { return store.find(name) != store.end(); }
+  const Snapshot *Get(const std::string &name) const
+  {
+    typename std::map<std::string, Snapshot>::const_iterator si = store.find(name);
+    return si == store.end() ? 0 : &si->second;
+  }
+  bool Remove(const std::string &name) { return store.erase(name) > 0; }
+  void Clear() { store.clear(); }
+
+  std::vector<std::string> Names() const
+  {
+    std::vector<std::string> names;
+    for (typename std::map<std::string, Snapshot>::const_iterator si = store.begin(); si != store.end(); ++si)
+      names.push_back(si->first);
+    return names;
+  }
+
+private:
+  template <class ContainerType>
+  static void RestoreContainer(ContainerType &c, const SelectionBitSet &saved, RestoreMode mode)
+  {
+    if (mode == REPLACE)
+    {
+      saved.ToFlags(c);
+      return;
+    }
+    SelectionBitSet cur;
+    cur.FromFlags(c);
+    switch (mode)
+    {
+    case OR:       cur.Or(saved);     break;
+    case AND:      cur.And(saved);    break;
+    case XOR:      cur.Xor(saved);    break;
+    case SUBTRACT: cur.AndNot(saved); break;
+    default: break;
+    }
+    cur.ToFlags(c);
+  }
+
+  ComputeMeshType *_m;
+  std::map<std::string, Snapshot> store;
+};
+
 /// \ingroup trimesh
 /// \brief A stack for saving and restoring selection.
 /**
@@ -203,23 +465,20 @@ typedef typename vcg::Box3<ScalarType>  Box3Type;
 /// \brief This function select all the vertices.
 static size_t VertexAll(MeshType &m)
 {
-  for(VertexIterator vi = m.vert.begin(); vi != m.vert.end(); ++vi)
-    if( !(*vi).IsD() )	(*vi).SetS();
+  SetAllS(m.vert, true);
   return m.vn;
 }
 
 /// \brief This function select all the edges.
 static size_t EdgeAll(MeshType &m)
 {
-  for(EdgeIterator ei = m.edge.begin(); ei != m.edge.end(); ++ei)
-    if( !(*ei).IsD() )	(*ei).SetS();
+  SetAllS(m.edge, true);
   return m.fn;
 }
 /// \brief This function select all the faces.
 static size_t FaceAll(MeshType &m)
 {
-  for(FaceIterator fi = m.face.begin(); fi != m.face.end(); ++fi)
-    if( !(*fi).IsD() )	(*fi).SetS();
+  SetAllS(m.face, true);
   return m.fn;
 }
 
@@ -236,24 +495,21 @@ static size_t TetraAll (MeshType & m)
 /// \brief This function clear the selection flag for all the vertices.
 static size_t VertexClear(MeshType &m)
 {
-  for(VertexIterator vi = m.vert.begin(); vi != m.vert.end(); ++vi)
-    if( !(*vi).IsD() )	(*vi).ClearS();
+  SetAllS(m.vert, false);
   return 0;
 }
 
 /// \brief This function clears the selection flag for all the edges.
 static size_t EdgeClear(MeshType &m)
 {
-  for(EdgeIterator ei = m.edge.begin(); ei != m.edge.end(); ++ei)
-    if( !(*ei).IsD() )	(*ei).ClearS();
+  SetAllS(m.edge, false);
   return 0;
 }
 
 /// \brief This function clears the selection flag for all the faces.
 static size_t FaceClear(MeshType &m)
 {
-  for(FaceIterator fi = m.face.begin(); fi != m.face.end(); ++fi)
-    if( !(*fi).IsD() )	(*fi).ClearS();
+  SetAllS(m.face, false);
   return 0;
 }
 
@@ -279,31 +535,19 @@ static void Clear(MeshType &m)
 /// \brief This function returns the number of selected faces.
 static size_t FaceCount(const MeshType &m)
 {
-  size_t selCnt=0;
-  ForEachFace(m, [&](const FaceType& f){
-    if(f.IsS()) ++selCnt;
-  });
-  return selCnt;
+  return CountS(m.face);
 }
 
 /// \brief This function returns the number of selected edges.
 static size_t EdgeCount(const MeshType &m)
 {
-  size_t selCnt=0;
-  ForEachEdge(m, [&](const EdgeType& e){
-    if(e.IsS()) ++selCnt;
-  });
-  return selCnt;
+  return CountS(m.edge);
 }
 
 /// \brief This function returns the number of selected vertices.
 static size_t VertexCount(const MeshType &m)
 {
-  size_t selCnt=0;
-  ForEachVertex(m, [&](const VertexType& v){
-    if(v.IsS()) ++selCnt;
-  });
-  return selCnt;
+  return CountS(m.vert);
 }
 
 /// \brief This function returns the number of selected tetras.
@@ -319,49 +563,19 @@ static size_t TetraCount (const MeshType & m)
 /// \brief This function inverts the selection flag for all the faces.
 static size_t FaceInvert(MeshType &m)
 {
-  size_t selCnt=0;
-  for(FaceIterator fi=m.face.begin();fi!=m.face.end();++fi)
-      if(!(*fi).IsD())
-      {
-        if((*fi).IsS()) (*fi).ClearS();
-        else {
-          (*fi).SetS();
-          ++selCnt;
-        }
-      }
-  return selCnt;
+  return InvertS(m.face);
 }
 
 /// \brief This function inverts the selection flag for all the edges.
 static size_t EdgeInvert(MeshType &m)
 {
-  size_t selCnt=0;
-  for(EdgeIterator ei=m.edge.begin();ei!=m.edge.end();++ei)
-      if(!(*ei).IsD())
-      {
-        if((*ei).IsS()) (*ei).ClearS();
-        else {
-          (*ei).SetS();
-          ++selCnt;
-        }
-      }
-  return selCnt;
+  return InvertS(m.edge);
 }
 
 /// \brief This function inverts the selection flag for all the vertices.
 static size_t VertexInvert(MeshType &m)
 {
-  size_t selCnt=0;
-  for(VertexIterator vi=m.vert.begin();vi!=m.vert.end();++vi)
-      if(!(*vi).IsD())
-      {
-        if((*vi).IsS()) (*vi).ClearS();
-        else {
-          (*vi).SetS();
-          ++selCnt;
-        }
-      }
-  return selCnt;
+  return InvertS(m.vert);
 }
 
 /// \brief This function inverts the selection flag for all the tetras.
@@ -385,29 +599,27 @@ static size_t TetraInvert (MeshType & m)
 /// \brief Select all the vertices that are touched by at least a single selected faces
 static size_t VertexFromFaceLoose(MeshType &m, bool preserveSelection=false)
 {
-  size_t selCnt=0;
-
   if(!preserveSelection) VertexClear(m);
-  for(FaceIterator fi = m.face.begin(); fi != m.face.end(); ++fi)
-    if( !(*fi).IsD() && (*fi).IsS())
-      for(int i = 0; i < (*fi).VN(); ++i)
-        if( !(*fi).V(i)->IsS()) { (*fi).V(i)->SetS(); ++selCnt; }
-  return selCnt;
+  std::vector<std::atomic<bool> > touched(m.vert.size());
+  MarkFaceVertices(m, touched, true);
+  return SelectMarked(m.vert, touched);
 }
 
 /// \brief Select all the vertices that are touched by at least a single selected edge
 static size_t VertexFromEdgeLoose(MeshType &m, bool preserveSelection=false)
 {
-  size_t selCnt=0;
-
   if(!preserveSelection) VertexClear(m);
-  for(EdgeIterator ei = m.edge.begin(); ei != m.edge.end(); ++ei)
-    if( !(*ei).IsD() && (*ei).IsS())
+  std::vector<std::atomic<bool> > touched(m.vert.size());
+  ClearMarks(touched);
+  const int en = int(m.edge.size());
+  parallel::For(en, [&](int i) {
+    if( !m.edge[i].IsD() && m.edge[i].IsS())
     {
-      if( !(*ei).V(0)->IsS()) { (*ei).V(0)->SetS(); ++selCnt; }
-      if( !(*ei).V(1)->IsS()) { (*ei).V(1)->SetS(); ++selCnt; }
+      touched[tri::Index(m, m.edge[i].cV(0))].store(true, std::memory_order_relaxed);
+      touched[tri::Index(m, m.edge[i].cV(1))].store(true, std::memory_order_relaxed);
     }
-  return selCnt;
+  });
+  return SelectMarked(m.vert, touched);
 }
 
 /// \brief Select ONLY the vertices that are touched ONLY by selected faces
@@ -415,62 +627,40 @@ static size_t VertexFromEdgeLoose(MeshType &m, bool preserveSelection=false)
 */
 static size_t VertexFromFaceStrict(MeshType &m, bool preserveSelection=false)
 {
-  SelectionStack<MeshType> ss(m);
-  if(preserveSelection) ss.push();  
-  VertexFromFaceLoose(m);
-  for(FaceIterator fi = m.face.begin(); fi != m.face.end(); ++fi)
-    if( !(*fi).IsD() && !(*fi).IsS())
-      for(int i = 0; i < (*fi).VN(); ++i)
-        (*fi).V(i)->ClearS();
+  std::vector<std::atomic<bool> > inSel(m.vert.size()), outSel(m.vert.size());
+  MarkFaceVertices(m, inSel, true);
+  MarkFaceVertices(m, outSel, false);
 
-  if(preserveSelection) ss.popOr();
-  return VertexCount(m);
+  return parallel::Reduce(int(m.vert.size()), size_t(0), [&](int i) -> size_t {
+    if(m.vert[i].IsD()) return 0;
+    if(inSel[i].load(std::memory_order_relaxed) && !outSel[i].load(std::memory_order_relaxed))
+      m.vert[i].SetS();
+    else if(!preserveSelection)
+      m.vert[i].ClearS();
+    return m.vert[i].IsS() ? 1 : 0;
+  }, std::plus<size_t>());
 }
 
 /// \brief Select ONLY the faces with ALL the vertices selected
 static size_t FaceFromVertexStrict(MeshType &m, bool preserveSelection=false)
 {
-  SelectionStack<MeshType> ss(m);
-  if(preserveSelection) ss.push();
-  size_t selCnt=0;
-  FaceClear(m);
-  for(FaceIterator fi = m.face.begin(); fi != m.face.end(); ++fi)
-    if( !(*fi).IsD())
-    {
-      bool selFlag=true;
-      for(int i = 0; i < (*fi).VN(); ++i)
-        if(!(*fi).V(i)->IsS())
-          selFlag =false;
-      if(selFlag)
-      {
-        (*fi).SetS();
-        ++selCnt;
-      }
-    }
-  
-  if(preserveSelection) ss.popOr();
-  return selCnt;
+  return SelectIf(m.face, [](const FaceType &f) {
+    for(int j = 0; j < f.VN(); ++j)
+      if(!f.cV(j)->IsS())
+        return false;
+    return true;
+  }, preserveSelection);
 }
 
 /// \brief Select all the faces with at least one selected vertex
 static size_t FaceFromVertexLoose(MeshType &m, bool preserveSelection=false)
 {
-  size_t selCnt=0;
-  if(!preserveSelection) FaceClear(m);
-  for(FaceIterator fi = m.face.begin(); fi != m.face.end(); ++fi)
-    if( !(*fi).IsD())
-    {
-      bool selVert=false;
-      for(int i = 0; i < (*fi).VN(); ++i)
-        if((*fi).V(i)->IsS()) 
-            selVert=true;
-
-      if(selVert) {
-        (*fi).SetS();
-        ++selCnt;
-      }
-    }
-  return selCnt;
+  return SelectIf(m.face, [](const FaceType &f) {
+    for(int j = 0; j < f.VN(); ++j)
+      if(f.cV(j)->IsS())
+        return true;
+    return false;
+  }, preserveSelection);
 }
 /// \brief This function dilate the face selection by simply first selecting all the vertices touched by the faces and then all the faces touched by these vertices 
 /// Note: it destroys the vertex selection. 
@@ -488,68 +678,71 @@ static size_t FaceErode(MeshType &m)
   return tri::UpdateSelection<MeshType>::FaceFromVertexStrict(m);  
 }
 
+/// \brief Dilate a face selection stored in a bitset (one bit per face) without touching the flags.
+/// Like FaceDilate(m), it adds all the faces sharing a vertex with a selected face; returns the number of selected faces.
+static size_t FaceDilate(const MeshType &m, SelectionBitSet &fs)
+{
+  std::vector<std::atomic<bool> > inSel(m.vert.size());
+  MarkFaceVertices(m, fs, inSel, true);
+  return FaceBitsIf(m, fs, [&](const FaceType &f) {
+    for(int j = 0; j < f.VN(); ++j)
+      if(inSel[tri::Index(m, f.cV(j))].load(std::memory_order_relaxed)) return true;
+    return false;
+  });
+}
+
+/// \brief Erode a face selection stored in a bitset (one bit per face) without touching the flags.
+/// Like FaceErode(m), it keeps only the faces whose vertices are not shared with an unselected face; returns the number of selected faces.
+static size_t FaceErode(const MeshType &m, SelectionBitSet &fs)
+{
+  std::vector<std::atomic<bool> > outSel(m.vert.size());
+  MarkFaceVertices(m, fs, outSel, false);
+  return FaceBitsIf(m, fs, [&](const FaceType &f) {
+    for(int j = 0; j < f.VN(); ++j)
+      if(outSel[tri::Index(m, f.cV(j))].load(std::memory_order_relaxed)) return false;
+    return true;
+  });
+}
+
+/// \brief Store the vertex selection in a bitset (see SelectionBitSet)
+static void VertexToBitSet(const MeshType &m, SelectionBitSet &bs) { bs.FromFlags(m.vert); }
+/// \brief Store the face selection in a bitset (see SelectionBitSet)
+static void FaceToBitSet(const MeshType &m, SelectionBitSet &bs) { bs.FromFlags(m.face); }
+/// \brief Set the vertex selection from a bitset with one bit per vertex; returns the number of selected vertices
+static size_t VertexFromBitSet(MeshType &m, const SelectionBitSet &bs) { bs.ToFlags(m.vert); return bs.Count(); }
+/// \brief Set the face selection from a bitset with one bit per face; returns the number of selected faces
+static size_t FaceFromBitSet(MeshType &m, const SelectionBitSet &bs) { bs.ToFlags(m.face); return bs.Count(); }
 
 /// \brief This function select the vertices with the border flag set
 static size_t VertexFromBorderFlag(MeshType &m, bool preserveSelection=false)
 {
-  size_t selCnt=0;
-  if(!preserveSelection) VertexClear(m);
-  for(VertexIterator vi = m.vert.begin(); vi != m.vert.end(); ++vi)
-    if( !(*vi).IsD() )
-    {
-      if((*vi).IsB() )
-      {
-        (*vi).SetS();
-        ++selCnt;
-      }
-    }
-  return selCnt;
+  return SelectIf(m.vert, [](const VertexType &v) { return v.IsB(); }, preserveSelection);
 }
 
 /// \brief This function select the faces that have an edge with the border flag set.
 static size_t FaceFromBorderFlag(MeshType &m, bool preserveSelection=false)
 {
   tri::RequireTriangularMesh(m);
-  size_t selCnt=0;
-  if(!preserveSelection) FaceClear(m);
-  for(FaceIterator fi = m.face.begin(); fi != m.face.end(); ++fi)
-    if( !(*fi).IsD() )
-    {
-      bool bordFlag=false;
-      for(int i = 0; i < 3; ++i)
-        if((*fi).IsB(i)) bordFlag=true;
-      if(bordFlag)
-      {
-        (*fi).SetS();
-        ++selCnt;
-      }
-    }
-  return selCnt;
+  return SelectIf(m.face, [](const FaceType &f) {
+    return f.IsB(0) || f.IsB(1) || f.IsB(2);
+  }, preserveSelection);
 }
 
 /// \brief This function select the faces that have an edge outside the given range.
 /// You can skip the second parameter to choose all the edges smaller than a given lenght
 static size_t FaceOutOfRangeEdge(MeshType &m, ScalarType MinEdgeThr, ScalarType MaxEdgeThr=(std::numeric_limits<ScalarType>::max)(), bool preserveSelection=false)
 {
-  if(!preserveSelection) FaceClear(m);
-  size_t selCnt = 0;
   MinEdgeThr=MinEdgeThr*MinEdgeThr;
   MaxEdgeThr=MaxEdgeThr*MaxEdgeThr;
-  for(FaceIterator fi=m.face.begin(); fi!=m.face.end();++fi)
-    if(!(*fi).IsD())
-      {
-        for(int i=0;i<(*fi).VN();++i)
-        {
-          const ScalarType squaredEdge=SquaredDistance((*fi).V0(i)->cP(),(*fi).V1(i)->cP());
-          if((squaredEdge<=MinEdgeThr) || (squaredEdge>=MaxEdgeThr) )
-          {
-            selCnt++;
-            (*fi).SetS();
-            break; // skip the rest of the edges of the tri
-          }
-        }
-      }
-      return selCnt;
+  return SelectIf(m.face, [&](FaceType &f) {
+    for(int i=0;i<f.VN();++i)
+    {
+      const ScalarType squaredEdge=SquaredDistance(f.V0(i)->cP(),f.V1(i)->cP());
+      if((squaredEdge<=MinEdgeThr) || (squaredEdge>=MaxEdgeThr) )
+        return true;
+    }
+    return false;
+  }, preserveSelection);
 }
 
 /// \brief This function expand current selection to cover the whole connected component.
@@ -557,82 +750,78 @@ static size_t FaceConnectedFF(MeshType &m)
 {
   // it also assumes that the FF adjacency is well computed.
   RequireFFAdjacency(m);
-  UpdateFlags<MeshType>::FaceClearV(m);
-  
-  std::deque<FacePointer> visitStack;
+
+  // breadth first visit, one level at a time; a face is claimed by the first thread
+  // that reaches it so that each face enters the frontier only once. Every range of the
+  // frontier collects the faces it reaches in its own list.
+  const int fn = int(m.face.size());
+  std::vector<std::atomic<bool> > reached(fn);
+  std::vector<int> frontier;
+  for(int i = 0; i < fn; ++i)
+  {
+    const bool sel = !m.face[i].IsD() && m.face[i].IsS();
+    reached[i].store(sel, std::memory_order_relaxed);
+    if(sel) frontier.push_back(i);
+  }
+
   size_t selCnt=0;
-  for(FaceIterator fi = m.face.begin(); fi != m.face.end(); ++fi)
-    if( !(*fi).IsD() && (*fi).IsS() && !(*fi).IsV() )
-      visitStack.push_back(&*fi);
-  
-  while(!visitStack.empty())
+  std::vector<int> next;
+  while(!frontier.empty())
   {
-    FacePointer fp = visitStack.front();
-    visitStack.pop_front();
-    assert(!fp->IsV());
-    fp->SetV();
-    for(int i=0;i<fp->VN();++i) {
-      FacePointer ff = fp->FFp(i);
-      if(! ff->IsS())
+    const int frontierSize = int(frontier.size());
+    const int grain = std::max(1024, (frontierSize + 63) / 64);
+    std::vector<std::vector<int> > chunkNext(parallel::ChunkNum(frontierSize, grain));
+    parallel::ForRange(frontierSize, grain, [&](int chunk, int b, int e) {
+      for(int k = b; k < e; ++k)
       {
-        ff->SetS();
-        ++selCnt;
-        visitStack.push_back(ff);
-        assert(!ff->IsV());
+        const FaceType &f = m.face[frontier[k]];
+        for(int i=0;i<f.VN();++i)
+        {
+          const int ffi = int(tri::Index(m, f.cFFp(i)));
+          if(!reached[ffi].load(std::memory_order_relaxed) && !reached[ffi].exchange(true))
+            chunkNext[chunk].push_back(ffi);
+        }
       }
-    }
+    });
+    next.clear();
+    for(size_t c = 0; c < chunkNext.size(); ++c)
+      next.insert(next.end(), chunkNext[c].begin(), chunkNext[c].end());
+    selCnt += next.size();
+    frontier.swap(next);
   }
+
+  // the visited flag marks the faces of the selected components, as the serial visit did
+  parallel::For(fn, [&](int i) {
+    if(!m.face[i].IsD())
+    {
+      if(reached[i].load(std::memory_order_relaxed)) { m.face[i].SetS(); m.face[i].SetV(); }
+      else m.face[i].ClearV();
+    }
+  });
   return selCnt;
 }
 /// \brief Select the faces whose quality is in the specified closed interval.
 static size_t FaceFromQualityRange(MeshType &m,float minq, float maxq, bool preserveSelection=false)
 {
-  size_t selCnt=0;
-  if(!preserveSelection) FaceClear(m);
   RequirePerFaceQuality(m);
-  for(FaceIterator fi=m.face.begin();fi!=m.face.end();++fi)
-      if(!(*fi).IsD())
-      {
-        if( (*fi).Q()>=minq &&  (*fi).Q()<=maxq )
-          {
-            (*fi).SetS();
-            ++selCnt;
-          }
-      }
-  return selCnt;
+  return SelectIf(m.face, [&](const FaceType &f) {
+    return f.cQ()>=minq && f.cQ()<=maxq;
+  }, preserveSelection);
 }
 
 /// \brief Select the vertices whose quality is in the specified closed interval.
 static size_t VertexFromQualityRange(MeshType &m,float minq, float maxq, bool preserveSelection=false)
 {
-  size_t selCnt=0;
-  if(!preserveSelection) VertexClear(m);
   RequirePerVertexQuality(m);
-  for(VertexIterator vi=m.vert.begin();vi!=m.vert.end();++vi)
-      if(!(*vi).IsD())
-      {
-        if( (*vi).Q()>=minq &&  (*vi).Q()<=maxq )
-                    {
-                        (*vi).SetS();
-                        ++selCnt;
-                    }
-      }
-  return selCnt;
+  return SelectIf(m.vert, [&](const VertexType &v) {
+    return v.cQ()>=minq && v.cQ()<=maxq;
+  }, preserveSelection);
 }
 
 /// \brief Select the vertices contained in the specified Box
 static size_t VertexInBox( MeshType & m, const Box3Type &bb, bool preserveSelection=false)
 {
-  if(!preserveSelection) VertexClear(m);
-  int selCnt=0;
-  for (VertexIterator vi = m.vert.begin(); vi != m.vert.end(); ++vi) if(!(*vi).IsD())
-  {
-    if(bb.IsIn((*vi).cP()) ) {
-      (*vi).SetS();
-      ++selCnt;
-    }
-  }
-  return selCnt;
+  return SelectIf(m.vert, [&](const VertexType &v) { return bb.IsIn(v.cP()); }, preserveSelection);
 }
 
 /// \brief Select the border vertices that form a corner along the border
@@ -679,6 +868,119 @@ void VertexNonManifoldEdges(MeshType &m, bool preserveSelection=false)
     }
 }
 
+private:
+/// Select the non deleted elements of a container for which pred holds; the others are
+/// unselected unless preserveSelection is set. Returns the number of elements satisfying pred.
+template <class ContainerType, class Pred>
+static size_t SelectIf(ContainerType &c, Pred pred, bool preserveSelection)
+{
+  const int n = int(c.size());
+  return parallel::Reduce(n, size_t(0), [&](int i) -> size_t {
+    if(c[i].IsD()) return 0;
+    if(pred(c[i])) { c[i].SetS(); return 1; }
+    if(!preserveSelection) c[i].ClearS();
+    return 0;
+  }, std::plus<size_t>());
+}
+
+template <class ContainerType>
+static void SetAllS(ContainerType &c, bool sel)
+{
+  const int n = int(c.size());
+  parallel::For(n, [&](int i) {
+    if(!c[i].IsD())
+    {
+      if(sel) c[i].SetS();
+      else    c[i].ClearS();
+    }
+  });
+}
+
+template <class ContainerType>
+static size_t CountS(const ContainerType &c)
+{
+  const int n = int(c.size());
+  return parallel::Reduce(n, size_t(0), [&](int i) -> size_t {
+    return (!c[i].IsD() && c[i].IsS()) ? 1 : 0;
+  }, std::plus<size_t>());
+}
+
+template <class ContainerType>
+static size_t InvertS(ContainerType &c)
+{
+  const int n = int(c.size());
+  return parallel::Reduce(n, size_t(0), [&](int i) -> size_t {
+    if(c[i].IsD()) return 0;
+    if(c[i].IsS()) { c[i].ClearS(); return 0; }
+    c[i].SetS();
+    return 1;
+  }, std::plus<size_t>());
+}
+
+template <class MarkType>
+static void ClearMarks(std::vector<MarkType> &mark)
+{
+  const int n = int(mark.size());
+  parallel::For(n, [&](int i) {
+    mark[i].store(false, std::memory_order_relaxed);
+  });
+}
+
+/// Mark the vertices of the faces whose selection flag is equal to faceSel.
+/// Faces sharing a vertex write the same value, so the marks need no ordering.
+static void MarkFaceVertices(const MeshType &m, std::vector<std::atomic<bool> > &mark, bool faceSel)
+{
+  ClearMarks(mark);
+  const int fn = int(m.face.size());
+  parallel::For(fn, [&](int i) {
+    const FaceType &f = m.face[i];
+    if(!f.IsD() && f.IsS() == faceSel)
+      for(int j = 0; j < f.VN(); ++j)
+        mark[tri::Index(m, f.cV(j))].store(true, std::memory_order_relaxed);
+  });
+}
+
+/// As above, for the face selection stored in fs.
+static void MarkFaceVertices(const MeshType &m, const SelectionBitSet &fs, std::vector<std::atomic<bool> > &mark, bool faceSel)
+{
+  assert(fs.Size() == m.face.size());
+  ClearMarks(mark);
+  parallel::For(int(m.face.size()), [&](int i) {
+    const FaceType &f = m.face[i];
+    if(!f.IsD() && fs.Test(i) == faceSel)
+      for(int j = 0; j < f.VN(); ++j)
+        mark[tri::Index(m, f.cV(j))].store(true, std::memory_order_relaxed);
+  });
+}
+
+/// Set the bit of the non deleted faces for which pred holds and clear the others.
+/// Each word is rebuilt by a single thread, so the bits need no synchronization.
+template <class Pred>
+static size_t FaceBitsIf(const MeshType &m, SelectionBitSet &fs, Pred pred)
+{
+  const size_t fn = m.face.size();
+  parallel::For(fs.WordNum(), [&](int i) {
+    const size_t begin = size_t(i) * SelectionBitSet::WordBits;
+    const size_t end = std::min(fn, begin + SelectionBitSet::WordBits);
+    SelectionBitSet::WordType word = 0;
+    for(size_t j = begin; j < end; ++j)
+      if(!m.face[j].IsD() && pred(m.face[j]))
+        word |= SelectionBitSet::WordType(1) << (j - begin);
+    fs.Word(i) = word;
+  });
+  return fs.Count();
+}
+
+/// Select the marked vertices; returns how many of them were not already selected.
+static size_t SelectMarked(typename MeshType::VertContainer &vert, const std::vector<std::atomic<bool> > &mark)
+{
+  return parallel::Reduce(int(vert.size()), size_t(0), [&](int i) -> size_t {
+    if(vert[i].IsD() || vert[i].IsS() || !mark[i].load(std::memory_order_relaxed)) return 0;
+    vert[i].SetS();
+    return 1;
+  }, std::plus<size_t>());
+}
+
 }; // end class
 
 }	// End namespace
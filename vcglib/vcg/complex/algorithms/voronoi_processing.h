@@ -30,6 +30,7 @@
 #include<vcg/complex/algorithms/smooth.h>
 #include<vcg/space/fitting3.h>
 #include<wrap/callback.h>
+#include<wrap/system/parallel.h>
 
 namespace vcg
 {
@@ -102,9 +103,11 @@ class VoronoiProcessing
   typedef typename face::Pos<FaceType>        PosType;
 
 public:
+	// One generator per thread, so that meshes processed concurrently get the same sequence
+	// they would get alone (e.g. the connected components in the Remesher).
 	static math::MarsenneTwisterRNG &RandomGenerator()
     {
-        static math::MarsenneTwisterRNG rnd;
+        static thread_local math::MarsenneTwisterRNG rnd;
         return rnd;
     }
 
@@ -1008,14 +1011,30 @@ struct QuadricSumDistance
   }
 };
 
+/// Group the vertex indexes by region: the vertices of region r (region[i]==r) are
+/// vertIdx[start[r]] .. vertIdx[start[r+1]-1], in mesh order.
+/// The regions can then be processed in parallel, each one accumulating its vertices
+/// in the same order of a serial scan of the mesh.
+static void GroupVerticesByRegion(const std::vector<int> &region, int regionNum,
+                                  std::vector<int> &start, std::vector<int> &vertIdx)
+{
+  start.assign(regionNum+1,0);
+  for(size_t i=0;i<region.size();++i)
+    ++start[region[i]+1];
+  for(int r=0;r<regionNum;++r)
+    start[r+1]+=start[r];
+  std::vector<int> pos(start.begin(),start.end()-1);
+  vertIdx.resize(region.size());
+  for(size_t i=0;i<region.size();++i)
+    vertIdx[pos[region[i]]++]=int(i);
+}
+
 /// \brief Relax the seeds of a Voronoi diagram according to the quadric distance rule.
 ///
 /// For each region it search the vertex that minimize the sum of the squared distance
 /// from all the points of the region.
 ///
-/// It uses a vector of QuadricSumDistances;
-/// for simplicity it is sized as the vertex vector even if only the ones of the quadric
-/// corresponding to seeds are actually used.
+/// The vertices are grouped by region and the regions are processed in parallel.
 ///
 /// It return true if at least one seed changed position.
 ///
@@ -1032,41 +1051,49 @@ static bool QuadricRelax(MeshType &m, std::vector<VertexType *> &seedVec,
   PerVertexPointerHandle sources = tri::Allocator<MeshType>:: template GetPerVertexAttribute<VertexPointer> (m,"sources");
   PerVertexBoolHandle fixed = tri::Allocator<MeshType>:: template GetPerVertexAttribute<bool> (m,"fixed");
 
-  QuadricSumDistance dz;
-  std::vector<QuadricSumDistance> dVec(m.vert.size(),dz);
-  for(VertexIterator vi=m.vert.begin();vi!=m.vert.end();++vi)
+  const int vn = int(m.vert.size());
+  std::vector<int> region(vn);
+  for(int i=0;i<vn;++i)
   {
-    assert(sources[vi]!=0);
-    int seedIndex = tri::Index(m,sources[vi]);
-    // When constraining seeds movement we move selected seeds only onto other selected vertices
-    if(vpp.constrainSelectedSeed)
-    { // So we sum only the contribs of the selected vertices
-      if( (sources[vi]->IsS() && vi->IsS()) || (!sources[vi]->IsS()))
-        dVec[seedIndex].AddPoint(vi->P());
-    }
-    else
-      dVec[seedIndex].AddPoint(vi->P());
+    assert(sources[size_t(i)]!=0);
+    region[i] = tri::Index(m,sources[size_t(i)]);
   }
+  std::vector<int> start, vertIdx;
+  GroupVerticesByRegion(region,vn,start,vertIdx);
 
-  // Search the local maxima for each region and use them as new seeds
+  // For each region sum the quadric of its points and search its local maxima,
+  // that is used as new seed
   std::pair<float,VertexPointer> zz(std::numeric_limits<ScalarType>::max(), static_cast<VertexPointer>(0));
   std::vector< std::pair<float,VertexPointer> > seedMaximaVec(m.vert.size(),zz);
-  for(VertexIterator vi=m.vert.begin();vi!=m.vert.end();++vi)
+  parallel::For(vn, [&](int seedIndex)
   {
-    assert(sources[vi]!=0);
-    int seedIndex = tri::Index(m,sources[vi]);
-    ScalarType val = dVec[seedIndex].Eval(vi->P());
-    vi->Q()=val;
-    // if constrainSelectedSeed we search only among selected vertices
-    if(!vpp.constrainSelectedSeed || !sources[vi]->IsS() || vi->IsS())
+    if(start[seedIndex]==start[seedIndex+1]) return;
+    const bool seedSelected = m.vert[seedIndex].IsS();
+    QuadricSumDistance dz;
+    for(int k=start[seedIndex];k<start[seedIndex+1];++k)
     {
-      if(seedMaximaVec[seedIndex].first > val)
+      const VertexType &v = m.vert[vertIdx[k]];
+      // When constraining seeds movement we move selected seeds only onto other selected vertices
+      // So we sum only the contribs of the selected vertices
+      if(!vpp.constrainSelectedSeed || !seedSelected || v.IsS())
+        dz.AddPoint(v.cP());
+    }
+    for(int k=start[seedIndex];k<start[seedIndex+1];++k)
+    {
+      VertexType &v = m.vert[vertIdx[k]];
+      ScalarType val = dz.Eval(v.cP());
+      v.Q()=val;
+      // if constrainSelectedSeed we search only among selected vertices
+      if(!vpp.constrainSelectedSeed || !seedSelected || v.IsS())
       {
-        seedMaximaVec[seedIndex].first = val;
-        seedMaximaVec[seedIndex].second = &*vi;
+        if(seedMaximaVec[seedIndex].first > val)
+        {
+          seedMaximaVec[seedIndex].first = val;
+          seedMaximaVec[seedIndex].second = &v;
+        }
       }
     }
-  }
+  });
 
   if(vpp.colorStrategy==VoronoiProcessingParameter::DistanceFromBorder)
     tri::UpdateColor<MeshType>::PerVertexQualityRamp(m);
@@ -1219,16 +1246,32 @@ static int RestrictedVoronoiRelaxing(MeshType &m, std::vector<CoordType> &seedPo
     VectorConstDataWrapper<std::vector<CoordType> > vdw(seedPosVec);
     KdTree<ScalarType> seedTree(vdw);
 
-    std::vector<std::pair<ScalarType,CoordType> > sumVec(seedPosVec.size(),std::make_pair(0,CoordType(0,0,0)));
-    for(VertexIterator vi=m.vert.begin();vi!=m.vert.end();++vi)
+    // Assign each vertex to the closest seed and compute the area weighted barycenter
+    // of each region; both run in parallel, the sums follow the mesh order as in a serial scan.
+    const int vn = int(m.vert.size());
+    const int sn = int(seedPosVec.size());
+    std::vector<int> region(vn);
+    parallel::For(vn, [&](int j)
     {
       unsigned int seedInd;
       ScalarType sqdist;
-      seedTree.doQueryClosest(vi->P(),seedInd,sqdist);
-      vi->Q()=sqrt(sqdist);
-      sumVec[seedInd].first+=area[vi];
-      sumVec[seedInd].second+=vi->cP()*area[vi];
-    }
+      seedTree.doQueryClosest(m.vert[j].P(),seedInd,sqdist);
+      m.vert[j].Q()=sqrt(sqdist);
+      region[j]=int(seedInd);
+    });
+    std::vector<int> start, vertIdx;
+    GroupVerticesByRegion(region,sn,start,vertIdx);
+
+    std::vector<std::pair<ScalarType,CoordType> > sumVec(seedPosVec.size(),std::make_pair(0,CoordType(0,0,0)));
+    parallel::For(sn, [&](int seedInd)
+    {
+      for(int k=start[seedInd];k<start[seedInd+1];++k)
+      {
+        const size_t j = size_t(vertIdx[k]);
+        sumVec[seedInd].first+=area[j];
+        sumVec[seedInd].second+=m.vert[j].cP()*area[j];
+      }
+    });
 
     vector<CoordType> newseedVec;
     vector<bool> newfixedVec;
@@ -31,6 +31,7 @@
 #include <vcg/complex/algorithms/voronoi_processing.h>
 #include <vcg/complex/algorithms/point_sampling.h>
 #include <vcg/complex/algorithms/crease_cut.h>
+#include <wrap/system/parallel.h>
 //#include <vcg/complex/algorithms/curve_on_manifold.h>
 
 #include <memory>
@@ -229,13 +230,19 @@ public:
 			return RemeshOneCC(original, samplingRadius, borderAngleDeg);
 		}
 
-		// Multiple CCs
+		// Multiple CCs: they are independent and are remeshed concurrently,
+		// the largest ones first to balance the load
 //		std::cout << "Remeshing " << ccs.size() << " components" << std::endl;
+		std::vector<int> order(ccs.size());
 		for (size_t i=0; i<ccs.size(); i++)
+			order[i] = int(i);
+		std::stable_sort(order.begin(), order.end(), [&ccs](int a, int b) { return ccs[a]->FN() > ccs[b]->FN(); });
+		parallel::For(int(order.size()), [&](int k)
 		{
+			const int i = order[k];
 //			std::cout << "Remeshing component " << (i+1) << "/" << ccs.size() << std::endl;
 			ccs[i] = RemeshOneCC(*ccs[i], samplingRadius, borderAngleDeg, i);
-		}
+		}, 0, "", 1);
 
 		MeshPtr ret = std::make_shared<Mesh>();
 		for (MeshPtr & mesh : ccs)
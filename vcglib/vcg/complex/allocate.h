@@ -209,12 +209,20 @@ public:
 
     pu.newBase = &*m.vert.begin();
     pu.newEnd =  &m.vert.back()+1;
+    FaceVectorSetVertexBase(m.face,m.vert);
     if(pu.NeedUpdate())
     {
-      for (FaceIterator fi=m.face.begin(); fi!=m.face.end(); ++fi)
-        if(!(*fi).IsD())
-          for(int i=0; i < (*fi).VN(); ++i)
-            if ((*fi).cV(i)!=0) pu.Update((*fi).V(i));
+      // faces that store vertex indexes only need the new base set above
+      if(!FaceType::HasVertexRefIdx())
+        for (FaceIterator fi=m.face.begin(); fi!=m.face.end(); ++fi)
+          if(!(*fi).IsD())
+            for(int i=0; i < (*fi).VN(); ++i)
+              if ((*fi).cV(i)!=0)
+              {
+                VertexPointer vp=(*fi).V(i);
+                pu.Update(vp);
+                (*fi).V(i)=vp;
+              }
 
       for (EdgeIterator ei=m.edge.begin(); ei!=m.edge.end(); ++ei)
         if(!(*ei).IsD())
@@ -638,6 +646,7 @@ public:
     // The actual resize
     m.face.resize(m.face.size()+n);
     m.fn+=int(n);
+    FaceVectorSetVertexBase(m.face,m.vert);
 
     size_t siz=(size_t)(m.face.size()-n);
     FaceIterator firstNewFace = m.face.begin();
@@ -998,6 +1007,7 @@ public:
     // setup the pointer updater
     pu.newBase  = (m.vert.empty())?0:&m.vert[0];
     pu.newEnd = (m.vert.empty())?0:&m.vert.back()+1;
+    FaceVectorSetVertexBase(m.face,m.vert);
 
     // resize the optional atttributes in m.vert_attr to reflect the changes
     ResizeAttribute(m.vert_attr,m.vn,m);
@@ -25,6 +25,7 @@
 
 #include <vcg/complex/allocate.h>
 #include <vcg/complex/algorithms/update/selection.h>
+#include <wrap/system/parallel.h>
 
 namespace vcg {
 namespace tri {
@@ -376,26 +377,7 @@ static void MeshAppendConst(
 	// phase 1.5
 	// manage textures, creating a new one only when necessary
 	// (not making unuseful duplicates on append) and save a mapping
-
-	// for each texture in the right mesh, it maps it to the texture index in the
-	// left mesh
-	std::vector<unsigned int> mappingTextures(mr.textures.size());
-
-	unsigned int baseMlT = ml.textures.size();
-	for (unsigned int i = 0; i < mr.textures.size(); ++i) {
-		auto it = std::find(ml.textures.begin(), ml.textures.end(), mr.textures[i]);
-		//if the right texture does not exists in the left mesh
-		if (it == ml.textures.end()) {
-			//add the texture in the left mesh and create the mapping
-			mappingTextures[i] = baseMlT++;
-			ml.textures.push_back(mr.textures[i]);
-		}
-		else {
-			//the ith right texture will map in the texture found in the left mesh
-			mappingTextures[i] = it - ml.textures.begin();
-		}
-	}
-	//ml.textures.insert(ml.textures.end(), mr.textures.begin(),mr.textures.end());
+	std::vector<unsigned int> mappingTextures = MergeTextures(ml, mr);
 
 	// phase 2.
 	// copy data from mr to its corresponding elements in ml and adjacencies
@@ -585,6 +567,147 @@ static void MeshAppendConst(
 	//        }
 }
 
+/**
+ * @brief Meshes
+ * Append all the meshes of mrs to ml.
+ * The containers of ml are grown only once to their final size, then each right
+ * mesh is copied into its own slice of vertices, edges and faces; the meshes are
+ * copied concurrently. Textures are merged as in MeshAppendConst. Adjacency
+ * relations, half edges, tetras and user defined attributes are not copied.
+ * @param onlyReferenced if true the vertices not referenced by any face or edge are skipped
+ * @param vertOffset if not null, it is filled with the index in ml.vert of the first vertex
+ *        copied from each right mesh, followed by the final size of ml.vert
+ * @param faceOffset the same for the faces
+ */
+static void Meshes(
+		MeshLeft& ml,
+		const std::vector<const ConstMeshRight*>& mrs,
+		const bool onlyReferenced = false,
+		std::vector<size_t>* vertOffset = 0,
+		std::vector<size_t>* faceOffset = 0)
+{
+	const int mn = int(mrs.size());
+
+	// phase 1. index of each copied vertex inside the slice of its mesh, and slice sizes
+	std::vector< std::vector<size_t> > vertRemap(mn);
+	std::vector<size_t> vOff(mn+1, 0), eOff(mn+1, 0), fOff(mn+1, 0);
+	parallel::For(mn, [&](int k) {
+		const ConstMeshRight& mr = *mrs[k];
+		std::vector<size_t>& rv = vertRemap[k];
+		rv.assign(mr.vert.size(), Remap::InvalidIndex());
+		std::vector<bool> referred(mr.vert.size(), !onlyReferenced);
+		if(onlyReferenced)
+		{
+			for(size_t i = 0; i < mr.face.size(); ++i)
+				if(!mr.face[i].IsD())
+					for(int j = 0; j < mr.face[i].VN(); ++j)
+						referred[Index(mr, mr.face[i].cV(j))] = true;
+			for(size_t i = 0; i < mr.edge.size(); ++i)
+				if(!mr.edge[i].IsD())
+					for(int j = 0; j < 2; ++j)
+						referred[Index(mr, mr.edge[i].cV(j))] = true;
+		}
+		size_t cnt = 0;
+		for(size_t i = 0; i < mr.vert.size(); ++i)
+			if(!mr.vert[i].IsD() && referred[i])
+				rv[i] = cnt++;
+		vOff[k+1] = cnt;
+		eOff[k+1] = mr.en;
+		fOff[k+1] = mr.fn;
+	}, 0, "", 1);
+	vOff[0] = ml.vert.size();
+	eOff[0] = ml.edge.size();
+	fOff[0] = ml.face.size();
+	for(int k = 0; k < mn; ++k)
+	{
+		vOff[k+1] += vOff[k];
+		eOff[k+1] += eOff[k];
+		fOff[k+1] += fOff[k];
+	}
+	Allocator<MeshLeft>::AddVertices(ml, vOff[mn] - vOff[0]);
+	Allocator<MeshLeft>::AddEdges(ml, eOff[mn] - eOff[0]);
+	Allocator<MeshLeft>::AddFaces(ml, fOff[mn] - fOff[0]);
+
+	std::vector< std::vector<unsigned int> > mappingTextures(mn);
+	for(int k = 0; k < mn; ++k)
+		mappingTextures[k] = MergeTextures(ml, *mrs[k]);
+
+	// phase 2. copy the data of each mesh into its slice
+	parallel::For(mn, [&](int k) {
+		const ConstMeshRight& mr = *mrs[k];
+		const std::vector<size_t>& rv = vertRemap[k];
+		const std::vector<unsigned int>& mt = mappingTextures[k];
+
+		const bool vertTexFlag = HasPerVertexTexCoord(mr);
+		for(size_t i = 0; i < mr.vert.size(); ++i)
+		{
+			if(rv[i] == Remap::InvalidIndex()) continue;
+			VertexLeft& vl = ml.vert[vOff[k] + rv[i]];
+			vl.ImportData(mr.vert[i]);
+			if(vertTexFlag && vl.T().n() >= 0 && size_t(vl.T().n()) < mt.size())
+				vl.T().n() = mt[vl.T().n()];
+		}
+
+		size_t ei = eOff[k];
+		for(size_t i = 0; i < mr.edge.size(); ++i)
+		{
+			const EdgeRight& e = mr.edge[i];
+			if(e.IsD()) continue;
+			EdgeLeft& el = ml.edge[ei++];
+			el.ImportData(e);
+			if(HasEVAdjacency(ml) && HasEVAdjacency(mr))
+				for(int j = 0; j < 2; ++j)
+					el.V(j) = &ml.vert[vOff[k] + rv[Index(mr, e.cV(j))]];
+		}
+
+		const bool wedgeTexFlag = HasPerWedgeTexCoord(mr);
+		size_t fi = fOff[k];
+		for(size_t i = 0; i < mr.face.size(); ++i)
+		{
+			const FaceRight& f = mr.face[i];
+			if(f.IsD()) continue;
+			FaceLeft& fl = ml.face[fi++];
+			fl.Alloc(f.VN());
+			if(HasFVAdjacency(ml) && HasFVAdjacency(mr))
+				for(int j = 0; j < fl.VN(); ++j)
+					fl.V(j) = &ml.vert[vOff[k] + rv[Index(mr, f.cV(j))]];
+			fl.ImportData(f);
+			if(wedgeTexFlag)
+				for(int j = 0; j < fl.VN(); ++j)
+					if(fl.WT(j).n() >= 0 && size_t(fl.WT(j).n()) < mt.size())
+						fl.WT(j).n() = mt[fl.WT(j).n()];
+		}
+	}, 0, "", 1);
+
+	if(vertOffset) vertOffset->swap(vOff);
+	if(faceOffset) faceOffset->swap(fOff);
+}
+
+/**
+ * For each texture of mr, the index of the same texture in ml.
+ * The textures of mr that ml does not have are added to ml.
+ */
+static std::vector<unsigned int> MergeTextures(MeshLeft& ml, const ConstMeshRight& mr)
+{
+	std::vector<unsigned int> mappingTextures(mr.textures.size());
+
+	unsigned int baseMlT = ml.textures.size();
+	for (unsigned int i = 0; i < mr.textures.size(); ++i) {
+		auto it = std::find(ml.textures.begin(), ml.textures.end(), mr.textures[i]);
+		//if the right texture does not exists in the left mesh
+		if (it == ml.textures.end()) {
+			//add the texture in the left mesh and create the mapping
+			mappingTextures[i] = baseMlT++;
+			ml.textures.push_back(mr.textures[i]);
+		}
+		else {
+			//the ith right texture will map in the texture found in the left mesh
+			mappingTextures[i] = it - ml.textures.begin();
+		}
+	}
+	return mappingTextures;
+}
+
 /**
  * \brief Copy the second mesh over the first one.
  * The first mesh is destroyed. If requested only the selected elements are copied.
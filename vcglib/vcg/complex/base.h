@@ -695,6 +695,10 @@ template < class FaceType>    bool FaceVectorHasPerWedgeColor   (const std::vect
 template < class FaceType>    bool FaceVectorHasPerWedgeNormal  (const std::vector<FaceType> &) {  return FaceType::HasWedgeNormal  (); }
 template < class FaceType>    bool FaceVectorHasPerWedgeTexCoord(const std::vector<FaceType> &) {  return FaceType::HasWedgeTexCoord(); }
 
+// Faces that store vertex references as indexes (face::VertexRefIdxOcf) need the base of the vertex vector;
+// plain face vectors store pointers and have nothing to update.
+template < class FaceType, class VertContainer > void FaceVectorSetVertexBase(std::vector<FaceType> &, VertContainer &) {}
+
 template < class TriMeshType> bool HasPerWedgeColor   (const TriMeshType &m) { return tri::FaceVectorHasPerWedgeColor   (m.face); }
 template < class TriMeshType> bool HasPerWedgeNormal  (const TriMeshType &m) { return tri::FaceVectorHasPerWedgeNormal  (m.face); }
 template < class TriMeshType> bool HasPerWedgeTexCoord(const TriMeshType &m) { return tri::FaceVectorHasPerWedgeTexCoord(m.face); }
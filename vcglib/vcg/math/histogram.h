@@ -27,6 +27,8 @@
 #include <string>
 #include <limits>
 #include <vector>
+#include <algorithm>
+#include <utility>
 #include <vcg/math/base.h>
 #include <stdio.h>
 
@@ -116,6 +118,166 @@ public:
 
 
 
+/**
+ * StreamingDistribution.
+ *
+ * Bounded memory, mergeable replacement for Distribution.
+ * Moments (sum, average, rms, variance) are exact; percentiles are computed from a
+ * KLL-like quantile sketch: values are kept in a hierarchy of compactors where an item
+ * at level h stands for 2^h samples, and when a level is full it is sorted and every
+ * other item is promoted to the next level. The memory is O(k) and the rank error is
+ * roughly 1/k. As long as less than <k> values have been added the percentiles are
+ * exact and equal to the ones of Distribution.
+ * Compaction is deterministic, so the same sequence of Add/Merge gives the same result.
+ * Two sketches can be merged, so a large set of values can be processed in parallel chunks.
+ */
+template <class ScalarType>
+class StreamingDistribution
+{
+private:
+  std::vector< std::vector<ScalarType> > level; // level[h] holds items of weight 2^h
+  std::vector<char> parity; // alternating offset used when compacting each level
+  std::vector<int> capacity; // capacity[d] is the capacity of the level at depth d below the top one
+  int k;
+  double cnt;
+  double valSum;
+  double sqrdValSum;
+  ScalarType min_v;
+  ScalarType max_v;
+
+public:
+
+  StreamingDistribution(int _k=2048) : k(std::max(_k,16)) { Clear(); }
+
+  void Clear()
+  {
+    level.assign(1,std::vector<ScalarType>());
+    parity.assign(1,0);
+    UpdateCapacities();
+    cnt=0;
+    valSum=0;
+    sqrdValSum=0;
+    min_v =  std::numeric_limits<ScalarType>::max();
+    max_v = -std::numeric_limits<ScalarType>::max();
+  }
+
+  void Add(const ScalarType v)
+  {
+    level[0].push_back(v);
+    cnt+=1;
+    valSum += double(v);
+    sqrdValSum += double(v)*double(v);
+    if(v<min_v) min_v=v;
+    if(v>max_v) max_v=v;
+    if(int(level[0].size())>=Capacity(0)) Compress();
+  }
+
+  void Merge(const StreamingDistribution &d)
+  {
+    if(level.size()<d.level.size())
+    {
+      level.resize(d.level.size());
+      parity.resize(d.level.size(),0);
+      UpdateCapacities();
+    }
+    for(size_t h=0;h<d.level.size();++h)
+      level[h].insert(level[h].end(),d.level[h].begin(),d.level[h].end());
+    cnt+=d.cnt;
+    valSum+=d.valSum;
+    sqrdValSum+=d.sqrdValSum;
+    if(d.min_v<min_v) min_v=d.min_v;
+    if(d.max_v>max_v) max_v=d.max_v;
+    Compress();
+  }
+
+  int K() const { return k; }
+  ScalarType Min() const { return min_v; }
+  ScalarType Max() const { return max_v; }
+  ScalarType Cnt() const { return ScalarType(cnt); }
+
+  ScalarType Sum() const { return valSum; }
+  ScalarType Avg() const { return valSum/cnt; }
+  //! Returns the Root Mean Square of the data.
+  ScalarType RMS() const { return math::Sqrt(sqrdValSum/cnt); }
+  //! Returns the variance of the data (the average of the squares less the square of the average).
+  ScalarType Variance() const { return sqrdValSum/cnt - (valSum/cnt)*(valSum/cnt); }
+  //! Returns the standard deviation of the data.
+  ScalarType StandardDeviation() const { return sqrt( Variance() ); }
+
+  //! Number of values actually stored in the sketch.
+  size_t StoredNum() const
+  {
+    size_t n=0;
+    for(size_t h=0;h<level.size();++h) n+=level[h].size();
+    return n;
+  }
+
+  //! Same convention of Distribution::Percentile: the value <r> such that a fraction <perc> of samples is <= <r>.
+  ScalarType Percentile(ScalarType perc) const
+  {
+    assert(cnt>0);
+    assert(perc>=0 && perc<=1);
+    std::vector< std::pair<ScalarType,double> > wv;
+    wv.reserve(StoredNum());
+    double totalW=0;
+    for(size_t h=0;h<level.size();++h)
+    {
+      const double w = double(1ull<<h);
+      for(size_t i=0;i<level[h].size();++i)
+        wv.push_back(std::make_pair(level[h][i],w));
+      totalW += w*level[h].size();
+    }
+    std::sort(wv.begin(),wv.end());
+    // same rounding used by Distribution::Percentile
+    const double target = std::max(1.0, std::floor(double(ScalarType(totalW)*perc - ScalarType(1))) + 1.0);
+    double cum=0;
+    for(size_t i=0;i<wv.size();++i)
+    {
+      cum+=wv[i].second;
+      if(cum>=target) return wv[i].first;
+    }
+    return wv.back().first;
+  }
+
+private:
+  // KLL capacities: the top level has capacity k, lower levels decrease geometrically by 2/3.
+  // They depend only on the depth, so they are computed once when a new level appears.
+  void UpdateCapacities()
+  {
+    while(capacity.size()<level.size())
+      capacity.push_back(std::max(8, int(double(k)*std::pow(2.0/3.0,int(capacity.size())))));
+  }
+
+  int Capacity(size_t h) const
+  {
+    return capacity[level.size()-1-h];
+  }
+
+  void Compress()
+  {
+    for(size_t h=0;h<level.size();++h)
+    {
+      if(int(level[h].size())<Capacity(h)) continue;
+      if(h+1==level.size())
+      {
+        level.push_back(std::vector<ScalarType>());
+        parity.push_back(0);
+        UpdateCapacities();
+      }
+      std::vector<ScalarType> &cur=level[h];
+      std::sort(cur.begin(),cur.end());
+      // with an odd number of items the largest one stays at this level
+      size_t pairNum = cur.size()/2;
+      const size_t offset = size_t(parity[h]);
+      parity[h]^=1;
+      for(size_t i=0;i<pairNum;++i)
+        level[h+1].push_back(cur[2*i+offset]);
+      if(cur.size()%2) cur[0]=cur.back();
+      cur.resize(cur.size()%2);
+    }
+  }
+};
+
 /**
  * Histogram.
  *
@@ -178,6 +340,12 @@ public:
      */
   void Add(ScalarType v, ScalarType increment=ScalarType(1.0));
 
+  /**
+     * Add all the values of another histogram defined over the same range and bins.
+     * Used to combine histograms filled in parallel.
+     */
+  void Merge(const Histogram<ScalarType> &h);
+
   ScalarType MaxCount() const;        //! Max number of elements among all buckets (including the two infinity bounded buckets)
   ScalarType MaxCountInRange() const; //! Max number of elements among all buckets between MinV and MaxV.
   int BinNum() const {return n;}
@@ -317,6 +485,19 @@ void Histogram<ScalarType>::Add(ScalarType v, ScalarType increment)
   rms += (v*v)*increment;
 }
 
+template <class ScalarType>
+void Histogram<ScalarType>::Merge(const Histogram<ScalarType> &h)
+{
+  assert(R==h.R);
+  for(size_t i=0;i<H.size();++i)
+    H[i]+=h.H[i];
+  if(h.minElem<minElem) minElem=h.minElem;
+  if(h.maxElem>maxElem) maxElem=h.maxElem;
+  cnt+=h.cnt;
+  sum+=h.sum;
+  rms+=h.rms;
+}
+
 template <class ScalarType>
 ScalarType Histogram<ScalarType>::BinCount(ScalarType v)
 {
@@ -51,6 +51,7 @@ public:
   inline       typename T::CoordType cP( const int ) const { assert(0);		static typename T::CoordType coord(0, 0, 0); return coord;	}
 
   static bool HasVertexRef()   { return false; }
+  static bool HasVertexRefIdx()   { return false; }
   static bool HasFVAdjacency()   { return false; }
 
   typedef typename T::VertexType::NormalType NormalType;
@@ -54,6 +54,7 @@ public:
     WedgeNormalEnabled=false;
     VFAdjacencyEnabled=false;
     FFAdjacencyEnabled=false;
+    _vertexBase=0;
   }
 
 // Auxiliary types to build internal vectors
@@ -236,6 +237,24 @@ void ReorderFace(std::vector<size_t> &newFaceIndex )
 ////////////////////////////////////////
 // Enabling Functions
 
+// Bytes allocated by the vector, including the optional component vectors.
+template <class T>
+static size_t VectorBytes(const std::vector<T> &v) { return v.capacity()*sizeof(T); }
+size_t MemoryUsage() const
+{
+  return VectorBytes(static_cast<const BaseType &>(*this)) +
+         VectorBytes(CV) +
+         VectorBytes(CDV) +
+         VectorBytes(MV) +
+         VectorBytes(NV) +
+         VectorBytes(QV) +
+         VectorBytes(WCV) +
+         VectorBytes(WNV) +
+         VectorBytes(WTV) +
+         VectorBytes(AV) +
+         VectorBytes(AF);
+}
+
 bool IsQualityEnabled() const {return QualityEnabled;}
 void EnableQuality() {
     assert(VALUE_TYPE::HasQualityOcf());
@@ -368,6 +387,12 @@ void DisableWedgeNormal() {
   WNV.clear();
 }
 
+// Base of the vertex vector the faces refer to.
+// Used only by VertexRefIdxOcf, that stores vertex references as 32 bit indexes;
+// it must be set again (see tri::FaceVectorSetVertexBase) whenever the vertex vector is reallocated.
+typename VALUE_TYPE::VertexType *VertexBase() const {return _vertexBase;}
+void SetVertexBase(typename VALUE_TYPE::VertexType *vb) {_vertexBase=vb;}
+
 public:
   std::vector<typename VALUE_TYPE::ColorType> CV;
   std::vector<typename VALUE_TYPE::CurvatureDirType> CDV;
@@ -390,9 +415,112 @@ public:
   bool WedgeTexEnabled;
   bool VFAdjacencyEnabled;
   bool FFAdjacencyEnabled;
+  typename VALUE_TYPE::VertexType *_vertexBase;
 }; // end class vector_ocf
 
 
+/*----------------------------- VertexRefIdxOcf ------------------------------*/
+/*! \brief Writable reference to a vertex stored as an index.
+ *
+ * It is what VertexRefIdxOcf::V() returns in place of a <tt>VertexType *&</tt>:
+ * it converts to a vertex pointer and assigning a vertex pointer to it stores its index.
+ */
+template <class VertexType> class VertexIdxRef {
+public:
+  static const unsigned int NullIndex = 0xffffffffu;
+
+  VertexIdxRef(unsigned int &_i, VertexType *_base):i(_i),base(_base) {}
+
+  operator VertexType *() const { return (i==NullIndex) ? 0 : base+i; }
+  VertexType *operator->() const { assert(i!=NullIndex); return base+i; }
+  VertexType &operator*() const { assert(i!=NullIndex); return base[i]; }
+
+  VertexIdxRef &operator=(VertexType *vp) {
+    assert(vp==0 || vp>=base);
+    i = (vp==0) ? NullIndex : (unsigned int)(vp-base);
+    return *this;
+  }
+  // assigning from another reference copies the referred vertex, not the reference
+  VertexIdxRef &operator=(const VertexIdxRef &r) { return (*this)=(VertexType *)r; }
+
+private:
+  unsigned int &i;
+  VertexType *base;
+};
+
+/*! \brief The references to the vertexes of a triangular face, stored as 32 bit indexes
+ *
+ * Drop-in replacement of VertexRef for faces stored in a vector_ocf: each face needs 12 bytes
+ * instead of 24 on 64 bit architectures and the references remain valid when the vertex
+ * vector is reallocated, as only the base of the vertex vector kept by the face vector has to change.
+ * Faces must live in their vector_ocf (as for every other Ocf component) and the non-const
+ * V() returns a VertexIdxRef instead of a reference to a pointer.
+ */
+template <class T> class VertexRefIdxOcf: public T {
+public:
+  typedef typename T::VertexType VertexType;
+  typedef typename T::VertexType::CoordType CoordType;
+  typedef typename T::VertexType::ScalarType ScalarType;
+  typedef VertexIdxRef<VertexType> VertexRefType;
+
+  VertexRefIdxOcf(){
+    _vi[0]=VertexRefType::NullIndex;
+    _vi[1]=VertexRefType::NullIndex;
+    _vi[2]=VertexRefType::NullIndex;
+  }
+
+  inline VertexRefType V( const int j )       { assert(j>=0 && j<3); return VertexRefType(_vi[j],(*this).Base().VertexBase()); }
+  inline const VertexType * V( const int j ) const { assert(j>=0 && j<3); return _vp(j); }
+  inline const VertexType * cV( const int j ) const { assert(j>=0 && j<3); return _vp(j); }
+
+  inline       CoordType &P( const int j )      	{	assert(j>=0 && j<3);		return _vp(j)->P();	}
+  inline const CoordType &P( const int j ) const	{	assert(j>=0 && j<3);		return _vp(j)->P();	}
+  inline       CoordType cP( const int j ) const	{	assert(j>=0 && j<3);		return _vp(j)->cP(); }
+
+  inline VertexRefType V0( const int j )       { return V(j);}
+  inline VertexRefType V1( const int j )       { return V((j+1)%3);}
+  inline VertexRefType V2( const int j )       { return V((j+2)%3);}
+  inline const VertexType * V0( const int j ) const { return V(j);}
+  inline const VertexType * V1( const int j ) const { return V((j+1)%3);}
+  inline const VertexType * V2( const int j ) const { return V((j+2)%3);}
+  inline const VertexType *  cV0( const int j ) const { return cV(j);}
+  inline const VertexType *  cV1( const int j ) const { return cV((j+1)%3);}
+  inline const VertexType *  cV2( const int j ) const { return cV((j+2)%3);}
+
+  inline       CoordType &  P0( const int j )       { return P(j);}
+  inline       CoordType &  P1( const int j )       { return P((j+1)%3);}
+  inline       CoordType &  P2( const int j )       { return P((j+2)%3);}
+  inline const CoordType &  P0( const int j ) const { return P(j);}
+  inline const CoordType &  P1( const int j ) const { return P((j+1)%3);}
+  inline const CoordType &  P2( const int j ) const { return P((j+2)%3);}
+  inline const CoordType & cP0( const int j ) const { return cV(j)->P();}
+  inline const CoordType & cP1( const int j ) const { return cV((j+1)%3)->P();}
+  inline const CoordType & cP2( const int j ) const { return cV((j+2)%3)->P();}
+
+  inline VertexRefType       FVp( const int i )       { return V(i); }
+  inline const VertexType *  FVp( const int i ) const { return this->cV(i); }
+  inline const VertexType * cFVp( const int i ) const { return this->cV(i); }
+
+  // As for VertexRef the references are not copied by ImportData
+  template <class RightValueType>
+  void ImportData(const RightValueType & rightF){  T::ImportData(rightF);}
+  inline void Alloc(const int & ns){T::Alloc(ns);}
+  inline void Dealloc(){T::Dealloc();}
+
+  static bool HasVertexRef()   { return true; }
+  static bool HasVertexRefIdx()   { return true; }
+  static bool HasFVAdjacency()   { return true; }
+
+  static void Name(std::vector<std::string> & name){name.push_back(std::string("VertexRefIdxOcf"));T::Name(name);}
+
+private:
+  inline VertexType *_vp(const int j) const {
+    return (_vi[j]==VertexRefType::NullIndex) ? 0 : (*this).Base().VertexBase()+_vi[j];
+  }
+  unsigned int _vi[3];
+};
+
+
 /*----------------------------- VFADJ ------------------------------*/
 template <class T> class VFAdjOcf: public T {
 public:
@@ -829,6 +957,11 @@ public:
     if(FaceType::HasNormalOcf()) return fv.IsNormalEnabled();
     else return FaceType::HasNormal();
   }
+  template < class FaceType, class VertContainer >
+  void FaceVectorSetVertexBase(face::vector_ocf<FaceType> &fv, VertContainer &vv)
+  {
+    fv.SetVertexBase(vv.empty() ? 0 : &*vv.begin());
+  }
   template < class FaceType >
   void ReorderFace( std::vector<size_t>  &newFaceIndex, face::vector_ocf< FaceType > &faceVec)
   {
@@ -505,9 +505,9 @@ public:
     // vfi.V() = vfi.F()->V(vfi.I())
     inline VertexType *V() const { return f->V(z);}
 
-    inline VertexType * const & V0() const { return f->V0(z);}
-    inline VertexType * const & V1() const { return f->V1(z);}
-    inline VertexType * const & V2() const { return f->V2(z);}
+    inline VertexType *V0() const { return f->V0(z);}
+    inline VertexType *V1() const { return f->V1(z);}
+    inline VertexType *V2() const { return f->V2(z);}
 
     bool End() const {return f==0;}
     void operator++() {
@@ -407,7 +407,9 @@ template <class FaceType, bool UpdateTopology>
 void SwapEdge(FaceType &f, const int z)
 {
     // swap V0(z) with V1(z)
-    std::swap(f.V0(z), f.V1(z));
+    typename FaceType::VertexType *tmp = f.V0(z);
+    f.V0(z) = f.V1(z);
+    f.V1(z) = tmp;
 
     // Managemnt of faux edge information (edge z is not affected)
     bool Faux1 = f.IsF((z+1)%3);
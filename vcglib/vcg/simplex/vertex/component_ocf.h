@@ -125,6 +125,23 @@ public:
 ////////////////////////////////////////
 // Enabling Eunctions
 
+// Bytes allocated by the vector, including the optional component vectors.
+template <class T>
+static size_t VectorBytes(const std::vector<T> &v) { return v.capacity()*sizeof(T); }
+size_t MemoryUsage() const
+{
+  return VectorBytes(static_cast<const BaseType &>(*this)) +
+         VectorBytes(CV) +
+         VectorBytes(CuV) +
+         VectorBytes(CuDV) +
+         VectorBytes(MV) +
+         VectorBytes(NV) +
+         VectorBytes(QV) +
+         VectorBytes(RadiusV) +
+         VectorBytes(TV) +
+         VectorBytes(AV);
+}
+
 bool IsQualityEnabled() const {return QualityEnabled;}
 void EnableQuality() {
     assert(VALUE_TYPE::HasQualityOcf());
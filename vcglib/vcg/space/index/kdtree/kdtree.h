@@ -121,11 +121,12 @@ namespace vcg {
 
     ~KdTree();
 
-    void doQueryK(const VectorType& queryPoint, int k, PriorityQueue& mNeighborQueue);
+    // queries do not modify the tree, they can be run concurrently from several threads
+    void doQueryK(const VectorType& queryPoint, int k, PriorityQueue& mNeighborQueue) const;
 
-    void doQueryDist(const VectorType& queryPoint, Scalar dist, std::vector<unsigned int>& points, std::vector<Scalar>& sqrareDists);
+    void doQueryDist(const VectorType& queryPoint, Scalar dist, std::vector<unsigned int>& points, std::vector<Scalar>& sqrareDists) const;
 
-    void doQueryClosest(const VectorType& queryPoint, unsigned int& index, Scalar& dist);
+    void doQueryClosest(const VectorType& queryPoint, unsigned int& index, Scalar& dist) const;
 
   protected:
 
@@ -204,7 +205,7 @@ namespace vcg {
   * topmost element [0] is NOT the nearest but the farthest!! (they are not sorted but arranged into a heap).
   */
   template<typename Scalar>
-  void KdTree<Scalar>::doQueryK(const VectorType& queryPoint, int k, PriorityQueue& mNeighborQueue)
+  void KdTree<Scalar>::doQueryK(const VectorType& queryPoint, int k, PriorityQueue& mNeighborQueue) const
   {
     mNeighborQueue.setMaxSize(k);
     mNeighborQueue.init();
@@ -222,7 +223,7 @@ namespace vcg {
       //while going down the tree qnode.nodeId is the nearest sub-tree, otherwise,
       //in backtracking, qnode.nodeId is the other sub-tree that will be visited iff
       //the actual nearest node is further than the split distance.
-      Node& node = mNodes[qnode.nodeId];
+      const Node& node = mNodes[qnode.nodeId];
 
       //if the distance is less than the top of the max-heap, it could be one of the k-nearest neighbours
       if (mNeighborQueue.getNofElements() < k || qnode.sq < mNeighborQueue.getTopWeight())
@@ -279,7 +280,7 @@ namespace vcg {
   * and the vector of the squared distances from the query point.
   */
   template<typename Scalar>
-  void KdTree<Scalar>::doQueryDist(const VectorType& queryPoint, Scalar dist, std::vector<unsigned int>& points, std::vector<Scalar>& sqrareDists)
+  void KdTree<Scalar>::doQueryDist(const VectorType& queryPoint, Scalar dist, std::vector<unsigned int>& points, std::vector<Scalar>& sqrareDists) const
   {
     std::vector<QueryNode> mNodeStack(numLevel + 1);
     mNodeStack[0].nodeId = 0;
@@ -290,7 +291,7 @@ namespace vcg {
     while (count)
     {
       QueryNode& qnode = mNodeStack[count - 1];
-      Node   & node = mNodes[qnode.nodeId];
+      const Node   & node = mNodes[qnode.nodeId];
 
       if (qnode.sq < sqrareDist)
       {
@@ -342,7 +343,7 @@ namespace vcg {
   * and the squared distance from the query point.
   */
   template<typename Scalar>
-  void KdTree<Scalar>::doQueryClosest(const VectorType& queryPoint, unsigned int& index, Scalar& dist)
+  void KdTree<Scalar>::doQueryClosest(const VectorType& queryPoint, unsigned int& index, Scalar& dist) const
   {
     std::vector<QueryNode> mNodeStack(numLevel + 1);
     mNodeStack[0].nodeId = 0;
@@ -356,7 +357,7 @@ namespace vcg {
     while (count)
     {
       QueryNode& qnode = mNodeStack[count - 1];
-      Node   & node = mNodes[qnode.nodeId];
+      const Node   & node = mNodes[qnode.nodeId];
 
       if (qnode.sq < minDist)
       {
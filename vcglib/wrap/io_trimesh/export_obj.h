@@ -29,6 +29,7 @@
 #include <wrap/callback.h>
 #include <wrap/io_trimesh/io_mask.h>
 #include <wrap/io_trimesh/io_material.h>
+#include <wrap/io_trimesh/io_buffer.h>
 #include <iostream>
 #include <fstream>
 #include <map>
@@ -165,65 +166,75 @@ public:
     std::vector<int> VertexId(m.vert.size());
     int numvert = 0;
     int curNormalIndex = 1;
-    int current = 0;
-    const int totalPrimitives = m.vn+m.fn;    
-    /*********************************** VERTICES *********************************/
+    const size_t totalPrimitives = m.vert.size()+m.face.size();
     for(auto vi=m.vert.begin(); vi!=m.vert.end(); ++vi) if( !(*vi).IsD() )
+      VertexId[vi-m.vert.begin()]=numvert++;
+    assert(numvert == m.vn);
+
+    // Lines are formatted in chunks (see io_buffer.h); chunks are formatted in
+    // parallel unless a line depends on the previous ones (shared normals,
+    // texture coords and materials are numbered as they are met).
+    auto progress = [&](size_t done, size_t offset, const char *msg) {
+      return cb == NULL || (*cb)(int((100*(offset+done))/totalPrimitives), msg);
+    };
+    /*********************************** VERTICES *********************************/
+    bool completed = WriteElementsInChunks(fp, m.vert.size(), [&](OutBuffer &out, size_t vIdx)
     {
-      VertexId[vi-m.vert.begin()]=numvert;
+      auto vi = m.vert.begin()+vIdx;
+      if( (*vi).IsD() )
+        return;
       //saves normal per vertex
       if (mask & Mask::IOM_WEDGNORMAL )
       {
         if(AddNewNormalVertex(NormalVertex,(*vi).N(),curNormalIndex))
         {
-          fprintf(fp,"vn %f %f %f\n",(*vi).N()[0],(*vi).N()[1],(*vi).N()[2]);
+          out.Printf("vn %f %f %f\n",(*vi).N()[0],(*vi).N()[1],(*vi).N()[2]);
           curNormalIndex++;
         }
       }
       if (mask & Mask::IOM_VERTNORMAL ) {
-        fprintf(fp,"vn %f %f %f\n",(*vi).N()[0],(*vi).N()[1],(*vi).N()[2]);
+        out.Printf("vn %f %f %f\n",(*vi).N()[0],(*vi).N()[1],(*vi).N()[2]);
       }
-      
+
       if (mask & Mask::IOM_VERTTEXCOORD ) {
-        fprintf(fp,"vt %f %f\n",(*vi).T().P()[0],(*vi).T().P()[1]);
+        out.Printf("vt %f %f\n",(*vi).T().P()[0],(*vi).T().P()[1]);
       }
 
-      fprintf(fp,"v %f %f %f",(*vi).P()[0],(*vi).P()[1],(*vi).P()[2]);
-      
-      if(mask & Mask::IOM_VERTCOLOR) // the socially accepted extension to the obj format. 
-        fprintf(fp," %f %f %f",double((*vi).C()[0])/255.,double((*vi).C()[1])/255.,double((*vi).C()[2])/255.);
-      fprintf(fp,"\n");
+      out.Printf("v %f %f %f",(*vi).P()[0],(*vi).P()[1],(*vi).P()[2]);
 
-      if (cb !=NULL)
-      {
-        if(!(*cb)((100*++current)/totalPrimitives, "writing vertices "))
-        {
-          fclose(fp);
-          return E_ABORTED;
-        }
-      }
-      numvert++;
+      if(mask & Mask::IOM_VERTCOLOR) // the socially accepted extension to the obj format.
+        out.Printf(" %f %f %f",double((*vi).C()[0])/255.,double((*vi).C()[1])/255.,double((*vi).C()[2])/255.);
+      out.Printf("\n");
+    }, [&](size_t done) { return progress(done, 0, "writing vertices "); },
+    !(mask & Mask::IOM_WEDGNORMAL));
+    if(!completed)
+    {
+      fclose(fp);
+      return E_ABORTED;
     }
-    assert(numvert == m.vn);
     fprintf(fp,"# %d vertices, %d vertices normals\n\n",m.vn,int(NormalVertex.size()));
 
-    /********************* FACES ************************/      
+    /********************* FACES ************************/
     //faces + texture coords
     std::map<TexCoordType,int> CoordIndexTexture;
     int curTexCoordIndex = 1;
     int curMatIndex = -1;
-    std::vector<Material> materialVec; //used if we do not have material attributes 
-    
-    for(ConstFaceIterator fi=m.face.begin(); fi!=m.face.end(); ++fi) if( !(*fi).IsD() )
+    std::vector<Material> materialVec; //used if we do not have material attributes
+    const bool useMaterials = (mask & Mask::IOM_FACECOLOR) || (mask & Mask::IOM_WEDGTEXCOORD) || (mask & Mask::IOM_VERTTEXCOORD);
+
+    completed = WriteElementsInChunks(fp, m.face.size(), [&](OutBuffer &out, size_t fIdx)
     {
-      if((mask & Mask::IOM_FACECOLOR) || (mask & Mask::IOM_WEDGTEXCOORD) || (mask & Mask::IOM_VERTTEXCOORD))
+      ConstFaceIterator fi = m.face.begin()+fIdx;
+      if( (*fi).IsD() )
+        return;
+      if(useMaterials)
       {
         int index=-1;
         if(useMaterialAttribute) index = materialIndexHandle[fi];
         else                     index = Materials<SaveMeshType>::CreateNewMaterial(m,materialVec,*fi);
-                  
+
         if(index != curMatIndex) {
-          fprintf(fp,"\nusemtl material_%d\n", index);
+          out.Printf("\nusemtl material_%d\n", index);
           curMatIndex = index;
         }
       }
@@ -234,15 +245,15 @@ public:
         {
             if(AddNewTextureCoord(CoordIndexTexture,(*fi).WT(k),curTexCoordIndex))
             {
-              fprintf(fp,"vt %f %f\n",(*fi).WT(k).u(),(*fi).WT(k).v());
+              out.Printf("vt %f %f\n",(*fi).WT(k).u(),(*fi).WT(k).v());
               curTexCoordIndex++; //ncreases the value number to be associated to the Texture
             }
         }
 
-      fprintf(fp,"f ");
+      out.Printf("f ");
       for(int k=0;k<(*fi).VN();k++)
       {
-        if(k!=0) fprintf(fp," ");
+        if(k!=0) out.Printf(" ");
         int vInd = -1;
         // +1 because Obj file format begins from index = 1 but not from index = 0.
         vInd = VertexId[tri::Index(m, (*fi).V(k))] + 1;//index of vertex per face
@@ -260,24 +271,26 @@ public:
           vn = vInd;
 
         //writes elements on file obj
-        WriteFacesElement(fp,vInd,vt,vn);
-      }
-      fprintf(fp,"\n");
-
-      if (cb !=NULL) {
-        if(!(*cb)((100*++current)/totalPrimitives, "writing vertices "))
-        { fclose(fp); return E_ABORTED;}
+        WriteFacesElement(out,vInd,vt,vn);
       }
-
-    } // end for faces
-
-    for(ConstEdgeIterator ei=m.edge.begin(); ei!=m.edge.end(); ++ei) if( !(*ei).IsD() )
+      out.Printf("\n");
+    }, [&](size_t done) { return progress(done, m.vert.size(), "writing vertices "); },
+    !useMaterials);
+    if(!completed)
     {
-      fprintf(fp,"l %i %i\n",
-              VertexId[tri::Index(m, (*ei).V(0))] + 1,
-              VertexId[tri::Index(m, (*ei).V(1))] + 1);
+      fclose(fp);
+      return E_ABORTED;
     }
 
+    WriteElementsInChunks(fp, m.edge.size(), [&](OutBuffer &out, size_t eIdx)
+    {
+      ConstEdgeIterator ei = m.edge.begin()+eIdx;
+      if( !(*ei).IsD() )
+        out.Printf("l %i %i\n",
+                   VertexId[tri::Index(m, (*ei).V(0))] + 1,
+                   VertexId[tri::Index(m, (*ei).V(1))] + 1);
+    }, [](size_t) { return true; });
+
     fprintf(fp,"# %d faces, %d coords texture\n\n",m.fn,int(CoordIndexTexture.size()));
 
     fprintf(fp,"# End of File\n");
@@ -330,17 +343,17 @@ public:
                 f v v v ...
 
         */
-  inline static void WriteFacesElement(FILE *fp,int v,int vt, int vn)
+  inline static void WriteFacesElement(OutBuffer &out,int v,int vt, int vn)
   {
-    fprintf(fp,"%d",v);
+    out.Printf("%d",v);
     if(vt!=-1)
     {
-      fprintf(fp,"/%d",vt);
+      out.Printf("/%d",vt);
       if(vn!=-1)
-        fprintf(fp,"/%d",vn);
+        out.Printf("/%d",vn);
     }
     else if(vn!=-1)
-      fprintf(fp,"//%d",vn);
+      out.Printf("//%d",vn);
   }
 
   /*
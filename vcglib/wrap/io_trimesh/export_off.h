@@ -32,6 +32,7 @@
 #include <stdio.h>
 #include <wrap/io_trimesh/io_mask.h>
 #include<wrap/io_trimesh/precision.h>
+#include <wrap/io_trimesh/io_buffer.h>
 #include <vcg/complex/algorithms/clean.h>
 #include <vcg/complex/algorithms/polygon_support.h>
 
@@ -76,26 +77,30 @@ public:
 
     fprintf(fpout,"%d %d 0\n", m.vn, polynumber); // note that as edge number we simply write zero
 
+    // vertices and triangles are formatted in parallel chunks (see io_buffer.h)
+    auto noProgress = [](size_t) { return true; };
+
     //vertices
     const int DGT = vcg::tri::io::Precision<ScalarType>::digits();
-    for(auto vp=m.vert.begin();vp!=m.vert.end();++vp)
+    bool written = WriteElementsInChunks(fpout, m.vert.size(), [&](OutBuffer &out, size_t vIdx)
     {
+      auto vp = m.vert.begin()+vIdx;
       if( ! vp->IsD() )
       {	// ***** ASCII *****
 
-        fprintf(fpout,"%.*g %.*g %.*g " ,DGT,vp->P()[0],DGT,vp->P()[1],DGT,vp->P()[2]);
+        out.Printf("%.*g %.*g %.*g " ,DGT,vp->P()[0],DGT,vp->P()[1],DGT,vp->P()[2]);
         if( tri::HasPerVertexColor(m)  && (mask & io::Mask::IOM_VERTCOLOR) )
-          fprintf(fpout,"%d %d %d %d ",vp->C()[0],vp->C()[1],vp->C()[2],vp->C()[3] );
+          out.Printf("%d %d %d %d ",vp->C()[0],vp->C()[1],vp->C()[2],vp->C()[3] );
 
         if( tri::HasPerVertexNormal(m)  && (mask & io::Mask::IOM_VERTNORMAL) )
-          fprintf(fpout,"%g %g %g ", double(vp->N()[0]),double(vp->N()[1]),double(vp->N()[2]));
+          out.Printf("%g %g %g ", double(vp->N()[0]),double(vp->N()[1]),double(vp->N()[2]));
 
         if( tri::HasPerVertexTexCoord(m)  && (mask & io::Mask::IOM_VERTTEXCOORD) )
-          fprintf(fpout,"%g %g ",vp->T().u(),vp->T().v());
+          out.Printf("%g %g ",vp->T().u(),vp->T().v());
 
-        fprintf(fpout,"\n");
+        out.Printf("\n");
       }
-    }
+    }, noProgress);
 
 
     if (mask &io::Mask::IOM_BITPOLYGONAL) {
@@ -113,22 +118,23 @@ public:
       }
     }
     else {
-      for(FaceIterator fi=m.face.begin();fi!=m.face.end();++fi)
+      written = written && WriteElementsInChunks(fpout, m.face.size(), [&](OutBuffer &out, size_t fIdx)
       {
+        FaceIterator fi = m.face.begin()+fIdx;
         if( ! fi->IsD() )
         {
-          fprintf(fpout,"%i ",fi->VN());
+          out.Printf("%i ",fi->VN());
           for(int i=0;i<fi->VN();++i)
-              fprintf(fpout,"%lu ",tri::Index(m,fi->V(i)));
+              out.Printf("%lu ",tri::Index(m,fi->V(i)));
           if( tri::HasPerFaceColor(m)  && (mask & io::Mask::IOM_FACECOLOR) )
-            fprintf(fpout,"%i %i %i", fi->C()[0],fi->C()[1],fi->C()[2] );
-          fprintf(fpout,"\n");
+            out.Printf("%i %i %i", fi->C()[0],fi->C()[1],fi->C()[2] );
+          out.Printf("\n");
         }
-      }
+      }, noProgress);
     }
 
 	int result = 0;
-	if (ferror(fpout)) result = 2;
+	if (!written || ferror(fpout)) result = 2;
 	fclose(fpout);
 	return result;
   }
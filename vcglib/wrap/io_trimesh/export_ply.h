@@ -33,11 +33,13 @@
 #include<wrap/io_trimesh/io_mask.h>
 #include<wrap/io_trimesh/io_ply.h>
 #include<wrap/io_trimesh/precision.h>
+#include<wrap/io_trimesh/io_buffer.h>
 #include<vcg/container/simple_temporary_data.h>
 #include <vcg/complex/base.h>
 
 
 #include <stdio.h>
+#include <algorithm>
 
 namespace vcg {
 namespace tri {
@@ -375,8 +377,6 @@ public:
 
 
 		int j;
-		std::vector<int> FlagV;
-		VertexPointer  vp;
 		VertexIterator vi;
 		SimpleTempData<typename SaveMeshType::VertContainer,int> indices(m.vert);
 
@@ -453,442 +453,448 @@ public:
 			}
 		}
 
+		// deleted vertices are skipped, so the face indices are computed before writing
 		for(j=0,vi=m.vert.begin();vi!=m.vert.end();++vi){
-			vp=&(*vi);
 			indices[vi] = j;
-			//((m.vn+m.fn) != 0) all vertices and faces have been marked as deleted but the are still in the vert/face vectors
-			if(cb && ((j%1000)==0) && ((m.vn+m.fn) != 0) )(*cb)( (100*j)/(m.vn+m.fn), "Saving Vertices");
+			if( !HasPerVertexFlags(m) || !vi->IsD() )
+				j++;
+		}
+		/*vcg::tri::*/
+		// this assert triggers when the vn != number of vertexes in vert that are not deleted.
+		assert(j==m.vn);
+		assert(std::count_if(m.face.begin(),m.face.end(),[](const FaceType &f){return !f.IsD();})==m.fn);
+
+		// Elements are formatted in parallel chunks and written in order (see io_buffer.h)
+		const size_t totalElem = m.vert.size()+m.face.size();
+		auto vertProgress = [&](size_t done){
+			if(cb && totalElem!=0) (*cb)( int((100*done)/totalElem), "Saving Vertices");
+			return true;
+		};
+		auto faceProgress = [&](size_t done){
+			if(cb && totalElem!=0) (*cb)( int((100*(m.vert.size()+done))/totalElem), "Saving Faces");
+			return true;
+		};
+
+		bool written = WriteElementsInChunks(fpout, m.vert.size(), [&](OutBuffer &out, size_t vIdx)
+		{
+			VertexPointer vp = &m.vert[vIdx];
+			if( HasPerVertexFlags(m) && vp->IsD() )
+				return;
 
-			if( !HasPerVertexFlags(m) || !vp->IsD() )
+			if(binary)
 			{
-				if(binary)
-				{
-					ScalarType t;
+				ScalarType t;
 
-					t = ScalarType(vp->P()[0]); fwrite(&t,sizeof(ScalarType),1,fpout);
-					t = ScalarType(vp->P()[1]); fwrite(&t,sizeof(ScalarType),1,fpout);
-					t = ScalarType(vp->P()[2]); fwrite(&t,sizeof(ScalarType),1,fpout);
+				t = ScalarType(vp->P()[0]); out.Write(&t,sizeof(ScalarType),1);
+				t = ScalarType(vp->P()[1]); out.Write(&t,sizeof(ScalarType),1);
+				t = ScalarType(vp->P()[2]); out.Write(&t,sizeof(ScalarType),1);
 
-					if( HasPerVertexNormal(m) && (pi.mask & Mask::IOM_VERTNORMAL) )
-					{
-						t = ScalarType(vp->N()[0]); fwrite(&t,sizeof(ScalarType),1,fpout);
-						t = ScalarType(vp->N()[1]); fwrite(&t,sizeof(ScalarType),1,fpout);
-						t = ScalarType(vp->N()[2]); fwrite(&t,sizeof(ScalarType),1,fpout);
-					}
-					if( HasPerVertexFlags(m) && (pi.mask & Mask::IOM_VERTFLAGS) )
-						fwrite(&(vp->Flags()),sizeof(int),1,fpout);
+				if( HasPerVertexNormal(m) && (pi.mask & Mask::IOM_VERTNORMAL) )
+				{
+					t = ScalarType(vp->N()[0]); out.Write(&t,sizeof(ScalarType),1);
+					t = ScalarType(vp->N()[1]); out.Write(&t,sizeof(ScalarType),1);
+					t = ScalarType(vp->N()[2]); out.Write(&t,sizeof(ScalarType),1);
+				}
+				if( HasPerVertexFlags(m) && (pi.mask & Mask::IOM_VERTFLAGS) )
+					out.Write(&(vp->Flags()),sizeof(int),1);
 
-					if( HasPerVertexColor(m) && (pi.mask & Mask::IOM_VERTCOLOR) ){
-						auto c = vp->C();
-						fwrite(&c,sizeof(char),4,fpout);
-					}
+				if( HasPerVertexColor(m) && (pi.mask & Mask::IOM_VERTCOLOR) ){
+					auto c = vp->C();
+					out.Write(&c,sizeof(char),4);
+				}
 
-					if( HasPerVertexQuality(m) && (pi.mask & Mask::IOM_VERTQUALITY) ){
-						auto q = vp->Q();
-						fwrite(&q, sizeof(typename VertexType::QualityType),1,fpout);
-					}
+				if( HasPerVertexQuality(m) && (pi.mask & Mask::IOM_VERTQUALITY) ){
+					auto q = vp->Q();
+					out.Write(&q, sizeof(typename VertexType::QualityType),1);
+				}
 
-					if( HasPerVertexRadius(m) && (pi.mask & Mask::IOM_VERTRADIUS) ){
-						auto r = vp->R();
-						fwrite(&r,sizeof(typename VertexType::RadiusType),1,fpout);
-					}
+				if( HasPerVertexRadius(m) && (pi.mask & Mask::IOM_VERTRADIUS) ){
+					auto r = vp->R();
+					out.Write(&r,sizeof(typename VertexType::RadiusType),1);
+				}
 
-					if( HasPerVertexTexCoord(m) && (pi.mask & Mask::IOM_VERTTEXCOORD) )
-					{
-						t = ScalarType(vp->T().u()); fwrite(&t,sizeof(ScalarType),1,fpout);
-						t = ScalarType(vp->T().v()); fwrite(&t,sizeof(ScalarType),1,fpout);
-					}
+				if( HasPerVertexTexCoord(m) && (pi.mask & Mask::IOM_VERTTEXCOORD) )
+				{
+					t = ScalarType(vp->T().u()); out.Write(&t,sizeof(ScalarType),1);
+					t = ScalarType(vp->T().v()); out.Write(&t,sizeof(ScalarType),1);
+				}
 
-					for(size_t i=0;i<pi.VertDescriptorVec.size();i++)
-					{
-						double td(0); float tf(0);int ti;short ts; char tc; unsigned char tu;
-						if(!pi.VertAttrNameVec.empty() && !pi.VertAttrNameVec[i].empty())
-						{ // trying to use named attribute to retrieve the value to store
-							assert(vcg::tri::HasPerVertexAttribute(m,pi.VertAttrNameVec[i]));
-							if (!pi.VertDescriptorVec[i].islist){
-								switch (pi.VertDescriptorVec[i].stotype1)
-								{
-								case ply::T_FLOAT  : tf=thfv[i][vp]; fwrite(&tf, sizeof(float),1,fpout); break;
-								case ply::T_DOUBLE : td=thdv[i][vp]; fwrite(&td, sizeof(double),1,fpout); break;
-								case ply::T_INT    : ti=thiv[i][vp]; fwrite(&ti, sizeof(int),1,fpout); break;
-								case ply::T_SHORT  : ts=thsv[i][vp]; fwrite(&ts, sizeof(short),1,fpout); break;
-								case ply::T_CHAR   : tc=thcv[i][vp]; fwrite(&tc, sizeof(char),1,fpout); break;
-								case ply::T_UCHAR  : tu=thuv[i][vp]; fwrite(&tu,sizeof(unsigned char),1,fpout); break;
-								default : assert(0);
-								}
-							}
-							else { //it is a Poin3f or a Point3d attribute. Saving it as a list
-								static const unsigned char psize = 3;
-								switch (pi.VertDescriptorVec[i].stotype1)
-								{
-								case ply::T_FLOAT  :
-									fwrite(&psize, sizeof(unsigned char), 1,fpout);
-									fwrite(&thp3fv[i][vp][0], sizeof(float), 1,fpout);
-									fwrite(&thp3fv[i][vp][1], sizeof(float), 1,fpout);
-									fwrite(&thp3fv[i][vp][2], sizeof(float), 1,fpout);
-									break;
-									//fprintf(fpout,"%d %f %f %f", 3, thp3fv[i][vp][0], thp3fv[i][vp][1], thp3fv[i][vp][2]); break;
-								case ply::T_DOUBLE :
-									fwrite(&psize, sizeof(unsigned char), 1,fpout);
-									fwrite(&thp3dv[i][vp][0], sizeof(double), 1,fpout);
-									fwrite(&thp3dv[i][vp][1], sizeof(double), 1,fpout);
-									fwrite(&thp3dv[i][vp][2], sizeof(double), 1,fpout);
-									break;
-									//fprintf(fpout,"%d %lf %lf %lf", 3, thp3dv[i][vp][0], thp3dv[i][vp][1], thp3dv[i][vp][2]); break;
-								default : assert(0);
-								}
+				for(size_t i=0;i<pi.VertDescriptorVec.size();i++)
+				{
+					double td(0); float tf(0);int ti;short ts; char tc; unsigned char tu;
+					if(!pi.VertAttrNameVec.empty() && !pi.VertAttrNameVec[i].empty())
+					{ // trying to use named attribute to retrieve the value to store
+						assert(vcg::tri::HasPerVertexAttribute(m,pi.VertAttrNameVec[i]));
+						if (!pi.VertDescriptorVec[i].islist){
+							switch (pi.VertDescriptorVec[i].stotype1)
+							{
+							case ply::T_FLOAT  : tf=thfv[i][vp]; out.Write(&tf, sizeof(float),1); break;
+							case ply::T_DOUBLE : td=thdv[i][vp]; out.Write(&td, sizeof(double),1); break;
+							case ply::T_INT    : ti=thiv[i][vp]; out.Write(&ti, sizeof(int),1); break;
+							case ply::T_SHORT  : ts=thsv[i][vp]; out.Write(&ts, sizeof(short),1); break;
+							case ply::T_CHAR   : tc=thcv[i][vp]; out.Write(&tc, sizeof(char),1); break;
+							case ply::T_UCHAR  : tu=thuv[i][vp]; out.Write(&tu,sizeof(unsigned char),1); break;
+							default : assert(0);
 							}
 						}
-						else
-						{
+						else { //it is a Poin3f or a Point3d attribute. Saving it as a list
+							static const unsigned char psize = 3;
 							switch (pi.VertDescriptorVec[i].stotype1)
 							{
-							case ply::T_FLOAT	 :		PlyConv(pi.VertDescriptorVec[i].memtype1,  ((char *)vp)+pi.VertDescriptorVec[i].offset1, tf );	fwrite(&tf, sizeof(float),1,fpout); break;
-							case ply::T_DOUBLE :		PlyConv(pi.VertDescriptorVec[i].memtype1,  ((char *)vp)+pi.VertDescriptorVec[i].offset1, td );	fwrite(&td, sizeof(double),1,fpout); break;
-							case ply::T_INT		 :		PlyConv(pi.VertDescriptorVec[i].memtype1,  ((char *)vp)+pi.VertDescriptorVec[i].offset1, ti );	fwrite(&ti, sizeof(int),1,fpout); break;
-							case ply::T_SHORT	 :		PlyConv(pi.VertDescriptorVec[i].memtype1,  ((char *)vp)+pi.VertDescriptorVec[i].offset1, ts );	fwrite(&ts, sizeof(short),1,fpout); break;
-							case ply::T_CHAR	 :		PlyConv(pi.VertDescriptorVec[i].memtype1,  ((char *)vp)+pi.VertDescriptorVec[i].offset1, tc );	fwrite(&tc, sizeof(char),1,fpout); break;
-							case ply::T_UCHAR	 :		PlyConv(pi.VertDescriptorVec[i].memtype1,  ((char *)vp)+pi.VertDescriptorVec[i].offset1, tu );	fwrite(&tu,sizeof(unsigned char),1,fpout); break;
+							case ply::T_FLOAT  :
+								out.Write(&psize, sizeof(unsigned char), 1);
+								out.Write(&thp3fv[i][vp][0], sizeof(float), 1);
+								out.Write(&thp3fv[i][vp][1], sizeof(float), 1);
+								out.Write(&thp3fv[i][vp][2], sizeof(float), 1);
+								break;
+								//out.Printf("%d %f %f %f", 3, thp3fv[i][vp][0], thp3fv[i][vp][1], thp3fv[i][vp][2]); break;
+							case ply::T_DOUBLE :
+								out.Write(&psize, sizeof(unsigned char), 1);
+								out.Write(&thp3dv[i][vp][0], sizeof(double), 1);
+								out.Write(&thp3dv[i][vp][1], sizeof(double), 1);
+								out.Write(&thp3dv[i][vp][2], sizeof(double), 1);
+								break;
+								//out.Printf("%d %lf %lf %lf", 3, thp3dv[i][vp][0], thp3dv[i][vp][1], thp3dv[i][vp][2]); break;
 							default : assert(0);
 							}
 						}
 					}
+					else
+					{
+						switch (pi.VertDescriptorVec[i].stotype1)
+						{
+						case ply::T_FLOAT	 :		PlyConv(pi.VertDescriptorVec[i].memtype1,  ((char *)vp)+pi.VertDescriptorVec[i].offset1, tf );	out.Write(&tf, sizeof(float),1); break;
+						case ply::T_DOUBLE :		PlyConv(pi.VertDescriptorVec[i].memtype1,  ((char *)vp)+pi.VertDescriptorVec[i].offset1, td );	out.Write(&td, sizeof(double),1); break;
+						case ply::T_INT		 :		PlyConv(pi.VertDescriptorVec[i].memtype1,  ((char *)vp)+pi.VertDescriptorVec[i].offset1, ti );	out.Write(&ti, sizeof(int),1); break;
+						case ply::T_SHORT	 :		PlyConv(pi.VertDescriptorVec[i].memtype1,  ((char *)vp)+pi.VertDescriptorVec[i].offset1, ts );	out.Write(&ts, sizeof(short),1); break;
+						case ply::T_CHAR	 :		PlyConv(pi.VertDescriptorVec[i].memtype1,  ((char *)vp)+pi.VertDescriptorVec[i].offset1, tc );	out.Write(&tc, sizeof(char),1); break;
+						case ply::T_UCHAR	 :		PlyConv(pi.VertDescriptorVec[i].memtype1,  ((char *)vp)+pi.VertDescriptorVec[i].offset1, tu );	out.Write(&tu,sizeof(unsigned char),1); break;
+						default : assert(0);
+						}
+					}
 				}
-				else 	// ***** ASCII *****
-				{
-					fprintf(fpout,"%.*g %.*g %.*g " ,DGT,vp->P()[0],DGT,vp->P()[1],DGT,vp->P()[2]);
+			}
+			else 	// ***** ASCII *****
+			{
+				out.Printf("%.*g %.*g %.*g " ,DGT,vp->P()[0],DGT,vp->P()[1],DGT,vp->P()[2]);
 
-					if( HasPerVertexNormal(m) && (pi.mask & Mask::IOM_VERTNORMAL) )
-						fprintf(fpout,"%.*g %.*g %.*g " ,DGT,ScalarType(vp->N()[0]),DGT,ScalarType(vp->N()[1]),DGT,ScalarType(vp->N()[2]));
+				if( HasPerVertexNormal(m) && (pi.mask & Mask::IOM_VERTNORMAL) )
+					out.Printf("%.*g %.*g %.*g " ,DGT,ScalarType(vp->N()[0]),DGT,ScalarType(vp->N()[1]),DGT,ScalarType(vp->N()[2]));
 
-					if( HasPerVertexFlags(m) && (pi.mask & Mask::IOM_VERTFLAGS))
-						fprintf(fpout,"%d ",vp->Flags());
+				if( HasPerVertexFlags(m) && (pi.mask & Mask::IOM_VERTFLAGS))
+					out.Printf("%d ",vp->Flags());
 
-					if( HasPerVertexColor(m) && (pi.mask & Mask::IOM_VERTCOLOR) )
-						fprintf(fpout,"%d %d %d %d ",vp->C()[0],vp->C()[1],vp->C()[2],vp->C()[3] );
+				if( HasPerVertexColor(m) && (pi.mask & Mask::IOM_VERTCOLOR) )
+					out.Printf("%d %d %d %d ",vp->C()[0],vp->C()[1],vp->C()[2],vp->C()[3] );
 
-					if( HasPerVertexQuality(m) && (pi.mask & Mask::IOM_VERTQUALITY) )
-						fprintf(fpout,"%.*g ",DGTVQ,vp->Q());
+				if( HasPerVertexQuality(m) && (pi.mask & Mask::IOM_VERTQUALITY) )
+					out.Printf("%.*g ",DGTVQ,vp->Q());
 
-					if( HasPerVertexRadius(m) && (pi.mask & Mask::IOM_VERTRADIUS) )
-						fprintf(fpout,"%.*g ",DGTVR,vp->R());
+				if( HasPerVertexRadius(m) && (pi.mask & Mask::IOM_VERTRADIUS) )
+					out.Printf("%.*g ",DGTVR,vp->R());
 
-					if( HasPerVertexTexCoord(m) && (pi.mask & Mask::IOM_VERTTEXCOORD) )
-						fprintf(fpout,"%f %f",vp->T().u(),vp->T().v());
+				if( HasPerVertexTexCoord(m) && (pi.mask & Mask::IOM_VERTTEXCOORD) )
+					out.Printf("%f %f",vp->T().u(),vp->T().v());
 
-					for(size_t i=0;i<pi.VertDescriptorVec.size();i++)
-					{
-						float tf(0); double td(0); int ti;
-						if(!pi.VertAttrNameVec.empty() && !pi.VertAttrNameVec[i].empty())
-						{ // trying to use named attribute to retrieve the value to store
-							assert(vcg::tri::HasPerVertexAttribute(m,pi.VertAttrNameVec[i]));
-							if (!pi.VertDescriptorVec[i].islist){
-								switch (pi.VertDescriptorVec[i].stotype1)
-								{
-								case ply::T_FLOAT  : tf=thfv[i][vp]; fprintf(fpout,"%f ",tf); break;
-								case ply::T_DOUBLE : td=thdv[i][vp]; fprintf(fpout,"%lf ",td); break;
-								case ply::T_INT    : ti=thiv[i][vp]; fprintf(fpout,"%i ",ti); break;
-								case ply::T_SHORT  : ti=thsv[i][vp]; fprintf(fpout,"%i ",ti); break;
-								case ply::T_CHAR   : ti=thcv[i][vp]; fprintf(fpout,"%i ",ti); break;
-								case ply::T_UCHAR  : ti=thuv[i][vp]; fprintf(fpout,"%i ",ti); break;
-								default : assert(0);
-								}
-							}
-							else { //it is a Poin3f or a Point3d attribute. Saving it as a list
-								switch (pi.VertDescriptorVec[i].stotype1)
-								{
-								case ply::T_FLOAT  : fprintf(fpout,"%d %f %f %f", 3, thp3fv[i][vp][0], thp3fv[i][vp][1], thp3fv[i][vp][2]); break;
-								case ply::T_DOUBLE : fprintf(fpout,"%d %lf %lf %lf", 3, thp3dv[i][vp][0], thp3dv[i][vp][1], thp3dv[i][vp][2]); break;
-								default : assert(0);
-								}
+				for(size_t i=0;i<pi.VertDescriptorVec.size();i++)
+				{
+					float tf(0); double td(0); int ti;
+					if(!pi.VertAttrNameVec.empty() && !pi.VertAttrNameVec[i].empty())
+					{ // trying to use named attribute to retrieve the value to store
+						assert(vcg::tri::HasPerVertexAttribute(m,pi.VertAttrNameVec[i]));
+						if (!pi.VertDescriptorVec[i].islist){
+							switch (pi.VertDescriptorVec[i].stotype1)
+							{
+							case ply::T_FLOAT  : tf=thfv[i][vp]; out.Printf("%f ",tf); break;
+							case ply::T_DOUBLE : td=thdv[i][vp]; out.Printf("%lf ",td); break;
+							case ply::T_INT    : ti=thiv[i][vp]; out.Printf("%i ",ti); break;
+							case ply::T_SHORT  : ti=thsv[i][vp]; out.Printf("%i ",ti); break;
+							case ply::T_CHAR   : ti=thcv[i][vp]; out.Printf("%i ",ti); break;
+							case ply::T_UCHAR  : ti=thuv[i][vp]; out.Printf("%i ",ti); break;
+							default : assert(0);
 							}
 						}
-						else
-						{
-							switch (pi.VertDescriptorVec[i].memtype1)
+						else { //it is a Poin3f or a Point3d attribute. Saving it as a list
+							switch (pi.VertDescriptorVec[i].stotype1)
 							{
-							case ply::T_FLOAT  : tf=*( (float  *)        (((char *)vp)+pi.VertDescriptorVec[i].offset1)); fprintf(fpout,"%f ",tf); break;
-							case ply::T_DOUBLE : td=*( (double *)        (((char *)vp)+pi.VertDescriptorVec[i].offset1)); fprintf(fpout,"%lf ",tf); break;
-							case ply::T_INT    : ti=*( (int	*)           (((char *)vp)+pi.VertDescriptorVec[i].offset1)); fprintf(fpout,"%i ",ti); break;
-							case ply::T_SHORT  : ti=*( (short  *)        (((char *)vp)+pi.VertDescriptorVec[i].offset1)); fprintf(fpout,"%i ",ti); break;
-							case ply::T_CHAR   : ti=*( (char   *)        (((char *)vp)+pi.VertDescriptorVec[i].offset1)); fprintf(fpout,"%i ",ti); break;
-							case ply::T_UCHAR  : ti=*( (unsigned char *) (((char *)vp)+pi.VertDescriptorVec[i].offset1)); fprintf(fpout,"%i ",ti); break;
+							case ply::T_FLOAT  : out.Printf("%d %f %f %f", 3, thp3fv[i][vp][0], thp3fv[i][vp][1], thp3fv[i][vp][2]); break;
+							case ply::T_DOUBLE : out.Printf("%d %lf %lf %lf", 3, thp3dv[i][vp][0], thp3dv[i][vp][1], thp3dv[i][vp][2]); break;
 							default : assert(0);
 							}
 						}
 					}
-
-					fprintf(fpout,"\n");
+					else
+					{
+						switch (pi.VertDescriptorVec[i].memtype1)
+						{
+						case ply::T_FLOAT  : tf=*( (float  *)        (((char *)vp)+pi.VertDescriptorVec[i].offset1)); out.Printf("%f ",tf); break;
+						case ply::T_DOUBLE : td=*( (double *)        (((char *)vp)+pi.VertDescriptorVec[i].offset1)); out.Printf("%lf ",tf); break;
+						case ply::T_INT    : ti=*( (int	*)           (((char *)vp)+pi.VertDescriptorVec[i].offset1)); out.Printf("%i ",ti); break;
+						case ply::T_SHORT  : ti=*( (short  *)        (((char *)vp)+pi.VertDescriptorVec[i].offset1)); out.Printf("%i ",ti); break;
+						case ply::T_CHAR   : ti=*( (char   *)        (((char *)vp)+pi.VertDescriptorVec[i].offset1)); out.Printf("%i ",ti); break;
+						case ply::T_UCHAR  : ti=*( (unsigned char *) (((char *)vp)+pi.VertDescriptorVec[i].offset1)); out.Printf("%i ",ti); break;
+						default : assert(0);
+						}
+					}
 				}
-				j++;
+
+				out.Printf("\n");
 			}
-		}
-		/*vcg::tri::*/
-		// this assert triggers when the vn != number of vertexes in vert that are not deleted.
-		assert(j==m.vn);
+		}, vertProgress);
 
-		unsigned char b3char = 3;
-		unsigned char b9char = 9;
-		unsigned char b6char = 6;
-		FacePointer fp;
-		int vv[3];
-		FaceIterator fi;
-		int fcnt=0;
-		for(j=0,fi=m.face.begin();fi!=m.face.end();++fi)
+		const unsigned char b3char = 3;
+		const unsigned char b9char = 9;
+		const unsigned char b6char = 6;
+		written = written && WriteElementsInChunks(fpout, m.face.size(), [&](OutBuffer &out, size_t fIdx)
 		{
-			//((m.vn+m.fn) != 0) all vertices and faces have been marked as deleted but the are still in the vert/face vectors
-			if(cb && ((j%1000)==0) && ((m.vn+m.fn) != 0))
-				(*cb)( 100*(m.vn+j)/(m.vn+m.fn), "Saving Vertices");
+			FacePointer fp = &m.face[fIdx];
+			if( fp->IsD() )
+				return;
 
-			fp=&(*fi);
-			if( ! fp->IsD() )
-			{ fcnt++;
-				if(binary)
-				{
-					vv[0]=indices[fp->cV(0)];
-					vv[1]=indices[fp->cV(1)];
-					vv[2]=indices[fp->cV(2)];
-					fwrite(&b3char,sizeof(char),1,fpout);
-					fwrite(vv,sizeof(int),3,fpout);
-
-					if(HasPerFaceFlags(m)&&( pi.mask & Mask::IOM_FACEFLAGS) ){
-						auto fl = fp->Flags();
-						fwrite(&fl,sizeof(int),1,fpout);
-					}
+			int vv[3];
+			if(binary)
+			{
+				vv[0]=indices[fp->cV(0)];
+				vv[1]=indices[fp->cV(1)];
+				vv[2]=indices[fp->cV(2)];
+				out.Write(&b3char,sizeof(char),1);
+				out.Write(vv,sizeof(int),3);
+
+				if(HasPerFaceFlags(m)&&( pi.mask & Mask::IOM_FACEFLAGS) ){
+					auto fl = fp->Flags();
+					out.Write(&fl,sizeof(int),1);
+				}
 
-					if( HasPerVertexTexCoord(m) && (!HasPerWedgeTexCoord(m)) && (pi.mask & Mask::IOM_WEDGTEXCOORD) )  // Note that you can save VT as WT if you really want it...
+				if( HasPerVertexTexCoord(m) && (!HasPerWedgeTexCoord(m)) && (pi.mask & Mask::IOM_WEDGTEXCOORD) )  // Note that you can save VT as WT if you really want it...
+				{
+					out.Write(&b6char,sizeof(char),1);
+					float t[6];
+					for(int k=0;k<3;++k)
 					{
-						fwrite(&b6char,sizeof(char),1,fpout);
-						float t[6];
-						for(int k=0;k<3;++k)
-						{
-							t[k*2+0] = fp->V(k)->T().u();
-							t[k*2+1] = fp->V(k)->T().v();
-						}
-						fwrite(t,sizeof(float),6,fpout);
+						t[k*2+0] = fp->V(k)->T().u();
+						t[k*2+1] = fp->V(k)->T().v();
 					}
-					else if( HasPerWedgeTexCoord(m) && (pi.mask & Mask::IOM_WEDGTEXCOORD)  )
+					out.Write(t,sizeof(float),6);
+				}
+				else if( HasPerWedgeTexCoord(m) && (pi.mask & Mask::IOM_WEDGTEXCOORD)  )
+				{
+					out.Write(&b6char,sizeof(char),1);
+					float t[6];
+					for(int k=0;k<3;++k)
 					{
-						fwrite(&b6char,sizeof(char),1,fpout);
-						float t[6];
-						for(int k=0;k<3;++k)
-						{
-							t[k*2+0] = fp->WT(k).u();
-							t[k*2+1] = fp->WT(k).v();
-						}
-						fwrite(t,sizeof(float),6,fpout);
+						t[k*2+0] = fp->WT(k).u();
+						t[k*2+1] = fp->WT(k).v();
 					}
+					out.Write(t,sizeof(float),6);
+				}
 
-					if(saveTexIndexFlag)
-					{
-						int t = fp->WT(0).n();
-						fwrite(&t,sizeof(int),1,fpout);
-					}
+				if(saveTexIndexFlag)
+				{
+					int t = fp->WT(0).n();
+					out.Write(&t,sizeof(int),1);
+				}
 
-					if( HasPerFaceColor(m) && (pi.mask & Mask::IOM_FACECOLOR) )
-						fwrite(&( fp->C() ),sizeof(char),4,fpout);
+				if( HasPerFaceColor(m) && (pi.mask & Mask::IOM_FACECOLOR) )
+					out.Write(&( fp->C() ),sizeof(char),4);
 
 
-					if( HasPerWedgeColor(m) && (pi.mask & Mask::IOM_WEDGCOLOR)  )
+				if( HasPerWedgeColor(m) && (pi.mask & Mask::IOM_WEDGCOLOR)  )
+				{
+					out.Write(&b9char,sizeof(char),1);
+					float t[3];
+					for(int z=0;z<3;++z)
 					{
-						fwrite(&b9char,sizeof(char),1,fpout);
-						float t[3];
-						for(int z=0;z<3;++z)
-						{
-							t[0] = float(fp->WC(z)[0])/255;
-							t[1] = float(fp->WC(z)[1])/255;
-							t[2] = float(fp->WC(z)[2])/255;
-							fwrite( t,sizeof(float),3,fpout);
-						}
+						t[0] = float(fp->WC(z)[0])/255;
+						t[1] = float(fp->WC(z)[1])/255;
+						t[2] = float(fp->WC(z)[2])/255;
+						out.Write( t,sizeof(float),3);
 					}
+				}
 
-					if( HasPerFaceNormal(m) && (pi.mask & Mask::IOM_FACENORMAL) )
-					{
-						ScalarType t;
-						t = ScalarType(fp->N()[0]); fwrite(&t,sizeof(ScalarType),1,fpout);
-						t = ScalarType(fp->N()[1]); fwrite(&t,sizeof(ScalarType),1,fpout);
-						t = ScalarType(fp->N()[2]); fwrite(&t,sizeof(ScalarType),1,fpout);
-					}
+				if( HasPerFaceNormal(m) && (pi.mask & Mask::IOM_FACENORMAL) )
+				{
+					ScalarType t;
+					t = ScalarType(fp->N()[0]); out.Write(&t,sizeof(ScalarType),1);
+					t = ScalarType(fp->N()[1]); out.Write(&t,sizeof(ScalarType),1);
+					t = ScalarType(fp->N()[2]); out.Write(&t,sizeof(ScalarType),1);
+				}
 
-					if( HasPerFaceQuality(m) && (pi.mask & Mask::IOM_FACEQUALITY) )
-						fwrite( &(fp->Q()),sizeof(typename FaceType::ScalarType),1,fpout);
+				if( HasPerFaceQuality(m) && (pi.mask & Mask::IOM_FACEQUALITY) )
+					out.Write( &(fp->Q()),sizeof(typename FaceType::ScalarType),1);
 
 
-					for(size_t i=0;i<pi.FaceDescriptorVec.size();i++)
-					{
-						double td(0); float tf(0);int ti;short ts; char tc; unsigned char tu;
-						if(!pi.FaceAttrNameVec.empty() && !pi.FaceAttrNameVec[i].empty())
-						{ // trying to use named attribute to retrieve the value to store
-							assert(vcg::tri::HasPerFaceAttribute(m,pi.FaceAttrNameVec[i]));
-							if (!pi.FaceDescriptorVec[i].islist){
-								switch (pi.FaceDescriptorVec[i].stotype1)
-								{
-								case ply::T_FLOAT  : tf=thff[i][fp]; fwrite(&tf, sizeof(float),1,fpout); break;
-								case ply::T_DOUBLE : td=thdf[i][fp]; fwrite(&td, sizeof(double),1,fpout); break;
-								case ply::T_INT    : ti=thif[i][fp]; fwrite(&ti, sizeof(int),1,fpout); break;
-								case ply::T_SHORT  : ts=thsf[i][fp]; fwrite(&ts, sizeof(short),1,fpout); break;
-								case ply::T_CHAR   : tc=thcf[i][fp]; fwrite(&tc, sizeof(char),1,fpout); break;
-								case ply::T_UCHAR  : tu=thuf[i][fp]; fwrite(&tu,sizeof(unsigned char),1,fpout); break;
-								default : assert(0);
-								}
-							}
-							else {
-								static const unsigned char psize = 3;
-								switch (pi.FaceDescriptorVec[i].stotype1)
-								{
-								case ply::T_FLOAT  :
-									fwrite(&psize, sizeof(unsigned char), 1,fpout);
-									fwrite(&thp3ff[i][fp][0], sizeof(float), 1,fpout);
-									fwrite(&thp3ff[i][fp][1], sizeof(float), 1,fpout);
-									fwrite(&thp3ff[i][fp][2], sizeof(float), 1,fpout);
-									break;
-								case ply::T_DOUBLE :
-									fwrite(&psize, sizeof(unsigned char), 1,fpout);
-									fwrite(&thp3df[i][fp][0], sizeof(double), 1,fpout);
-									fwrite(&thp3df[i][fp][1], sizeof(double), 1,fpout);
-									fwrite(&thp3df[i][fp][2], sizeof(double), 1,fpout);
-								default : assert(0);
-								}
+				for(size_t i=0;i<pi.FaceDescriptorVec.size();i++)
+				{
+					double td(0); float tf(0);int ti;short ts; char tc; unsigned char tu;
+					if(!pi.FaceAttrNameVec.empty() && !pi.FaceAttrNameVec[i].empty())
+					{ // trying to use named attribute to retrieve the value to store
+						assert(vcg::tri::HasPerFaceAttribute(m,pi.FaceAttrNameVec[i]));
+						if (!pi.FaceDescriptorVec[i].islist){
+							switch (pi.FaceDescriptorVec[i].stotype1)
+							{
+							case ply::T_FLOAT  : tf=thff[i][fp]; out.Write(&tf, sizeof(float),1); break;
+							case ply::T_DOUBLE : td=thdf[i][fp]; out.Write(&td, sizeof(double),1); break;
+							case ply::T_INT    : ti=thif[i][fp]; out.Write(&ti, sizeof(int),1); break;
+							case ply::T_SHORT  : ts=thsf[i][fp]; out.Write(&ts, sizeof(short),1); break;
+							case ply::T_CHAR   : tc=thcf[i][fp]; out.Write(&tc, sizeof(char),1); break;
+							case ply::T_UCHAR  : tu=thuf[i][fp]; out.Write(&tu,sizeof(unsigned char),1); break;
+							default : assert(0);
 							}
 						}
-						else
-						{
-							switch (pi.FaceDescriptorVec[i].stotype1){
-							case ply::T_FLOAT	 :		PlyConv(pi.FaceDescriptorVec[i].memtype1,  ((char *)fp)+pi.FaceDescriptorVec[i].offset1, tf );	fwrite(&tf, sizeof(float),1,fpout); break;
-							case ply::T_DOUBLE :		PlyConv(pi.FaceDescriptorVec[i].memtype1,  ((char *)fp)+pi.FaceDescriptorVec[i].offset1, td );	fwrite(&td, sizeof(double),1,fpout); break;
-							case ply::T_INT		 :		PlyConv(pi.FaceDescriptorVec[i].memtype1,  ((char *)fp)+pi.FaceDescriptorVec[i].offset1, ti );	fwrite(&ti, sizeof(int),1,fpout); break;
-							case ply::T_SHORT	 :		PlyConv(pi.FaceDescriptorVec[i].memtype1,  ((char *)fp)+pi.FaceDescriptorVec[i].offset1, ts );	fwrite(&ts, sizeof(short),1,fpout); break;
-							case ply::T_CHAR	 :		PlyConv(pi.FaceDescriptorVec[i].memtype1,  ((char *)fp)+pi.FaceDescriptorVec[i].offset1, tc );	fwrite(&tc, sizeof(char),1,fpout); break;
-							case ply::T_UCHAR	 :		PlyConv(pi.FaceDescriptorVec[i].memtype1,  ((char *)fp)+pi.FaceDescriptorVec[i].offset1, tu );	fwrite(&tu, sizeof(unsigned char),1,fpout); break;
+						else {
+							static const unsigned char psize = 3;
+							switch (pi.FaceDescriptorVec[i].stotype1)
+							{
+							case ply::T_FLOAT  :
+								out.Write(&psize, sizeof(unsigned char), 1);
+								out.Write(&thp3ff[i][fp][0], sizeof(float), 1);
+								out.Write(&thp3ff[i][fp][1], sizeof(float), 1);
+								out.Write(&thp3ff[i][fp][2], sizeof(float), 1);
+								break;
+							case ply::T_DOUBLE :
+								out.Write(&psize, sizeof(unsigned char), 1);
+								out.Write(&thp3df[i][fp][0], sizeof(double), 1);
+								out.Write(&thp3df[i][fp][1], sizeof(double), 1);
+								out.Write(&thp3df[i][fp][2], sizeof(double), 1);
 							default : assert(0);
 							}
 						}
 					}
+					else
+					{
+						switch (pi.FaceDescriptorVec[i].stotype1){
+						case ply::T_FLOAT	 :		PlyConv(pi.FaceDescriptorVec[i].memtype1,  ((char *)fp)+pi.FaceDescriptorVec[i].offset1, tf );	out.Write(&tf, sizeof(float),1); break;
+						case ply::T_DOUBLE :		PlyConv(pi.FaceDescriptorVec[i].memtype1,  ((char *)fp)+pi.FaceDescriptorVec[i].offset1, td );	out.Write(&td, sizeof(double),1); break;
+						case ply::T_INT		 :		PlyConv(pi.FaceDescriptorVec[i].memtype1,  ((char *)fp)+pi.FaceDescriptorVec[i].offset1, ti );	out.Write(&ti, sizeof(int),1); break;
+						case ply::T_SHORT	 :		PlyConv(pi.FaceDescriptorVec[i].memtype1,  ((char *)fp)+pi.FaceDescriptorVec[i].offset1, ts );	out.Write(&ts, sizeof(short),1); break;
+						case ply::T_CHAR	 :		PlyConv(pi.FaceDescriptorVec[i].memtype1,  ((char *)fp)+pi.FaceDescriptorVec[i].offset1, tc );	out.Write(&tc, sizeof(char),1); break;
+						case ply::T_UCHAR	 :		PlyConv(pi.FaceDescriptorVec[i].memtype1,  ((char *)fp)+pi.FaceDescriptorVec[i].offset1, tu );	out.Write(&tu, sizeof(unsigned char),1); break;
+						default : assert(0);
+						}
+					}
 				}
-				else	// ***** ASCII *****
-				{
-					fprintf(fpout,"%d " ,fp->VN());
-					for(int k=0;k<fp->VN();++k)
-						fprintf(fpout,"%d ",indices[fp->cV(k)]);
+			}
+			else	// ***** ASCII *****
+			{
+				out.Printf("%d " ,fp->VN());
+				for(int k=0;k<fp->VN();++k)
+					out.Printf("%d ",indices[fp->cV(k)]);
 
-					if(HasPerFaceFlags(m)&&( pi.mask & Mask::IOM_FACEFLAGS ))
-						fprintf(fpout,"%d ",fp->Flags());
+				if(HasPerFaceFlags(m)&&( pi.mask & Mask::IOM_FACEFLAGS ))
+					out.Printf("%d ",fp->Flags());
 
-					if( HasPerVertexTexCoord(m) && (pi.mask & Mask::IOM_WEDGTEXCOORD) ) // you can save VT as WT if you really want it...
-					{
-						fprintf(fpout,"%d ",fp->VN()*2);
-						for(int k=0;k<fp->VN();++k)
-							fprintf(fpout,"%f %f "
-									,fp->V(k)->T().u()
-									,fp->V(k)->T().v()
-									);
-					}
-					else if( HasPerWedgeTexCoord(m) && (pi.mask & Mask::IOM_WEDGTEXCOORD)  )
-					{
-						fprintf(fpout,"%d ",fp->VN()*2);
-						for(int k=0;k<fp->VN();++k)
-							fprintf(fpout,"%f %f "
-									,fp->WT(k).u()
-									,fp->WT(k).v()
-									);
-					}
+				if( HasPerVertexTexCoord(m) && (pi.mask & Mask::IOM_WEDGTEXCOORD) ) // you can save VT as WT if you really want it...
+				{
+					out.Printf("%d ",fp->VN()*2);
+					for(int k=0;k<fp->VN();++k)
+						out.Printf("%f %f "
+								,fp->V(k)->T().u()
+								,fp->V(k)->T().v()
+								);
+				}
+				else if( HasPerWedgeTexCoord(m) && (pi.mask & Mask::IOM_WEDGTEXCOORD)  )
+				{
+					out.Printf("%d ",fp->VN()*2);
+					for(int k=0;k<fp->VN();++k)
+						out.Printf("%f %f "
+								,fp->WT(k).u()
+								,fp->WT(k).v()
+								);
+				}
 
-					if(saveTexIndexFlag)
-					{
-						fprintf(fpout,"%d ",fp->WT(0).n());
-					}
+				if(saveTexIndexFlag)
+				{
+					out.Printf("%d ",fp->WT(0).n());
+				}
 
-					if( HasPerFaceColor(m) && (pi.mask & Mask::IOM_FACECOLOR)  )
-					{
-						fprintf(fpout, "%u %u %u %u ", fp->C()[0], fp->C()[1], fp->C()[2], fp->C()[3]);
-					}
-					else if( HasPerWedgeColor(m) && (pi.mask & Mask::IOM_WEDGCOLOR)  )
-					{
-						fprintf(fpout,"9 ");
-						for(int z=0;z<3;++z)
-							fprintf(fpout,"%g %g %g "
-									,double(fp->WC(z)[0])/255
-									,double(fp->WC(z)[1])/255
-									,double(fp->WC(z)[2])/255
-									);
-					}
+				if( HasPerFaceColor(m) && (pi.mask & Mask::IOM_FACECOLOR)  )
+				{
+					out.Printf( "%u %u %u %u ", fp->C()[0], fp->C()[1], fp->C()[2], fp->C()[3]);
+				}
+				else if( HasPerWedgeColor(m) && (pi.mask & Mask::IOM_WEDGCOLOR)  )
+				{
+					out.Printf("9 ");
+					for(int z=0;z<3;++z)
+						out.Printf("%g %g %g "
+								,double(fp->WC(z)[0])/255
+								,double(fp->WC(z)[1])/255
+								,double(fp->WC(z)[2])/255
+								);
+				}
 
-					if (HasPerFaceNormal(m) && (pi.mask & Mask::IOM_FACENORMAL))
-						fprintf(fpout,"%.*g %.*g %.*g " ,DGT, ScalarType(fp->N()[0]),DGT,ScalarType(fp->N()[1]),DGT,ScalarType(fp->N()[2]));
+				if (HasPerFaceNormal(m) && (pi.mask & Mask::IOM_FACENORMAL))
+					out.Printf("%.*g %.*g %.*g " ,DGT, ScalarType(fp->N()[0]),DGT,ScalarType(fp->N()[1]),DGT,ScalarType(fp->N()[2]));
 
-					if( HasPerFaceQuality(m) && (pi.mask & Mask::IOM_FACEQUALITY) )
-						fprintf(fpout,"%.*g ",DGTFQ,fp->Q());
+				if( HasPerFaceQuality(m) && (pi.mask & Mask::IOM_FACEQUALITY) )
+					out.Printf("%.*g ",DGTFQ,fp->Q());
 
-					for(size_t i=0;i<pi.FaceDescriptorVec.size();i++)
-					{
-						float tf(0); double td(0); int ti;
-						if(!pi.FaceAttrNameVec.empty() && !pi.FaceAttrNameVec[i].empty())
-						{ // trying to use named attribute to retrieve the value to store
-							assert(vcg::tri::HasPerFaceAttribute(m,pi.FaceAttrNameVec[i]));
-							if(!pi.FaceDescriptorVec[i].islist) {
-								switch (pi.FaceDescriptorVec[i].stotype1)
-								{
-								case ply::T_FLOAT  : tf=thff[i][fp]; fprintf(fpout,"%f ",tf); break;
-								case ply::T_DOUBLE : td=thdf[i][fp]; fprintf(fpout,"%g ",td); break;
-								case ply::T_INT	: ti=thif[i][fp]; fprintf(fpout,"%i ",ti); break;
-								case ply::T_SHORT  : ti=thsf[i][fp]; fprintf(fpout,"%i ",ti); break;
-								case ply::T_CHAR   : ti=thcf[i][fp]; fprintf(fpout,"%i ",ti); break;
-								case ply::T_UCHAR  : ti=thuf[i][fp]; fprintf(fpout,"%i ",ti); break;
-								default : assert(0);
-								}
-							}
-							else {
-								switch (pi.FaceDescriptorVec[i].stotype1)
-								{
-								case ply::T_FLOAT  : fprintf(fpout,"%d %f %f %f", 3, thp3ff[i][fp][0], thp3ff[i][fp][1], thp3ff[i][fp][2]); break;
-								case ply::T_DOUBLE : fprintf(fpout,"%d %lf %lf %lf", 3, thp3df[i][fp][0], thp3df[i][fp][1], thp3df[i][fp][2]); break;
-								default : assert(0);
-								}
+				for(size_t i=0;i<pi.FaceDescriptorVec.size();i++)
+				{
+					float tf(0); double td(0); int ti;
+					if(!pi.FaceAttrNameVec.empty() && !pi.FaceAttrNameVec[i].empty())
+					{ // trying to use named attribute to retrieve the value to store
+						assert(vcg::tri::HasPerFaceAttribute(m,pi.FaceAttrNameVec[i]));
+						if(!pi.FaceDescriptorVec[i].islist) {
+							switch (pi.FaceDescriptorVec[i].stotype1)
+							{
+							case ply::T_FLOAT  : tf=thff[i][fp]; out.Printf("%f ",tf); break;
+							case ply::T_DOUBLE : td=thdf[i][fp]; out.Printf("%g ",td); break;
+							case ply::T_INT	: ti=thif[i][fp]; out.Printf("%i ",ti); break;
+							case ply::T_SHORT  : ti=thsf[i][fp]; out.Printf("%i ",ti); break;
+							case ply::T_CHAR   : ti=thcf[i][fp]; out.Printf("%i ",ti); break;
+							case ply::T_UCHAR  : ti=thuf[i][fp]; out.Printf("%i ",ti); break;
+							default : assert(0);
 							}
 						}
-						else
-						{
-							switch (pi.FaceDescriptorVec[i].memtype1)
+						else {
+							switch (pi.FaceDescriptorVec[i].stotype1)
 							{
-							case  ply::T_FLOAT	:		tf=*( (float  *)		(((char *)fp)+pi.FaceDescriptorVec[i].offset1));	fprintf(fpout,"%g ",tf); break;
-							case  ply::T_DOUBLE :		td=*( (double *)		(((char *)fp)+pi.FaceDescriptorVec[i].offset1));	fprintf(fpout,"%g ",tf); break;
-							case  ply::T_INT		:		ti=*( (int	*)		(((char *)fp)+pi.FaceDescriptorVec[i].offset1));	fprintf(fpout,"%i ",ti); break;
-							case  ply::T_SHORT	:		ti=*( (short  *)		(((char *)fp)+pi.FaceDescriptorVec[i].offset1));	fprintf(fpout,"%i ",ti); break;
-							case  ply::T_CHAR		:		ti=*( (char   *)		(((char *)fp)+pi.FaceDescriptorVec[i].offset1));	fprintf(fpout,"%i ",ti); break;
-							case  ply::T_UCHAR	:		ti=*( (unsigned char *) (((char *)fp)+pi.FaceDescriptorVec[i].offset1));	fprintf(fpout,"%i ",ti); break;
+							case ply::T_FLOAT  : out.Printf("%d %f %f %f", 3, thp3ff[i][fp][0], thp3ff[i][fp][1], thp3ff[i][fp][2]); break;
+							case ply::T_DOUBLE : out.Printf("%d %lf %lf %lf", 3, thp3df[i][fp][0], thp3df[i][fp][1], thp3df[i][fp][2]); break;
 							default : assert(0);
 							}
 						}
 					}
-
-					fprintf(fpout,"\n");
+					else
+					{
+						switch (pi.FaceDescriptorVec[i].memtype1)
+						{
+						case  ply::T_FLOAT	:		tf=*( (float  *)		(((char *)fp)+pi.FaceDescriptorVec[i].offset1));	out.Printf("%g ",tf); break;
+						case  ply::T_DOUBLE :		td=*( (double *)		(((char *)fp)+pi.FaceDescriptorVec[i].offset1));	out.Printf("%g ",tf); break;
+						case  ply::T_INT		:		ti=*( (int	*)		(((char *)fp)+pi.FaceDescriptorVec[i].offset1));	out.Printf("%i ",ti); break;
+						case  ply::T_SHORT	:		ti=*( (short  *)		(((char *)fp)+pi.FaceDescriptorVec[i].offset1));	out.Printf("%i ",ti); break;
+						case  ply::T_CHAR		:		ti=*( (char   *)		(((char *)fp)+pi.FaceDescriptorVec[i].offset1));	out.Printf("%i ",ti); break;
+						case  ply::T_UCHAR	:		ti=*( (unsigned char *) (((char *)fp)+pi.FaceDescriptorVec[i].offset1));	out.Printf("%i ",ti); break;
+						default : assert(0);
+						}
+					}
 				}
+
+				out.Printf("\n");
 			}
-		}
-		assert(fcnt==m.fn);
-		int eauxvv[2];
-		if( pi.mask & Mask::IOM_EDGEINDEX )
+		}, faceProgress);
+
+		if( written && (pi.mask & Mask::IOM_EDGEINDEX) )
 		{
-			int ecnt=0;
-			for(EdgeIterator ei=m.edge.begin();ei!=m.edge.end();++ei)
+			assert(std::count_if(m.edge.begin(),m.edge.end(),[](const typename SaveMeshType::EdgeType &e){return !e.IsD();})==m.en);
+			written = WriteElementsInChunks(fpout, m.edge.size(), [&](OutBuffer &out, size_t eIdx)
 			{
-				if( ! ei->IsD() )
+				EdgeIterator ei = m.edge.begin()+eIdx;
+				if( ei->IsD() )
+					return;
+				if(binary)
 				{
-					++ecnt;
-					if(binary)
-					{
-						eauxvv[0]=indices[ei->cV(0)];
-						eauxvv[1]=indices[ei->cV(1)];
-						fwrite(eauxvv,sizeof(int),2,fpout);
-					}
-					else // ***** ASCII *****
-						fprintf(fpout,"%d %d \n", indices[ei->cV(0)],	indices[ei->cV(1)]);
+					int eauxvv[2];
+					eauxvv[0]=indices[ei->cV(0)];
+					eauxvv[1]=indices[ei->cV(1)];
+					out.Write(eauxvv,sizeof(int),2);
 				}
-			}
-			assert(ecnt==m.en);
+				else // ***** ASCII *****
+					out.Printf("%d %d \n", indices[ei->cV(0)],	indices[ei->cV(1)]);
+			}, [](size_t){ return true; });
 		}
 		int result = 0;
-		if (ferror(fpout)) result = ply::E_STREAMERROR;
+		if (!written || ferror(fpout)) result = ply::E_STREAMERROR;
 		fclose(fpout);
 		return result;
 	}
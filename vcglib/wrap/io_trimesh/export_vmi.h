@@ -55,7 +55,7 @@ namespace io {
         static unsigned int & Out_mode(){static unsigned int  out_mode = 0; return out_mode;}
 
 
-        static unsigned int & pos(){static unsigned int  p = 0; return p;}
+        static size_t & pos(){static size_t  p = 0; return p;}
         static int fwrite_sim(const void * , size_t size, size_t count){ pos() += size * count;return size * count; }
         static int fwrite_mem(const void *src , size_t size, size_t count ){ memcpy(&Out_mem()[pos()],src,size*count); pos() += size * count;return size * count; }
 
@@ -255,7 +255,7 @@ namespace io {
             Out_mem() = ptr;
             return Serialize(m);
         }
-        static int BufferSize(const SaveMeshType &m){
+        static size_t BufferSize(const SaveMeshType &m){
             Out_mode() = 0;
             pos() = 0 ;
             Serialize(m);
@@ -305,36 +305,39 @@ public:
 		};
 		return cad[i];
 	}
+	static std::vector<std::string> ErrorMsgList()
+	{
+		std::vector<std::string> msg(PlyInfo::E_MAXPLYINFOERRORS);
+		msg[ply::E_NOERROR				]="No errors";
+		msg[ply::E_CANTOPEN				]="Can't open file";
+		msg[ply::E_NOTHEADER ]="Header not found";
+		msg[ply::E_UNESPECTEDEOF	]="Eof in header";
+		msg[ply::E_NOFORMAT				]="Format not found";
+		msg[ply::E_SYNTAX				]="Syntax error on header";
+		msg[ply::E_PROPOUTOFELEMENT]="Property without element";
+		msg[ply::E_BADTYPENAME		]="Bad type name";
+		msg[ply::E_ELEMNOTFOUND		]="Element not found";
+		msg[ply::E_PROPNOTFOUND		]="Property not found";
+		msg[ply::E_BADTYPE				]="Bad type on addtoread";
+		msg[ply::E_INCOMPATIBLETYPE]="Incompatible type";
+		msg[ply::E_BADCAST				]="Bad cast";
+
+		msg[PlyInfo::E_NO_VERTEX      ]="No vertex field found";
+		msg[PlyInfo::E_NO_FACE        ]="No face field found";
+		msg[PlyInfo::E_SHORTFILE      ]="Unespected eof";
+		msg[PlyInfo::E_NO_3VERTINFACE ]="Face with more than 3 vertices";
+		msg[PlyInfo::E_BAD_VERT_INDEX ]="Bad vertex index in face";
+		msg[PlyInfo::E_BAD_VERT_INDEX_EDGE ]="Bad vertex index in edge";
+		msg[PlyInfo::E_NO_6TCOORD     ]="Face with no 6 texture coordinates";
+		msg[PlyInfo::E_DIFFER_COLORS  ]="Number of color differ from vertices";
+		return msg;
+	}
+
 	/// Standard call for knowing the meaning of an error code
 	static const char *ErrorMsg(int error)
 	{
-		static std::vector<std::string> ply_error_msg;
-		if(ply_error_msg.empty())
-		{
-			ply_error_msg.resize(PlyInfo::E_MAXPLYINFOERRORS );
-			ply_error_msg[ply::E_NOERROR				]="No errors";
-			ply_error_msg[ply::E_CANTOPEN				]="Can't open file";
-			ply_error_msg[ply::E_NOTHEADER ]="Header not found";
-			ply_error_msg[ply::E_UNESPECTEDEOF	]="Eof in header";
-			ply_error_msg[ply::E_NOFORMAT				]="Format not found";
-			ply_error_msg[ply::E_SYNTAX				]="Syntax error on header";
-			ply_error_msg[ply::E_PROPOUTOFELEMENT]="Property without element";
-			ply_error_msg[ply::E_BADTYPENAME		]="Bad type name";
-			ply_error_msg[ply::E_ELEMNOTFOUND		]="Element not found";
-			ply_error_msg[ply::E_PROPNOTFOUND		]="Property not found";
-			ply_error_msg[ply::E_BADTYPE				]="Bad type on addtoread";
-			ply_error_msg[ply::E_INCOMPATIBLETYPE]="Incompatible type";
-			ply_error_msg[ply::E_BADCAST				]="Bad cast";
-
-			ply_error_msg[PlyInfo::E_NO_VERTEX      ]="No vertex field found";
-			ply_error_msg[PlyInfo::E_NO_FACE        ]="No face field found";
-			ply_error_msg[PlyInfo::E_SHORTFILE      ]="Unespected eof";
-			ply_error_msg[PlyInfo::E_NO_3VERTINFACE ]="Face with more than 3 vertices";
-			ply_error_msg[PlyInfo::E_BAD_VERT_INDEX ]="Bad vertex index in face";
-			ply_error_msg[PlyInfo::E_BAD_VERT_INDEX_EDGE ]="Bad vertex index in edge";
-			ply_error_msg[PlyInfo::E_NO_6TCOORD     ]="Face with no 6 texture coordinates";
-			ply_error_msg[PlyInfo::E_DIFFER_COLORS  ]="Number of color differ from vertices";
-		}
+		// a static const local is initialized just once, even when called concurrently
+		static const std::vector<std::string> ply_error_msg = ErrorMsgList();
 
 		if(error>PlyInfo::E_MAXPLYINFOERRORS || error<0) return "Unknown error";
 		else return ply_error_msg[error].c_str();
@@ -953,7 +956,11 @@ public:
 						tf.V(0) = index[ tsa.v[k+0] ];
 						tf.V(1) = index[ tsa.v[k+1] ];
 						tf.V(2) = index[ tsa.v[k+2] ];
-						if((k+remainder)%2) std::swap (tf.V(0), tf.V(1) );
+						if((k+remainder)%2) {
+							VertexPointer tmp = tf.V(0);
+							tf.V(0) = tf.V(1);
+							tf.V(1) = tmp;
+						}
 					}
 				}
 			}
@@ -246,7 +246,8 @@ namespace io {
     {
 
         static void ReadString(std::string & out){
-            unsigned int l; Read(&l,4,1);
+            unsigned int l = 0; Read(&l,4,1);
+            if(!Available(1,l)) { out.clear(); return; }
             char * buf = new char[l+1];
             Read(buf,1,l);buf[l]='\0';
             out = std::string(buf);
@@ -316,6 +317,9 @@ namespace io {
             LoadVertexOcf( FILE * /*f*/, vertex::vector_ocf<typename OpenMeshType::VertexType> & vert){
             std::string s;
 
+                // the raw vertex image carries the container pointer of the saved mesh
+                vert._updateOVP(vert.begin(),vert.end());
+
                 // vertex quality
                 ReadString( s);
                 if( s == std::string("HAS_VERTEX_QUALITY_OCF")) {
@@ -441,6 +445,9 @@ namespace io {
                         LoadFaceOcf( face::vector_ocf<FaceType> & face){
                                 std::string s;
 
+                                // the raw face image carries the container pointer of the saved mesh
+                                face._updateOVP(face.begin(),face.end());
+
                                 // face quality
                                 ReadString( s);
                                 if( s == std::string("HAS_FACE_QUALITY_OCF")) {
@@ -534,9 +541,27 @@ namespace io {
         static FILE *& F(){static FILE * f; return f;}
 
 
-        static void * Malloc(unsigned int n){ return (n)?malloc(n):0;}
+        static void * Malloc(size_t n){ return (n)?malloc(n):0;}
         static void Free(void * ptr){ if(ptr) free (ptr);}
 
+        /* return a buffer holding the next size*count bytes of the input, or 0 if the input is
+           too short. When reading from memory the bytes are used in place, avoiding a temporary
+           copy of every attribute */
+        static void * ReadBlock(size_t size, size_t count){
+            if(In_mode() == 0){
+                if(!Available(size,count)) return 0;
+                void * data = (void*) &In_mem()[pos()];
+                pos() += size * count;
+                return data;
+            }
+            if(Failed()) return 0;
+            void * data = Malloc(size*count);
+            if(data == 0) { Failed() = (size*count != 0); return 0; }
+            Read(data,size,count);
+            return data;
+        }
+        static void FreeBlock(void * data){ if(In_mode() != 0) Free(data);}
+
 
         typedef typename OpenMeshType::FaceType FaceType;
         typedef typename OpenMeshType::FaceContainer FaceContainer;
@@ -590,14 +615,14 @@ namespace io {
 
             ReadString( name); ReadInt( nameFsize);
 
-            for(i=0; i < nameFsize; ++i)
+            for(i=0; i < nameFsize && !Failed(); ++i)
                 {ReadString(  name);fnameF.push_back( name );mask |= FaceMaskBitFromString(name);}
             mask |= LoadFaceOcfMask();
 
             ReadString( name); ReadInt( faceSize);
             ReadString(  name); ReadInt( nameVsize);
 
-            for(i=0; i < nameVsize; ++i)
+            for(i=0; i < nameVsize && !Failed(); ++i)
                 {ReadString(  name) ;fnameV.push_back( name);mask |= VertexMaskBitFromString(name);}
             mask |= LoadVertexOcfMask();
 
@@ -610,8 +635,8 @@ namespace io {
             for(unsigned int i =0; i < 2; ++i){ReadFloat( float_value); bbox.max[i]=float_value;}
 
             ReadString( name);
-            assert(strstr( name.c_str(),"end_header")!=NULL);
-            return true;
+            if(strstr( name.c_str(),"end_header")==NULL) Failed() = true;
+            return !Failed();
         }
 
 
@@ -624,18 +649,35 @@ namespace io {
 
     public:
         static const char * & In_mem(){static const char *    in_mem; return in_mem;}
+        static size_t & In_size(){static size_t  in_size = 0; return in_size;}
         static unsigned int & In_mode(){static unsigned int  in_mode = 0; return in_mode;}
+        /* set when the input is shorter than what the header says (truncated or corrupted) */
+        static bool & Failed(){static bool failed = false; return failed;}
 
 
-        static unsigned int & pos(){static unsigned int  p = 0; return p;}
+        static size_t & pos(){static size_t  p = 0; return p;}
         static int Read_sim(const void * , size_t size, size_t count ){ pos() += size * count;return size * count; }
-        static int Read_mem( void *dst , size_t size, size_t count ){ memcpy(dst,&In_mem()[pos()],size*count); pos() += size * count;return size * count; }
-
+        static int Read_mem( void *dst , size_t size, size_t count ){
+            if(!Available(size,count)) return 0;
+            memcpy(dst,&In_mem()[pos()],size*count); pos() += size * count;return size * count; }
+
+        /* true if the next size*count bytes can be read from memory (always true when reading
+           from a file, where a short read is detected by Read); otherwise sets Failed */
+        static bool Available(size_t size, size_t count){
+            if(In_mode() != 0 || Failed()) return !Failed();
+            const size_t left = In_size() - pos();
+            if(size != 0 && count > left / size) Failed() = true;
+            return !Failed();
+        }
 
         static int Read( void * dst,  size_t size, size_t count){
             switch(In_mode()){
             case 0: return Read_mem(dst, size,count );  break;
-            case 1: return fread(dst, size,count, F() ); break;
+            case 1: {
+                    size_t n = fread(dst, size,count, F() );
+                    if(n != count) Failed() = true;
+                    return n;
+                } break;
              }
             assert(0);
             return 0;
@@ -648,12 +690,17 @@ namespace io {
             unsigned int   vertSize, faceSize;
             vcg::Box3f bbox;
             F() = fopen(f,"rb");
+            if(!F()) return false;
             In_mode() = 1;
-            GetHeader(nameV,nameF,vertSize, faceSize, bbox, mask);
-            return true;
+            Failed() = false;
+            bool res = GetHeader(nameV,nameF,vertSize, faceSize, bbox, mask);
+            fclose(F());
+            return res;
         }
 
-        static bool LoadMaskFromMem(  const char * ptr, int & mask){
+        /* read the mask from a mesh image of size bytes already in memory; returns false if
+           the header is truncated or corrupted */
+        static bool LoadMaskFromMem(  const char * ptr, size_t size, int & mask){
             std::vector<std::string>  nameV;
             std::vector<std::string>  nameF;
             unsigned int   vertSize, faceSize;
@@ -661,12 +708,14 @@ namespace io {
             In_mode() = 0;
             pos() = 0;
             In_mem() = ptr;
-            GetHeader(nameV,nameF,vertSize, faceSize, bbox, mask);
-            return true;
+            In_size() = size;
+            Failed() = false;
+            return GetHeader(nameV,nameF,vertSize, faceSize, bbox, mask);
         }
 
         static int Open(OpenMeshType &m, const char * filename, int & mask,CallBackPos  * /*cb*/ = 0 )       {
             In_mode() = 1;
+            Failed() = false;
             F() = fopen(filename,"rb");
             if(!F()) return VMI_FAILED_OPEN;
             if(F()==NULL)	return 1; // 1 is the error code for cant'open, see the ErrorMsg function
@@ -674,10 +723,16 @@ namespace io {
             fclose(F());
             return  res;
         }
-        static int ReadFromMem(  OpenMeshType &m, int & mask,char * ptr){
+        /* deserialize a mesh image of size bytes already in memory (e.g. a memory mapped VMI
+           file). Vertices, faces and attributes are copied with a single memcpy each; every
+           block is checked against the size, and VMI_FAILED_OPEN is returned if the image
+           is truncated or corrupted */
+        static int ReadFromMem(  OpenMeshType &m, int & mask,const char * ptr, size_t size){
             In_mode() = 0;
             pos() = 0;
             In_mem() = ptr;
+            In_size() = size;
+            Failed() = false;
             return Deserialize(m,mask);
         }
 
@@ -693,7 +748,7 @@ namespace io {
 
             /* read the header */
       vcg::Box3f lbbox;
-      GetHeader(fnameV, fnameF, vertSize, faceSize,lbbox,mask);
+      if(!GetHeader(fnameV, fnameF, vertSize, faceSize,lbbox,mask)) return VMI_FAILED_OPEN;
       m.bbox.Import(lbbox);
             /* read the mesh type */
             OpenMeshType::FaceType::Name(nameF);
@@ -721,6 +776,8 @@ namespace io {
             Read(&m.bbox,sizeof(Box3<typename OpenMeshType::ScalarType>),1 );
             Read(&m.C(),sizeof(Color4b),1 );
 
+            /* do not allocate more than the input holds */
+            if(!Available(sizeof(VertexType),vertSize) ) return VMI_FAILED_OPEN;
 
             /* resize the vector of vertices */
             m.vert.resize(vertSize);
@@ -734,12 +791,14 @@ namespace io {
             }
 
             read = 0;
+            if(!Available(sizeof(FaceType),faceSize) ) return VMI_FAILED_OPEN;
             m.face.resize(faceSize);
             if(faceSize>0){
                 /* load the faces */
                 read = Read((void*)& m.face[0],sizeof(FaceType),faceSize );
                 LoadFaceOcf<OpenMeshType,FaceContainer>(m.face);
             }
+            FaceVectorSetVertexBase(m.face,m.vert);
 
 
             /* load the per vertex attributes */
@@ -752,10 +811,10 @@ namespace io {
                 ReadString(_trash); ReadString(_string);
                 ReadString(_trash); ReadInt(sz);
 
-                void * data = Malloc(sz*m.vert.size());
-                Read(data,sz,m.vert.size());
+                void * data = ReadBlock(sz,m.vert.size());
+                if(Failed()) { FreeBlock(data); return VMI_FAILED_OPEN; }
                 AttrAll<OpenMeshType,A0,A1,A2,A3,A4>::template AddAttrib<0>(m,_string.c_str(),sz,data);
-                Free(data);
+                FreeBlock(data);
             }
 
             /* load the per face attributes */
@@ -763,10 +822,10 @@ namespace io {
             for(size_t ia = 0 ; ia < n; ++ia){
                 ReadString(_trash); ReadString( _string);
                 ReadString(_trash); ReadInt( sz);
-                void * data = Malloc(sz*m.face.size());
-                Read(data,sz,m.face.size() );
+                void * data = ReadBlock(sz,m.face.size());
+                if(Failed()) { FreeBlock(data); return VMI_FAILED_OPEN; }
                 AttrAll<OpenMeshType,A0,A1,A2,A3,A4>::template AddAttrib<1>(m,_string.c_str(),sz,data);
-                Free(data);
+                FreeBlock(data);
             }
 
             /* load the per mesh attributes */
@@ -774,12 +833,14 @@ namespace io {
             for(unsigned int ia = 0 ; ia < n; ++ia){
                 ReadString( _trash); ReadString( _string);
                 ReadString( _trash); ReadInt( sz);
-                void * data = Malloc(sz);
-                Read(data,1,sz );
+                void * data = ReadBlock(1,sz);
+                if(Failed()) { FreeBlock(data); return VMI_FAILED_OPEN; }
                 AttrAll<OpenMeshType,A0,A1,A2,A3,A4>::template AddAttrib<2>(m,_string.c_str(),sz,data);
-                Free(data);
+                FreeBlock(data);
             }
 
+            if(Failed()) return VMI_FAILED_OPEN;
+
             if(!m.face.empty()){
             if(FaceVectorHasVFAdjacency(m.face))
                 for(vi = m.vert.begin(); vi != m.vert.end(); ++vi){
@@ -788,7 +849,8 @@ namespace io {
                     (*vi).VFp() = (*vi).VFp()-(FaceType*)offsetF+ &m.face[0];
                 }
 
-            if(FaceVectorHasFVAdjacency(m.face))
+            // vertex references stored as indexes do not depend on where the vertices were
+            if(FaceVectorHasFVAdjacency(m.face) && !FaceType::HasVertexRefIdx())
                 for(fi = m.face.begin(); fi != m.face.end(); ++fi){
                     (*fi).V(0) = (*fi).V(0)-(VertexType*)offsetV+ &m.vert[0];
                     (*fi).V(1) = (*fi).V(1)-(VertexType*)offsetV+ &m.vert[0];
@@ -0,0 +1,135 @@
+/****************************************************************************
+* VCGLib                                                            o o     *
+* Visual and Computer Graphics Library                            o     o   *
+*                                                                _   O  _   *
+* Copyright(C) 2004-2016                                           \/)\/    *
+* Visual Computing Lab                                            /\/|      *
+* ISTI - Italian National Research Council                           |      *
+*                                                                    \      *
+* All rights reserved.                                                      *
+*                                                                           *
+* This program is free software; you can redistribute it and/or modify      *
+* it under the terms of the GNU General Public License as published by      *
+* the Free Software Foundation; either version 2 of the License, or         *
+* (at your option) any later version.                                       *
+*                                                                           *
+* This program is distributed in the hope that it will be useful,           *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)          *
+* for more details.                                                         *
+*                                                                           *
+****************************************************************************/
+
+#ifndef __VCGLIB_IOTRIMESH_IO_BUFFER
+#define __VCGLIB_IOTRIMESH_IO_BUFFER
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+#include <wrap/system/parallel.h>
+
+namespace vcg {
+namespace tri {
+namespace io {
+
+/** Growable memory buffer with the same fwrite/fprintf pair used by the exporters.
+    Element records are formatted in memory and reach the file with a single fwrite.
+*/
+class OutBuffer
+{
+public:
+	void Write(const void *src, size_t size, size_t count)
+	{
+		const size_t n = size * count;
+		if (n == 0)
+			return;
+		const size_t old = buf.size();
+		buf.resize(old + n);
+		memcpy(&buf[old], src, n);
+	}
+
+	void Printf(const char *fmt, ...)
+	{
+		char tmp[256];
+		va_list args;
+		va_start(args, fmt);
+		int len = vsnprintf(tmp, sizeof(tmp), fmt, args);
+		va_end(args);
+		if (len < 0)
+			return;
+		if (size_t(len) < sizeof(tmp)) {
+			buf.insert(buf.end(), tmp, tmp + len);
+			return;
+		}
+		// longer records are formatted again straight into the buffer
+		const size_t old = buf.size();
+		buf.resize(old + len + 1);
+		va_start(args, fmt);
+		vsnprintf(&buf[old], len + 1, fmt, args);
+		va_end(args);
+		buf.resize(old + len);
+	}
+
+	void Clear() { buf.clear(); }
+	size_t Size() const { return buf.size(); }
+
+	bool Flush(FILE *fp)
+	{
+		bool ok = buf.empty() || fwrite(&buf[0], 1, buf.size(), fp) == buf.size();
+		buf.clear();
+		return ok;
+	}
+
+private:
+	std::vector<char> buf;
+};
+
+/** Write n elements to fp, formatting them in chunks of consecutive elements.
+    writeElem(OutBuffer &out, size_t i) appends the record of element i (or nothing,
+    e.g. for deleted elements). Chunks are formatted in parallel and always written
+    in element order, so the output does not depend on the number of threads. Writers
+    that carry state from one element to the next must pass inParallel=false; their
+    chunks are then formatted in order on the calling thread.
+    progress(size_t done) is called from the calling thread after each batch of
+    chunks has been written; if it returns false the write is interrupted.
+    Returns false if the write has been interrupted or fwrite failed.
+*/
+template <class WriteElemFunc, class ProgressFunc>
+bool WriteElementsInChunks(FILE *fp, size_t n, WriteElemFunc writeElem, ProgressFunc progress, bool inParallel = true)
+{
+	const size_t chunkSize = 4096;
+	const size_t batchChunks = 64;
+	const size_t chunkNum = (n + chunkSize - 1) / chunkSize;
+	std::vector<OutBuffer> chunks(std::min(batchChunks, chunkNum));
+
+	for (size_t b = 0; b < chunkNum; b += batchChunks) {
+		const int bn = int(std::min(batchChunks, chunkNum - b));
+		auto formatChunk = [&](int c) {
+			const size_t begin = (b + c) * chunkSize;
+			const size_t end = std::min(n, begin + chunkSize);
+			for (size_t i = begin; i < end; ++i)
+				writeElem(chunks[c], i);
+		};
+		if (inParallel)
+			parallel::For(bn, formatChunk, 0, "", 1);
+		else
+			for (int c = 0; c < bn; ++c)
+				formatChunk(c);
+		for (int c = 0; c < bn; ++c)
+			if (!chunks[c].Flush(fp))
+				return false;
+		if (!progress(std::min(n, (b + bn) * chunkSize)))
+			return false;
+	}
+	return true;
+}
+
+} // end namespace io
+} // end namespace tri
+} // end namespace vcg
+
+#endif
@@ -77,6 +77,7 @@ public:
 		p.propname=propName;
 		p.stotype1 = propertyType;
 		p.memtype1 = propertyType;
+		p.islist = false;
 
 		if (elemType == 0){ //vertex
 			VertAttrNameVec.push_back(attrName);
@@ -0,0 +1,301 @@
+/****************************************************************************
+* VCGLib                                                            o o     *
+* Visual and Computer Graphics Library                            o     o   *
+*                                                                _   O  _   *
+* Copyright(C) 2004-2016                                           \/)\/    *
+* Visual Computing Lab                                            /\/|      *
+* ISTI - Italian National Research Council                           |      *
+*                                                                    \      *
+* All rights reserved.                                                      *
+*                                                                           *
+* This program is free software; you can redistribute it and/or modify      *
+* it under the terms of the GNU General Public License as published by      *
+* the Free Software Foundation; either version 2 of the License, or         *
+* (at your option) any later version.                                       *
+*                                                                           *
+* This program is distributed in the hope that it will be useful,           *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of            *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the             *
+* GNU General Public License (http://www.gnu.org/licenses/gpl.txt)          *
+* for more details.                                                         *
+*                                                                           *
+****************************************************************************/
+#ifndef __VCG_SYSTEM_PARALLEL
+#define __VCG_SYSTEM_PARALLEL
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <wrap/callback.h>
+
+namespace vcg {
+/** Parallel loops, reductions and sorts over an index range, built on the OpenMP runtime
+    used by the rest of the library (only OpenMP 2.0 constructs, so that MSVC can build them).
+
+    - SetMaxThreads() sets a process wide limit. OpenMP keeps the thread count of the
+      parallel regions per thread, so the limit reaches the regions started by the calling
+      thread at once and those started by any other thread (e.g. the workers of a thread
+      pool) only after that thread calls ApplyMaxThreads(). Until SetMaxThreads() is
+      called with a positive value OMP_NUM_THREADS is honoured.
+    - A call made from inside a parallel region runs serially on the calling thread,
+      so algorithms using these functions can be nested without oversubscription.
+    - The range is split in chunks that idle threads pick up dynamically. Results of
+      Reduce() and Sort() do not depend on the number of threads.
+    - The CallBackPos, if any, is called only from the thread that started the loop,
+      with the percentage of completed chunks; if it returns false the remaining chunks
+      are skipped and the function returns false.
+    - An exception thrown by the body stops the loop and is rethrown to the caller.
+*/
+namespace parallel {
+
+namespace detail {
+
+/// Thread count the process started with (OMP_NUM_THREADS when set, otherwise one per processor).
+inline int StartThreads()
+{
+#ifdef _OPENMP
+    // captured by the first call, before any thread changes its count
+    static const int startThreads = omp_get_max_threads();
+    return startThreads;
+#else
+    return 1;
+#endif
+}
+
+/// The limit set by SetMaxThreads(), 0 if none.
+inline std::atomic<int> &ThreadLimit()
+{
+    static std::atomic<int> limit(0);
+    return limit;
+}
+
+} // end namespace detail
+
+/** Apply the limit set by SetMaxThreads() to the parallel regions started by the calling thread.
+    A positive cap lowers it further, e.g. for a task that runs next to other tasks.
+    Threads not created by OpenMP must call it before running parallel code.
+*/
+inline void ApplyMaxThreads(int cap = 0)
+{
+#ifdef _OPENMP
+    const int limit = detail::ThreadLimit();
+    int n = limit > 0 ? limit : detail::StartThreads();
+    if (cap > 0) n = std::min(n, cap);
+    omp_set_num_threads(n);
+#else
+    (void)cap;
+#endif
+}
+
+/// Limit the number of threads used by parallel regions; 0 restores the count the process
+/// started with (OMP_NUM_THREADS when set, otherwise one per processor).
+/// The limit is applied to the calling thread, see ApplyMaxThreads() for the others.
+inline void SetMaxThreads(int n)
+{
+    detail::StartThreads();
+    detail::ThreadLimit() = std::max(0, n);
+    ApplyMaxThreads();
+}
+
+/// Number of threads that a parallel region started here would use.
+inline int MaxThreads()
+{
+#ifdef _OPENMP
+    return omp_in_parallel() ? 1 : omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
+
+inline int ThreadIndex()
+{
+#ifdef _OPENMP
+    return omp_get_thread_num();
+#else
+    return 0;
+#endif
+}
+
+namespace detail {
+
+inline int ChunkSize(int n, int threads, int grain)
+{
+    if (grain > 0) return grain;
+    // a few chunks per thread balance the load without too much scheduling
+    return std::max(1, n / (threads * 8));
+}
+
+/// Run chunkFunc(chunk, begin, end) on all the chunks of [0,n).
+template <class ChunkFunc>
+bool ForChunks(int n, int grain, ChunkFunc chunkFunc, CallBackPos *cb, const char *msg)
+{
+    if (n <= 0) return true;
+    const int threads = MaxThreads();
+    const int chunk = ChunkSize(n, threads, grain);
+    const int chunkNum = (n + chunk - 1) / chunk;
+
+    if (chunkNum == 1 || threads == 1)
+    {
+        // not worth a parallel region: run the chunks on the calling thread
+        int reported = -1;
+        for (int c = 0; c < chunkNum; ++c)
+        {
+            chunkFunc(c, c * chunk, std::min(n, (c + 1) * chunk));
+            const int pos = int((100LL * (c + 1)) / chunkNum);
+            if (cb != 0 && pos != reported)
+            {
+                reported = pos;
+                if (!cb(pos, msg)) return false;
+            }
+        }
+        return true;
+    }
+
+    std::atomic<bool> stop(false);
+    std::atomic<int> done(0);
+    std::exception_ptr error;
+    int reported = -1;
+
+#pragma omp parallel for schedule(dynamic, 1) num_threads(threads)
+    for (int c = 0; c < chunkNum; ++c)
+    {
+        if (stop.load(std::memory_order_relaxed)) continue;
+        try
+        {
+            chunkFunc(c, c * chunk, std::min(n, (c + 1) * chunk));
+        }
+        catch (...)
+        {
+#pragma omp critical(vcg_parallel_error)
+            if (!error) error = std::current_exception();
+            stop = true;
+        }
+        const int d = ++done;
+        if (cb != 0 && ThreadIndex() == 0)
+        {
+            const int pos = int((100LL * d) / chunkNum);
+            if (pos != reported)
+            {
+                reported = pos;
+                if (!cb(pos, msg)) stop = true;
+            }
+        }
+    }
+    if (error) std::rethrow_exception(error);
+    if (cb != 0 && !stop && reported != 100)
+        cb(100, msg);
+    return !stop;
+}
+
+} // end namespace detail
+
+/** Call body(i) for every i in [0,n).
+    grain is the number of consecutive indices processed as a unit (0 chooses it).
+    Returns false if the loop has been interrupted by the callback.
+*/
+template <class Func>
+bool For(int n, Func body, CallBackPos *cb = 0, const char *msg = "", int grain = 0)
+{
+    return detail::ForChunks(n, grain, [&](int, int b, int e) {
+        for (int i = b; i < e; ++i) body(i);
+    }, cb, msg);
+}
+
+/** Call body(chunk, begin, end) on the consecutive ranges of grain indices that split [0,n)
+    (the last one may be shorter); chunk is the position of the range, in [0, ChunkNum(n, grain)).
+    Useful when every range fills its own partial result (a table, a histogram) that is too
+    big to be returned by value as Reduce() does; the partial results can then be merged in order.
+*/
+template <class Func>
+bool ForRange(int n, int grain, Func body, CallBackPos *cb = 0, const char *msg = "")
+{
+    assert(grain > 0);
+    return detail::ForChunks(n, grain, body, cb, msg);
+}
+
+/// Number of ranges used by ForRange() with the same n and grain.
+inline int ChunkNum(int n, int grain)
+{
+    return n <= 0 ? 0 : (n + grain - 1) / grain;
+}
+
+/** Combine the values map(i), i in [0,n), with the associative function combine.
+    Partial results of the chunks are combined in index order and the default chunking
+    does not depend on the thread count, so the result is the same with any number of
+    threads (also for floating point sums).
+*/
+template <class T, class MapFunc, class CombineFunc>
+T Reduce(int n, const T &identity, MapFunc map, CombineFunc combine, int grain = 0)
+{
+    if (n <= 0) return identity;
+    const int chunk = grain > 0 ? grain : std::max(1, n / 256);
+    std::vector<T> partial((n + chunk - 1) / chunk, identity);
+    detail::ForChunks(n, chunk, [&](int c, int b, int e) {
+        T acc = identity;
+        for (int i = b; i < e; ++i) acc = combine(acc, map(i));
+        partial[c] = acc;
+    }, 0, "");
+    T result = identity;
+    for (size_t c = 0; c < partial.size(); ++c)
+        result = combine(result, partial[c]);
+    return result;
+}
+
+/** Sort a vector: blocks are sorted in parallel and then merged pairwise in parallel.
+    Elements that are equivalent for comp keep their relative order.
+*/
+template <class T, class Compare>
+void Sort(std::vector<T> &v, Compare comp)
+{
+    const int n = int(v.size());
+    const int minBlock = 1 << 14;
+    int blockNum = 1;
+    while (blockNum < MaxThreads() && n / (blockNum * 2) >= minBlock) blockNum *= 2;
+    if (blockNum == 1)
+    {
+        std::stable_sort(v.begin(), v.end(), comp);
+        return;
+    }
+
+    std::vector<int> bound(blockNum + 1);
+    for (int b = 0; b <= blockNum; ++b)
+        bound[b] = int((long long)n * b / blockNum);
+    For(blockNum, [&](int b) {
+        std::stable_sort(v.begin() + bound[b], v.begin() + bound[b + 1], comp);
+    }, 0, "", 1);
+
+    std::vector<T> tmp(n);
+    std::vector<T> *src = &v, *dst = &tmp;
+    for (int width = 1; width < blockNum; width *= 2)
+    {
+        const int pairNum = blockNum / (2 * width);
+        For(pairNum, [&](int p) {
+            const int b = bound[2 * p * width], m = bound[(2 * p + 1) * width], e = bound[(2 * p + 2) * width];
+            std::merge(std::make_move_iterator(src->begin() + b), std::make_move_iterator(src->begin() + m),
+                       std::make_move_iterator(src->begin() + m), std::make_move_iterator(src->begin() + e),
+                       dst->begin() + b, comp);
+        }, 0, "", 1);
+        std::swap(src, dst);
+    }
+    if (src != &v) v.swap(tmp);
+}
+
+template <class T>
+void Sort(std::vector<T> &v)
+{
+    Sort(v, std::less<T>());
+}
+
+} // end namespace parallel
+} // end namespace vcg
+
+#endif // __VCG_SYSTEM_PARALLEL